@@ -14,32 +14,29 @@
 #include <stdlib.h>
 #include "platform_defs.h"
 
-#if PCK_DEBUG_OUTPUT
-#include <windows.h>
-#include <stdio.h>
-#endif
-
 #pragma warning ( disable : 4996 )
 #pragma warning ( disable : 4267 )
 
-// Forward declarations
-unsigned int JSHash(const char *str);
-void zupbase64cpy(char *_dst, const char *_src, int len);
+#define DICT_POOL_SIZE		(1024 * 1024)
+#define DICT_MIN_SLOTS		1024
 
-// JS Hash Function
-unsigned int JSHash(const char *str)
+// FNV-1a with a final mix, the low bits are used as the slot
+static inline uint64_t DictHashStr(const char *str, size_t len)
 {
-	unsigned int hash = 1315423911;
+	uint64_t hash = 0xcbf29ce484222325ULL;
 
-	while(*str) {
-		hash ^= ((hash << 5) + (*str++) + (hash >> 2));
+	for(size_t i = 0;i < len;i++) {
+		hash ^= (uint8_t)str[i];
+		hash *= 0x100000001b3ULL;
 	}
 
-	return (hash & HASH_TABLE_LENGTH);
-
+	hash ^= hash >> 29;
+	hash *= 0xbf58476d1ce4e5b9ULL;
+	hash ^= hash >> 32;
+	return hash;
 }
 
-void zupbase64cpy(char *_dst, const char *_src, int len)
+static void zupbase64cpy(char *_dst, const char *_src, int len)
 {
 
 	for(; len > 0; len--) {
@@ -50,127 +47,131 @@ void zupbase64cpy(char *_dst, const char *_src, int len)
 	}
 }
 
-CDictHash::CDictHash()
+CDictHash::CDictHash(size_t nExpectedCount) :
+	m_nCount(0),
+	m_MemPool(DICT_POOL_SIZE)
 {
-	lpDictHashTable = new LPZUP_FILENAME_DICT[HASH_TABLE_LENGTH + 1];
-	memset(lpDictHashTable, 0, sizeof(LPZUP_FILENAME_DICT) * (HASH_TABLE_LENGTH + 1));
-
+	resize(nExpectedCount);
 }
 
 CDictHash::~CDictHash()
 {
+}
+
+//Keep the load below 3/4
+void CDictHash::resize(size_t nCount)
+{
+	size_t nSize = DICT_MIN_SLOTS;
+	while(nSize < (nCount + nCount / 3 + 1))
+		nSize <<= 1;
+
+	if(nSize <= m_Slots.size())
+		return;
 
-	LPZUP_FILENAME_DICT *lpDictHash = lpDictHashTable;
+	std::vector<DICT_SLOT> oldSlots(nSize, DICT_SLOT{ 0, NULL });
+	oldSlots.swap(m_Slots);
 
-	for(unsigned int i = 0;i < HASH_TABLE_LENGTH;i++) {
-		if(NULL != *lpDictHash) {
-			Dealloc(*lpDictHash);
-		}
-		lpDictHash++;
+	size_t nMask = nSize - 1;
+
+	for(const DICT_SLOT &slot : oldSlots) {
+
+		if(NULL == slot.lpDict)
+			continue;
+
+		size_t i = slot.hash & nMask;
+		while(NULL != m_Slots[i].lpDict)
+			i = (i + 1) & nMask;
+
+		m_Slots[i] = slot;
 	}
+}
 
-	delete[] lpDictHashTable;
+char* CDictHash::AllocString(const char *str, size_t len)
+{
+	char *lpString = (char*)m_MemPool.Alloc(len + 1, 1);
 
+	if(NULL != lpString) {
+		memcpy(lpString, str, len);
+		lpString[len] = 0;
+	}
+	return lpString;
 }
 
 LPZUP_FILENAME_DICT CDictHash::add(const char *keystr)
 {
+	size_t len = strlen(keystr);
+
+	if(MAX_PATH_PCK <= len)
+		return NULL;
 
-	unsigned char len = strlen(keystr);
 	char szlwrstr[MAX_PATH_PCK];
 	memcpy(szlwrstr, keystr, len + 1);
+	strlwr(szlwrstr);
 
-	unsigned int key = JSHash(strlwr(szlwrstr));
-	unsigned int sizeStuct = sizeof(ZUP_FILENAME_DICT);
+	uint64_t hash = DictHashStr(szlwrstr, len);
+	size_t nMask = m_Slots.size() - 1;
+	size_t i = hash & nMask;
 
-	LPZUP_FILENAME_DICT	lpDict = *(lpDictHashTable + key);
+	for(; NULL != m_Slots[i].lpDict; i = (i + 1) & nMask) {
 
-	if(NULL == lpDict) {
-		lpDict = *(lpDictHashTable + key) = AllocNode(sizeStuct);
-		lpDict->realstrlength = len;
-		memcpy(lpDict->base64str, szlwrstr, len);
-		//memcpy(lpDict->realbase64str, keystr, len);
-		zupbase64cpy(lpDict->realbase64str, keystr, len);
+		const ZUP_FILENAME_DICT *lpDict = m_Slots[i].lpDict;
+		if((hash == m_Slots[i].hash) && (len == lpDict->base64strlength) && (0 == memcmp(lpDict->base64str, szlwrstr, len)))
+			return NULL;
+	}
 
-		return lpDict;
-	} else {
+	LPZUP_FILENAME_DICT lpDict = (LPZUP_FILENAME_DICT)m_MemPool.Alloc(sizeof(ZUP_FILENAME_DICT));
+	char *lpRealBase64 = (char*)m_MemPool.Alloc(len + 1, 1);
 
-		do {
-			if(0 == strcmp(lpDict->base64str, szlwrstr)) {
-				return 0;
-			}
+	if((NULL == lpDict) || (NULL == lpRealBase64) || (NULL == (lpDict->base64str = AllocString(szlwrstr, len))))
+		return NULL;
 
-			if(NULL == lpDict->next) {
-				lpDict->next = AllocNode(sizeStuct);
-				lpDict = lpDict->next;
-				lpDict->realstrlength = len;
-				memcpy(lpDict->base64str, szlwrstr, len);
-				//memcpy(lpDict->realbase64str, keystr, len);
-				zupbase64cpy(lpDict->realbase64str, keystr, len);
+	zupbase64cpy(lpRealBase64, keystr, len);
+	lpRealBase64[len] = 0;
 
-				return lpDict;
-			} else {
-				lpDict = lpDict->next;
-			}
+	lpDict->realbase64str = lpRealBase64;
+	lpDict->base64strlength = len;
+	lpDict->realstr = "";
+	lpDict->wrealstr = L"";
+	lpDict->realstrlength = lpDict->wrealstrlength = 0;
 
-		} while(1);
+	m_Slots[i] = DICT_SLOT{ hash, lpDict };
+	++m_nCount;
 
-	}
+	if(m_Slots.size() < (m_nCount + m_nCount / 3 + 1))
+		resize(m_nCount * 2);
 
+	return lpDict;
 }
 
 LPZUP_FILENAME_DICT CDictHash::find(const char *keystr)
 {
-	unsigned int key = JSHash(keystr);
+	size_t len = strlen(keystr);
+	uint64_t hash = DictHashStr(keystr, len);
+	size_t nMask = m_Slots.size() - 1;
 
-	LPZUP_FILENAME_DICT	lpDict = *(lpDictHashTable + key);
+	for(size_t i = hash & nMask; NULL != m_Slots[i].lpDict; i = (i + 1) & nMask) {
 
-	if(NULL == lpDict) {
-		return 0;
-	} else {
-		if(NULL == lpDict->next) {
+		LPZUP_FILENAME_DICT lpDict = m_Slots[i].lpDict;
+		if((hash == m_Slots[i].hash) && (len == lpDict->base64strlength) && (0 == memcmp(lpDict->base64str, keystr, len)))
 			return lpDict;
-		} else {
-
-			do {
-				if(0 == strcmp(lpDict->base64str, keystr)) {
-					return lpDict;
-				}
-				lpDict = lpDict->next;
-			} while(NULL != lpDict);
-
-			return 0;
-		}
 	}
 
+	return NULL;
 }
 
-
-LPZUP_FILENAME_DICT CDictHash::AllocNode(unsigned int sizeStuct)
+void CDictHash::setdecoded(LPZUP_FILENAME_DICT lpDict, const char *realstr, unsigned int realstrlength, const wchar_t *wrealstr, unsigned int wrealstrlength)
 {
-	LPZUP_FILENAME_DICT		lpMallocNode;
+	char	*lpRealStr = AllocString(realstr, realstrlength);
+	wchar_t	*lpWRealStr = (wchar_t*)m_MemPool.Alloc((wrealstrlength + 1) * sizeof(wchar_t), sizeof(wchar_t));
 
-	if(NULL == (lpMallocNode = (LPZUP_FILENAME_DICT)malloc(sizeStuct))) {
-		return lpMallocNode;
-	}
-	//Initialize memory
-	memset(lpMallocNode, 0, sizeStuct);
-
-	return lpMallocNode;
-
-}
+	if((NULL == lpRealStr) || (NULL == lpWRealStr))
+		return;
 
-void CDictHash::Dealloc(LPZUP_FILENAME_DICT lpDictHash)
-{
-#if PCK_DEBUG_OUTPUT
-	LPZUP_FILENAME_DICT lpDebug = lpDictHash;
-#endif
-	LPZUP_FILENAME_DICT lpTemp = lpDictHash;
-
-	while(NULL != lpDictHash) {
-		lpTemp = lpDictHash->next;
-		free(lpDictHash);
-		lpDictHash = lpTemp;
-	}
+	memcpy(lpWRealStr, wrealstr, wrealstrlength * sizeof(wchar_t));
+	lpWRealStr[wrealstrlength] = 0;
 
+	lpDict->realstr = lpRealStr;
+	lpDict->realstrlength = realstrlength;
+	lpDict->wrealstr = lpWRealStr;
+	lpDict->wrealstrlength = wrealstrlength;
 }
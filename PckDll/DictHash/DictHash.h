@@ -12,41 +12,55 @@
 #ifndef _CDICTHASH_H_
 #define _CDICTHASH_H_
 
-#define	HASH_TABLE_LENGTH		0xffff
-#define	MAX_PATH_PCK			260
+#include <stdint.h>
+#include <vector>
+#include "AllocMemPool.h"
 
+#define	MAX_PATH_PCK			260
 
+//Strings of an entry are stored in the memory pool of the dictionary
 typedef struct _ZUP_FILENAME_DICT {
 	
-	char				base64str[MAX_PATH_PCK];
-	char				realbase64str[MAX_PATH_PCK];
-	char				realstr[MAX_PATH_PCK];
-	wchar_t				wrealstr[MAX_PATH_PCK];
+	const char			*base64str;			//The key, lowercase
+	const char			*realbase64str;		//The key with '-' replaced by '/'
+	const char			*realstr;			//Decoded name in pck codepage
+	const wchar_t		*wrealstr;			//Decoded name
+	unsigned int		base64strlength;
 	unsigned int		realstrlength;
 	unsigned int		wrealstrlength;
-
-	_ZUP_FILENAME_DICT	*next;
 }ZUP_FILENAME_DICT, *LPZUP_FILENAME_DICT;
 
 class CDictHash
 {
 
 public:
-	CDictHash();
+	//The table is sized for nExpectedCount keys and grows when it gets full
+	CDictHash(size_t nExpectedCount = 0);
 	virtual ~CDictHash();
 
 	LPZUP_FILENAME_DICT	find(const char *keystr);
 
+	//NULL if the key already exists
 	LPZUP_FILENAME_DICT	add(const char *keystr);
 
+	//Store the decoded name of an added entry
+	void	setdecoded(LPZUP_FILENAME_DICT lpDict, const char *realstr, unsigned int realstrlength, const wchar_t *wrealstr, unsigned int wrealstrlength);
+
 
 protected:
-	
-	LPZUP_FILENAME_DICT	*lpDictHashTable;
 
-	LPZUP_FILENAME_DICT	AllocNode(unsigned int sizeStuct);
-	void	Dealloc(LPZUP_FILENAME_DICT lpDictHash);
+	typedef struct _DICT_SLOT {
+		uint64_t			hash;
+		LPZUP_FILENAME_DICT	lpDict;			//NULL if the slot is empty
+	}DICT_SLOT;
+
+	std::vector<DICT_SLOT>	m_Slots;
+	size_t					m_nCount;
+	CAllocMemPool			m_MemPool;
+
+	void	resize(size_t nCount);
+	char*	AllocString(const char *str, size_t len);
 
 };
 
-#endif	//_CDICTHASH_H_
\ No newline at end of file
+#endif	//_CDICTHASH_H_
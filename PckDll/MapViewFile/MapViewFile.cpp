@@ -272,6 +272,18 @@ QWORD CMapViewFile::GetFileSize()
 	return cqwSize.qwValue;
 }
 
+QWORD CMapViewFile::GetFileWriteTime()
+{
+	FILETIME ftWrite;
+	if (!::GetFileTime(hFile, NULL, NULL, &ftWrite))
+		return 0;
+
+	UNQWORD cqwTime;
+	cqwTime.dwValue = ftWrite.dwLowDateTime;
+	cqwTime.dwValueHigh = ftWrite.dwHighDateTime;
+	return cqwTime.qwValue;
+}
+
 //Automatically generate the name required when CreateFileMappingA. It is required that the name of the FileMapping being used at the same time cannot be repeated.
 LPCSTR CMapViewFile::GenerateMapName()
 {
@@ -79,6 +79,8 @@ public:
 	DWORD	Read(LPVOID buffer, DWORD dwBytesToRead);
 
 	QWORD	GetFileSize();
+	//Last write time of the open file, 0 when it can not be read
+	QWORD	GetFileWriteTime();
 
 	virtual LPBYTE	View(QWORD dwAddress, DWORD dwSize);
 	//virtual LPBYTE	ReView(LPVOID lpMapAddressOld, QWORD dwAddress, DWORD dwSize);
@@ -132,6 +132,9 @@ private:
 		QWORD dwFileSizeToWrite);
 
 	BOOL	ViewAndWrite2(QWORD dwAddress, const void *  buffer, DWORD dwSize);
+
+	//Bytes written by Write2 since the last flush, several files may be written at the same time
+	int		m_nBytesWriten = 0;
 };
 
 
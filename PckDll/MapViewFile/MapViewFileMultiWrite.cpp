@@ -288,7 +288,6 @@ BOOL CMapViewFileMultiWrite::ViewAndWrite2(QWORD dwAddress, const void *  buffer
 //Calculate the required size of each file
 BOOL CMapViewFileMultiWrite::Write2(QWORD dwAddress, const void* buffer, DWORD dwBytesToWrite)
 {
-	static int nBytesWriten = 0;
 	//PCK_STEP_ADD_SIZE
 	if (!IsNeedExpandWritingFile(dwAddress, dwBytesToWrite)) {
 		return FALSE;
@@ -298,14 +297,14 @@ BOOL CMapViewFileMultiWrite::Write2(QWORD dwAddress, const void* buffer, DWORD d
 		return FALSE;
 	}
 
-	nBytesWriten += dwBytesToWrite;
-	if (FLUSH_SIZE_THRESHOLD < nBytesWriten)
+	m_nBytesWriten += dwBytesToWrite;
+	if (FLUSH_SIZE_THRESHOLD < m_nBytesWriten)
 	{
 		for (int i = 0; i < m_file_cell.size(); i++) {
 			m_file_cell[i].lpMapView->FlushFileBuffers();
 		}
 		
-		nBytesWriten = 0;
+		m_nBytesWriten = 0;
 	}
 
 	UnmapViewAll();
@@ -0,0 +1,345 @@
+//////////////////////////////////////////////////////////////////////
+// PckCheckpointIndex.cpp: random access points in the data of large compressed files
+//
+// The saved index is a head, then every file with its points, the windows
+// are compressed. The head keeps the size and write time of the pck and a
+// crc of the rest, the offsets of the data are checked against the index of
+// the pck, a point of a changed file is never used
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "zlib.h"
+#include "PckCheckpointIndex.h"
+#include "PckDefines.h"
+#include "PckClassLog.h"
+#include "MapViewFileMultiPck.h"
+#include <algorithm>
+#include <string>
+#include <string.h>
+
+#define CHECKPOINT_FILE_MAGIC			"WPCKCKP2"
+
+#pragma pack(push, 4)
+
+typedef struct _CHECKPOINT_FILE_HEAD
+{
+	char		szMagic[8];
+	uint64_t	qwPckSize;
+	uint64_t	qwPckWriteTime;
+	uint32_t	dwInterval;
+	uint32_t	dwItemCount;
+	uint32_t	dwBodyCrc;		//crc32 of everything after the head
+}CHECKPOINT_FILE_HEAD;
+
+typedef struct _CHECKPOINT_FILE_ITEM
+{
+	uint64_t	qwAddressOffset;
+	uint64_t	qwFileClearTextSize;
+	uint64_t	qwFileCipherTextSize;
+	uint32_t	dwPointCount;
+}CHECKPOINT_FILE_ITEM;
+
+typedef struct _CHECKPOINT_FILE_POINT
+{
+	uint64_t	qwOut;
+	uint32_t	dwIn;
+	int32_t		iBits;
+	uint32_t	dwWindowSize;
+	uint32_t	dwPackedSize;
+}CHECKPOINT_FILE_POINT;
+
+#pragma pack(pop)
+
+//0 when the pck can not be opened, a saved index is then never used
+static uint64_t GetPckWriteTime(const wchar_t *lpszPckFile)
+{
+	CMapViewFileRead cFileRead;
+
+	if (!cFileRead.Open(lpszPckFile))
+		return 0;
+
+	return cFileRead.GetFileWriteTime();
+}
+
+#pragma region CPckEntryCheckpoints
+
+CPckEntryCheckpoints::CPckEntryCheckpoints(uint32_t dwInterval) :
+	m_dwInterval(dwInterval)
+{}
+
+const PCK_CHECKPOINT* CPckEntryCheckpoints::Find(uint64_t qwPosition)
+{
+	std::lock_guard<std::mutex> lckPoints(m_LockPoints);
+
+	auto it = std::upper_bound(m_Points.begin(), m_Points.end(), qwPosition, [](uint64_t qwOut, const PCK_CHECKPOINT &cPoint) {
+		return qwOut < cPoint.qwOut;
+	});
+
+	return (m_Points.begin() == it) ? NULL : &*(it - 1);
+}
+
+BOOL CPckEntryCheckpoints::IsWanted(uint64_t qwOut)
+{
+	std::lock_guard<std::mutex> lckPoints(m_LockPoints);
+
+	//Points are only added after the last one, a reader behind it makes none
+	uint64_t qwLast = m_Points.empty() ? 0 : m_Points.back().qwOut;
+	return (qwLast + m_dwInterval) <= qwOut;
+}
+
+void CPckEntryCheckpoints::Add(PCK_CHECKPOINT &&cPoint)
+{
+	std::lock_guard<std::mutex> lckPoints(m_LockPoints);
+
+	//Another reader got there first
+	uint64_t qwLast = m_Points.empty() ? 0 : m_Points.back().qwOut;
+	if ((qwLast + m_dwInterval) > cPoint.qwOut)
+		return;
+
+	m_Points.push_back(std::move(cPoint));
+}
+
+uint32_t CPckEntryCheckpoints::GetCount()
+{
+	std::lock_guard<std::mutex> lckPoints(m_LockPoints);
+	return (uint32_t)m_Points.size();
+}
+
+void CPckEntryCheckpoints::CopyTo(std::vector<const PCK_CHECKPOINT*> &lpPoints)
+{
+	std::lock_guard<std::mutex> lckPoints(m_LockPoints);
+
+	lpPoints.clear();
+	for (const PCK_CHECKPOINT &cPoint : m_Points)
+		lpPoints.push_back(&cPoint);
+}
+
+#pragma endregion
+
+#pragma region CPckCheckpointIndex
+
+CPckCheckpointIndex::CPckCheckpointIndex() :
+	m_isLoaded(FALSE),
+	m_dwInterval(0)
+{}
+
+void CPckCheckpointIndex::SetInterval(uint32_t dwInterval)
+{
+	if ((0 != dwInterval) && (CHECKPOINT_MIN_INTERVAL > dwInterval))
+		dwInterval = CHECKPOINT_MIN_INTERVAL;
+
+	if (dwInterval == m_dwInterval)
+		return;
+
+	Clear();
+	m_dwInterval = dwInterval;
+}
+
+uint32_t CPckCheckpointIndex::GetInterval()
+{
+	return m_dwInterval;
+}
+
+std::shared_ptr<CPckEntryCheckpoints> CPckCheckpointIndex::Get(const wchar_t *lpszPckFile, uint64_t qwPckSize, const PCKFILEINDEX *lpFileIndex)
+{
+	uint32_t dwInterval = m_dwInterval;
+
+	if ((0 == dwInterval) || (dwInterval >= lpFileIndex->dwFileClearTextSize))
+		return nullptr;
+
+	std::lock_guard<std::mutex> lckIndex(m_LockIndex);
+
+	if (!m_isLoaded) {
+		m_isLoaded = TRUE;
+		Load(lpszPckFile, qwPckSize);
+	}
+
+	CHECKPOINT_ITEM &cItem = m_mapItems[lpFileIndex->dwAddressOffset];
+
+	//A new file, or another file was written at the offset
+	if ((nullptr == cItem.lpCheckpoints) ||
+		(cItem.dwFileClearTextSize != lpFileIndex->dwFileClearTextSize) ||
+		(cItem.dwFileCipherTextSize != lpFileIndex->dwFileCipherTextSize)) {
+
+		cItem.dwFileClearTextSize = lpFileIndex->dwFileClearTextSize;
+		cItem.dwFileCipherTextSize = lpFileIndex->dwFileCipherTextSize;
+		cItem.lpCheckpoints = std::make_shared<CPckEntryCheckpoints>(dwInterval);
+	}
+
+	return cItem.lpCheckpoints;
+}
+
+BOOL CPckCheckpointIndex::Save(const wchar_t *lpszPckFile, uint64_t qwPckSize)
+{
+	std::wstring szIndexFile = std::wstring(lpszPckFile) + CHECKPOINT_FILE_EXT;
+
+	std::vector<char> data;
+	auto append = [&data](const void *buffer, size_t nSize) {
+		data.insert(data.end(), (const char*)buffer, (const char*)buffer + nSize);
+	};
+
+	CHECKPOINT_FILE_HEAD cHead = { 0 };
+	memcpy(cHead.szMagic, CHECKPOINT_FILE_MAGIC, sizeof(cHead.szMagic));
+	cHead.qwPckSize = qwPckSize;
+	cHead.qwPckWriteTime = GetPckWriteTime(lpszPckFile);
+	cHead.dwInterval = m_dwInterval;
+	append(&cHead, sizeof(cHead));
+
+	uint32_t dwPointCount = 0;
+	std::vector<const PCK_CHECKPOINT*> lpPoints;
+	std::vector<uint8_t> packed(compressBound(CHECKPOINT_WINDOW_SIZE));
+
+	{
+		std::lock_guard<std::mutex> lckIndex(m_LockIndex);
+
+		for (auto &it : m_mapItems) {
+
+			it.second.lpCheckpoints->CopyTo(lpPoints);
+			if (lpPoints.empty())
+				continue;
+
+			CHECKPOINT_FILE_ITEM cItem = { it.first, it.second.dwFileClearTextSize, it.second.dwFileCipherTextSize, (uint32_t)lpPoints.size() };
+			append(&cItem, sizeof(cItem));
+
+			for (const PCK_CHECKPOINT *lpPoint : lpPoints) {
+
+				uLongf dwPackedSize = (uLongf)packed.size();
+				if (Z_OK != compress(packed.data(), &dwPackedSize, lpPoint->lpWindow.data(), (uLong)lpPoint->lpWindow.size()))
+					return FALSE;
+
+				CHECKPOINT_FILE_POINT cPoint = { lpPoint->qwOut, lpPoint->dwIn, lpPoint->iBits, (uint32_t)lpPoint->lpWindow.size(), (uint32_t)dwPackedSize };
+				append(&cPoint, sizeof(cPoint));
+				append(packed.data(), dwPackedSize);
+			}
+
+			++cHead.dwItemCount;
+			dwPointCount += (uint32_t)lpPoints.size();
+		}
+	}
+
+	cHead.dwBodyCrc = crc32(0L, (const Bytef*)data.data() + sizeof(cHead), (uInt)(data.size() - sizeof(cHead)));
+	memcpy(data.data(), &cHead, sizeof(cHead));
+
+	CMapViewFileWrite cFileWrite;
+
+	if (!cFileWrite.Open(szIndexFile.c_str(), CREATE_ALWAYS)) {
+		Logger_el(UCSTEXT(TEXT_OPENWRITENAME_FAIL), szIndexFile.c_str());
+		return FALSE;
+	}
+
+	if (data.size() != cFileWrite.Write(data.data(), (DWORD)data.size())) {
+		Logger_el(TEXT_WRITEFILE_FAIL);
+		return FALSE;
+	}
+
+	Logger.i(TEXT_LOG_CHECKPOINT_SAVE, dwPointCount, cHead.dwItemCount, szIndexFile.c_str());
+	return TRUE;
+}
+
+BOOL CPckCheckpointIndex::Load(const wchar_t *lpszPckFile, uint64_t qwPckSize)
+{
+	std::wstring szIndexFile = std::wstring(lpszPckFile) + CHECKPOINT_FILE_EXT;
+
+	CMapViewFileRead cFileRead;
+
+	if (!cFileRead.FileExists(szIndexFile.c_str()))
+		return FALSE;
+
+	if (!cFileRead.Open(szIndexFile.c_str())) {
+		Logger_el(UCSTEXT(TEXT_OPENNAME_FAIL), szIndexFile.c_str());
+		return FALSE;
+	}
+
+	std::vector<char> data((size_t)cFileRead.GetFileSize());
+	if (data.size() != cFileRead.Read(data.data(), (DWORD)data.size())) {
+		Logger_el(TEXT_READFILE_FAIL);
+		return FALSE;
+	}
+
+	size_t nOffset = 0;
+	auto take = [&data, &nOffset](void *buffer, size_t nSize) -> BOOL {
+		if ((data.size() - nOffset) < nSize)
+			return FALSE;
+		memcpy(buffer, data.data() + nOffset, nSize);
+		nOffset += nSize;
+		return TRUE;
+	};
+
+	CHECKPOINT_FILE_HEAD cHead;
+
+	//Written for another version of the pck, the data of its files may have moved
+	if (!take(&cHead, sizeof(cHead)) || (0 != memcmp(cHead.szMagic, CHECKPOINT_FILE_MAGIC, sizeof(cHead.szMagic))) ||
+		(qwPckSize != cHead.qwPckSize) || (0 == cHead.qwPckWriteTime) || (GetPckWriteTime(lpszPckFile) != cHead.qwPckWriteTime) ||
+		(cHead.dwBodyCrc != crc32(0L, (const Bytef*)data.data() + nOffset, (uInt)(data.size() - nOffset)))) {
+		Logger.w(TEXT_CHECKPOINT_FILE_INVALID, szIndexFile.c_str());
+		return FALSE;
+	}
+
+	//The points are kept only when the whole file is read
+	std::unordered_map<uint64_t, CHECKPOINT_ITEM> mapItems;
+	uint32_t dwPointCount = 0;
+	std::vector<uint8_t> packed;
+
+	for (uint32_t i = 0; i < cHead.dwItemCount; i++) {
+
+		CHECKPOINT_FILE_ITEM cFileItem;
+		if (!take(&cFileItem, sizeof(cFileItem))) {
+			Logger.w(TEXT_CHECKPOINT_FILE_INVALID, szIndexFile.c_str());
+			return FALSE;
+		}
+
+		CHECKPOINT_ITEM &cItem = mapItems[cFileItem.qwAddressOffset];
+		cItem.dwFileClearTextSize = (ulong_t)cFileItem.qwFileClearTextSize;
+		cItem.dwFileCipherTextSize = (ulong_t)cFileItem.qwFileCipherTextSize;
+		cItem.lpCheckpoints = std::make_shared<CPckEntryCheckpoints>(m_dwInterval);
+
+		for (uint32_t j = 0; j < cFileItem.dwPointCount; j++) {
+
+			CHECKPOINT_FILE_POINT cFilePoint;
+			if (!take(&cFilePoint, sizeof(cFilePoint)) || (CHECKPOINT_WINDOW_SIZE < cFilePoint.dwWindowSize) ||
+				(0 > cFilePoint.iBits) || (7 < cFilePoint.iBits) || (0 == cFilePoint.dwIn) || (cFilePoint.dwIn >= cFileItem.qwFileCipherTextSize)) {
+				Logger.w(TEXT_CHECKPOINT_FILE_INVALID, szIndexFile.c_str());
+				return FALSE;
+			}
+
+			packed.resize(cFilePoint.dwPackedSize);
+			if (!take(packed.data(), packed.size())) {
+				Logger.w(TEXT_CHECKPOINT_FILE_INVALID, szIndexFile.c_str());
+				return FALSE;
+			}
+
+			PCK_CHECKPOINT cPoint;
+			cPoint.qwOut = cFilePoint.qwOut;
+			cPoint.dwIn = cFilePoint.dwIn;
+			cPoint.iBits = cFilePoint.iBits;
+			cPoint.lpWindow.resize(cFilePoint.dwWindowSize);
+
+			uLongf dwWindowSize = cFilePoint.dwWindowSize;
+			if ((Z_OK != uncompress(cPoint.lpWindow.data(), &dwWindowSize, packed.data(), (uLong)packed.size())) || (dwWindowSize != cFilePoint.dwWindowSize)) {
+				Logger.w(TEXT_CHECKPOINT_FILE_INVALID, szIndexFile.c_str());
+				return FALSE;
+			}
+
+			cItem.lpCheckpoints->Add(std::move(cPoint));
+			++dwPointCount;
+		}
+	}
+
+	m_mapItems = std::move(mapItems);
+
+	Logger.i(TEXT_LOG_CHECKPOINT_LOAD, dwPointCount, cHead.dwItemCount, szIndexFile.c_str());
+	return TRUE;
+}
+
+void CPckCheckpointIndex::Clear()
+{
+	std::lock_guard<std::mutex> lckIndex(m_LockIndex);
+
+	//Open virtual files keep the points they use
+	m_mapItems.clear();
+	m_isLoaded = FALSE;
+}
+
+#pragma endregion
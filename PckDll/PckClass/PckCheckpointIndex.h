@@ -0,0 +1,102 @@
+//////////////////////////////////////////////////////////////////////
+// PckCheckpointIndex.h: random access points in the data of large compressed files
+//
+// A checkpoint is the state of the inflater at the end of a deflate block:
+// the offsets in the compressed and the decompressed data and the last 32KB
+// of output. The inflater restarts there without the data in front of it
+// (as zran.c of zlib), so a read deep in a file inflates at most one interval.
+// The points of a file are made while it is read and shared by every reader,
+// they can be saved next to the pck and are loaded when it is opened again
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "pck_default_vars.h"
+#include "PckStructs.h"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#define CHECKPOINT_WINDOW_SIZE			32768
+//Smaller intervals would keep more window than data
+#define CHECKPOINT_MIN_INTERVAL			(256 * 1024)
+//The saved index is the pck file name with this appended
+#define CHECKPOINT_FILE_EXT				L".ckpt"
+
+typedef struct _PCK_CHECKPOINT
+{
+	uint64_t				qwOut;		//Decompressed offset
+	uint32_t				dwIn;		//Offset of the first full byte in the compressed data
+	int32_t					iBits;		//Bits of the byte before dwIn that belong to the next block
+	std::vector<uint8_t>	lpWindow;
+}PCK_CHECKPOINT;
+
+//The checkpoints of one file
+class CPckEntryCheckpoints
+{
+public:
+	CPckEntryCheckpoints(uint32_t dwInterval);
+	~CPckEntryCheckpoints() = default;
+
+	//Last point at or before qwPosition or NULL, a point is never changed or removed once it is added
+	const PCK_CHECKPOINT*	Find(uint64_t qwPosition);
+	//Points are kept one interval apart, the inflater asks before it copies the window
+	BOOL	IsWanted(uint64_t qwOut);
+	void	Add(PCK_CHECKPOINT &&cPoint);
+
+	uint32_t	GetCount();
+	//Copy of the points for saving
+	void	CopyTo(std::vector<const PCK_CHECKPOINT*> &lpPoints);
+
+private:
+	std::mutex					m_LockPoints;
+	//A deque keeps the points where they are while more are added
+	std::deque<PCK_CHECKPOINT>	m_Points;
+	uint32_t					m_dwInterval;
+};
+
+//The checkpoints of the files of one pck
+class CPckCheckpointIndex
+{
+public:
+	CPckCheckpointIndex();
+	~CPckCheckpointIndex() = default;
+
+	//Decompressed bytes between two points, 0 - disabled, the points made before are dropped
+	void		SetInterval(uint32_t dwInterval);
+	uint32_t	GetInterval();
+	BOOL		IsEnabled() { return 0 != m_dwInterval; }
+
+	//Points of the file, NULL when disabled or the file is smaller than an interval.
+	//The first call loads the saved index of the pck
+	std::shared_ptr<CPckEntryCheckpoints>	Get(const wchar_t *lpszPckFile, uint64_t qwPckSize, const PCKFILEINDEX *lpFileIndex);
+
+	//Write the points to lpszPckFile + CHECKPOINT_FILE_EXT
+	BOOL		Save(const wchar_t *lpszPckFile, uint64_t qwPckSize);
+
+	//The keys are the offsets of the data, call this when the pck is changed or closed
+	void		Clear();
+
+private:
+
+	typedef struct _CHECKPOINT_ITEM
+	{
+		ulong_t		dwFileClearTextSize;
+		ulong_t		dwFileCipherTextSize;
+		std::shared_ptr<CPckEntryCheckpoints>	lpCheckpoints;
+	}CHECKPOINT_ITEM;
+
+	//The saved index is used only when the pck has the size and write time it had and
+	//its crc is right, nothing of it is kept when a part can not be read
+	BOOL		Load(const wchar_t *lpszPckFile, uint64_t qwPckSize);
+
+	std::mutex	m_LockIndex;
+	std::unordered_map<uint64_t, CHECKPOINT_ITEM>	m_mapItems;
+	BOOL		m_isLoaded;
+	std::atomic<uint32_t>	m_dwInterval;
+};
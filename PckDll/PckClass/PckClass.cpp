@@ -29,7 +29,9 @@ CPckClass::~CPckClass()
 
 BOOL CPckClass::Init(LPCWSTR	szFile)
 {
-	wcscpy_s(m_PckAllInfo.szFilename, szFile);
+	//Extracting changes the current directory, the file is opened again by its full path
+	if(0 == GetFullPathNameW(szFile, MAX_PATH, m_PckAllInfo.szFilename, NULL))
+		wcscpy_s(m_PckAllInfo.szFilename, szFile);
 	GetFileTitleW(m_PckAllInfo.szFilename, m_PckAllInfo.szFileTitle, MAX_PATH);
 
 	if(!MountPckFile(m_PckAllInfo.szFilename)) {
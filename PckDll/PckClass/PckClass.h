@@ -11,10 +11,13 @@
 //////////////////////////////////////////////////////////////////////
 
 #include <assert.h>
+#include <string>
+#include <vector>
 #include "pck_default_vars.h"
 
 #include "PckClassVersionDetect.h"
 #include "PckClassWriteOperator.h"
+#include "PckVirtualFile.h"
 
 #if !defined(_PCKCLASS_H_)
 #define _PCKCLASS_H_
@@ -34,21 +37,39 @@ public:
 
 	BOOL	ExtractFiles(const PCK_UNIFIED_FILE_ENTRY **lpFileEntryArray, int nEntryCount, const wchar_t *lpszDestDirectory);
 	BOOL	ExtractAllFiles(const wchar_t *lpszDestDirectory);
+	//Decompress every file without writing it, FALSE if one of them is damaged
+	BOOL	VerifyAllFiles();
 
 private:
-	//unzip files
-	BOOL	ExtractFiles(const PCKINDEXTABLE **lpIndexToExtract, int nFileCount);
-	BOOL	ExtractFiles(const PCK_PATH_NODE **lpNodeToExtract, int nFileCount);
+	//unzip files, the paths are made from szDestDirectory, the current directory of the process is not changed
+	BOOL	ExtractFiles(const PCKINDEXTABLE **lpIndexToExtract, int nFileCount, const std::wstring &szDestDirectory);
+	BOOL	ExtractFiles(const PCK_PATH_NODE **lpNodeToExtract, int nFileCount, const std::wstring &szDestDirectory);
 
 public:
 	//Preview file
 	virtual BOOL	GetSingleFileData(const PCKINDEXTABLE* const lpPckFileIndexTable, char *buffer, size_t sizeOfBuffer = 0);
+	//Preview many files, they are read by several threads that each open the pck once
+	//lpStatus[i] = PCK_OK or error code, return the number of files read successfully
+	uint32_t		GetBatchFileData(const PCKINDEXTABLE **lpIndexArray, int nCount, char **lpBuffers, const size_t *lpSizeOfBuffers, int *lpStatus);
+	//Read the file a part at a time, cFile does not use this object after it is opened
+	virtual BOOL	OpenVirtualFile(const PCKINDEXTABLE* const lpPckFileIndexTable, CPckVirtualFile &cFile);
 protected:
 	virtual BOOL	GetSingleFileData(LPVOID lpvoidFileRead, const PCKINDEXTABLE* const lpPckFileIndexTable, char *buffer, size_t sizeOfBuffer = 0);
 private:
 	//PckClassExtract.cpp
-	BOOL	StartExtract(LPPCK_PATH_NODE lpNodeToExtract, LPVOID lpMapAddress);
+	typedef struct _EXTRACT_FILE
+	{
+		std::wstring			szPath;
+		const PCKINDEXTABLE		*lpIndex;
+	}EXTRACT_FILE;
+
+	//Creates the folders under lpNode and lists its files, FALSE if canceled
+	BOOL	CollectExtractFiles(const PCK_PATH_NODE *lpNode, const std::wstring &szDirectory, std::vector<EXTRACT_FILE> &lpFiles);
+	//The listed files are decompressed by the worker pool, each thread opens the pck once
+	BOOL	ExtractListedFiles(const std::vector<EXTRACT_FILE> &lpFiles);
 	BOOL	DecompressFile(const wchar_t * lpszFilename, const PCKINDEXTABLE* lpPckFileIndexTable, LPVOID lpvoidFileRead);
+	//Index entries of the files under lpNode and its sub folders
+	static void	CollectFiles(const PCK_PATH_NODE *lpNode, std::vector<const PCKINDEXTABLE*> &lpIndexArray);
 #pragma endregion
 
 #pragma region PckClassMount.cpp
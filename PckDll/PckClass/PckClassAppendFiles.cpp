@@ -5,8 +5,50 @@
 BOOL CPckClassWriteOperator::UpdatePckFile(const wchar_t * szPckFile, const vector<wstring> &lpszFilePath, const PCK_PATH_NODE* lpNodeToInsert)
 {
 	DWORD		dwNewFileCount = 0;			//Number of files, number of files in the original pck file
+	QWORD		qwTotalNewFileSize = 0;		//All file sizes when uncompressed
+
+	m_FilesToBeAdded.clear();
+	m_PckAllInfo.lpFilesToBeAdded = &m_FilesToBeAdded;
+
+#pragma region Traverse the files to be added 
+	if(!EnumAllFilesByPathList(lpszFilePath, dwNewFileCount, qwTotalNewFileSize, m_PckAllInfo.lpFilesToBeAdded))
+		return FALSE;
+
+	if(0 == dwNewFileCount)return TRUE;
+#pragma endregion
+
+	return WriteFilesToBeAdded(szPckFile, lpNodeToInsert, dwNewFileCount, qwTotalNewFileSize, DATA_FROM_FILE, NULL);
+}
+
+//Add the files of a zup, lpZupFiles is filled by CZupClass::GetFilesToApply and emptied here
+BOOL CPckClassWriteOperator::UpdatePckFileFromZup(const wchar_t * szPckFile, const wchar_t * szZupFile, vector<FILES_TO_COMPRESS> &lpZupFiles, const PCK_PATH_NODE* lpNodeToInsert)
+{
+	QWORD		qwTotalNewFileSize = 0;
+
+	m_FilesToBeAdded.clear();
+	m_FilesToBeAdded.swap(lpZupFiles);
+	m_PckAllInfo.lpFilesToBeAdded = &m_FilesToBeAdded;
+
+	for(const FILES_TO_COMPRESS &cFile : m_FilesToBeAdded)
+		qwTotalNewFileSize += cFile.qwFileSize;
+
+	DWORD		dwNewFileCount = m_FilesToBeAdded.size();
+
+	if(0 == dwNewFileCount)return TRUE;
+
+	CMapViewFileMultiPckRead	cZupRead;
+
+	if(!cZupRead.OpenPckAndMappingRead(szZupFile)) {
+		Logger_el(UCSTEXT(TEXT_OPENNAME_FAIL), szZupFile);
+		return FALSE;
+	}
+
+	return WriteFilesToBeAdded(szPckFile, lpNodeToInsert, dwNewFileCount, qwTotalNewFileSize, DATA_FROM_ZUP, &cZupRead);
+}
+
+BOOL CPckClassWriteOperator::WriteFilesToBeAdded(const wchar_t * szPckFile, const PCK_PATH_NODE* lpNodeToInsert, DWORD dwNewFileCount, QWORD qwTotalNewFileSize, int iDataSource, CMapViewFileMultiPckRead *lpZupRead)
+{
 	DWORD		dwDuplicateFileCount = 0;
-	uint64_t		qwTotalNewFileSize = 0;						//All file sizes when uncompressed
 
 	int			level = m_lpPckParams->dwCompressLevel;
 	int			threadnum = m_lpPckParams->dwMTThread;
@@ -23,9 +65,6 @@ BOOL CPckClassWriteOperator::UpdatePckFile(const wchar_t * szPckFile, const vect
 
 
 #pragma region Setting parameters
-	
-	m_FilesToBeAdded.clear();
-	m_PckAllInfo.lpFilesToBeAdded = &m_FilesToBeAdded;
 
 	if(m_PckAllInfo.isPckFileLoaded) {
 
@@ -65,14 +104,7 @@ BOOL CPckClassWriteOperator::UpdatePckFile(const wchar_t * szPckFile, const vect
 
 #pragma endregion
 
-#pragma region Traverse the files to be added 
-	if(!EnumAllFilesByPathList(lpszFilePath, dwNewFileCount, qwTotalNewFileSize, m_PckAllInfo.lpFilesToBeAdded))
-		return FALSE;
-
-	if(0 == dwNewFileCount)return TRUE;
-
 	m_PckAllInfo.dwFileCountToAdd = dwNewFileCount;
-#pragma endregion
 	//Parameter Description
 	// mt_dwFileCount	Total number of files added, including duplicates
 	// dwFileCount		The calculation process uses parameters. This parameter will be used in the following calculation process to represent the total number of files added, excluding duplicates.
@@ -114,7 +146,8 @@ BOOL CPckClassWriteOperator::UpdatePckFile(const wchar_t * szPckFile, const vect
 	cThreadParams.cDataFetchMethod.ciFilesListEnd = m_PckAllInfo.lpFilesToBeAdded->cend();
 
 	cThreadParams.lpFileWrite = &cFileWriter;
-	cThreadParams.pck_data_src = DATA_FROM_FILE;
+	cThreadParams.pck_data_src = (PCK_DATA_SOURCE)iDataSource;
+	cThreadParams.cDataFetchMethod.lpFileReadPCK = lpZupRead;
 	cThreadParams.dwFileCountOfWriteTarget = dwNewFileCount;
 	cThreadParams.lpPckClassThreadWorker = this;
 	cThreadParams.dwAddressStartAt = dwAddressWhereToAppendData;
@@ -125,15 +158,29 @@ BOOL CPckClassWriteOperator::UpdatePckFile(const wchar_t * szPckFile, const vect
 	m_PckAllInfo.dwFileCount = m_PckAllInfo.dwFileCountOld - dwDuplicateFileCount;
 
 	CPckThreadRunner m_threadRunner(&cThreadParams);
-	m_threadRunner.start();
+	BOOL isIndexWritten = m_threadRunner.start();
 
-	//Re-open it here, or open it directly, which is completed by the interface thread
 	m_lpPckParams->cVarParams.dwOldFileCount = m_PckAllInfo.dwFileCountOld;
 	m_lpPckParams->cVarParams.dwPrepareToAddFileCount = dwNewFileCount;
 	m_lpPckParams->cVarParams.dwChangedFileCount = m_PckAllInfo.dwFileCountToAdd;
 	m_lpPckParams->cVarParams.dwDuplicateFileCount = dwDuplicateFileCount;
 	m_lpPckParams->cVarParams.dwFinalFileCount = m_PckAllInfo.dwFinalFileCount;
 
+	//The written index is merged into the loaded one instead of opening the pck again,
+	//if that can not be done the loaded pck is out of date and has to be opened again
+	if(m_PckAllInfo.isPckFileLoaded) {
+
+		wchar_t szFullNewFilename[MAX_PATH];
+		if(0 == GetFullPathNameW(m_PckAllInfo.szNewFilename, MAX_PATH, szFullNewFilename, NULL))
+			wcscpy_s(szFullNewFilename, m_PckAllInfo.szNewFilename);
+
+		if(!(isIndexWritten && (0 == wcscmp(szFullNewFilename, m_PckAllInfo.szFilename)) && MergeAddedIndex())) {
+
+			Logger.w(TEXT_UPDATE_INDEX_NOT_MERGED);
+			m_PckAllInfo.isPckFileLoaded = FALSE;
+		}
+	}
+
 	Logger.i(TEXT_LOG_WORKING_DONE);
 
 	return TRUE;
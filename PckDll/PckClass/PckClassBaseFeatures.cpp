@@ -1,5 +1,7 @@
 //#include <Windows.h>
 #include "PckClassBaseFeatures.h"
+#include "PckTaskEvents.h"
+#include <atomic>
 #include <cstring>
 //#include <tchar.h>
 
@@ -42,6 +44,11 @@ uint64_t CPckClassBaseFeatures::GetPckSize()
 	return m_PckAllInfo.qwPckSize;
 }
 
+const wchar_t* CPckClassBaseFeatures::GetPckFilename()
+{
+	return m_PckAllInfo.szFilename;
+}
+
 uint32_t CPckClassBaseFeatures::GetPckFileCount()
 {
 	return m_PckAllInfo.dwFileCount;
@@ -59,25 +66,41 @@ uint64_t CPckClassBaseFeatures::GetPckRedundancyDataSize()
 
 
 #pragma region UI_Params
+typedef std::atomic_ref<uint32_t>	PROGRESS_REF;
+
 void CPckClassBaseFeatures::SetParams_ProgressInc()
 {
-	++m_lpPckParams->cVarParams.dwUIProgress;
+	uint32_t dwUIProgress = PROGRESS_REF(m_lpPckParams->cVarParams.dwUIProgress).fetch_add(1, std::memory_order_relaxed) + 1;
+
+	if (nullptr != m_lpPckParams->lpTaskEvents)
+		m_lpPckParams->lpTaskEvents->Progress(dwUIProgress, PROGRESS_REF(m_lpPckParams->cVarParams.dwUIProgressUpper).load(std::memory_order_relaxed));
 }
 void CPckClassBaseFeatures::SetParams_Progress(DWORD dwUIProgress)
 {
-	m_lpPckParams->cVarParams.dwUIProgress = dwUIProgress;
+	PROGRESS_REF(m_lpPckParams->cVarParams.dwUIProgress).store(dwUIProgress, std::memory_order_relaxed);
 }
 
 void CPckClassBaseFeatures::SetParams_ProgressUpper(DWORD dwUIProgressUpper, BOOL bReset)
 {
 	if(bReset)
-		m_lpPckParams->cVarParams.dwUIProgress = 0;
-	m_lpPckParams->cVarParams.dwUIProgressUpper = dwUIProgressUpper;
+		PROGRESS_REF(m_lpPckParams->cVarParams.dwUIProgress).store(0, std::memory_order_relaxed);
+	PROGRESS_REF(m_lpPckParams->cVarParams.dwUIProgressUpper).store(dwUIProgressUpper, std::memory_order_relaxed);
 }
 
 void CPckClassBaseFeatures::AddParams_ProgressUpper(DWORD dwUIProgressUpperAdd)
 {
-	m_lpPckParams->cVarParams.dwUIProgressUpper += dwUIProgressUpperAdd;
+	PROGRESS_REF(m_lpPckParams->cVarParams.dwUIProgressUpper).fetch_add(dwUIProgressUpperAdd, std::memory_order_relaxed);
+}
+
+void CPckClassBaseFeatures::SetParams_Stage(int iStage)
+{
+	//Index writes of rename and delete are not tasks
+	if ((nullptr == m_lpPckParams->lpTaskEvents) || !std::atomic_ref<BOOL>(m_lpPckParams->cVarParams.bThreadRunning).load())
+		return;
+
+	m_lpPckParams->lpTaskEvents->SetStage(iStage,
+		PROGRESS_REF(m_lpPckParams->cVarParams.dwUIProgress).load(std::memory_order_relaxed),
+		PROGRESS_REF(m_lpPckParams->cVarParams.dwUIProgressUpper).load(std::memory_order_relaxed));
 }
 #pragma endregion
 
@@ -87,8 +110,27 @@ void CPckClassBaseFeatures::SetThreadFlag(BOOL isThreadWorking)
 	//if (FALSE == isThreadWorking)
 	//After starting and ending the task, set the force exit flag to 0
 	//m_lpPckParams->cVarParams.bForcedStopWorking = FALSE;
+	int iResult = m_lpPckParams->cVarParams.errMessageNo;
 	SetErrMsgFlag(PCK_OK);
-	m_lpPckParams->cVarParams.bThreadRunning = isThreadWorking;
+
+	CPckTaskEvents *lpTaskEvents = m_lpPckParams->lpTaskEvents;
+
+	if (isThreadWorking && (nullptr != lpTaskEvents))
+		lpTaskEvents->Begin();
+
+	BOOL isWasWorking = std::atomic_ref<BOOL>(m_lpPckParams->cVarParams.bThreadRunning).exchange(isThreadWorking);
+
+	//The threads of the task log without waiting, all of it is shown when the task ends
+	if (isThreadWorking && !isWasWorking)
+		Logger.BeginAsync();
+	else if (!isThreadWorking && isWasWorking)
+		Logger.EndAsync();
+
+	//The result of the task is cleared above for the next one, the callback still gets it
+	if (!isThreadWorking && (nullptr != lpTaskEvents))
+		lpTaskEvents->End(iResult,
+			PROGRESS_REF(m_lpPckParams->cVarParams.dwUIProgress).load(std::memory_order_relaxed),
+			PROGRESS_REF(m_lpPckParams->cVarParams.dwUIProgressUpper).load(std::memory_order_relaxed));
 }
 
 BOOL CPckClassBaseFeatures::CheckIfNeedForcedStopWorking()
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include "PckHeader.h"
 #include "PckClassLog.h"
+#include "PckClassProfiler.h"
 
 #include "AllocMemPool.h"
 #include "PckClassZlib.h"
@@ -22,6 +23,7 @@ public:
 
 	//File size
 	uint64_t	GetPckSize();
+	const wchar_t*	GetPckFilename();
 
 	//Get the number of files
 	uint32_t	GetPckFileCount();
@@ -44,6 +46,9 @@ protected:
 	void	SetParams_ProgressUpper(DWORD dwUIProgressUpper, BOOL bReset = TRUE);
 	void	AddParams_ProgressUpper(DWORD dwUIProgressUpperAdd);
 
+	//A stage of the running task started, PCK_STAGE_*
+	void	SetParams_Stage(int iStage);
+
 	//multi-threaded process
 	void	SetThreadFlag(BOOL isThreadWorking);
 	BOOL	CheckIfNeedForcedStopWorking();
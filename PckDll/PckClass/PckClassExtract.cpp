@@ -11,6 +11,11 @@
 //////////////////////////////////////////////////////////////////////
 #pragma warning ( disable : 4267 )
 #include "PckClass.h"
+#include "PckWorkerPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
 
 BOOL CPckClass::GetSingleFileData(const PCKINDEXTABLE* const lpPckFileIndexTable, char *buffer, size_t sizeOfBuffer)
 {
@@ -22,6 +27,11 @@ BOOL CPckClass::GetSingleFileData(const PCKINDEXTABLE* const lpPckFileIndexTable
 	return CPckClass::GetSingleFileData(&cFileRead, lpPckFileIndexTable, buffer, sizeOfBuffer);
 }
 
+BOOL CPckClass::OpenVirtualFile(const PCKINDEXTABLE* const lpPckFileIndexTable, CPckVirtualFile &cFile)
+{
+	return cFile.OpenStream(m_PckAllInfo.szFilename, &lpPckFileIndexTable->cFileIndex);
+}
+
 BOOL CPckClass::GetSingleFileData(LPVOID lpvoidFileRead, const PCKINDEXTABLE* const lpPckFileIndexTable, char *buffer, size_t sizeOfBuffer)
 {
 
@@ -39,7 +49,10 @@ BOOL CPckClass::GetSingleFileData(LPVOID lpvoidFileRead, const PCKINDEXTABLE* co
 	if(0 != sizeOfBuffer && sizeOfBuffer < dwFileLengthToWrite)
 		dwFileLengthToWrite = sizeOfBuffer;
 
-	if(m_zlib.check_zlib_header(lpMapAddress)) {
+	//A stored file of one byte has no room for a zlib header
+	if((2 <= lpPckFileIndex->dwFileCipherTextSize) && m_zlib.check_zlib_header(lpMapAddress)) {
+
+		CPckProfileScope cProfile(PROFILE_INFLATE, dwFileLengthToWrite);
 
 		ulong_t ulFileLengthToWrite = dwFileLengthToWrite;
 		if(Z_OK != m_zlib.decompress_part((BYTE*)buffer, &ulFileLengthToWrite,
@@ -65,33 +78,82 @@ BOOL CPckClass::GetSingleFileData(LPVOID lpvoidFileRead, const PCKINDEXTABLE* co
 	return TRUE;
 }
 
-BOOL CPckClass::ExtractFiles(const PCKINDEXTABLE **lpIndexToExtract, int nFileCount)
+uint32_t CPckClass::GetBatchFileData(const PCKINDEXTABLE **lpIndexArray, int nCount, char **lpBuffers, const size_t *lpSizeOfBuffers, int *lpStatus)
 {
+	if (0 >= nCount)
+		return 0;
 
-	Logger.i(TEXT_LOG_EXTRACT);
+	std::atomic<int>		iNextIndex(0);
+	std::atomic<uint32_t>	dwSuccessCount(0);
 
-	//First set up the progress bar
-	SetParams_ProgressUpper(nFileCount, TRUE);
+	int threadnum = (int)std::min<uint32_t>(std::max<uint32_t>(m_lpPckParams->dwMTThread, 1), nCount);
 
-	CMapViewFileMultiPckRead	cFileRead;
+	auto ReadFiles = [&]() {
 
-	if(!cFileRead.OpenPckAndMappingRead(m_PckAllInfo.szFilename)) 
-		return FALSE;
+		CMapViewFileMultiPckRead	cFileRead;
+		BOOL isOpened = cFileRead.OpenPckAndMappingRead(m_PckAllInfo.szFilename);
 
-	BOOL	ret = TRUE;
+		if (!isOpened)
+			Logger_el(UCSTEXT(TEXT_OPENNAME_FAIL), m_PckAllInfo.szFilename);
 
-	wchar_t	szFilename[MAX_PATH_PCK_260], *szStrchr;
+		int i;
+		while (nCount > (i = iNextIndex++)) {
 
-	const PCKINDEXTABLE **lpIndexToExtractPtr = lpIndexToExtract;
+			const PCKINDEXTABLE* lpIndex = lpIndexArray[i];
+			int status;
 
-	for(int i = 0;i < nFileCount;i++) {
-		if(CheckIfNeedForcedStopWorking()) {
-			Logger.w(TEXT_USERCANCLE);
+			if ((NULL == lpIndex) || (NULL == lpBuffers[i]))
+				status = PCK_ERR_NOT_FILE;
+			else if (!isOpened)
+				status = PCK_ERR_OPENMAPVIEWR;
+			//No data to view
+			else if (0 == lpIndex->cFileIndex.dwFileClearTextSize)
+				status = PCK_OK;
+			else
+				status = GetSingleFileData(&cFileRead, lpIndex, lpBuffers[i], (NULL == lpSizeOfBuffers) ? 0 : lpSizeOfBuffers[i]) ? PCK_OK : PCK_ERROR;
 
-			return FALSE;
+			if (PCK_OK == status)
+				++dwSuccessCount;
+
+			if (NULL != lpStatus)
+				lpStatus[i] = status;
 		}
+	};
+
+	CPckTaskGroup cReadTasks(threadnum);
+	for (int i = 1; i < threadnum; ++i)
+		cReadTasks.Run(ReadFiles);
+
+	ReadFiles();
+	cReadTasks.Wait();
+
+	return dwSuccessCount;
+}
+
+//szDirectory/lpszName, the separator is only added when szDirectory does not end with one
+static std::wstring JoinPath(const std::wstring &szDirectory, const wchar_t *lpszName)
+{
+	std::wstring szPath(szDirectory);
+
+	if ((!szPath.empty()) && (L'\\' != szPath.back()) && (L'/' != szPath.back()))
+		szPath.push_back(L'/');
+
+	return szPath.append(lpszName);
+}
+
+BOOL CPckClass::ExtractFiles(const PCKINDEXTABLE **lpIndexToExtract, int nFileCount, const std::wstring &szDestDirectory)
+{
+
+	Logger.i(TEXT_LOG_EXTRACT);
+
+	std::vector<EXTRACT_FILE> lpFiles;
+	lpFiles.reserve(nFileCount);
+
+	wchar_t	szFilename[MAX_PATH_PCK_260], *szStrchr;
 
-		wcscpy(szFilename, (*lpIndexToExtractPtr)->cFileIndex.szwFilename);
+	for(int i = 0;i < nFileCount;i++) {
+
+		wcscpy(szFilename, lpIndexToExtract[i]->cFileIndex.szwFilename);
 
 		szStrchr = szFilename;
 		for(int j = 0;j < MAX_PATH_PCK_260;j++) {
@@ -101,71 +163,129 @@ BOOL CPckClass::ExtractFiles(const PCKINDEXTABLE **lpIndexToExtract, int nFileCo
 			++szStrchr;
 		}
 
-		//unzip files
-		if(!(DecompressFile(szFilename, *lpIndexToExtractPtr, &cFileRead))) {
-			Logger_el(TEXT_UNCOMP_FAIL);
-			return FALSE;
-		} else {
-			//dwCount++;
-			SetParams_ProgressInc();
-		}
-
-		++lpIndexToExtractPtr;
+		lpFiles.push_back({ JoinPath(szDestDirectory, szFilename), lpIndexToExtract[i] });
 	}
 
+	if (!ExtractListedFiles(lpFiles))
+		return FALSE;
+
 	Logger.i(TEXT_LOG_WORKING_DONE);
-	return	ret;
+	return	TRUE;
 }
 
-BOOL CPckClass::ExtractFiles(const PCK_PATH_NODE **lpNodeToExtract, int nFileCount)
+BOOL CPckClass::ExtractFiles(const PCK_PATH_NODE **lpNodeToExtract, int nFileCount, const std::wstring &szDestDirectory)
 {
 
 	Logger.i(TEXT_LOG_EXTRACT);
 
-	//First set up the progress bar
-	SetParams_ProgressUpper(nFileCount, TRUE);
+	//The folders are created while the files are listed, the files are then written in parallel
+	std::vector<EXTRACT_FILE> lpFiles;
 
-	CMapViewFileMultiPckRead	cFileRead;
+	for(int i = 0;i < nFileCount;i++) {
+
+		const PCK_PATH_NODE *lpNode = lpNodeToExtract[i];
+		std::wstring szPath = JoinPath(szDestDirectory, lpNode->szName);
+
+		if(PCK_ENTRY_TYPE_FOLDER != (PCK_ENTRY_TYPE_FOLDER & lpNode->entryType)) {
+
+			lpFiles.push_back({ szPath, lpNode->lpPckIndexTable });
 
-	if(!cFileRead.OpenPckAndMappingRead(m_PckAllInfo.szFilename)) 
+		} else {
+
+			//The root node has no name, its files go to the destination itself
+			if (0 != *lpNode->szName)
+				CreateDirectoryW(szPath.c_str(), NULL);
+
+			if (!CollectExtractFiles(lpNode->child->next, szPath, lpFiles))
+				return FALSE;
+		}
+	}
+
+	if (!ExtractListedFiles(lpFiles))
 		return FALSE;
 
-	BOOL	ret = TRUE;
+	Logger.i(TEXT_LOG_WORKING_DONE);
+	return	TRUE;
+}
 
-	const PCK_PATH_NODE **lpNodeToExtractPtr = lpNodeToExtract;
+BOOL CPckClass::CollectExtractFiles(const PCK_PATH_NODE *lpNode, const std::wstring &szDirectory, std::vector<EXTRACT_FILE> &lpFiles)
+{
+	for (; NULL != lpNode; lpNode = lpNode->next) {
 
-	for(int i = 0;i < nFileCount;i++) {
-		if(CheckIfNeedForcedStopWorking()) {
+		if (CheckIfNeedForcedStopWorking()) {
 			Logger.w(TEXT_USERCANCLE);
 			return FALSE;
 		}
 
-		if(PCK_ENTRY_TYPE_FOLDER != (PCK_ENTRY_TYPE_FOLDER & (*lpNodeToExtractPtr)->entryType)) {
+		std::wstring szPath = JoinPath(szDirectory, lpNode->szName);
 
-			//unzip files
-			if(!(DecompressFile((*lpNodeToExtractPtr)->szName, (*lpNodeToExtractPtr)->lpPckIndexTable, &cFileRead))) {
-				Logger_el(TEXT_UNCOMP_FAIL);
+		if (PCK_ENTRY_TYPE_FOLDER == (PCK_ENTRY_TYPE_FOLDER & lpNode->entryType)) {
+
+			CreateDirectoryW(szPath.c_str(), NULL);
+
+			if (!CollectExtractFiles(lpNode->child->next, szPath, lpFiles))
 				return FALSE;
-			} else {
-				//dwCount++;
-				SetParams_ProgressInc();
+		}
+		else {
+			lpFiles.push_back({ szPath, lpNode->lpPckIndexTable });
+		}
+	}
+	return TRUE;
+}
+
+BOOL CPckClass::ExtractListedFiles(const std::vector<EXTRACT_FILE> &lpFiles)
+{
+	const uint32_t dwFileCount = (uint32_t)lpFiles.size();
+
+	//First set up the progress bar
+	SetParams_ProgressUpper(dwFileCount, TRUE);
+
+	std::atomic<uint32_t>	dwNextIndex(0);
+	//The first failure stops the other threads after their current file
+	std::atomic<BOOL>		isFailed(FALSE);
+
+	uint32_t threadnum = std::min<uint32_t>(std::max<uint32_t>(m_lpPckParams->dwMTThread, 1), std::max<uint32_t>(dwFileCount, 1));
+
+	auto ExtractFiles = [&]() {
+
+		CMapViewFileMultiPckRead	cFileRead;
+
+		if (!cFileRead.OpenPckAndMappingRead(m_PckAllInfo.szFilename)) {
+			Logger_el(UCSTEXT(TEXT_OPENNAME_FAIL), m_PckAllInfo.szFilename);
+			isFailed = TRUE;
+			return;
+		}
+
+		uint32_t i;
+		while ((!isFailed) && (dwFileCount > (i = dwNextIndex++))) {
+
+			if (CheckIfNeedForcedStopWorking()) {
+				isFailed = TRUE;
+				return;
 			}
 
-		} else {
-			//Add the number of files in the current directory to the progress
-			AddParams_ProgressUpper((*lpNodeToExtractPtr)->child->dwFilesCount - 1);
+			//unzip files
+			if (!DecompressFile(lpFiles[i].szPath.c_str(), lpFiles[i].lpIndex, &cFileRead)) {
+				Logger_el(TEXT_UNCOMP_FAIL);
+				isFailed = TRUE;
+				return;
+			}
 
-			CreateDirectoryW((*lpNodeToExtractPtr)->szName, NULL);
-			SetCurrentDirectoryW((*lpNodeToExtractPtr)->szName);
-			ret = StartExtract((*lpNodeToExtractPtr)->child->next, &cFileRead);
-			SetCurrentDirectoryA("..\\");
+			SetParams_ProgressInc();
 		}
+	};
 
-		lpNodeToExtractPtr++;
-	}
+	CPckTaskGroup cExtractTasks(threadnum);
+	for (uint32_t i = 1; i < threadnum; ++i)
+		cExtractTasks.Run(ExtractFiles);
 
-	Logger.i(TEXT_LOG_WORKING_DONE);
-	return	ret;
+	ExtractFiles();
+	cExtractTasks.Wait();
+
+	if (isFailed && (PCK_MSG_USERCANCELED == m_lpPckParams->cVarParams.errMessageNo))
+		Logger.w(TEXT_USERCANCLE);
+
+	return !isFailed;
 }
 
 BOOL CPckClass::ExtractFiles(const PCK_UNIFIED_FILE_ENTRY **lpFileEntryArray, int nEntryCount, const wchar_t *lpszDestDirectory)
@@ -175,18 +295,20 @@ BOOL CPckClass::ExtractFiles(const PCK_UNIFIED_FILE_ENTRY **lpFileEntryArray, in
 	if (!MakeFolderExist(lpszDestDirectory))
 		return FALSE;
 
-	SetCurrentDirectoryW(lpszDestDirectory);
-
 	SetThreadFlag(TRUE);
+	SetParams_Stage(PCK_STAGE_EXTRACT);
 
 	if (PCK_ENTRY_TYPE_INDEX == (*lpFileEntryArray)->entryType) {
 
-		rtn = ExtractFiles((const PCKINDEXTABLE **)lpFileEntryArray, nEntryCount);
+		rtn = ExtractFiles((const PCKINDEXTABLE **)lpFileEntryArray, nEntryCount, lpszDestDirectory);
 	}
 	else {
-		rtn = ExtractFiles((const PCK_PATH_NODE **)lpFileEntryArray, nEntryCount);
+		rtn = ExtractFiles((const PCK_PATH_NODE **)lpFileEntryArray, nEntryCount, lpszDestDirectory);
 	}
 
+	if (!rtn && (PCK_OK == m_lpPckParams->cVarParams.errMessageNo))
+		SetErrMsgFlag(PCK_ERROR);
+
 	SetThreadFlag(FALSE);
 	return rtn;
 }
@@ -198,56 +320,105 @@ BOOL CPckClass::ExtractAllFiles(const wchar_t *lpszDestDirectory)
 	if (!MakeFolderExist(lpszDestDirectory))
 		return FALSE;
 
-	SetCurrentDirectoryW(lpszDestDirectory);
-
 	SetThreadFlag(TRUE);
+	SetParams_Stage(PCK_STAGE_EXTRACT);
 
 	const PCK_PATH_NODE *lpRootNode = &m_PckAllInfo.cRootNode;
-	rtn = ExtractFiles(&lpRootNode, 1);
+	rtn = ExtractFiles(&lpRootNode, 1, lpszDestDirectory);
+
+	if (!rtn && (PCK_OK == m_lpPckParams->cVarParams.errMessageNo))
+		SetErrMsgFlag(PCK_ERROR);
 
 	SetThreadFlag(FALSE);
 	return rtn;
 }
 
-BOOL CPckClass::StartExtract(LPPCK_PATH_NODE lpNodeToExtract, LPVOID lpvoidFileRead)
+BOOL CPckClass::VerifyAllFiles()
 {
+	Logger.i(TEXT_LOG_VERIFY);
 
-	CMapViewFileMultiPckRead	*lpFileRead = (CMapViewFileMultiPckRead*)lpvoidFileRead;
+	//The files of the directory tree, the index of a zup is not the one of its pck
+	std::vector<const PCKINDEXTABLE*> lpIndexTable;
+	CollectFiles(m_PckAllInfo.cRootNode.child, lpIndexTable);
 
-	do {
-		if(CheckIfNeedForcedStopWorking()) {
-			Logger.w(TEXT_USERCANCLE);
-			return FALSE;
+	const uint32_t dwFileCount = (uint32_t)lpIndexTable.size();
+
+	SetThreadFlag(TRUE);
+	SetParams_Stage(PCK_STAGE_VERIFY);
+	SetParams_ProgressUpper(dwFileCount, TRUE);
+
+	std::atomic<uint32_t>	dwNextIndex(0);
+	std::atomic<uint32_t>	dwFailedCount(0);
+
+	uint32_t threadnum = std::min<uint32_t>(std::max<uint32_t>(m_lpPckParams->dwMTThread, 1), std::max<uint32_t>(dwFileCount, 1));
+
+	auto VerifyFiles = [&]() {
+
+		CMapViewFileMultiPckRead	cFileRead;
+
+		if (!cFileRead.OpenPckAndMappingRead(m_PckAllInfo.szFilename)) {
+			Logger_el(UCSTEXT(TEXT_OPENNAME_FAIL), m_PckAllInfo.szFilename);
+			SetErrMsgFlag(PCK_ERR_OPENMAPVIEWR);
+			return;
 		}
 
-		//lpThisNodePtr = lpNodeToExtract;
-		if(PCK_ENTRY_TYPE_FOLDER == (PCK_ENTRY_TYPE_FOLDER & lpNodeToExtract->entryType)) {
+		//Grows to the largest file this thread has seen
+		std::vector<char> buffer;
 
-			CreateDirectoryW(lpNodeToExtract->szName, NULL);
-			SetCurrentDirectoryW(lpNodeToExtract->szName);
+		uint32_t i;
+		while (dwFileCount > (i = dwNextIndex++)) {
 
-			StartExtract(lpNodeToExtract->child->next, lpFileRead);
+			if (CheckIfNeedForcedStopWorking())
+				return;
 
-			SetCurrentDirectoryA("..\\");
+			const PCKINDEXTABLE* lpIndex = lpIndexTable[i];
 
-		} else {
+			if (0 != lpIndex->cFileIndex.dwFileClearTextSize) {
 
-			//unzip files
-			if(!DecompressFile(lpNodeToExtract->szName, lpNodeToExtract->lpPckIndexTable, lpFileRead)) {
-				Logger_el(TEXT_UNCOMP_FAIL);
+				if (buffer.size() < lpIndex->cFileIndex.dwFileClearTextSize)
+					buffer.resize(lpIndex->cFileIndex.dwFileClearTextSize);
 
-				return FALSE;
-			} else {
-				//dwCount++;
-				SetParams_ProgressInc();
+				if (!GetSingleFileData(&cFileRead, lpIndex, buffer.data()))
+					++dwFailedCount;
 			}
+
+			SetParams_ProgressInc();
 		}
+	};
 
-		lpNodeToExtract = lpNodeToExtract->next;
+	CPckTaskGroup cVerifyTasks(threadnum);
+	for (uint32_t i = 1; i < threadnum; ++i)
+		cVerifyTasks.Run(VerifyFiles);
 
-	} while(NULL != lpNodeToExtract);
+	VerifyFiles();
+	cVerifyTasks.Wait();
 
-	return TRUE;
+	if (0 != dwFailedCount)
+		Logger.e(TEXT_VERIFY_FAIL, (uint32_t)dwFailedCount, dwFileCount);
+
+	BOOL rtn = (0 == dwFailedCount) && (PCK_OK == m_lpPckParams->cVarParams.errMessageNo);
+
+	if (rtn)
+		Logger.i(TEXT_LOG_WORKING_DONE);
+	else if (PCK_OK == m_lpPckParams->cVarParams.errMessageNo)
+		SetErrMsgFlag(PCK_ERROR);
+
+	SetThreadFlag(FALSE);
+	return rtn;
+}
+
+void CPckClass::CollectFiles(const PCK_PATH_NODE *lpNode, std::vector<const PCKINDEXTABLE*> &lpIndexArray)
+{
+	for (; NULL != lpNode; lpNode = lpNode->next) {
+
+		if (PCK_ENTRY_TYPE_DOTDOT == (PCK_ENTRY_TYPE_DOTDOT & lpNode->entryType))
+			continue;
+
+		if (PCK_ENTRY_TYPE_FOLDER == (PCK_ENTRY_TYPE_FOLDER & lpNode->entryType))
+			CollectFiles(lpNode->child, lpIndexArray);
+		else if (NULL != lpNode->lpPckIndexTable)
+			lpIndexArray.push_back(lpNode->lpPckIndexTable);
+	}
 }
 
 BOOL CPckClass::DecompressFile(LPCWSTR	lpszFilename, const PCKINDEXTABLE* lpPckFileIndexTable, LPVOID lpvoidFileRead)
@@ -265,6 +436,8 @@ BOOL CPckClass::DecompressFile(LPCWSTR	lpszFilename, const PCKINDEXTABLE* lpPckF
 
 	dwFileLengthToWrite = lpPckFileIndex->dwFileClearTextSize;
 
+	CPckProfileScope cProfile(PROFILE_EXTRACT, dwFileLengthToWrite);
+
 	//The following is to create a file to save the decompressed file
 	if(!cFileWrite.Open(lpszFilename, CREATE_ALWAYS)) {
 		Logger_el(TEXT_OPENWRITENAME_FAIL, lpszFilename);
@@ -145,22 +145,93 @@ QWORD CPckClassFileDisk::GetPckFilesizeByCompressed(LPCWSTR lpszFilename, QWORD
 }
 
 //////////////////////////The following are the procedures that need to be called during the program///////////////////////////////
-VOID CPckClassFileDisk::EnumFile(LPWSTR szFilename, BOOL IsPatition, DWORD &dwFileCount, vector<FILES_TO_COMPRESS> *lpFileLinkList, QWORD &qwTotalFileSize, size_t nLen)
+#pragma region Filename pool
+
+//Size of each node of the filename pool
+#define	FILENAME_POOL_SIZE				(1024*1024)
+
+CAllocMemPool* CPckClassFileDisk::NewFilenamePool()
+{
+	std::lock_guard<std::mutex> lckPools(m_LockFilenamePools);
+
+	m_FilenamePools.emplace_back(new CAllocMemPool(FILENAME_POOL_SIZE));
+	return m_FilenamePools.back().get();
+}
+
+//nLen is the length of the disk path in front of the path in pck
+BOOL CPckClassFileDisk::AddFileToList(CAllocMemPool *lpPool, vector<FILES_TO_COMPRESS> *lpFileLinkList, const wchar_t *lpszFilename, size_t nFilenameLen, size_t nLen, uint64_t qwFileSize, DWORD &dwFileCount, QWORD &qwTotalFileSize)
+{
+	//The clear text size in the index is 32 bits
+	if (UINT32_MAX < qwFileSize) {
+		Logger.e(TEXT_ADDFILE_TOOBIG, lpszFilename);
+		return FALSE;
+	}
+
+	if (MAX_PATH_PCK_256 <= (nFilenameLen - nLen)) {
+		Logger.w(TEXT_ADDFILE_NAME_TOOLONG, lpszFilename);
+		return TRUE;
+	}
+
+	wchar_t *lpszPooled = (wchar_t*)lpPool->Alloc((nFilenameLen + 1) * sizeof(wchar_t), sizeof(wchar_t));
+	if (nullptr == lpszPooled) {
+		Logger_el(TEXT_MALLOC_FAIL);
+		return FALSE;
+	}
+	memcpy(lpszPooled, lpszFilename, (nFilenameLen + 1) * sizeof(wchar_t));
+
+	lpFileLinkList->push_back(FILES_TO_COMPRESS{ 0 });
+	LPFILES_TO_COMPRESS	pFileinfo = &lpFileLinkList->back();
+
+	pFileinfo->lpszFilename = lpszPooled;
+	pFileinfo->lpszFilenameInPck = lpszPooled + nLen;
+	pFileinfo->qwFileSize = qwFileSize;
+
+	//The path in pck uses '\', keep a converted copy if the disk path does not
+	if (nullptr != wcschr(pFileinfo->lpszFilenameInPck, L'/')) {
+
+		size_t nInPckLen = nFilenameLen - nLen;
+		wchar_t *lpszInPck = (wchar_t*)lpPool->Alloc((nInPckLen + 1) * sizeof(wchar_t), sizeof(wchar_t));
+		if (nullptr == lpszInPck) {
+			Logger_el(TEXT_MALLOC_FAIL);
+			return FALSE;
+		}
+
+		for (size_t i = 0; i <= nInPckLen; ++i)
+			lpszInPck[i] = (L'/' == lpszPooled[nLen + i]) ? L'\\' : lpszPooled[nLen + i];
+
+		pFileinfo->lpszFilenameInPck = lpszInPck;
+	}
+
+#if PCK_DEBUG_OUTPUT
+	pFileinfo->id = lpFileLinkList->size();
+#endif
+	++dwFileCount;
+	qwTotalFileSize += qwFileSize;
+	return TRUE;
+}
+
+#pragma endregion
+
+#ifdef _WIN32
+BOOL CPckClassFileDisk::EnumFile(LPWSTR szFilename, BOOL IsPatition, DWORD &dwFileCount, vector<FILES_TO_COMPRESS> *lpFileLinkList, QWORD &qwTotalFileSize, size_t nLen)
 {
 
 	wchar_t		szPath[MAX_PATH], szFile[MAX_PATH];
 
-	size_t nLenBytePath = mystrcpy(szPath, szFilename) - szPath + 1;
+	size_t nLenPath = mystrcpy(szPath, szFilename) - szPath;
 	wcscat(szFilename, L"\\*.*");
 
 	HANDLE					hFile;
 	WIN32_FIND_DATAW		WFD;
 
+	CAllocMemPool			*lpPool = m_FilenamePools.back().get();
+
 	if((hFile = FindFirstFileW(szFilename, &WFD)) != INVALID_HANDLE_VALUE) {
 		if(!IsPatition) {
 			FindNextFileW(hFile, &WFD);
 			if(!FindNextFileW(hFile, &WFD)) {
-				return;
+				FindClose(hFile);
+				return TRUE;
 			}
 		}
 
@@ -168,84 +239,79 @@ VOID CPckClassFileDisk::EnumFile(LPWSTR szFilename, BOOL IsPatition, DWORD &dwFi
 			if((WFD.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0) {
 
 				if((MAX_PATH_PCK_260 - 13) >= mystrcpy(mystrcpy(mystrcpy(szFile, szPath), L"\\"), WFD.cFileName) - szFile) {
-					EnumFile(szFile, FALSE, dwFileCount, lpFileLinkList, qwTotalFileSize, nLen);
+					if(!EnumFile(szFile, FALSE, dwFileCount, lpFileLinkList, qwTotalFileSize, nLen)) {
+						FindClose(hFile);
+						return FALSE;
+					}
 				}
 
 			} else {
 
-				//if(NULL == pFileinfo)return;
-				if(0 != WFD.nFileSizeHigh)continue;
-
-				++dwFileCount;
+				const wchar_t *lpszName = (MAX_PATH <= nLenPath + 1 + wcslen(WFD.cFileName)) ? WFD.cAlternateFileName : WFD.cFileName;
+				size_t nFilenameLen = mystrcpy(mystrcpy(mystrcpy(szFile, szPath), L"\\"), lpszName) - szFile;
 
-				lpFileLinkList->push_back(FILES_TO_COMPRESS{ 0 });
-				LPFILES_TO_COMPRESS	pFileinfo = &lpFileLinkList->back();
+				uint64_t qwFileSize = (((uint64_t)WFD.nFileSizeHigh) << 32) | WFD.nFileSizeLow;
 
-				if(MAX_PATH_PCK_260 < nLenBytePath + wcslen(WFD.cFileName)) {
-					mystrcpy(mystrcpy(mystrcpy(pFileinfo->szwFilename, szPath), L"\\"), WFD.cAlternateFileName);
-				} else {
-					mystrcpy(mystrcpy(mystrcpy(pFileinfo->szwFilename, szPath), L"\\"), WFD.cFileName);
+				if(!AddFileToList(lpPool, lpFileLinkList, szFile, nFilenameLen, nLen, qwFileSize, dwFileCount, qwTotalFileSize)) {
+					FindClose(hFile);
+					return FALSE;
 				}
-
-#if PCK_DEBUG_OUTPUT
-				pFileinfo->id = lpFileLinkList->size();
-#endif
-
-				pFileinfo->nFileTitleLen = nLen;
-				pFileinfo->nBytesToCopy = MAX_PATH - nLen;
-
-				qwTotalFileSize += (pFileinfo->dwFileSize = WFD.nFileSizeLow);
-
 			}
 
 		} while(FindNextFileW(hFile, &WFD));
 
 		FindClose(hFile);
 	}
-
+	return TRUE;
 }
+#endif
 
 BOOL CPckClassFileDisk::EnumAllFilesByPathList(const vector<wstring> &lpszFilePath, DWORD &_out_FileCount, QWORD &_out_TotalFileSize, vector<FILES_TO_COMPRESS> *lpFileLinkList)
 {
 	wchar_t		szPathMbsc[MAX_PATH];
 	DWORD		dwAppendCount = lpszFilePath.size();
 
+	m_FilenamePools.clear();
+	CAllocMemPool *lpPool = NewFilenamePool();
+
 	for(DWORD i = 0; i < dwAppendCount; i++) {
 
 		wcscpy_s(szPathMbsc, lpszFilePath[i].c_str());
-		size_t nLen = (size_t)(wcsrchr(szPathMbsc, L'\\') - szPathMbsc) + 1;
+
+		//Remove the trailing separator, the folder name itself is part of the path in pck
+		size_t nPathLen = wcslen(szPathMbsc);
+		while((1 < nPathLen) && ((L'\\' == szPathMbsc[nPathLen - 1]) || (L'/' == szPathMbsc[nPathLen - 1])))
+			szPathMbsc[--nPathLen] = 0;
+
+		const wchar_t *lpszTitle = szPathMbsc + nPathLen;
+		while((szPathMbsc < lpszTitle) && (L'\\' != lpszTitle[-1]) && (L'/' != lpszTitle[-1]))
+			--lpszTitle;
+
+		size_t nLen = lpszTitle - szPathMbsc;
 
 		if(FILE_ATTRIBUTE_DIRECTORY == (FILE_ATTRIBUTE_DIRECTORY & GetFileAttributesW(szPathMbsc))) {
 			//folder
-			EnumFile(szPathMbsc, FALSE, _out_FileCount, lpFileLinkList, _out_TotalFileSize, nLen);
+#ifdef _WIN32
+			if(!EnumFile(szPathMbsc, FALSE, _out_FileCount, lpFileLinkList, _out_TotalFileSize, nLen))
+				return FALSE;
+#else
+			if(!EnumFolderParallel(szPathMbsc, nLen, _out_FileCount, lpFileLinkList, _out_TotalFileSize))
+				return FALSE;
+#endif
 		} else {
 
 			CMapViewFileRead cFileRead;
 
 			if(!cFileRead.Open(szPathMbsc)) {
-				//m_PckLog.PrintLogEL(TEXT_OPENNAME_FAIL, szPathMbsc, __FILE__, __FUNCTION__, __LINE__);
-
-				assert(FALSE);
+				Logger_el(TEXT_OPENNAME_FAIL, szPathMbsc);
 				return FALSE;
 			}
 
-			lpFileLinkList->push_back(FILES_TO_COMPRESS{ 0 });
-			LPFILES_TO_COMPRESS	lpfirstFile = &lpFileLinkList->back();
-
-			wcscpy(lpfirstFile->szwFilename, szPathMbsc);
-
-			lpfirstFile->nFileTitleLen = nLen;
-			lpfirstFile->nBytesToCopy = MAX_PATH - nLen;
-
-#if PCK_DEBUG_OUTPUT
-			lpfirstFile->id = lpFileLinkList->size();
-#endif
-			_out_TotalFileSize += (lpfirstFile->dwFileSize = cFileRead.GetFileSize());
-			_out_FileCount++;
+			if(!AddFileToList(lpPool, lpFileLinkList, szPathMbsc, nPathLen, nLen, cFileRead.GetFileSize(), _out_FileCount, _out_TotalFileSize))
+				return FALSE;
 		}
 	}
 
-	assert(0 != _out_FileCount);
 	return TRUE;
 
 }
@@ -263,6 +329,10 @@ BOOL CPckClassFileDisk::MakeFolderExistInternal(const wchar_t* lpszDirectory)
 
 
 	wchar_t *lpLastDir = wcsrchr(szUpwardPath, '\\');
+	wchar_t *lpLastSlash = wcsrchr(szUpwardPath, '/');
+
+	if ((NULL == lpLastDir) || ((NULL != lpLastSlash) && (lpLastSlash > lpLastDir)))
+		lpLastDir = lpLastSlash;
 
 	if (PathFileExistsW(szUpwardPath)) {
 
@@ -274,10 +344,15 @@ BOOL CPckClassFileDisk::MakeFolderExistInternal(const wchar_t* lpszDirectory)
 		}
 	}
 
+	//A relative path without a parent
+	if (NULL == lpLastDir)
+		return CreateDirectoryW(szUpwardPath, NULL);
+
+	wchar_t chSeparator = *lpLastDir;
 	*lpLastDir = 0;
 
 	if (MakeFolderExistInternal(szUpwardPath)) {
-		*lpLastDir = '\\';
+		*lpLastDir = chSeparator;
 		if (CreateDirectoryW(szUpwardPath, NULL))
 			return TRUE;
 	}
@@ -10,6 +10,9 @@ typedef uint64_t QWORD;
 #include "MapViewFileMultiPck.h"
 #include "PckClassBaseFeatures.h"
 
+#include <memory>
+#include <mutex>
+
 
 class CPckClassFileDisk :
 	protected virtual CPckClassBaseFeatures
@@ -40,7 +43,19 @@ private:
 	//qwCurrentPckFilesize is the size of the existing file, qwToAddSpace is the size that needs to be expanded, and the return value is (qwCurrentPckFilesize + the maximum size that can be expanded)
 	QWORD	GetPckFilesizeByCompressed(QWORD qwDiskFreeSpace, QWORD qwToAddSpace, QWORD qwCurrentPckFilesize);
 	//Traverse folders
-	VOID	EnumFile(LPWSTR szFilename, BOOL IsPatition, DWORD &dwFileCount, vector<FILES_TO_COMPRESS> *lpFileLinkList, QWORD &qwTotalFileSize, size_t nLen);
+#ifdef _WIN32
+	BOOL	EnumFile(LPWSTR szFilename, BOOL IsPatition, DWORD &dwFileCount, vector<FILES_TO_COMPRESS> *lpFileLinkList, QWORD &qwTotalFileSize, size_t nLen);
+#else
+	//PckClassFileDiskEnum.cpp, subdirectories are walked in parallel
+	BOOL	EnumFolderParallel(const wchar_t *lpszFolder, size_t nLen, DWORD &dwFileCount, vector<FILES_TO_COMPRESS> *lpFileLinkList, QWORD &qwTotalFileSize);
+#endif
+
+	//Path strings of the files to add, one pool per enumerating thread
+	CAllocMemPool*	NewFilenamePool();
+	static BOOL		AddFileToList(CAllocMemPool *lpPool, vector<FILES_TO_COMPRESS> *lpFileLinkList, const wchar_t *lpszFilename, size_t nFilenameLen, size_t nLen, uint64_t qwFileSize, DWORD &dwFileCount, QWORD &qwTotalFileSize);
+
+	vector<std::unique_ptr<CAllocMemPool>>	m_FilenamePools;
+	std::mutex								m_LockFilenamePools;
 
 };
 
@@ -0,0 +1,244 @@
+//////////////////////////////////////////////////////////////////////
+// PckClassFileDiskEnum.cpp: traverse the folders to add with the native posix api
+//
+// Subdirectories are read in parallel through openat/fdopendir, each thread
+// keeps its own file list and filename pool, the lists are merged at the end
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _WIN32
+
+#include "PckClassFileDisk.h"
+#include "PckWorkerPool.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+
+#define TEXT_ENUM_OPENDIR_FAIL		"Failed to read folder \"%s\", skipped!"
+#define TEXT_ENUM_FILENAME_FAIL		"Failed to convert filename \"%s/%s\", skipped!"
+
+typedef struct _ENUM_DIR_TASK
+{
+	std::string		szPath;			//Path on disk
+	std::wstring	szwPath;		//The same path converted to wchar_t
+}ENUM_DIR_TASK;
+
+class CPckEnumFolderWorker
+{
+public:
+	CPckEnumFolderWorker(size_t nLen) :
+		m_nLen(nLen)
+	{}
+
+	std::mutex					m_LockQueue;
+	std::condition_variable		m_cvQueue;
+	std::deque<ENUM_DIR_TASK>	m_DirQueue;
+	//Threads that are reading a folder, new folders may still be queued by them
+	int							m_nBusy = 0;
+	BOOL						m_isFailed = FALSE;
+
+	//Length of the disk path in front of the path in pck
+	size_t						m_nLen;
+
+	void PushDir(ENUM_DIR_TASK &&task)
+	{
+		std::lock_guard<std::mutex> lckQueue(m_LockQueue);
+		m_DirQueue.push_back(std::move(task));
+		m_cvQueue.notify_one();
+	}
+
+	BOOL PopDir(ENUM_DIR_TASK &task)
+	{
+		std::unique_lock<std::mutex> lckQueue(m_LockQueue);
+		m_cvQueue.wait(lckQueue, [this] { return m_isFailed || (!m_DirQueue.empty()) || (0 == m_nBusy); });
+
+		if (m_isFailed || m_DirQueue.empty()) {
+			m_cvQueue.notify_all();
+			return FALSE;
+		}
+
+		task = std::move(m_DirQueue.front());
+		m_DirQueue.pop_front();
+		++m_nBusy;
+		return TRUE;
+	}
+
+	void DoneDir(BOOL isSuccess)
+	{
+		std::lock_guard<std::mutex> lckQueue(m_LockQueue);
+		--m_nBusy;
+		if (!isSuccess)
+			m_isFailed = TRUE;
+		if (m_isFailed || ((0 == m_nBusy) && m_DirQueue.empty()))
+			m_cvQueue.notify_all();
+	}
+};
+
+//Results of one thread
+typedef struct _ENUM_THREAD_RESULT
+{
+	vector<FILES_TO_COMPRESS>	cFileList;
+	DWORD						dwFileCount = 0;
+	QWORD						qwTotalFileSize = 0;
+}ENUM_THREAD_RESULT;
+
+typedef BOOL(*ENUM_ADD_FILE_FUNC)(CAllocMemPool*, vector<FILES_TO_COMPRESS>*, const wchar_t*, size_t, size_t, uint64_t, DWORD&, QWORD&);
+
+static BOOL EnumOneFolder(CPckEnumFolderWorker &cWorker, const ENUM_DIR_TASK &task, CAllocMemPool *lpPool, ENUM_THREAD_RESULT &cResult, ENUM_ADD_FILE_FUNC AddFile)
+{
+	int fd = open(task.szPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	DIR *lpDir;
+
+	if ((0 > fd) || (nullptr == (lpDir = fdopendir(fd)))) {
+		if (0 <= fd)
+			close(fd);
+		Logger.w(TEXT_ENUM_OPENDIR_FAIL, task.szPath.c_str());
+		return TRUE;
+	}
+
+	std::wstring	szwFile;
+	wchar_t			szwName[MAX_PATH_PCK_260];
+	struct dirent	*lpEntry;
+
+	while (nullptr != (lpEntry = readdir(lpDir))) {
+
+		const char *lpszName = lpEntry->d_name;
+
+		if (('.' == lpszName[0]) && ((0 == lpszName[1]) || (('.' == lpszName[1]) && (0 == lpszName[2]))))
+			continue;
+
+		BOOL isDir = (DT_DIR == lpEntry->d_type);
+		struct stat st;
+
+		//Regular files need the size, d_type may be DT_UNKNOWN so the entry itself is read first
+		if (!isDir) {
+			if (0 != fstatat(fd, lpszName, &st, AT_SYMLINK_NOFOLLOW))
+				continue;
+
+			//Do not follow links to folders, they may point back to a parent
+			if (S_ISLNK(st.st_mode) && ((0 != fstatat(fd, lpszName, &st, 0)) || S_ISDIR(st.st_mode)))
+				continue;
+
+			isDir = S_ISDIR(st.st_mode);
+			if (!isDir && !S_ISREG(st.st_mode))
+				continue;
+		}
+
+		size_t nNameLen = mbstowcs(szwName, lpszName, MAX_PATH_PCK_260);
+		if (((size_t)-1 == nNameLen) || (MAX_PATH_PCK_260 <= nNameLen)) {
+			Logger.w(TEXT_ENUM_FILENAME_FAIL, task.szPath.c_str(), lpszName);
+			continue;
+		}
+
+		szwFile.assign(task.szwPath).append(L"/").append(szwName, nNameLen);
+
+		if (isDir) {
+
+			if (MAX_PATH_PCK_256 <= (szwFile.size() - cWorker.m_nLen)) {
+				Logger.w(TEXT_ADDFILE_NAME_TOOLONG, szwFile.c_str());
+				continue;
+			}
+
+			ENUM_DIR_TASK subdir;
+			subdir.szPath.assign(task.szPath).append("/").append(lpszName);
+			subdir.szwPath = std::move(szwFile);
+			cWorker.PushDir(std::move(subdir));
+		}
+		else {
+
+			if (!AddFile(lpPool, &cResult.cFileList, szwFile.c_str(), szwFile.size(), cWorker.m_nLen, st.st_size, cResult.dwFileCount, cResult.qwTotalFileSize)) {
+				closedir(lpDir);
+				return FALSE;
+			}
+		}
+	}
+
+	closedir(lpDir);
+	return TRUE;
+}
+
+BOOL CPckClassFileDisk::EnumFolderParallel(const wchar_t *lpszFolder, size_t nLen, DWORD &dwFileCount, vector<FILES_TO_COMPRESS> *lpFileLinkList, QWORD &qwTotalFileSize)
+{
+	CPckEnumFolderWorker cWorker(nLen);
+
+	ENUM_DIR_TASK root;
+	root.szwPath = lpszFolder;
+
+	char szPath[PATH_MAX];
+	size_t nPathLen = wcstombs(szPath, lpszFolder, sizeof(szPath) - 1);
+	if ((size_t)-1 == nPathLen) {
+		Logger_el(TEXT_OPENNAME_FAIL, lpszFolder);
+		return FALSE;
+	}
+	root.szPath.assign(szPath, nPathLen);
+
+	cWorker.PushDir(std::move(root));
+
+	uint32_t dwThreadCount = ((nullptr == m_lpPckParams) || (0 == m_lpPckParams->dwMTThread)) ? 1 : m_lpPckParams->dwMTThread;
+
+	vector<ENUM_THREAD_RESULT>	cResults(dwThreadCount);
+
+	ENUM_ADD_FILE_FUNC AddFile = &CPckClassFileDisk::AddFileToList;
+
+	auto EnumDirs = [this, &cWorker, AddFile](CAllocMemPool *lpPool, ENUM_THREAD_RESULT *lpResult) {
+
+		ENUM_DIR_TASK task;
+		while (cWorker.PopDir(task)) {
+
+			BOOL isSuccess = EnumOneFolder(cWorker, task, lpPool, *lpResult, AddFile);
+
+			if (CheckIfNeedForcedStopWorking())
+				isSuccess = FALSE;
+
+			cWorker.DoneDir(isSuccess);
+		}
+	};
+
+	{
+		CPckTaskGroup cEnumTasks(dwThreadCount);
+
+		for (uint32_t i = 1; i < dwThreadCount; ++i) {
+
+			CAllocMemPool *lpPool = NewFilenamePool();
+			ENUM_THREAD_RESULT *lpResult = &cResults[i];
+
+			cEnumTasks.Run([&EnumDirs, lpPool, lpResult]() { EnumDirs(lpPool, lpResult); });
+		}
+
+		EnumDirs(NewFilenamePool(), &cResults[0]);
+		cEnumTasks.Wait();
+	}
+
+	if (cWorker.m_isFailed)
+		return FALSE;
+
+	//Merge, then sort by the path in pck so that the result does not depend on thread timing
+	size_t nFirstNew = lpFileLinkList->size();
+	size_t nTotal = nFirstNew;
+	for (const auto &r : cResults)
+		nTotal += r.cFileList.size();
+
+	lpFileLinkList->reserve(nTotal);
+
+	for (const auto &r : cResults) {
+		lpFileLinkList->insert(lpFileLinkList->end(), r.cFileList.begin(), r.cFileList.end());
+		dwFileCount += r.dwFileCount;
+		qwTotalFileSize += r.qwTotalFileSize;
+	}
+
+	std::sort(lpFileLinkList->begin() + nFirstNew, lpFileLinkList->end(), [](const FILES_TO_COMPRESS &a, const FILES_TO_COMPRESS &b) {
+		return 0 > wcscmp(a.lpszFilenameInPck, b.lpszFilenameInPck);
+	});
+
+	return TRUE;
+}
+
+#endif
@@ -37,8 +37,10 @@ BOOL CPckClassHeadTail::SetAdditionalInfo(const char* lpszAdditionalInfo)
 
 	cWritefile.SetFilePointer(-((QWORD)(m_PckAllInfo.lpSaveAsPckVerFunc->dwTailSize)), FILE_END);
 
+	BYTE	tailbuf[MAX_TAIL_LENGTH] = { 0 };
+
 	if(!cWritefile.Write(
-		m_PckAllInfo.lpSaveAsPckVerFunc->FillTailData(&m_PckAllInfo), 
+		m_PckAllInfo.lpSaveAsPckVerFunc->FillTailData(&m_PckAllInfo, tailbuf), 
 		m_PckAllInfo.lpSaveAsPckVerFunc->dwTailSize)) {
 
 		Logger_el(TEXT_WRITEFILE_FAIL);
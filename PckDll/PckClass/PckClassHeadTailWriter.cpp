@@ -17,8 +17,11 @@ BOOL CPckClassHeadTailWriter::WriteHeadAndTail(CMapViewFileMultiPckWrite *lpWrit
 	if(isRenewAddtional)
 		strcpy(lpPckAllInfo->szAdditionalInfo, PCK_ADDITIONAL_INFO);
 
+	BYTE	headbuf[MAX_HEAD_LENGTH] = { 0 };
+	BYTE	tailbuf[MAX_TAIL_LENGTH] = { 0 };
+
 	//Write pckTail
-	if (!lpWrite->Write2(dwAddress, m_PckAllInfo.lpSaveAsPckVerFunc->FillTailData(lpPckAllInfo), m_PckAllInfo.lpSaveAsPckVerFunc->dwTailSize)) {
+	if (!lpWrite->Write2(dwAddress, m_PckAllInfo.lpSaveAsPckVerFunc->FillTailData(lpPckAllInfo, tailbuf), m_PckAllInfo.lpSaveAsPckVerFunc->dwTailSize)) {
 		
 		Logger_el(TEXT_VIEWMAP_FAIL);
 		return FALSE;
@@ -31,7 +34,7 @@ BOOL CPckClassHeadTailWriter::WriteHeadAndTail(CMapViewFileMultiPckWrite *lpWrit
 
 	assert(0 != lpPckAllInfo->qwPckSize);
 
-	if (!lpWrite->Write2(0, m_PckAllInfo.lpSaveAsPckVerFunc->FillHeadData(lpPckAllInfo), m_PckAllInfo.lpSaveAsPckVerFunc->dwHeadSize)) {
+	if (!lpWrite->Write2(0, m_PckAllInfo.lpSaveAsPckVerFunc->FillHeadData(lpPckAllInfo, headbuf), m_PckAllInfo.lpSaveAsPckVerFunc->dwHeadSize)) {
 		Logger_el(TEXT_VIEWMAP_FAIL);
 		return FALSE;
 	}
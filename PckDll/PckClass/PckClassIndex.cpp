@@ -1,5 +1,6 @@
 
 #include "PckClassIndex.h"
+#include "PckWorkerPool.h"
 #include <thread>
 #include <vector>
 
@@ -37,22 +38,24 @@ void CPckClassIndex::GenerateUnicodeStringToIndex()
 {
 	LPPCKINDEXTABLE lpPckIndexTable = m_PckAllInfo.lpPckIndexTable;
 
-	for(DWORD i = 0;i < m_PckAllInfo.dwFileCount;++i) {
-		//File name length
-		lpPckIndexTable->nFilelenBytes = strlen(lpPckIndexTable->cFileIndex.szFilename);
-		if(i == 0) {
-		}
-		//The remaining space in the file name does not occupy the last \0
-		lpPckIndexTable->nFilelenLeftBytes = MAX_PATH_PCK_256 - lpPckIndexTable->nFilelenBytes - 1;
-		//pck ansi -> unicode
-		CPckClassCodepage::PckFilenameCode2UCS(lpPckIndexTable->cFileIndex.szFilename, lpPckIndexTable->cFileIndex.szwFilename, sizeof(lpPckIndexTable->cFileIndex.szwFilename) / sizeof(wchar_t));
-		if(i == 0) {
-		}
-		++lpPckIndexTable;
-	}
+	RunBlocksInPool(m_PckAllInfo.dwFileCount, INDEX_BLOCK_ENTRIES, m_lpPckParams->dwMTThread, [&](uint32_t dwBegin, uint32_t dwEnd) {
+
+		for(uint32_t i = dwBegin;i < dwEnd;++i)
+			GenerateUnicodeStringToIndex(lpPckIndexTable + i);
+	});
 
 }
 
+void CPckClassIndex::GenerateUnicodeStringToIndex(LPPCKINDEXTABLE lpPckIndexTable)
+{
+	//File name length
+	lpPckIndexTable->nFilelenBytes = strlen(lpPckIndexTable->cFileIndex.szFilename);
+	//The remaining space in the file name does not occupy the last \0
+	lpPckIndexTable->nFilelenLeftBytes = MAX_PATH_PCK_256 - lpPckIndexTable->nFilelenBytes - 1;
+	//pck ansi -> unicode
+	CPckClassCodepage::PckFilenameCode2UCS(lpPckIndexTable->cFileIndex.szFilename, lpPckIndexTable->cFileIndex.szwFilename, sizeof(lpPckIndexTable->cFileIndex.szwFilename) / sizeof(wchar_t));
+}
+
 //Calculate the number of valid files during reconstruction and exclude duplicate files
 DWORD CPckClassIndex::ReCountFiles()
 {
@@ -82,4 +85,18 @@ LPPCKINDEXTABLE_COMPRESS CPckClassIndex::FillAndCompressIndexData(LPPCKINDEXTABL
 	lpPckIndexTableComped->dwIndexValueTail = lpPckIndexTableComped->dwIndexDataLength ^ m_PckAllInfo.lpSaveAsPckVerFunc->cPckXorKeys.IndexCompressedFilenameDataLengthCryptKey2;
 
 	return lpPckIndexTableComped;
-}
\ No newline at end of file
+}
+
+BOOL CPckClassIndex::DecompressIndexData(LPPCKINDEXTABLE lpPckIndexTable, const PCKINDEXTABLE_COMPRESS *lpPckIndexTableComped)
+{
+	BYTE pckFileIndexBuf[MAX_INDEXTABLE_CLEARTEXT_LENGTH];
+	ulong_t ulFileBytesRead = MAX_INDEXTABLE_CLEARTEXT_LENGTH;
+
+	if(!m_zlib.decompress(pckFileIndexBuf, &ulFileBytesRead, lpPckIndexTableComped->buffer, lpPckIndexTableComped->dwIndexDataLength))
+		return FALSE;
+
+	m_PckAllInfo.lpSaveAsPckVerFunc->PickIndexData(&lpPckIndexTable->cFileIndex, pckFileIndexBuf);
+	lpPckIndexTable->entryType = PCK_ENTRY_TYPE_INDEX;
+	GenerateUnicodeStringToIndex(lpPckIndexTable);
+	return TRUE;
+}
@@ -4,6 +4,11 @@
 #include "PckClassZlib.h"
 #include "MapViewFileMultiPck.h"
 
+//Index entries decoded or encoded by one task of the worker pool
+#define INDEX_BLOCK_ENTRIES		4096
+//Index entries compressed before they are added to the index being written
+#define INDEX_WRITE_BATCH_ENTRIES	65536
+
 class CPckClassIndex :
 	public virtual CPckClassBaseFeatures
 {
@@ -25,6 +30,11 @@ protected:
 	DWORD	ReCountFiles();
 	//Fill the modified index data into the structure by version and compress it
 	LPPCKINDEXTABLE_COMPRESS FillAndCompressIndexData(LPPCKINDEXTABLE_COMPRESS lpPckIndexTableComped, LPPCKFILEINDEX lpPckFileIndexToCompress);
+	//The other way, the index written by FillAndCompressIndexData back to lpPckIndexTable with its Unicode name
+	BOOL	DecompressIndexData(LPPCKINDEXTABLE lpPckIndexTable, const PCKINDEXTABLE_COMPRESS *lpPckIndexTableComped);
+
+private:
+	void	GenerateUnicodeStringToIndex(LPPCKINDEXTABLE lpPckIndexTable);
 
 };
 
@@ -1,9 +1,12 @@
 #include "PckClassIndex.h"
 #include "PckClassZlib.h"
+#include "PckWorkerPool.h"
+#include <vector>
 
 
 BOOL CPckClassIndex::ReadPckFileIndexes()
 {
+	CPckProfileScope cProfile(PROFILE_INDEX_READ);
 	CMapViewFileMultiPckRead cRead;
 
 	if(!cRead.OpenPckAndMappingRead(m_PckAllInfo.szFilename)) {
@@ -39,46 +42,47 @@ BOOL CPckClassIndex::ReadPckFileIndexes()
 	byteLevelKey = (*(DWORD*)lpFileBuffer) ^ IndexCompressedFilenameDataLengthCryptKey[0];
 	isLevel0 = (m_PckAllInfo.lpDetectedPckVerFunc->dwFileIndexSize == byteLevelKey)/* ? TRUE : FALSE*/;
 
-	if(isLevel0) {
+	//The entries are found one after the other, each one starts where the previous ends,
+	//then they are decoded in blocks by the worker pool
+	std::vector<BYTE*>	lpEntries(m_PckAllInfo.dwFileCount);
+	std::vector<DWORD>	dwEntryLengths(isLevel0 ? 0 : m_PckAllInfo.dwFileCount);
 
-		for(DWORD i = 0;i < m_PckAllInfo.dwFileCount;i++) {
-			//First copy the two compressed data length information
-			memcpy(dwFileIndexTableCryptedDataLength, lpFileBuffer, 8);
+	for(DWORD i = 0;i < m_PckAllInfo.dwFileCount;++i) {
+		//First copy the two compressed data length information
+		memcpy(dwFileIndexTableCryptedDataLength, lpFileBuffer, 8);
+		*(QWORD*)dwFileIndexTableCryptedDataLength ^= *(QWORD*)IndexCompressedFilenameDataLengthCryptKey;
+		lpFileBuffer += 8;
 
-			*(QWORD*)dwFileIndexTableCryptedDataLength ^= *(QWORD*)IndexCompressedFilenameDataLengthCryptKey;
+		if(dwFileIndexTableCryptedDataLength[0] != dwFileIndexTableCryptedDataLength[1]) {
 
-			if(dwFileIndexTableCryptedDataLength[0] != dwFileIndexTableCryptedDataLength[1]) {
-
-				//Logger_el(TEXT_READ_INDEX_FAIL);
-				return FALSE;
-			}
+			//Logger_el(TEXT_READ_INDEX_FAIL);
+			return FALSE;
+		}
 
-			lpFileBuffer += 8;
+		lpEntries[i] = lpFileBuffer;
 
-			m_PckAllInfo.lpDetectedPckVerFunc->PickIndexData(&lpPckIndexTable->cFileIndex, lpFileBuffer);
+		if(isLevel0) {
 			lpFileBuffer += dwFileIndexTableClearDataLength;
-			++lpPckIndexTable;
-
+		} else {
+			dwEntryLengths[i] = dwFileIndexTableCryptedDataLength[0];
+			lpFileBuffer += dwFileIndexTableCryptedDataLength[0];
 		}
-	} else {
-
-		for(DWORD i = 0;i < m_PckAllInfo.dwFileCount;++i) {
+	}
 
-			memcpy(dwFileIndexTableCryptedDataLength, lpFileBuffer, 8);
-			*(QWORD*)dwFileIndexTableCryptedDataLength ^= *(QWORD*)IndexCompressedFilenameDataLengthCryptKey;
-			lpFileBuffer += 8;
+	RunBlocksInPool(m_PckAllInfo.dwFileCount, INDEX_BLOCK_ENTRIES, m_lpPckParams->dwMTThread, [&](uint32_t dwBegin, uint32_t dwEnd) {
 
-			if(dwFileIndexTableCryptedDataLength[0] != dwFileIndexTableCryptedDataLength[1]) {
+		for(uint32_t i = dwBegin;i < dwEnd;++i) {
 
-				//Logger_el(TEXT_READ_INDEX_FAIL);
-				return FALSE;
+			if(isLevel0) {
+				m_PckAllInfo.lpDetectedPckVerFunc->PickIndexData(&lpPckIndexTable[i].cFileIndex, lpEntries[i]);
+				continue;
 			}
-			
+
 			ulong_t ulFileBytesRead = MAX_INDEXTABLE_CLEARTEXT_LENGTH/*dwFileIndexTableClearDataLength*/;
 			BYTE pckFileIndexBuf[MAX_INDEXTABLE_CLEARTEXT_LENGTH];
 
 			m_zlib.decompress(pckFileIndexBuf, &ulFileBytesRead,
-				lpFileBuffer, dwFileIndexTableCryptedDataLength[0]);
+				lpEntries[i], dwEntryLengths[i]);
 
 #if PCK_V2031_ENABLE
 			/*
@@ -87,13 +91,9 @@ BOOL CPckClassIndex::ReadPckFileIndexes()
 			*/
 			PCKFILEINDEX_V2031* testnewindex = (PCKFILEINDEX_V2031*)pckFileIndexBuf;
 #endif
-			m_PckAllInfo.lpDetectedPckVerFunc->PickIndexData(&lpPckIndexTable->cFileIndex, pckFileIndexBuf);
-
-			lpFileBuffer += dwFileIndexTableCryptedDataLength[0];
-			++lpPckIndexTable;
-
+			m_PckAllInfo.lpDetectedPckVerFunc->PickIndexData(&lpPckIndexTable[i].cFileIndex, pckFileIndexBuf);
 		}
-	}
+	});
 
 	return TRUE;
 }
\ No newline at end of file
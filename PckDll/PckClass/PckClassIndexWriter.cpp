@@ -1,6 +1,7 @@
 
 #include "PckClassIndexWriter.h"
 #include "PckIndexCache.h"
+#include "PckWorkerPool.h"
 
 CPckClassIndexWriter::CPckClassIndexWriter()
 {}
@@ -11,8 +12,11 @@ CPckClassIndexWriter::~CPckClassIndexWriter()
 //Write all indexes
 BOOL CPckClassIndexWriter::WriteAllIndex(CMapViewFileMultiPckWrite *lpWrite, LPPCK_ALL_INFOS lpPckAllInfo,  QWORD &dwAddress)
 {
+	CPckProfileScope cProfile(PROFILE_INDEX_WRITE);
 	CPckMemoryCache cPckCache;
 
+	SetParams_Stage(PCK_STAGE_WRITE_INDEX);
+
 	//The file progress, initialization, and writing index progress are displayed in the window.
 	DWORD dwValidFileCount = lpPckAllInfo->dwFileCount + lpPckAllInfo->dwFileCountToAdd;
 	SetParams_ProgressUpper(dwValidFileCount);
@@ -22,22 +26,36 @@ BOOL CPckClassIndexWriter::WriteAllIndex(CMapViewFileMultiPckWrite *lpWrite, LPP
 	DWORD dwOldPckFileCount = lpPckAllInfo->dwFileCountOld;
 	DWORD dwFinalFileCount = 0;
 
-	for(DWORD i = 0; i < dwOldPckFileCount; i++) {
+	//The entries are compressed by the worker pool one batch at a time, and added in their order
+	vector<PCKINDEXTABLE_COMPRESS> cCompressedBatch(std::min<DWORD>(dwOldPckFileCount, INDEX_WRITE_BATCH_ENTRIES));
 
-		if(!lpPckIndexTableOld->isInvalid) {
-			PCKINDEXTABLE_COMPRESS	pckIndexTableTemp;
+	for(DWORD dwBatch = 0; dwBatch < dwOldPckFileCount; dwBatch += INDEX_WRITE_BATCH_ENTRIES) {
 
-			FillAndCompressIndexData(&pckIndexTableTemp, &lpPckIndexTableOld->cFileIndex);
-			cPckCache.add(pckIndexTableTemp.compressed_index_data, pckIndexTableTemp.dwIndexDataLength + 8);
-			
-			++dwFinalFileCount;
-			SetParams_ProgressInc();
-		}
-		else {
-			--dwValidFileCount;
-		}
-		lpPckIndexTableOld++;
+		DWORD dwBatchCount = std::min<DWORD>(dwOldPckFileCount - dwBatch, INDEX_WRITE_BATCH_ENTRIES);
+
+		RunBlocksInPool(dwBatchCount, INDEX_BLOCK_ENTRIES, m_lpPckParams->dwMTThread, [&](uint32_t dwBegin, uint32_t dwEnd) {
+
+			for(uint32_t i = dwBegin; i < dwEnd; i++) {
 
+				if(!lpPckIndexTableOld[i].isInvalid)
+					FillAndCompressIndexData(&cCompressedBatch[i], &lpPckIndexTableOld[i].cFileIndex);
+			}
+		});
+
+		for(DWORD i = 0; i < dwBatchCount; i++) {
+
+			if(!lpPckIndexTableOld->isInvalid) {
+
+				cPckCache.add(cCompressedBatch[i].compressed_index_data, cCompressedBatch[i].dwIndexDataLength + 8);
+
+				++dwFinalFileCount;
+				SetParams_ProgressInc();
+			}
+			else {
+				--dwValidFileCount;
+			}
+			lpPckIndexTableOld++;
+		}
 	}
 
 	SetParams_ProgressUpper(dwValidFileCount, FALSE);
@@ -65,6 +83,7 @@ BOOL CPckClassIndexWriter::WriteAllIndex(CMapViewFileMultiPckWrite *lpWrite, LPP
 
 	lpWrite->Write2(dwAddress, cPckCache.c_buffer(), cPckCache.size());
 	dwAddress += cPckCache.size();
+	cProfile.SetBytes(cPckCache.size());
 
 	return TRUE;
 }
\ No newline at end of file
@@ -16,14 +16,39 @@
 #include "PckClassLog.h"
 #include "CharsCodeConv.h"
 #include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <ctype.h>
+#include <stdlib.h>
 
 
 CPckClassLog& Logger = CPckClassLog::GetInstance();
 
 ShowLogW	CPckClassLog::ShowLogExtern = CPckClassLog::PrintLogToConsole;
 
-CPckClassLog::CPckClassLog()
+static const char g_szLevels[] = "DINWE";
+
+//Holds the ring of one thread, it goes back to the log when the thread ends
+class CPckLogThreadSlot
+{
+public:
+	~CPckLogThreadSlot()
+	{
+		if (nullptr != lpRing)
+			Logger.ReleaseRing(lpRing);
+	}
+
+	CPckClassLog::LPLOG_RING	lpRing = nullptr;
+};
+
+CPckClassLog::CPckClassLog() :
+	m_iLevelRank(0)
 {
+	//WINPCK_LOG_LEVEL=W shows warnings and errors only
+	const char *lpszLevel = getenv("WINPCK_LOG_LEVEL");
+
+	if ((nullptr != lpszLevel) && (0 != *lpszLevel))
+		SetLevel((char)toupper((unsigned char)*lpszLevel));
 }
 
 CPckClassLog::~CPckClassLog()
@@ -31,6 +56,16 @@ CPckClassLog::~CPckClassLog()
 #if PCK_DEBUG_OUTPUT
 	OutputDebugStringA(__FUNCTION__, "\r\n");
 #endif
+	//A task that never ended
+	if (m_tFlusher.joinable()) {
+		m_isAsync = FALSE;
+		StopFlusher();
+		m_tFlusher.join();
+		Drain();
+	}
+
+	for (LPLOG_RING lpRing : m_lpAllRings)
+		delete lpRing;
 }
 
 void CPckClassLog::PckClassLog_func_register(ShowLogW _ShowLogW)
@@ -38,6 +73,30 @@ void CPckClassLog::PckClassLog_func_register(ShowLogW _ShowLogW)
 	ShowLogExtern = _ShowLogW;
 }
 
+int CPckClassLog::GetLevelRank(const char chLevel)
+{
+	const char *lpszLevel = strchr(g_szLevels, chLevel);
+
+	//The system error after an error, or a level not known here
+	if ((' ' == chLevel) || (0 == chLevel) || (nullptr == lpszLevel))
+		return sizeof(g_szLevels) - 2;
+
+	return (int)(lpszLevel - g_szLevels);
+}
+
+void CPckClassLog::SetLevel(const char chLevel)
+{
+	if (nullptr == strchr(g_szLevels, chLevel) || (0 == chLevel))
+		return;
+
+	m_iLevelRank.store(GetLevelRank(chLevel), std::memory_order_relaxed);
+}
+
+char CPckClassLog::GetLevel() const
+{
+	return g_szLevels[m_iLevelRank.load(std::memory_order_relaxed)];
+}
+
 wchar_t* CPckClassLog::GetErrorMsg(CONST DWORD dwError, wchar_t *szMessage)
 {
 	//static WCHAR szMessage[1024] = L"wrong reason?;
@@ -74,6 +133,38 @@ void CPckClassLog::ShowLog(const char _loglevel, const wchar_t *_logtext)
 	ShowLogExtern(_loglevel, _logtext);
 }
 
+void CPckClassLog::PostLog(const char _loglevel, const wchar_t *_logtext)
+{
+	if (!m_isAsync.load(std::memory_order_acquire)) {
+		ShowLog(_loglevel, _logtext);
+		return;
+	}
+
+	LPLOG_RING lpRing;
+	LPLOG_RECORD lpRecord = BeginPush(lpRing);
+
+	if (nullptr == lpRecord)
+		return;
+
+	lpRecord->chLevel = _loglevel;
+	lpRecord->isWide = TRUE;
+	wcsncpy(lpRecord->wszText, _logtext, LOG_RECORD_WTEXT - 1);
+	lpRecord->wszText[LOG_RECORD_WTEXT - 1] = 0;
+
+	size_t nTextLen = wcslen(_logtext);
+
+	if (LOG_RECORD_WTEXT <= nTextLen) {
+
+		nTextLen = std::min<size_t>(nTextLen, LOG_BUFFER - 1);
+
+		if (nullptr != (lpRecord->lpLongText = malloc((nTextLen + 1) * sizeof(wchar_t)))) {
+			wmemcpy((wchar_t*)lpRecord->lpLongText, _logtext, nTextLen);
+			((wchar_t*)lpRecord->lpLongText)[nTextLen] = 0;
+		}
+	}
+	EndPush(lpRing);
+}
+
 void CPckClassLog::PrintLogToConsole(const char log_level, const wchar_t *str)
 {
 	
@@ -87,7 +178,11 @@ void CPckClassLog::PrintLogToConsole(const char log_level, const wchar_t *str)
 
 void CPckClassLog::e(const char *_text, ...)
 {
-	va_list	ap; 
+	//The system error is not wanted either
+	if (!IsLevelEnabled('E'))
+		return;
+
+	va_list	ap;
 	va_start(ap, _text); 
 	PrintLog('E', _text, ap);
 	va_end(ap); 
@@ -129,6 +224,9 @@ void CPckClassLog::n(const char *_text, ...)
 
 void CPckClassLog::e(const wchar_t *_text, ...)
 {
+	if (!IsLevelEnabled('E'))
+		return;
+
 	va_list	ap;
 	va_start(ap, _text);
 	PrintLog('E', _text, ap);
@@ -177,7 +275,7 @@ void CPckClassLog::PrintErrorLog()
 
 	m_dwLastError = GetLastError();
 	if (0 != m_dwLastError) {
-		ShowLog(' ', GetErrorMsg(m_dwLastError, szMessage));
+		PostLog(' ', GetErrorMsg(m_dwLastError, szMessage));
 		m_dwLastError = 0;
 	}
 #if PCK_DEBUG_OUTPUT
@@ -189,22 +287,293 @@ void CPckClassLog::PrintErrorLog()
 
 void CPckClassLog::PrintLog(const char chLevel, const char *_fmt, va_list ap)
 {
+	if (!IsLevelEnabled(chLevel))
+		return;
+
+	if (m_isAsync.load(std::memory_order_acquire)) {
+
+		//Formatted straight into the ring, the code page is converted by the flusher
+		LPLOG_RING lpRing;
+		LPLOG_RECORD lpRecord = BeginPush(lpRing);
+
+		if (nullptr == lpRecord)
+			return;
+
+		lpRecord->chLevel = chLevel;
+		lpRecord->isWide = FALSE;
+
+		va_list apLong;
+		va_copy(apLong, ap);
+
+		int nTextLen = _vsnprintf(lpRecord->szText, LOG_RECORD_TEXT, _fmt, ap);
+		lpRecord->szText[LOG_RECORD_TEXT - 1] = 0;
+
+		if ((0 > nTextLen) || (LOG_RECORD_TEXT <= nTextLen))
+			SetLongText(lpRecord, _fmt, apLong);
+
+		va_end(apLong);
+		EndPush(lpRing);
+		return;
+	}
+
 	char _maintext[LOG_BUFFER];
-	_vsnprintf(_maintext, sizeof(_maintext), _fmt, ap);
+	_vsnprintf(_maintext, LOG_BUFFER, _fmt, ap);
+	_maintext[LOG_BUFFER - 1] = 0;
 
 	ShowLog(chLevel, _maintext);
 }
 
 void CPckClassLog::PrintLog(const char chLevel, const wchar_t *_fmt, va_list ap)
 {
+	if (!IsLevelEnabled(chLevel))
+		return;
+
+	if (m_isAsync.load(std::memory_order_acquire)) {
+
+		LPLOG_RING lpRing;
+		LPLOG_RECORD lpRecord = BeginPush(lpRing);
+
+		if (nullptr == lpRecord)
+			return;
+
+		lpRecord->chLevel = chLevel;
+		lpRecord->isWide = TRUE;
+
+		va_list apLong;
+		va_copy(apLong, ap);
+
+		//-1 when it is cut
+		int nTextLen = _vsnwprintf(lpRecord->wszText, LOG_RECORD_WTEXT, _fmt, ap);
+		lpRecord->wszText[LOG_RECORD_WTEXT - 1] = 0;
+
+		if ((0 > nTextLen) || (LOG_RECORD_WTEXT <= nTextLen))
+			SetLongText(lpRecord, _fmt, apLong);
+
+		va_end(apLong);
+		EndPush(lpRing);
+		return;
+	}
+
 	wchar_t _maintext[LOG_BUFFER];
-	_vsnwprintf(_maintext, sizeof(_maintext), _fmt, ap);
+	_vsnwprintf(_maintext, LOG_BUFFER, _fmt, ap);
+	_maintext[LOG_BUFFER - 1] = 0;
 
 	ShowLog(chLevel, _maintext);
 }
 
 #pragma endregion
 
+#pragma region Async
+
+void CPckClassLog::BeginAsync()
+{
+	std::lock_guard<std::mutex> lckAsync(m_LockAsync);
+
+	if (0 != m_iAsyncTasks++)
+		return;
+
+	uint32_t dwRun;
+	{
+		std::lock_guard<std::mutex> lckFlusher(m_LockFlusher);
+		dwRun = ++m_dwFlusherRun;
+	}
+	m_tFlusher = std::thread(&CPckClassLog::FlushThread, this, dwRun);
+	m_isAsync.store(TRUE, std::memory_order_release);
+}
+
+void CPckClassLog::EndAsync()
+{
+	std::thread tFlusher;
+	{
+		std::lock_guard<std::mutex> lckAsync(m_LockAsync);
+
+		if ((0 == m_iAsyncTasks) || (0 != --m_iAsyncTasks))
+			return;
+
+		m_isAsync.store(FALSE, std::memory_order_release);
+		StopFlusher();
+		tFlusher = std::move(m_tFlusher);
+	}
+
+	//Another task may begin while the flusher ends, it starts its own
+	tFlusher.join();
+
+	//The threads of the task have ended, what they left is shown before it returns
+	Drain();
+}
+
+void CPckClassLog::StopFlusher()
+{
+	{
+		std::lock_guard<std::mutex> lckFlusher(m_LockFlusher);
+		++m_dwFlusherRun;
+	}
+	//The flusher of the next task may wait on it too
+	m_cvFlusher.notify_all();
+}
+
+CPckClassLog::LPLOG_RING CPckClassLog::AcquireRing()
+{
+	std::lock_guard<std::mutex> lckRings(m_LockRings);
+
+	if (!m_lpFreeRings.empty()) {
+		LPLOG_RING lpRing = m_lpFreeRings.back();
+		m_lpFreeRings.pop_back();
+		return lpRing;
+	}
+
+	LPLOG_RING lpRing = new LOG_RING;
+	lpRing->dwHead.store(0, std::memory_order_relaxed);
+	lpRing->dwTail.store(0, std::memory_order_relaxed);
+	lpRing->qwDropped.store(0, std::memory_order_relaxed);
+	m_lpAllRings.push_back(lpRing);
+	return lpRing;
+}
+
+//What is left in it is still drained, the next thread goes on writing after it
+void CPckClassLog::ReleaseRing(LPLOG_RING lpRing)
+{
+	std::lock_guard<std::mutex> lckRings(m_LockRings);
+	m_lpFreeRings.push_back(lpRing);
+}
+
+CPckClassLog::LPLOG_RING CPckClassLog::GetThreadRing()
+{
+	static thread_local CPckLogThreadSlot cSlot;
+
+	if (nullptr == cSlot.lpRing)
+		cSlot.lpRing = AcquireRing();
+	return cSlot.lpRing;
+}
+
+CPckClassLog::LPLOG_RECORD CPckClassLog::BeginPush(LPLOG_RING &lpRing)
+{
+	lpRing = GetThreadRing();
+
+	uint32_t dwHead = lpRing->dwHead.load(std::memory_order_relaxed);
+
+	if (LOG_RING_RECORDS <= (dwHead - lpRing->dwTail.load(std::memory_order_acquire))) {
+		lpRing->qwDropped.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	LPLOG_RECORD lpRecord = &lpRing->records[dwHead % LOG_RING_RECORDS];
+	lpRecord->qwTime = std::chrono::steady_clock::now().time_since_epoch().count();
+	lpRecord->lpLongText = nullptr;
+	return lpRecord;
+}
+
+//Formatted again into LOG_BUFFER, the record keeps the cut message if there is no memory
+void CPckClassLog::SetLongText(LPLOG_RECORD lpRecord, const char *_fmt, va_list ap)
+{
+	char *lpszText = (char*)malloc(LOG_BUFFER);
+
+	if (nullptr == lpszText)
+		return;
+
+	_vsnprintf(lpszText, LOG_BUFFER, _fmt, ap);
+	lpszText[LOG_BUFFER - 1] = 0;
+	lpRecord->lpLongText = lpszText;
+}
+
+void CPckClassLog::SetLongText(LPLOG_RECORD lpRecord, const wchar_t *_fmt, va_list ap)
+{
+	wchar_t *lpszText = (wchar_t*)malloc(LOG_BUFFER * sizeof(wchar_t));
+
+	if (nullptr == lpszText)
+		return;
+
+	_vsnwprintf(lpszText, LOG_BUFFER, _fmt, ap);
+	lpszText[LOG_BUFFER - 1] = 0;
+	lpRecord->lpLongText = lpszText;
+}
+
+void CPckClassLog::EndPush(LPLOG_RING lpRing)
+{
+	uint32_t dwHead = lpRing->dwHead.load(std::memory_order_relaxed) + 1;
+	lpRing->dwHead.store(dwHead, std::memory_order_release);
+
+	//Wake the flusher before the ring is full, no lock is taken
+	if ((LOG_RING_RECORDS / 2) == (dwHead - lpRing->dwTail.load(std::memory_order_relaxed)))
+		m_cvFlusher.notify_one();
+}
+
+void CPckClassLog::FlushThread(uint32_t dwRun)
+{
+	std::unique_lock<std::mutex> lckFlusher(m_LockFlusher);
+
+	while (dwRun == m_dwFlusherRun) {
+
+		m_cvFlusher.wait_for(lckFlusher, std::chrono::milliseconds(LOG_FLUSH_INTERVAL));
+
+		lckFlusher.unlock();
+		Drain();
+		lckFlusher.lock();
+	}
+}
+
+void CPckClassLog::Drain()
+{
+	std::lock_guard<std::mutex> lckDrain(m_LockDrain);
+
+	std::vector<LPLOG_RING> lpRings;
+	{
+		std::lock_guard<std::mutex> lckRings(m_LockRings);
+		lpRings = m_lpAllRings;
+	}
+
+	std::vector<LPLOG_RECORD> lpRecords;
+	std::vector<uint32_t> dwHeads(lpRings.size());
+	uint64_t qwDropped = 0;
+
+	for (size_t i = 0; i < lpRings.size(); i++) {
+
+		LPLOG_RING lpRing = lpRings[i];
+		uint32_t dwTail = lpRing->dwTail.load(std::memory_order_relaxed);
+
+		dwHeads[i] = lpRing->dwHead.load(std::memory_order_acquire);
+
+		for (; dwTail != dwHeads[i]; ++dwTail)
+			lpRecords.push_back(&lpRing->records[dwTail % LOG_RING_RECORDS]);
+
+		qwDropped += lpRing->qwDropped.exchange(0, std::memory_order_relaxed);
+	}
+
+	//The threads wrote at the same time, shown in the order they were written
+	std::stable_sort(lpRecords.begin(), lpRecords.end(), [](LPLOG_RECORD a, LPLOG_RECORD b) {
+		return a->qwTime < b->qwTime;
+	});
+
+	for (LPLOG_RECORD lpRecord : lpRecords) {
+
+		if (nullptr != lpRecord->lpLongText) {
+
+			if (lpRecord->isWide)
+				ShowLog(lpRecord->chLevel, (const wchar_t*)lpRecord->lpLongText);
+			else
+				ShowLog(lpRecord->chLevel, (const char*)lpRecord->lpLongText);
+
+			free(lpRecord->lpLongText);
+			lpRecord->lpLongText = nullptr;
+		}
+		else if (lpRecord->isWide)
+			ShowLog(lpRecord->chLevel, lpRecord->wszText);
+		else
+			ShowLog(lpRecord->chLevel, lpRecord->szText);
+	}
+
+	for (size_t i = 0; i < lpRings.size(); i++)
+		lpRings[i]->dwTail.store(dwHeads[i], std::memory_order_release);
+
+	if (0 != qwDropped) {
+		char szDropped[128];
+		snprintf(szDropped, sizeof(szDropped), "%llu log messages were dropped, a thread wrote them faster than they were shown", (unsigned long long)qwDropped);
+		ShowLog('W', szDropped);
+	}
+}
+
+#pragma endregion
+
 #if PCK_DEBUG_OUTPUT
 void CPckClassLog::OutputVsIde(const char *_text, ...)
 {
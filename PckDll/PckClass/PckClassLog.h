@@ -1,13 +1,23 @@
 #pragma once
 //#include <Windows.h>
 #include "PckDefines.h"
-#if PCK_DEBUG_OUTPUT_FILE
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
-#endif
+#include <thread>
+#include <vector>
 
 //log
 #define	LOG_BUFFER						8192
 
+//While a task runs, every thread writes its messages to its own ring and a
+//flusher thread shows them, a full ring drops the message instead of waiting.
+//A message longer than a record is kept in memory of its own, up to LOG_BUFFER
+#define	LOG_RECORD_TEXT					2000
+#define	LOG_RECORD_WTEXT				(LOG_RECORD_TEXT / sizeof(wchar_t))
+#define	LOG_RING_RECORDS				256
+#define	LOG_FLUSH_INTERVAL				20
+
 class CPckClassLog
 {
 private:
@@ -26,6 +36,15 @@ public:
 	//Register LOG display mode
 	void PckClassLog_func_register(ShowLogW _ShowLogW);
 
+	//Messages below the level are dropped before they are formatted, 'D' shows all
+	void	SetLevel(const char chLevel);
+	char	GetLevel() const;
+	BOOL	IsLevelEnabled(const char chLevel) const { return GetLevelRank(chLevel) >= m_iLevelRank.load(std::memory_order_relaxed); }
+
+	//Called when a task starts and ends, the messages of the task are all shown when it ends
+	void	BeginAsync();
+	void	EndAsync();
+
 	void e(const char *_text, ...);
 	void w(const char *_text, ...);
 	void i(const char *_text, ...);
@@ -57,6 +76,47 @@ public:
 
 private:
 
+	typedef struct _LOG_RECORD
+	{
+		uint64_t	qwTime;
+		char		chLevel;
+		BOOL		isWide;
+		//The message when it does not fit the record, freed when it is shown
+		void		*lpLongText;
+		union {
+			char	szText[LOG_RECORD_TEXT];
+			wchar_t	wszText[LOG_RECORD_WTEXT];
+		};
+	}LOG_RECORD, *LPLOG_RECORD;
+
+	//One thread writes, the flusher reads
+	typedef struct alignas(64) _LOG_RING
+	{
+		std::atomic<uint32_t>	dwHead;
+		alignas(64) std::atomic<uint32_t>	dwTail;
+		std::atomic<uint64_t>	qwDropped;
+		LOG_RECORD				records[LOG_RING_RECORDS];
+	}LOG_RING, *LPLOG_RING;
+
+	friend class CPckLogThreadSlot;
+
+	//A thread takes a ring at its first message while a task runs and gives it back when it ends
+	LPLOG_RING	AcquireRing();
+	void		ReleaseRing(LPLOG_RING lpRing);
+	LPLOG_RING	GetThreadRing();
+
+	LPLOG_RECORD	BeginPush(LPLOG_RING &lpRing);
+	void			SetLongText(LPLOG_RECORD lpRecord, const char *_fmt, va_list ap);
+	void			SetLongText(LPLOG_RECORD lpRecord, const wchar_t *_fmt, va_list ap);
+	void			EndPush(LPLOG_RING lpRing);
+
+	void		FlushThread(uint32_t dwRun);
+	//Ends the running flusher, a new one may already run when it is joined
+	void		StopFlusher();
+	void		Drain();
+
+	static int	GetLevelRank(const char chLevel);
+
 	//Log display mode, displayed to the console by default
 	static void		PrintLogToConsole(const char log_level, const wchar_t *str);
 
@@ -64,12 +124,32 @@ private:
 
 	void		ShowLog(const char log_level, const char *str);
 	void		ShowLog(const char log_level, const wchar_t *str);
+	//Shown now, or by the flusher while a task runs
+	void		PostLog(const char log_level, const wchar_t *str);
 
 	//error message
 	DWORD	m_dwLastError = 0;
 	//Return specific error information
 	wchar_t *GetErrorMsg(CONST DWORD dwError, wchar_t *szMessage);
 
+	std::atomic<int>	m_iLevelRank;
+
+	std::atomic<BOOL>	m_isAsync = FALSE;
+	int					m_iAsyncTasks = 0;
+	std::mutex			m_LockAsync;
+
+	std::thread				m_tFlusher;
+	//A flusher runs while it is the value it was started with
+	uint32_t				m_dwFlusherRun = 0;
+	std::mutex				m_LockFlusher;
+	std::condition_variable	m_cvFlusher;
+
+	//The flusher and the last drain of a task
+	std::mutex				m_LockDrain;
+
+	std::mutex				m_LockRings;
+	std::vector<LPLOG_RING>	m_lpAllRings;
+	std::vector<LPLOG_RING>	m_lpFreeRings;
 };
 
 extern CPckClassLog& Logger;
@@ -15,25 +15,25 @@ BOOL CPckClass::MountPckFile(LPCWSTR	szFile)
 {
 	try
 	{
-		size_t versionCount = GetPckVersionCount();
-		Logger.d("MountPckFile: Attempting to detect version, total versions: %zu", versionCount);
+		PCK_DETECT_DATA cDetectData;
 
-		for(size_t version = 0; version <= versionCount; version++)
+		//The header and tail are read once, then every matching version is tried until the indexes can be read
+		if(!ReadPckHeadTail(szFile, cDetectData))
+			return FALSE;
+
+		int nextVersion = 0;
+		while(DetectPckVerion(szFile, cDetectData, nextVersion))
 		{
-			Logger.d("MountPckFile: Trying version %zu of %zu", version, versionCount);
-			if(DetectPckVerion(szFile, version))
+			Logger.d("MountPckFile: Version %d detected, reading indexes", nextVersion - 1);
+			if(ReadPckFileIndexes())
 			{
-				Logger.d("MountPckFile: Version %zu detected, reading indexes", version);
-				if(ReadPckFileIndexes())
-				{
-					//Set the entryType of the last Index to PCK_ENTRY_TYPE_TAIL_INDEX
-					m_PckAllInfo.lpPckIndexTable[m_PckAllInfo.dwFileCount].entryType = PCK_ENTRY_TYPE_TAIL_INDEX;
-					Logger.d("MountPckFile: Successfully mounted PCK file");
-					return TRUE;
-				}
+				//Set the entryType of the last Index to PCK_ENTRY_TYPE_TAIL_INDEX
+				m_PckAllInfo.lpPckIndexTable[m_PckAllInfo.dwFileCount].entryType = PCK_ENTRY_TYPE_TAIL_INDEX;
+				Logger.d("MountPckFile: Successfully mounted PCK file");
+				return TRUE;
 			}
 		}
-		Logger.e("MountPckFile: Failed to detect any valid PCK version after trying %zu versions", versionCount + 1);
+		Logger.e("MountPckFile: Failed to detect any valid PCK version");
 		return FALSE;
 	}
 	catch (MyException e) {
@@ -45,6 +45,7 @@ BOOL CPckClass::MountPckFile(LPCWSTR	szFile)
 
 void CPckClass::BuildDirTree()
 {
+	CPckProfileScope cProfile(PROFILE_INDEX_BUILD, m_PckAllInfo.dwFileCount);
 	Logger.d("BuildDirTree: Starting directory tree construction");
 	//Convert all ansi text in the read index to Unicode
 	GenerateUnicodeStringToIndex();
@@ -38,6 +38,8 @@ void CPckClassNode::ParseIndexTableToNode(LPPCKINDEXTABLE lpMainIndexTable)
 		m_PckAllInfo.cRootNode.child->entryType |= PCK_ENTRY_TYPE_ROOT;
 	} else {
 	}
+
+	m_PathTable.Build(&m_PckAllInfo.cRootNode);
 }
 
 /********************************
@@ -157,54 +159,51 @@ BOOL CPckClassNode::AddFileToNode(LPPCKINDEXTABLE lpPckIndexTable)
 #pragma endregion
 
 #pragma region FindFileNode
-const PCK_PATH_NODE* CPckClassNode::FindFileNode(const PCK_PATH_NODE* lpBaseNode, wchar_t* lpszFile)
+const PCK_PATH_NODE* CPckClassNode::FindFileNode(const PCK_PATH_NODE* lpBaseNode, const wchar_t* lpszFile)
 {
-	if ((NULL == lpBaseNode) || (NULL == lpBaseNode->child))
+	if ((NULL == lpBaseNode) || (NULL == lpszFile))
 		return NULL;
 
-	const PCK_PATH_NODE* lpChildNode = lpBaseNode->child;
-
-	wchar_t			szFilename[MAX_PATH];
-	wcscpy_s(szFilename, lpszFile);
-
-	wchar_t			*lpszFilename = szFilename;
-
-	if(NULL == lpChildNode->szName)
-		return NULL;
-
-	do {
-		wchar_t	szToFind[MAX_PATH_PCK_260] = { 0 };
-		strpathcpy(szToFind, lpszFilename);
-
-		do {
+	const PCK_PATH_NODE* lpFoundNode = m_PathTable.Find(lpBaseNode, lpszFile);
 
-			if(0 == wcscmp(lpChildNode->szName, szToFind)) {
+	if (NULL != lpFoundNode)
+		return (PCK_ENTRY_TYPE_FOLDER & lpFoundNode->entryType) ? (LPPCK_PATH_NODE)INVALID_NODE : lpFoundNode;
 
-				if(NULL == lpChildNode->child && 0 == *lpszFilename)return lpChildNode;
+	//Not found, it is still a conflict if a file of that name is used as a folder
+	wchar_t		szFilename[MAX_PATH_PCK_260];
+	wcscpy_s(szFilename, lpszFile);
 
-				if((NULL == lpChildNode->child && (TEXT('\\') == *lpszFilename || TEXT('/') == *lpszFilename)) || (NULL != lpChildNode->child && 0 == *lpszFilename)) {
-					return (LPPCK_PATH_NODE)INVALID_NODE;
-				}
+	BOOL		hasName = FALSE;
 
-				break;
-			}
+	for (wchar_t *lpszSearch = szFilename; 0 != *lpszSearch; ++lpszSearch) {
 
-			if(NULL == lpChildNode->next) {
-				return NULL;
-			}
-			lpChildNode = lpChildNode->next;
+		if ((TEXT('\\') != *lpszSearch) && (TEXT('/') != *lpszSearch)) {
+			hasName = TRUE;
+			continue;
+		}
 
-		} while(1);
+		if (!hasName)
+			continue;
 
-		lpChildNode = lpChildNode->child;
+		wchar_t chSep = *lpszSearch;
+		*lpszSearch = 0;
+		lpFoundNode = m_PathTable.Find(lpBaseNode, szFilename);
+		*lpszSearch = chSep;
 
-		if(TEXT('\\') == *lpszFilename || TEXT('/') == *lpszFilename)
-			++lpszFilename;
+		//The folders below do not exist either
+		if (NULL == lpFoundNode)
+			return NULL;
 
-	} while(*lpszFilename);
+		if (!(PCK_ENTRY_TYPE_FOLDER & lpFoundNode->entryType))
+			return (LPPCK_PATH_NODE)INVALID_NODE;
+	}
 
 	return NULL;
+}
 
+const PCK_PATH_NODE* CPckClassNode::FindNodeByPath(const wchar_t* lpszPath, BOOL isIgnoreCase)
+{
+	return m_PathTable.Find(NULL, lpszPath, isIgnoreCase);
 }
 
 #pragma endregion
@@ -378,7 +377,7 @@ BOOL CPckClassNode::FindDuplicateNodeFromFileList(const PCK_PATH_NODE* lpNodeToI
 	for(size_t i=0;i<sizeOfFileList;i++){
 
 		FILES_TO_COMPRESS *lpfirstFile = &(*lpFilesList)[i];
-		const PCK_PATH_NODE* lpDuplicateNode = FindFileNode(lpNodeToInsertPtr, lpfirstFile->szwFilename + lpfirstFile->nFileTitleLen);
+		const PCK_PATH_NODE* lpDuplicateNode = FindFileNode(lpNodeToInsertPtr, lpfirstFile->lpszFilenameInPck);
 
 		if(INVALID_NODE == (intptr_t)lpDuplicateNode) {
 			Logger.w(TEXT_ERROR_DUP_FOLDER_FILE);
@@ -394,4 +393,137 @@ BOOL CPckClassNode::FindDuplicateNodeFromFileList(const PCK_PATH_NODE* lpNodeToI
 
 	}
 	return TRUE;
-}
\ No newline at end of file
+}
+
+#pragma region MergeAddedIndex
+
+BOOL CPckClassNode::MergeAddedIndex()
+{
+	const vector<PCKINDEXTABLE_COMPRESS> *lpCompedPckIndexTableNew = m_PckAllInfo.lpPckIndexTableToAdd;
+	DWORD dwNewPckFileCount = (NULL == lpCompedPckIndexTableNew) ? 0 : m_PckAllInfo.dwFileCountToAdd;
+
+	//The same entries in the same order as WriteAllIndex wrote them
+	LPPCKINDEXTABLE lpMergedIndexTable = (LPPCKINDEXTABLE)AllocMemory(sizeof(PCKINDEXTABLE) * (m_PckAllInfo.dwFinalFileCount + 1));
+	if(NULL == lpMergedIndexTable)
+		return FALSE;
+
+	LPPCKINDEXTABLE lpOldIndexTable = m_PckAllInfo.lpPckIndexTable;
+	DWORD dwOldPckFileCount = m_PckAllInfo.dwFileCountOld;
+
+	vector<LPPCKINDEXTABLE> lpMergedIndex(dwOldPckFileCount, NULL);
+	LPPCKINDEXTABLE lpPckIndexTable = lpMergedIndexTable;
+
+	for(DWORD i = 0; i < dwOldPckFileCount; ++i) {
+
+		if(!lpOldIndexTable[i].isInvalid) {
+			memcpy(lpPckIndexTable, &lpOldIndexTable[i], sizeof(PCKINDEXTABLE));
+			lpMergedIndex[i] = lpPckIndexTable++;
+		}
+	}
+
+	//A replaced file keeps its node, it is pointed at the added entry
+	vector<LPPCKINDEXTABLE> lpIndexToAdd;
+
+	for(DWORD i = 0; i < dwNewPckFileCount; ++i) {
+
+		if(!DecompressIndexData(lpPckIndexTable, &(*lpCompedPckIndexTableNew)[i])) {
+			free(lpMergedIndexTable);
+			return FALSE;
+		}
+
+		const PCK_PATH_NODE* lpSameNode = FindNodeByPath(lpPckIndexTable->cFileIndex.szwFilename);
+
+		if((NULL != lpSameNode) && (NULL != lpSameNode->lpPckIndexTable) && (lpSameNode->lpPckIndexTable->isInvalid) &&
+			(lpOldIndexTable <= lpSameNode->lpPckIndexTable) && (lpSameNode->lpPckIndexTable < (lpOldIndexTable + dwOldPckFileCount)))
+			lpMergedIndex[lpSameNode->lpPckIndexTable - lpOldIndexTable] = lpPckIndexTable;
+		else
+			lpIndexToAdd.push_back(lpPckIndexTable);
+
+		++lpPckIndexTable;
+	}
+
+	if((DWORD)(lpPckIndexTable - lpMergedIndexTable) != m_PckAllInfo.dwFinalFileCount) {
+		assert(FALSE);
+		free(lpMergedIndexTable);
+		return FALSE;
+	}
+
+	lpPckIndexTable->entryType = PCK_ENTRY_TYPE_TAIL_INDEX;
+
+	//Nothing can fail from here on
+	m_PathTable.Clear();
+
+	if(NULL != m_PckAllInfo.cRootNode.child)
+		MergeNodes(m_PckAllInfo.cRootNode.child, lpOldIndexTable, lpMergedIndex);
+
+	for(LPPCKINDEXTABLE lpAdded : lpIndexToAdd)
+		AddFileToNode(lpAdded);
+
+	if(NULL != m_PckAllInfo.cRootNode.child)
+		m_PckAllInfo.cRootNode.child->entryType |= PCK_ENTRY_TYPE_ROOT;
+
+	m_PathTable.Build(&m_PckAllInfo.cRootNode);
+
+	free(lpOldIndexTable);
+	m_PckAllInfo.lpPckIndexTable = lpMergedIndexTable;
+
+	m_PckAllInfo.dwFileCountOld = m_PckAllInfo.dwFileCount = m_PckAllInfo.dwFinalFileCount;
+	m_PckAllInfo.dwFileCountToAdd = 0;
+	m_PckAllInfo.lpPckIndexTableToAdd = NULL;
+
+	return TRUE;
+}
+
+void CPckClassNode::MergeNodes(LPPCK_PATH_NODE lpFirstNode, const PCKINDEXTABLE *lpOldIndexTable, const std::vector<LPPCKINDEXTABLE> &lpMergedIndex)
+{
+	LPPCK_PATH_NODE lpPrevNode = lpFirstNode;
+
+	for(LPPCK_PATH_NODE lpNode = lpFirstNode->next; NULL != lpNode; lpNode = lpNode->next) {
+
+		BOOL isRemoved;
+
+		if(PCK_ENTRY_TYPE_FOLDER & lpNode->entryType) {
+
+			MergeNodes(lpNode->child, lpOldIndexTable, lpMergedIndex);
+
+			//The files under it are taken out of the counts already
+			if((isRemoved = (0 == lpNode->child->dwFilesCount))) {
+				for(LPPCK_PATH_NODE lpDirCount = lpFirstNode; NULL != lpDirCount; lpDirCount = lpDirCount->parentfirst)
+					--(lpDirCount->dwDirsCount);
+			}
+		} else {
+
+			const PCKFILEINDEX *lpOldFileIndex = &lpNode->lpPckIndexTable->cFileIndex;
+			LPPCKINDEXTABLE lpMerged = lpMergedIndex[lpNode->lpPckIndexTable - lpOldIndexTable];
+
+			isRemoved = (NULL == lpMerged);
+
+			//Deleted, or replaced by an added file whose sizes the folders get
+			if(lpNode->lpPckIndexTable->isInvalid) {
+
+				for(LPPCK_PATH_NODE lpDirCount = lpFirstNode; NULL != lpDirCount; lpDirCount = lpDirCount->parentfirst) {
+
+					if(isRemoved) {
+						--(lpDirCount->dwFilesCount);
+					} else {
+						lpDirCount->qdwDirCipherTextSize += lpMerged->cFileIndex.dwFileCipherTextSize;
+						lpDirCount->qdwDirClearTextSize += lpMerged->cFileIndex.dwFileClearTextSize;
+					}
+					lpDirCount->qdwDirCipherTextSize -= lpOldFileIndex->dwFileCipherTextSize;
+					lpDirCount->qdwDirClearTextSize -= lpOldFileIndex->dwFileClearTextSize;
+				}
+			}
+
+			if(!isRemoved)
+				lpNode->lpPckIndexTable = lpMerged;
+		}
+
+		//The node stays in the pool until the pck is closed
+		if(isRemoved)
+			lpPrevNode->next = lpNode->next;
+		else
+			lpPrevNode = lpNode;
+	}
+}
+
+#pragma endregion
\ No newline at end of file
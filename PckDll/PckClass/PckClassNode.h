@@ -1,5 +1,6 @@
 #pragma once
 #include "PckClassIndex.h"
+#include "PckClassPathTable.h"
 
 #define INVALID_NODE	( -1 )
 
@@ -13,7 +14,9 @@ public:
 	//Perform path analysis on the PckIndex file and put it into Node
 	void			ParseIndexTableToNode(LPPCKINDEXTABLE lpMainIndexTable);
 	//Find identical nodes
-	const PCK_PATH_NODE*	FindFileNode(const PCK_PATH_NODE* lpBaseNode, wchar_t* lpszFile);
+	const PCK_PATH_NODE*	FindFileNode(const PCK_PATH_NODE* lpBaseNode, const wchar_t* lpszFile);
+	//Find a node by its full path in pck
+	const PCK_PATH_NODE*	FindNodeByPath(const wchar_t* lpszPath, BOOL isIgnoreCase = FALSE);
 
 	//Delete a node
 	virtual VOID	DeleteNode(LPPCK_PATH_NODE lpNode);
@@ -38,6 +41,12 @@ public:
 	static BOOL	GetCurrentNodeString(wchar_t *szCurrentNodePathString, const PCK_PATH_NODE* lpNode);
 protected:
 	BOOL	FindDuplicateNodeFromFileList(const PCK_PATH_NODE* lpNodeToInsertPtr, DWORD &_in_out_FileCount);
+	//After the index is written by WriteAllIndex, make the loaded index and the tree the same as the written one:
+	//the invalid entries are removed and the added ones (lpPckIndexTableToAdd) are inserted, the nodes stay where they are
+	BOOL	MergeAddedIndex();
+
+	//Full path lookup of the nodes, built with the tree
+	CPckClassPathTable	m_PathTable;
 
 private:
 
@@ -45,6 +54,8 @@ private:
 
 	//Perform path analysis on the PckIndex file and put it into Node
 	BOOL	AddFileToNode(LPPCKINDEXTABLE	lpPckIndexNode);
+	//Point the file nodes under the .. node lpFirstNode at lpMergedIndex[their old index], remove those without one and the folders left empty
+	void	MergeNodes(LPPCK_PATH_NODE lpFirstNode, const PCKINDEXTABLE *lpOldIndexTable, const std::vector<LPPCKINDEXTABLE> &lpMergedIndex);
 
 };
 
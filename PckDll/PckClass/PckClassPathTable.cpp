@@ -0,0 +1,225 @@
+//////////////////////////////////////////////////////////////////////
+// PckClassPathTable.cpp: lookup of a node in the directory tree by its full path
+//
+// The table is open addressing with linear probing, the key is the
+// FNV-1a hash of the path with '\' between the names
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "PckClassPathTable.h"
+#include <wctype.h>
+
+#define PATH_HASH_SEED		0xcbf29ce484222325ULL
+#define PATH_HASH_PRIME		0x100000001b3ULL
+
+typedef struct _PATH_PART
+{
+	const wchar_t	*lpszName;
+	size_t			nLen;
+}PATH_PART;
+
+static inline BOOL IsPathSeparator(wchar_t ch)
+{
+	return (L'\\' == ch) || (L'/' == ch);
+}
+
+//The same folding as wcsicmp
+static inline wchar_t FoldChar(wchar_t ch, BOOL isIgnoreCase)
+{
+	if (!isIgnoreCase)
+		return ch;
+	if (0x80 > ch)
+		return ((L'A' <= ch) && (L'Z' >= ch)) ? (ch | 0x20) : ch;
+	return towlower(ch);
+}
+
+static inline uint64_t HashChar(uint64_t qwHash, wchar_t ch)
+{
+	return (qwHash ^ (uint32_t)ch) * PATH_HASH_PRIME;
+}
+
+static inline uint64_t HashName(uint64_t qwHash, const wchar_t *lpszName, BOOL isIgnoreCase)
+{
+	for (; *lpszName; ++lpszName)
+		qwHash = HashChar(qwHash, FoldChar(*lpszName, isIgnoreCase));
+	return qwHash;
+}
+
+static inline BOOL IsSameName(const wchar_t *lpszNodeName, const PATH_PART &cPart, BOOL isIgnoreCase)
+{
+	for (size_t i = 0; i < cPart.nLen; ++i) {
+		if (FoldChar(lpszNodeName[i], isIgnoreCase) != FoldChar(cPart.lpszName[i], isIgnoreCase))
+			return FALSE;
+	}
+	return (0 == lpszNodeName[cPart.nLen]);
+}
+
+void CPckClassPathTable::Build(LPPCK_PATH_NODE lpRootNode)
+{
+	Clear();
+
+	m_lpRootNode = lpRootNode;
+	BuildSlots(m_Slots, FALSE);
+}
+
+void CPckClassPathTable::Clear()
+{
+	std::lock_guard<std::mutex> lckIgnoreCase(m_LockIgnoreCase);
+
+	m_lpRootNode = nullptr;
+	PATH_SLOTS().swap(m_Slots);
+	PATH_SLOTS().swap(m_SlotsIgnoreCase);
+	m_isIgnoreCaseBuilt = false;
+}
+
+void CPckClassPathTable::BuildSlots(PATH_SLOTS &lpSlots, BOOL isIgnoreCase) const
+{
+	if (nullptr == m_lpRootNode)
+		return;
+
+	//Nodes with the hash of their path, then folders with the hash of their path and '\'
+	PATH_SLOTS cNodes, cFolders;
+	cFolders.push_back({ PATH_HASH_SEED, m_lpRootNode });
+
+	while (!cFolders.empty()) {
+
+		PATH_SLOT cFolder = cFolders.back();
+		cFolders.pop_back();
+
+		if (nullptr == cFolder.lpNode->child)
+			continue;
+
+		//Skip the .. node
+		for (LPPCK_PATH_NODE lpNode = cFolder.lpNode->child->next; nullptr != lpNode; lpNode = lpNode->next) {
+
+			uint64_t qwHash = HashName(cFolder.qwHash, lpNode->szName, isIgnoreCase);
+			cNodes.push_back({ qwHash, lpNode });
+
+			if (PCK_ENTRY_TYPE_FOLDER & lpNode->entryType)
+				cFolders.push_back({ HashChar(qwHash, L'\\'), lpNode });
+		}
+	}
+
+	//Keep the load below 3/4
+	size_t nSize = 16;
+	while (nSize < (cNodes.size() + cNodes.size() / 3 + 1))
+		nSize <<= 1;
+
+	size_t nMask = nSize - 1;
+	lpSlots.assign(nSize, { 0, nullptr });
+
+	for (const PATH_SLOT &cNode : cNodes) {
+
+		size_t i = cNode.qwHash & nMask;
+		while (nullptr != lpSlots[i].lpNode)
+			i = (i + 1) & nMask;
+
+		lpSlots[i] = cNode;
+	}
+}
+
+const CPckClassPathTable::PATH_SLOTS* CPckClassPathTable::GetSlots(BOOL isIgnoreCase) const
+{
+	if (!isIgnoreCase)
+		return &m_Slots;
+
+	if (!m_isIgnoreCaseBuilt) {
+
+		std::lock_guard<std::mutex> lckIgnoreCase(m_LockIgnoreCase);
+
+		if (!m_isIgnoreCaseBuilt) {
+			BuildSlots(m_SlotsIgnoreCase, TRUE);
+			m_isIgnoreCaseBuilt = true;
+		}
+	}
+	return &m_SlotsIgnoreCase;
+}
+
+LPPCK_PATH_NODE CPckClassPathTable::Find(const PCK_PATH_NODE *lpBaseNode, const wchar_t *lpszPath, BOOL isIgnoreCase) const
+{
+	if ((nullptr == lpszPath) || (nullptr == m_lpRootNode))
+		return nullptr;
+
+	//The folder of a .. node is its parent, files have nothing under them
+	if ((nullptr == lpBaseNode) || (PCK_ENTRY_TYPE_ROOT & lpBaseNode->entryType))
+		lpBaseNode = m_lpRootNode;
+	else if (PCK_ENTRY_TYPE_DOTDOT & lpBaseNode->entryType)
+		lpBaseNode = lpBaseNode->parent;
+	else if (!(PCK_ENTRY_TYPE_FOLDER & lpBaseNode->entryType))
+		return nullptr;
+
+	const PATH_SLOTS *lpSlots = GetSlots(isIgnoreCase);
+	if (lpSlots->empty())
+		return nullptr;
+
+	//Hash of the path of the base folder
+	const PCK_PATH_NODE *lpParents[MAX_PATH_PCK_260];
+	size_t nDepth = 0;
+
+	for (const PCK_PATH_NODE *lpNode = lpBaseNode; m_lpRootNode != lpNode; lpNode = lpNode->parent) {
+		if ((nullptr == lpNode) || (MAX_PATH_PCK_260 == nDepth))
+			return nullptr;
+		lpParents[nDepth++] = lpNode;
+	}
+
+	uint64_t qwHash = PATH_HASH_SEED;
+	while (0 != nDepth) {
+		qwHash = HashName(qwHash, lpParents[--nDepth]->szName, isIgnoreCase);
+		qwHash = HashChar(qwHash, L'\\');
+	}
+
+	//Split and hash the relative path
+	PATH_PART cParts[MAX_PATH_PCK_260];
+	size_t nParts = 0;
+
+	while (*lpszPath) {
+
+		while (IsPathSeparator(*lpszPath))
+			++lpszPath;
+
+		if (0 == *lpszPath)
+			break;
+
+		if (MAX_PATH_PCK_260 == nParts)
+			return nullptr;
+
+		if (0 != nParts)
+			qwHash = HashChar(qwHash, L'\\');
+
+		PATH_PART &cPart = cParts[nParts++];
+		cPart.lpszName = lpszPath;
+
+		for (; *lpszPath && !IsPathSeparator(*lpszPath); ++lpszPath)
+			qwHash = HashChar(qwHash, FoldChar(*lpszPath, isIgnoreCase));
+
+		cPart.nLen = lpszPath - cPart.lpszName;
+	}
+
+	if (0 == nParts)
+		return nullptr;
+
+	size_t nMask = lpSlots->size() - 1;
+
+	for (size_t i = qwHash & nMask; nullptr != (*lpSlots)[i].lpNode; i = (i + 1) & nMask) {
+
+		const PATH_SLOT &cSlot = (*lpSlots)[i];
+		if (qwHash != cSlot.qwHash)
+			continue;
+
+		//Compare the names from the node up to the base folder
+		const PCK_PATH_NODE *lpNode = cSlot.lpNode;
+		size_t j = nParts;
+
+		while ((0 != j) && IsSameName(lpNode->szName, cParts[j - 1], isIgnoreCase)) {
+			lpNode = lpNode->parent;
+			--j;
+		}
+
+		if ((0 == j) && (lpBaseNode == lpNode))
+			return cSlot.lpNode;
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,51 @@
+//////////////////////////////////////////////////////////////////////
+// PckClassPathTable.h: lookup of a node in the directory tree by its full path
+//
+// Every node is stored under the hash of its path from the root, a lookup
+// hashes the normalized path and checks the candidates against the names
+// of the node and its parents, so no directory has to be scanned
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "PckStructs.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+class CPckClassPathTable
+{
+public:
+	CPckClassPathTable() = default;
+	~CPckClassPathTable() = default;
+
+	//Index the nodes under lpRootNode, the case-insensitive table is built by its first lookup
+	void	Build(LPPCK_PATH_NODE lpRootNode);
+	void	Clear();
+
+	//Find lpszPath under the folder lpBaseNode (NULL for the root), '\' and '/' are both separators,
+	//leading, repeated and trailing separators are ignored
+	LPPCK_PATH_NODE	Find(const PCK_PATH_NODE *lpBaseNode, const wchar_t *lpszPath, BOOL isIgnoreCase = FALSE) const;
+
+private:
+
+	typedef struct _PATH_SLOT
+	{
+		uint64_t		qwHash;
+		LPPCK_PATH_NODE	lpNode;			//NULL if the slot is empty
+	}PATH_SLOT;
+
+	typedef std::vector<PATH_SLOT> PATH_SLOTS;
+
+	void	BuildSlots(PATH_SLOTS &lpSlots, BOOL isIgnoreCase) const;
+	const PATH_SLOTS*	GetSlots(BOOL isIgnoreCase) const;
+
+	LPPCK_PATH_NODE		m_lpRootNode = nullptr;
+
+	PATH_SLOTS			m_Slots;
+	mutable PATH_SLOTS	m_SlotsIgnoreCase;
+	mutable std::mutex	m_LockIgnoreCase;
+	mutable std::atomic<bool>	m_isIgnoreCaseBuilt = false;
+};
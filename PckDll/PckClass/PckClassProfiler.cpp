@@ -0,0 +1,286 @@
+//////////////////////////////////////////////////////////////////////
+// PckClassProfiler.cpp: time spent in the stages of long operations
+//
+// Setting WINPCK_TRACE to a file name starts profiling when the library
+// is loaded, the trace is written when it is unloaded or profiling stops
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "PckClassProfiler.h"
+#include "PckClassLog.h"
+#ifdef _WIN32
+#include "MapViewFile.h"
+#else
+#include "MapViewFile_posix.h"
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <stdlib.h>
+
+#define PROFILE_WRITE_CHUNK		(64 * 1024 * 1024)
+
+CPckClassProfiler& Profiler = CPckClassProfiler::GetInstance();
+
+static const char *const g_szStageNames[PROFILE_STAGE_COUNT] = {
+	"source_read",
+	"inflate",
+	"deflate",
+	"queue_wait",
+	"memory_wait",
+	"write",
+	"extract",
+	"index_read",
+	"index_write",
+	"index_build",
+};
+
+//Holds the counters of one thread, they go back to the profiler when the thread ends
+class CPckProfilerThreadSlot
+{
+public:
+	~CPckProfilerThreadSlot()
+	{
+		if (nullptr != lpCounters)
+			Profiler.Release(lpCounters);
+	}
+
+	CPckClassProfiler::LPTHREAD_COUNTERS	lpCounters = nullptr;
+};
+
+CPckClassProfiler::CPckClassProfiler()
+{
+	//The log is used while the trace is written at exit, so it has to be destroyed after this
+	CPckClassLog::GetInstance();
+
+	const char *lpszTraceFile = getenv("WINPCK_TRACE");
+
+	if ((nullptr != lpszTraceFile) && (0 != *lpszTraceFile)) {
+
+		wchar_t szTraceFile[MAX_PATH];
+		size_t nLen = mbstowcs(szTraceFile, lpszTraceFile, MAX_PATH - 1);
+
+		if ((size_t)-1 != nLen) {
+			szTraceFile[nLen] = 0;
+			Start(szTraceFile);
+		}
+	}
+}
+
+CPckClassProfiler::~CPckClassProfiler()
+{
+	if (m_isEnabled) {
+		m_isEnabled = false;
+		if (m_isTracing)
+			WriteTrace();
+	}
+
+	for (LPTHREAD_COUNTERS lpCounters : m_lpAllCounters)
+		delete lpCounters;
+}
+
+uint64_t CPckClassProfiler::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char* CPckClassProfiler::GetStageName(PCK_PROFILE_STAGE stage)
+{
+	if ((0 > stage) || (PROFILE_STAGE_COUNT <= stage))
+		return "";
+	return g_szStageNames[stage];
+}
+
+void CPckClassProfiler::Reset(LPTHREAD_COUNTERS lpCounters)
+{
+	for (int i = 0; i < PROFILE_STAGE_COUNT; i++) {
+		lpCounters->qwNanoseconds[i].store(0, std::memory_order_relaxed);
+		lpCounters->qwCount[i].store(0, std::memory_order_relaxed);
+		lpCounters->qwBytes[i].store(0, std::memory_order_relaxed);
+	}
+
+	std::lock_guard<std::mutex> lckEvents(lpCounters->lockEvents);
+	std::vector<PROFILE_EVENT>().swap(lpCounters->lpEvents);
+	lpCounters->qwDroppedEvents = 0;
+}
+
+void CPckClassProfiler::Start(const wchar_t *lpszTraceFile)
+{
+	m_isEnabled = false;
+
+	std::lock_guard<std::mutex> lckCounters(m_LockCounters);
+
+	for (LPTHREAD_COUNTERS lpCounters : m_lpAllCounters)
+		Reset(lpCounters);
+
+	m_szTraceFile = (nullptr != lpszTraceFile) ? lpszTraceFile : L"";
+	m_isTracing = !m_szTraceFile.empty();
+	m_qwStartAt = Now();
+	m_isEnabled = true;
+}
+
+BOOL CPckClassProfiler::Stop()
+{
+	if (!m_isEnabled.exchange(false))
+		return FALSE;
+
+	if (!m_isTracing)
+		return TRUE;
+
+	m_isTracing = false;
+	return WriteTrace();
+}
+
+CPckClassProfiler::LPTHREAD_COUNTERS CPckClassProfiler::Acquire()
+{
+	std::lock_guard<std::mutex> lckCounters(m_LockCounters);
+
+	if (!m_lpFreeCounters.empty()) {
+		LPTHREAD_COUNTERS lpCounters = m_lpFreeCounters.back();
+		m_lpFreeCounters.pop_back();
+		return lpCounters;
+	}
+
+	LPTHREAD_COUNTERS lpCounters = new THREAD_COUNTERS();
+	Reset(lpCounters);
+	lpCounters->dwThreadID = (uint32_t)m_lpAllCounters.size() + 1;
+	m_lpAllCounters.push_back(lpCounters);
+	return lpCounters;
+}
+
+//The counts stay in the totals, the next thread adds to them
+void CPckClassProfiler::Release(LPTHREAD_COUNTERS lpCounters)
+{
+	std::lock_guard<std::mutex> lckCounters(m_LockCounters);
+	m_lpFreeCounters.push_back(lpCounters);
+}
+
+CPckClassProfiler::LPTHREAD_COUNTERS CPckClassProfiler::GetThreadCounters()
+{
+	static thread_local CPckProfilerThreadSlot cSlot;
+
+	if (nullptr == cSlot.lpCounters)
+		cSlot.lpCounters = Acquire();
+	return cSlot.lpCounters;
+}
+
+void CPckClassProfiler::Add(PCK_PROFILE_STAGE stage, uint64_t qwStart, uint64_t qwEnd, uint64_t qwBytes)
+{
+	if (!IsEnabled())
+		return;
+
+	LPTHREAD_COUNTERS lpCounters = GetThreadCounters();
+
+	//Only this thread writes them, no read-modify-write is needed
+	auto AddTo = [](std::atomic<uint64_t> &qwCounter, uint64_t qwValue) {
+		qwCounter.store(qwCounter.load(std::memory_order_relaxed) + qwValue, std::memory_order_relaxed);
+	};
+
+	AddTo(lpCounters->qwNanoseconds[stage], qwEnd - qwStart);
+	AddTo(lpCounters->qwCount[stage], 1);
+	AddTo(lpCounters->qwBytes[stage], qwBytes);
+
+	if (m_isTracing.load(std::memory_order_relaxed)) {
+
+		std::lock_guard<std::mutex> lckEvents(lpCounters->lockEvents);
+
+		if (PROFILE_MAX_EVENTS_PER_THREAD > lpCounters->lpEvents.size())
+			lpCounters->lpEvents.push_back({ qwStart, qwEnd, qwBytes, stage });
+		else
+			++lpCounters->qwDroppedEvents;
+	}
+}
+
+void CPckClassProfiler::GetStage(PCK_PROFILE_STAGE stage, uint64_t *lpqwNanoseconds, uint64_t *lpqwCount, uint64_t *lpqwBytes)
+{
+	uint64_t qwNanoseconds = 0, qwCount = 0, qwBytes = 0;
+
+	{
+		std::lock_guard<std::mutex> lckCounters(m_LockCounters);
+
+		for (LPTHREAD_COUNTERS lpCounters : m_lpAllCounters) {
+			qwNanoseconds += lpCounters->qwNanoseconds[stage].load(std::memory_order_relaxed);
+			qwCount += lpCounters->qwCount[stage].load(std::memory_order_relaxed);
+			qwBytes += lpCounters->qwBytes[stage].load(std::memory_order_relaxed);
+		}
+	}
+
+	if (nullptr != lpqwNanoseconds)
+		*lpqwNanoseconds = qwNanoseconds;
+	if (nullptr != lpqwCount)
+		*lpqwCount = qwCount;
+	if (nullptr != lpqwBytes)
+		*lpqwBytes = qwBytes;
+}
+
+//Chrome trace event format, complete events in microseconds
+BOOL CPckClassProfiler::WriteTrace()
+{
+	std::string szTrace = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	char szEvent[256];
+	uint64_t qwDroppedEvents = 0;
+	BOOL isFirst = TRUE;
+
+#ifdef _WIN32
+	int iProcessID = (int)GetCurrentProcessId();
+#else
+	int iProcessID = (int)getpid();
+#endif
+
+	{
+		std::lock_guard<std::mutex> lckCounters(m_LockCounters);
+
+		for (LPTHREAD_COUNTERS lpCounters : m_lpAllCounters) {
+
+			std::lock_guard<std::mutex> lckEvents(lpCounters->lockEvents);
+
+			if (lpCounters->lpEvents.empty())
+				continue;
+
+			snprintf(szEvent, sizeof(szEvent), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"pck thread %u\"}}",
+				isFirst ? "" : ",\n", iProcessID, lpCounters->dwThreadID, lpCounters->dwThreadID);
+			szTrace += szEvent;
+			isFirst = FALSE;
+
+			for (const PROFILE_EVENT &cEvent : lpCounters->lpEvents) {
+
+				//A stage entered before profiling started
+				uint64_t qwStart = (cEvent.qwStart > m_qwStartAt) ? (cEvent.qwStart - m_qwStartAt) : 0;
+
+				snprintf(szEvent, sizeof(szEvent), ",\n{\"name\":\"%s\",\"cat\":\"pck\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"bytes\":%llu}}",
+					g_szStageNames[cEvent.stage], iProcessID, lpCounters->dwThreadID,
+					qwStart / 1000.0, (cEvent.qwEnd - cEvent.qwStart) / 1000.0, (unsigned long long)cEvent.qwBytes);
+				szTrace += szEvent;
+			}
+
+			qwDroppedEvents += lpCounters->qwDroppedEvents;
+			std::vector<PROFILE_EVENT>().swap(lpCounters->lpEvents);
+		}
+	}
+
+	szTrace += "\n]}\n";
+
+	if (0 != qwDroppedEvents)
+		Logger.w("Trace: %llu events over the limit of a thread were not kept", (unsigned long long)qwDroppedEvents);
+
+	CMapViewFileWrite cFileWrite;
+
+	if (!cFileWrite.Open(m_szTraceFile.c_str(), CREATE_ALWAYS)) {
+		Logger_el(UCSTEXT(TEXT_OPENWRITENAME_FAIL), m_szTraceFile.c_str());
+		return FALSE;
+	}
+
+	for (size_t nPos = 0; nPos < szTrace.size();) {
+
+		DWORD dwToWrite = (DWORD)std::min<size_t>(szTrace.size() - nPos, PROFILE_WRITE_CHUNK);
+
+		if (dwToWrite != cFileWrite.Write((LPVOID)(szTrace.data() + nPos), dwToWrite)) {
+			Logger_el(TEXT_WRITEFILE_FAIL);
+			return FALSE;
+		}
+		nPos += dwToWrite;
+	}
+	return TRUE;
+}
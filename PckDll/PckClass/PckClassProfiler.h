@@ -0,0 +1,141 @@
+//////////////////////////////////////////////////////////////////////
+// PckClassProfiler.h: time spent in the stages of long operations
+//
+// Every thread adds to its own counters, so the threads never share a
+// cache line or a lock while counting. When a trace file is given the
+// thread also keeps one event per stage it went through, they are written
+// as a Chrome trace (chrome://tracing, Perfetto) when profiling stops.
+// Nothing is counted while profiling is off, apart from one flag test
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "PckDefines.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+typedef enum _PCK_PROFILE_STAGE
+{
+	PROFILE_SOURCE_READ,			//Files to add, entries of a pck or zup being read
+	PROFILE_INFLATE,
+	PROFILE_DEFLATE,
+	PROFILE_QUEUE_WAIT,				//The writer waiting for compressed data
+	PROFILE_MEMORY_WAIT,			//A compress thread waiting for the memory budget
+	PROFILE_WRITE,					//Data written to the pck
+	PROFILE_EXTRACT,				//A file extracted to disk, inflate and write
+	PROFILE_INDEX_READ,
+	PROFILE_INDEX_WRITE,
+	PROFILE_INDEX_BUILD,			//Directory tree built from the index
+	PROFILE_STAGE_COUNT
+}PCK_PROFILE_STAGE;
+
+//Events of one thread kept for the trace
+#define PROFILE_MAX_EVENTS_PER_THREAD	(1024 * 1024)
+
+class CPckClassProfiler
+{
+private:
+	CPckClassProfiler();
+	CPckClassProfiler(const CPckClassProfiler&) = delete;
+	~CPckClassProfiler();
+
+	const CPckClassProfiler& operator=(const CPckClassProfiler&) = delete;
+
+public:
+
+	static CPckClassProfiler& GetInstance() {
+		static CPckClassProfiler onlyInstance;
+		return onlyInstance;
+	}
+
+	//Counting restarts from zero, a trace is kept when lpszTraceFile is not NULL
+	void	Start(const wchar_t *lpszTraceFile);
+	//Writes the trace if one is kept
+	BOOL	Stop();
+
+	BOOL	IsEnabled() const { return m_isEnabled.load(std::memory_order_relaxed); }
+
+	void	Add(PCK_PROFILE_STAGE stage, uint64_t qwStart, uint64_t qwEnd, uint64_t qwBytes);
+
+	//Sums of all threads
+	void	GetStage(PCK_PROFILE_STAGE stage, uint64_t *lpqwNanoseconds, uint64_t *lpqwCount, uint64_t *lpqwBytes);
+
+	static const char*	GetStageName(PCK_PROFILE_STAGE stage);
+	//Nanoseconds of a monotonic clock
+	static uint64_t		Now();
+
+private:
+
+	typedef struct _PROFILE_EVENT
+	{
+		uint64_t			qwStart;
+		uint64_t			qwEnd;
+		uint64_t			qwBytes;
+		PCK_PROFILE_STAGE	stage;
+	}PROFILE_EVENT;
+
+	//Only its thread writes the counters, others may read them at any time
+	typedef struct alignas(64) _THREAD_COUNTERS
+	{
+		std::atomic<uint64_t>	qwNanoseconds[PROFILE_STAGE_COUNT];
+		std::atomic<uint64_t>	qwCount[PROFILE_STAGE_COUNT];
+		std::atomic<uint64_t>	qwBytes[PROFILE_STAGE_COUNT];
+		uint32_t				dwThreadID;
+
+		std::mutex				lockEvents;
+		std::vector<PROFILE_EVENT>	lpEvents;
+		uint64_t				qwDroppedEvents;
+	}THREAD_COUNTERS, *LPTHREAD_COUNTERS;
+
+	friend class CPckProfilerThreadSlot;
+
+	//A thread takes counters at its first event and gives them back when it ends
+	LPTHREAD_COUNTERS	Acquire();
+	void				Release(LPTHREAD_COUNTERS lpCounters);
+	LPTHREAD_COUNTERS	GetThreadCounters();
+
+	static void			Reset(LPTHREAD_COUNTERS lpCounters);
+	BOOL				WriteTrace();
+
+	std::atomic<bool>				m_isEnabled = false;
+	std::atomic<bool>				m_isTracing = false;
+	uint64_t						m_qwStartAt = 0;
+	std::wstring					m_szTraceFile;
+
+	std::mutex						m_LockCounters;
+	std::vector<LPTHREAD_COUNTERS>		m_lpAllCounters;
+	std::vector<LPTHREAD_COUNTERS>		m_lpFreeCounters;
+};
+
+extern CPckClassProfiler& Profiler;
+
+//Adds the time from its construction to its destruction to a stage
+class CPckProfileScope
+{
+public:
+	CPckProfileScope(PCK_PROFILE_STAGE stage, uint64_t qwBytes = 0) :
+		m_stage(stage),
+		m_qwBytes(qwBytes),
+		m_qwStart(Profiler.IsEnabled() ? CPckClassProfiler::Now() : 0)
+	{}
+
+	~CPckProfileScope()
+	{
+		if (0 != m_qwStart)
+			Profiler.Add(m_stage, m_qwStart, CPckClassProfiler::Now(), m_qwBytes);
+	}
+
+	void	SetBytes(uint64_t qwBytes) { m_qwBytes = qwBytes; }
+
+	CPckProfileScope(const CPckProfileScope&) = delete;
+	CPckProfileScope& operator=(const CPckProfileScope&) = delete;
+
+private:
+	PCK_PROFILE_STAGE	m_stage;
+	uint64_t			m_qwBytes;
+	uint64_t			m_qwStart;
+};
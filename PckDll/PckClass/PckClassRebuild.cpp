@@ -28,7 +28,7 @@ BOOL CPckClassWriteOperator::RebuildPckFile(const wchar_t * lpszScriptFile, cons
 	CPckClassRebuildFilter cScriptFilter;
 
 	if ((nullptr != lpszScriptFile) && (0 != *lpszScriptFile)) 
-		cScriptFilter.ApplyScript(lpszScriptFile, &m_PckAllInfo.cRootNode);
+		cScriptFilter.ApplyScript(lpszScriptFile, &m_PathTable);
 
 	return bUseRecompress ? RecompressPckFile(szRebuildPckFile) : RebuildPckFile(szRebuildPckFile);
 }
@@ -38,15 +38,17 @@ BOOL CPckClassWriteOperator::StripPck(const wchar_t * lpszStripedPckFile, int fl
 	//filter first*\textures\*.dds
 	CPckClassRebuildFilter cScriptFilter;
 
-	/*if (PCK_STRIP_DDS & flag) {
-		
+	if (PCK_STRIP_DDS & flag) {
+
 		cScriptFilter.StripModelTexture(
-			m_PckAllInfo.lpPckIndexTable, 
+			m_PckAllInfo.lpPckIndexTable,
 			m_PckAllInfo.dwFileCount,
 			m_PckAllInfo.cRootNode.child,
 			m_PckAllInfo.szFileTitle
 		);
-	}*/
+	}
+
+	//The textures stay marked as deleted until cScriptFilter is gone, the other content is stripped by the compress threads
 	return RecompressPckFile(lpszStripedPckFile, flag);
 }
 
@@ -57,7 +59,6 @@ BOOL CPckClassWriteOperator::RebuildPckFile(const wchar_t * szRebuildPckFile)
 
 	
 	QWORD	dwAddress = PCK_DATA_START_AT;
-	DWORD	dwFileCount = m_PckAllInfo.dwFileCount;
 	DWORD	dwValidFileCount = ReCountFiles();
 	QWORD	dwTotalFileSizeAfterRebuild = GetPckFilesizeRebuild(szRebuildPckFile, m_PckAllInfo.qwPckSize);
 
@@ -69,6 +70,7 @@ BOOL CPckClassWriteOperator::RebuildPckFile(const wchar_t * szRebuildPckFile)
 
 	//Thread tag
 	SetThreadFlag(TRUE);
+	SetParams_Stage(PCK_STAGE_COPY);
 
 	//Set the total value of the interface progress bar
 	SetParams_ProgressUpper(dwValidFileCount);
@@ -88,35 +90,40 @@ BOOL CPckClassWriteOperator::RebuildPckFile(const wchar_t * szRebuildPckFile)
 	vector<PCKINDEXTABLE_COMPRESS> cPckIndexTable(dwValidFileCount);
 
 	//Do not use Enum for traversal processing, use _PCK_INDEX_TABLE instead
+	//The order of the data area is decided by the layout option
+	vector<LPPCKINDEXTABLE> lpOrderedIndex;
+	BuildRebuildOrder(lpOrderedIndex);
 
-	LPPCKINDEXTABLE lpPckIndexTableSource = pckAllInfo.lpPckIndexTable;
 	pckAllInfo.dwFileCountToAdd = 0;
 
-	for(DWORD i = 0; i < dwFileCount; ++i) {
+	for(LPPCKINDEXTABLE lpPckIndexTableSource : lpOrderedIndex) {
 
 		if(CheckIfNeedForcedStopWorking()) {
 			Logger.w(TEXT_USERCANCLE);
 			break;
 		}
 
-		if(lpPckIndexTableSource->isInvalid) {
-			++lpPckIndexTableSource;
-			continue;
-		}
-
 		LPBYTE lpBufferToRead;
 
 		DWORD dwNumberOfBytesToMap = lpPckIndexTableSource->cFileIndex.dwFileCipherTextSize;
-		DWORD dwSrcAddress = lpPckIndexTableSource->cFileIndex.dwAddressOffset;	//Save original address
+		QWORD dwSrcAddress = lpPckIndexTableSource->cFileIndex.dwAddressOffset;	//Save original address
 
 		if (0 != dwNumberOfBytesToMap) {
 
-			if (NULL == (lpBufferToRead = cFileRead.View(dwSrcAddress, dwNumberOfBytesToMap))) {
-				Logger_el(TEXT_VIEWMAP_FAIL);
-				return FALSE;
+			{
+				CPckProfileScope cProfile(PROFILE_SOURCE_READ, dwNumberOfBytesToMap);
+
+				if (NULL == (lpBufferToRead = cFileRead.View(dwSrcAddress, dwNumberOfBytesToMap))) {
+					Logger_el(TEXT_VIEWMAP_FAIL);
+					return FALSE;
+				}
 			}
 
-			cFileWrite.Write2(dwAddress, lpBufferToRead, dwNumberOfBytesToMap);
+			//The mapped pages of the source are read while they are copied
+			{
+				CPckProfileScope cProfile(PROFILE_WRITE, dwNumberOfBytesToMap);
+				cFileWrite.Write2(dwAddress, lpBufferToRead, dwNumberOfBytesToMap);
+			}
 			cFileRead.UnmapViewAll();
 
 		}
@@ -130,7 +137,6 @@ BOOL CPckClassWriteOperator::RebuildPckFile(const wchar_t * szRebuildPckFile)
 
 		lpPckIndexTableSource->cFileIndex.dwAddressOffset = dwSrcAddress;	//Restore original address
 
-		++lpPckIndexTableSource;
 		++(pckAllInfo.dwFileCountToAdd);
 		SetParams_ProgressInc();
 
@@ -195,11 +201,15 @@ BOOL CPckClassWriteOperator::RecompressPckFile(const wchar_t * szRecompressPckFi
 
 #pragma endregion
 
+	//The order of the data area is decided by the layout option
+	vector<LPPCKINDEXTABLE> lpOrderedIndex;
+	BuildRebuildOrder(lpOrderedIndex);
+
 	cThreadParams.cDataFetchMethod.lpFileReadPCK = &cFileRead;
 	cThreadParams.cDataFetchMethod.iStripFlag = iStripMode;
 	cThreadParams.cDataFetchMethod.dwProcessIndex = 0;
-	cThreadParams.cDataFetchMethod.dwTotalIndexCount = pckAllInfo.dwFileCount;
-	cThreadParams.cDataFetchMethod.lpPckIndexTablePtrSrc = pckAllInfo.lpPckIndexTable;
+	cThreadParams.cDataFetchMethod.dwTotalIndexCount = lpOrderedIndex.size();
+	cThreadParams.cDataFetchMethod.lpPckIndexTableOrdered = lpOrderedIndex.data();
 
 	cThreadParams.lpPckClassThreadWorker = this;
 	cThreadParams.lpFileWrite = &cFileWriter;
@@ -103,61 +103,13 @@ BOOL CPckClassRebuildFilter::ParseOneLine(FILEOP * pFileOp, LPCWSTR lpszLine)
 	return TRUE;
 }
 
-//Decompose directories in scripts
-void CPckClassRebuildFilter::SepratePaths(FILEOP * pFileOp)
+//Case-insensitive, as the scripts are written by hand
+LPPCK_PATH_NODE CPckClassRebuildFilter::LocationFileIndex(LPCWSTR lpszPath, const CPckClassPathTable *lpPathTable)
 {
-	wcscpy(pFileOp->szFilenameBuffer, pFileOp->szFilename);
-
-	pFileOp->lpszSepratedPaths[0] = pFileOp->szFilenameBuffer;
-
-	wchar_t *lpszSearch = pFileOp->szFilenameBuffer;
-	int nPathDepthCount = 1;
-
-
-	while(*lpszSearch) {
-
-		wchar_t *test = wcschr(lpszSearch, L'\\');
-		//The presence of \\double slashes is not considered here.
-		if((L'\\' == *lpszSearch) || (L'/' == *lpszSearch)) {
-			*lpszSearch = 0;
-			++lpszSearch;
-			pFileOp->lpszSepratedPaths[nPathDepthCount] = lpszSearch;
-			++nPathDepthCount;
-		}
-		++lpszSearch;
-	}
-
-}
-
-LPPCK_PATH_NODE CPckClassRebuildFilter::LocationFileIndex(LPWSTR *lpszPaths, LPPCK_PATH_NODE lpNode)
-{
-	LPCWSTR lpszSearchDir = *lpszPaths;
-
-	if((NULL == lpszSearchDir) || (NULL == lpNode))
+	if((NULL == lpszPath) || (NULL == lpPathTable))
 		return NULL;
 
-	//Skip directly to the .. directory
-	LPPCK_PATH_NODE lpNodeSearch = lpNode->next;
-
-	while(1) {
-
-		if(NULL == lpNodeSearch)
-			return NULL;
-
-		if(0 == wcsicmp(lpszSearchDir, lpNodeSearch->szName)) {
-
-			//Whether it has been matched
-			if(NULL == *(lpszPaths + 1)) {
-
-				return lpNodeSearch;
-			} else {
-				return LocationFileIndex(lpszPaths + 1, lpNodeSearch->child);
-			}
-		}
-		lpNodeSearch = lpNodeSearch->next;
-	}
-
-	return NULL;
+	return lpPathTable->Find(NULL, lpszPath, TRUE);
 }
 
 void CPckClassRebuildFilter::MarkFilterFlagToFileIndex(LPPCKINDEXTABLE	lpPckIndexTable, SCRIPTOP op)
@@ -202,7 +154,7 @@ void CPckClassRebuildFilter::MarkFilterFlagToNode(LPPCK_PATH_NODE lpNode, SCRIPT
 #pragma region ApplyScript2IndexList, applies the script content to the file list
 
 //Apply script contents to file list
-BOOL CPckClassRebuildFilter::ApplyScript2IndexList(LPPCK_PATH_NODE lpRootNode)
+BOOL CPckClassRebuildFilter::ApplyScript2IndexList(const CPckClassPathTable *lpPathTable)
 {
 	//Whether an error occurred during the parsing process
 	BOOL bHasErrorHappend = FALSE;
@@ -214,11 +166,8 @@ BOOL CPckClassRebuildFilter::ApplyScript2IndexList(LPPCK_PATH_NODE lpRootNode)
 
 		if(OP_CheckFile != pFileOp->op) {
 
-			//Decompose directories in scripts
-			SepratePaths(pFileOp);
-
 			//Locate file index
-			LPPCK_PATH_NODE lpFoundNode = LocationFileIndex(pFileOp->lpszSepratedPaths, lpRootNode->child);
+			LPPCK_PATH_NODE lpFoundNode = LocationFileIndex(pFileOp->szFilename, lpPathTable);
 
 			if(NULL == lpFoundNode) {
 
@@ -293,12 +242,12 @@ void CPckClassRebuildFilter::ResetRebuildFilterInIndexList()
 }
 
 //Apply script content
-BOOL CPckClassRebuildFilter::Apply(LPPCK_PATH_NODE lpRootNode)
+BOOL CPckClassRebuildFilter::Apply(const CPckClassPathTable *lpPathTable)
 {
 	BOOL rtn = FALSE;
 
 	//Apply data to tree
-	rtn = ApplyScript2IndexList(lpRootNode);
+	rtn = ApplyScript2IndexList(lpPathTable);
 
 	if (!rtn) {
 		ResetRebuildFilterInIndexList();
@@ -311,12 +260,12 @@ BOOL CPckClassRebuildFilter::Apply(LPPCK_PATH_NODE lpRootNode)
 	return rtn;
 }
 
-BOOL CPckClassRebuildFilter::ApplyScript(const wchar_t * lpszScriptFile, LPPCK_PATH_NODE lpRootNode)
+BOOL CPckClassRebuildFilter::ApplyScript(const wchar_t * lpszScriptFile, const CPckClassPathTable *lpPathTable)
 {
 	if (!ParseScript(lpszScriptFile))
 		return FALSE;
 
-	return Apply(lpRootNode);
+	return Apply(lpPathTable);
 }
 
 BOOL CPckClassRebuildFilter::TestScript(const wchar_t * lpszScriptFile)
@@ -340,6 +289,9 @@ BOOL CPckClassRebuildFilter::ModelTextureCheck(LPCWSTR lpszFilename)
 
 	lpszTexturePath += wcslen(constTexturePath);
 
+	if (wcslen(lpszTexturePath) < wcslen(constDdsExt))
+		return FALSE;
+
 	LPCWSTR subdir = wcschr(lpszTexturePath, L'\\');
 	if (nullptr != subdir) {
 		if (nullptr != wcschr(subdir+1, L'\\'))
@@ -360,10 +312,10 @@ void CPckClassRebuildFilter::StripModelTexture(LPPCKINDEXTABLE lpPckIndexHead, D
 {
 
 	int nDetectOffset = 0;
-#if 0
+
 	//Detect whether the folder in the pck directory starts with the pck file name
 	//For example, the root directory in gfx.pck is gfx and there is only one
-	LPPCK_PATH_NODE lpRootNodeFirstDir = lpRootNode->next;
+	LPPCK_PATH_NODE lpRootNodeFirstDir = (nullptr != lpRootNode) ? lpRootNode->next : nullptr;
 	int nRootDirCount = 0;
 	vector<wstring> sRootDirs;
 
@@ -390,7 +342,7 @@ void CPckClassRebuildFilter::StripModelTexture(LPPCKINDEXTABLE lpPckIndexHead, D
 		}
 
 		//Compared
-		for (int i = 0; i < sRootDirs.size(); i++) {
+		for (size_t i = 0; i < sRootDirs.size(); i++) {
 
 			if (nullptr != wcsstr(szFileTitle, sRootDirs[i].c_str())) {
 
@@ -399,7 +351,6 @@ void CPckClassRebuildFilter::StripModelTexture(LPPCKINDEXTABLE lpPckIndexHead, D
 			}
 		}
 	}
-#endif
 
 	LPPCKINDEXTABLE lpPckIndexTable = lpPckIndexHead;
 
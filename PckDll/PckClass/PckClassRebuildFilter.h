@@ -2,6 +2,7 @@
 #include <string>
 #include "PckClassLog.h"
 #include "PckStructs.h"
+#include "PckClassPathTable.h"
 
 class CPckClassRebuildFilter
 {
@@ -12,15 +13,13 @@ private:
 	{
 		SCRIPTOP op;
 		wchar_t	szFilename[MAX_PATH];
-		wchar_t	szFilenameBuffer[MAX_PATH];		//Fill in \ or / in the path with 0, and use lpszSepratedPaths to point to the separate path names.
-		wchar_t*	lpszSepratedPaths[MAX_PATH];
 	}FILEOP;
 
 public:
 	CPckClassRebuildFilter();
 	~CPckClassRebuildFilter();
 
-	BOOL	ApplyScript(const wchar_t * lpszScriptFile, LPPCK_PATH_NODE lpRootNode);
+	BOOL	ApplyScript(const wchar_t * lpszScriptFile, const CPckClassPathTable *lpPathTable);
 	BOOL	TestScript(const wchar_t * lpszScriptFile);
 
 	void	StripModelTexture(LPPCKINDEXTABLE lpPckIndexHead, DWORD dwFileCount, LPPCK_PATH_NODE lpRootNode, LPCWSTR lpszPckFilename);
@@ -39,15 +38,14 @@ private:
 
 	BOOL	OpenScriptFileAndConvBufToUcs2(const wchar_t * lpszScriptFile);
 
-	BOOL	ApplyScript2IndexList(LPPCK_PATH_NODE lpRootNode);
+	BOOL	ApplyScript2IndexList(const CPckClassPathTable *lpPathTable);
 	void	MarkFilterFlagToNode(LPPCK_PATH_NODE lpNode, SCRIPTOP op);
 	void	MarkFilterFlagToFileIndex(LPPCKINDEXTABLE	lpPckIndexTable, SCRIPTOP op);
-	LPPCK_PATH_NODE LocationFileIndex(LPWSTR *lpszPaths, LPPCK_PATH_NODE lpNode);
-	void	SepratePaths(FILEOP * pFileOp);
+	LPPCK_PATH_NODE LocationFileIndex(LPCWSTR lpszPath, const CPckClassPathTable *lpPathTable);
 	BOOL	ParseOneLine(FILEOP * pFileOp, LPCWSTR lpszLine);
 	BOOL	ParseScript(const wchar_t * lpszScriptFile);
 
-	BOOL	Apply(LPPCK_PATH_NODE lpRootNode);
+	BOOL	Apply(const CPckClassPathTable *lpPathTable);
 	BOOL	ModelTextureCheck(LPCWSTR lpszFilename);
 	void	ResetRebuildFilterInIndexList();
 
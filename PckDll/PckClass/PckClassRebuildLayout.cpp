@@ -0,0 +1,202 @@
+//////////////////////////////////////////////////////////////////////
+// PckClassRebuildLayout.cpp: decide the order in which file data is written when rebuilding
+//
+// Files that are read together are stored together, so that the game
+// reads fewer and more sequential pages from the rebuilt pck
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "PckClassWriteOperator.h"
+#include "MapViewFileMultiPck.h"
+#include "CharsCodeConv.h"
+#include "TextLineSpliter.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#pragma region Sort key
+
+//Lowercase, unify separators to '\' and drop the leading separator
+static void LayoutNormalizePath(const wchar_t *lpszPath, wstring &szOut)
+{
+	while ((L'\\' == *lpszPath) || (L'/' == *lpszPath))
+		++lpszPath;
+
+	szOut.clear();
+	for (; *lpszPath; ++lpszPath) {
+		wchar_t ch = *lpszPath;
+		szOut.push_back((L'/' == ch) ? L'\\' : towlower(ch));
+	}
+}
+
+//Files directly in a directory must stay together, so the directory is terminated by a character smaller than '\'
+static void LayoutKeyByDirectory(const wstring &szPath, wstring &szKey)
+{
+	size_t pos = szPath.rfind(L'\\');
+
+	if (wstring::npos == pos) {
+		szKey.assign(1, L'\1');
+		szKey.append(szPath);
+	}
+	else {
+		szKey.assign(szPath, 0, pos);
+		szKey.push_back(L'\1');
+		szKey.append(szPath, pos + 1, wstring::npos);
+	}
+}
+
+static void LayoutKeyByExtension(const wstring &szPath, wstring &szKey)
+{
+	size_t posSep = szPath.rfind(L'\\');
+	size_t posExt = szPath.rfind(L'.');
+
+	if ((wstring::npos == posExt) || ((wstring::npos != posSep) && (posExt < posSep)))
+		szKey.clear();
+	else
+		szKey.assign(szPath, posExt + 1, wstring::npos);
+
+	wstring szDirKey;
+	LayoutKeyByDirectory(szPath, szDirKey);
+
+	szKey.push_back(L'\1');
+	szKey.append(szDirKey);
+}
+
+#pragma endregion
+
+#pragma region Access list
+
+BOOL CPckClassWriteOperator::ReadLayoutAccessList(const wchar_t *lpszListFile, unordered_map<wstring, uint32_t> &mapRank)
+{
+	CMapViewFileRead	cFileRead;
+	char				*lpBufferToRead;
+
+	if ((nullptr == lpszListFile) || (0 == *lpszListFile))
+		return FALSE;
+
+	//The caller warns, the rebuild goes on in the original order
+	if (nullptr == (lpBufferToRead = (char*)cFileRead.OpenMappingViewAllRead(lpszListFile)))
+		return FALSE;
+
+	CTextConv2UCS2 cText2Ucs;
+	const wchar_t* lpszUnicodeString = cText2Ucs.GetUnicodeString(lpBufferToRead, cFileRead.GetFileSize());
+
+	vector<wstring> lines;
+	CTextUnitsW::SplitLine(lpszUnicodeString, lines, LINE_TRIM_LEFT | LINE_TRIM_RIGHT | LINE_EMPTY_DELETE);
+
+	mapRank.reserve(lines.size());
+
+	wstring szKey;
+	uint32_t rank = 0;
+	for (const wstring &line : lines) {
+
+		//comment line
+		if (L'#' == line[0])
+			continue;
+
+		LayoutNormalizePath(line.c_str(), szKey);
+		//The first occurrence of a path wins
+		if (mapRank.emplace(szKey, rank).second)
+			++rank;
+	}
+	return TRUE;
+}
+
+#pragma endregion
+
+//Collect the valid entries of the index in the order their data should be written
+void CPckClassWriteOperator::BuildRebuildOrder(vector<LPPCKINDEXTABLE> &lpOrderedIndex)
+{
+	LPPCKINDEXTABLE lpPckIndexTable = m_PckAllInfo.lpPckIndexTable;
+	DWORD dwFileCount = m_PckAllInfo.dwFileCount;
+	int iLayout = (nullptr == m_lpPckParams) ? PCK_LAYOUT_ORIGINAL : m_lpPckParams->iRebuildLayout;
+
+	lpOrderedIndex.clear();
+	lpOrderedIndex.reserve(dwFileCount);
+
+	for (DWORD i = 0; i < dwFileCount; ++i, ++lpPckIndexTable) {
+		if (!lpPckIndexTable->isInvalid)
+			lpOrderedIndex.push_back(lpPckIndexTable);
+	}
+
+	if (PCK_LAYOUT_ORIGINAL == iLayout)
+		return;
+
+	typedef std::pair<wstring, LPPCKINDEXTABLE> LAYOUT_KEY;
+	vector<LAYOUT_KEY> keys(lpOrderedIndex.size());
+	wstring szPath;
+
+	switch (iLayout) {
+	case PCK_LAYOUT_BY_DIRECTORY:
+
+		Logger.i(TEXT_LOG_REBUILD_LAYOUT, "by directory");
+		for (size_t i = 0; i < lpOrderedIndex.size(); ++i) {
+			LayoutNormalizePath(lpOrderedIndex[i]->cFileIndex.szwFilename, szPath);
+			LayoutKeyByDirectory(szPath, keys[i].first);
+			keys[i].second = lpOrderedIndex[i];
+		}
+		break;
+
+	case PCK_LAYOUT_BY_EXTENSION:
+
+		Logger.i(TEXT_LOG_REBUILD_LAYOUT, "by extension");
+		for (size_t i = 0; i < lpOrderedIndex.size(); ++i) {
+			LayoutNormalizePath(lpOrderedIndex[i]->cFileIndex.szwFilename, szPath);
+			LayoutKeyByExtension(szPath, keys[i].first);
+			keys[i].second = lpOrderedIndex[i];
+		}
+		break;
+
+	case PCK_LAYOUT_ACCESS_LIST:
+	{
+		unordered_map<wstring, uint32_t> mapRank;
+		if (!ReadLayoutAccessList(m_lpPckParams->lpszLayoutListFile, mapRank)) {
+			Logger.w(TEXT_LOG_LAYOUT_LIST_FAIL, (nullptr == m_lpPckParams->lpszLayoutListFile) ? L"" : m_lpPckParams->lpszLayoutListFile);
+			return;
+		}
+
+		Logger.i(TEXT_LOG_REBUILD_LAYOUT, "by access list");
+
+		vector<std::pair<uint32_t, LPPCKINDEXTABLE>> ranks(lpOrderedIndex.size());
+		uint32_t dwMatched = 0;
+
+		for (size_t i = 0; i < lpOrderedIndex.size(); ++i) {
+			LayoutNormalizePath(lpOrderedIndex[i]->cFileIndex.szwFilename, szPath);
+
+			auto it = mapRank.find(szPath);
+			if (mapRank.end() != it) {
+				ranks[i].first = it->second;
+				++dwMatched;
+			}
+			else {
+				//Unlisted files keep their original order after the listed ones
+				ranks[i].first = UINT32_MAX;
+			}
+			ranks[i].second = lpOrderedIndex[i];
+		}
+
+		Logger.i(TEXT_LOG_LAYOUT_LIST, dwMatched, (int)lpOrderedIndex.size());
+
+		std::stable_sort(ranks.begin(), ranks.end(), [](const std::pair<uint32_t, LPPCKINDEXTABLE> &a, const std::pair<uint32_t, LPPCKINDEXTABLE> &b) {
+			return a.first < b.first;
+		});
+
+		for (size_t i = 0; i < ranks.size(); ++i)
+			lpOrderedIndex[i] = ranks[i].second;
+		return;
+	}
+
+	default:
+		Logger.w(TEXT_LOG_REBUILD_LAYOUT, "unknown, keep original order");
+		return;
+	}
+
+	std::stable_sort(keys.begin(), keys.end(), [](const LAYOUT_KEY &a, const LAYOUT_KEY &b) {
+		return a.first < b.first;
+	});
+
+	for (size_t i = 0; i < keys.size(); ++i)
+		lpOrderedIndex[i] = keys[i].second;
+}
@@ -19,6 +19,34 @@
 
 #include "Raw2HexString.h"
 
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+//All known versions, shared by every opened pck.
+//A deque keeps lpSaveAsPckVerFunc of opened pcks valid while versions are added,
+//it is created on first use because global CPckControlCenter objects may be constructed before this file is initialized
+static std::deque<PCK_VERSION_FUNC>& PckVersionList()
+{
+	static std::deque<PCK_VERSION_FUNC> cPckVersionFunc;
+	return cPckVersionFunc;
+}
+static std::mutex			cPckVersionLock;
+
+//GuardByte1 of the algorithm ids below MAX_SEARCH_DEPTH -> the smallest id with it,
+//built on the first unknown pck, cPckVersionLock must be held
+static std::unordered_map<uint32_t, uint32_t>& PckGuardIdMap()
+{
+	static std::unordered_map<uint32_t, uint32_t> cGuardIds;
+
+	if (cGuardIds.empty()) {
+		cGuardIds.reserve(MAX_SEARCH_DEPTH);
+		for (uint32_t i = 0; i < MAX_SEARCH_DEPTH; i++)
+			cGuardIds.emplace(CPckAlgorithmId(i).GetPckGuardByte1(), i);
+	}
+	return cGuardIds;
+}
+
 #pragma region illustrate
 
 /*
@@ -104,7 +132,9 @@ Among them, 78 DA ** ** ** ** ** ** is the check header of zlib, usually 78 01(1
 
 CPckClassVersionDetect::CPckClassVersionDetect()
 {
-	if (cPckVersionFunc.empty()) {
+	std::lock_guard<std::mutex> lckVersion(cPckVersionLock);
+
+	if (PckVersionList().empty()) {
 		FillGeneralVersionInfo();
 		FillSpecialVersionInfo();
 	}
@@ -148,21 +178,25 @@ const PCK_VERSION_FUNC CPckClassVersionDetect::cPckSPVersionFunc[] =
 
 
 template<typename T, typename X>
-BOOL get_pckAllInfo_by_version(CMapViewFileMultiPckRead& cRead, T& pckTail, PCK_ALL_INFOS& pckAllInfo, X* pPckHead, int id, uint64_t& qwPckSizeInHeader)
+BOOL get_pckAllInfo_by_version(const PCK_DETECT_DATA& cDetectData, PCK_ALL_INFOS& pckAllInfo, const X* pPckHead, const PCK_KEYS& cPckKeys)
 {
-	cRead.SetFilePointer(qwPckSizeInHeader - ((uint64_t)(sizeof(T))), FILE_BEGIN);
-	if (!cRead.Read(&pckTail, sizeof(T))) {
-		throw MyExceptionEx(TEXT_READFILE_FAIL);
-	}
-	if (cPckVersionFunc[id].cPckXorKeys.TailVerifyKey1 == pckTail.dwIndexTableCheckHead) {
+	if (sizeof(T) > cDetectData.dwTailSize)
+		return FALSE;
+
+	T pckTail;
+	memcpy(&pckTail, cDetectData.szTail + cDetectData.dwTailSize - sizeof(T), sizeof(T));
+
+	if (cPckKeys.TailVerifyKey1 == pckTail.dwIndexTableCheckHead) {
 		pckAllInfo.qwPckSize = pPckHead->dwPckSize;
-		pckAllInfo.dwAddressOfFileEntry = pckTail.dwEntryOffset ^ cPckVersionFunc[id].cPckXorKeys.IndexesEntryAddressCryptKey;
+		pckAllInfo.dwAddressOfFileEntry = pckTail.dwEntryOffset ^ cPckKeys.IndexesEntryAddressCryptKey;
 		memcpy(pckAllInfo.szAdditionalInfo, pckTail.szAdditionalInfo, PCK_ADDITIONAL_INFO_SIZE);
 		return TRUE;
 	}
 	return FALSE;
 }
 
+static_assert((sizeof(PCKTAIL_V2020) <= PCK_DETECT_TAIL_SIZE) && (sizeof(PCKTAIL_V2030) <= PCK_DETECT_TAIL_SIZE) && (sizeof(PCKTAIL_VXAJH) <= PCK_DETECT_TAIL_SIZE), "PCK_DETECT_TAIL_SIZE is too small");
+
 void CPckClassVersionDetect::FillGeneralVersionInfo()
 {
 	PCK_VERSION_FUNC cPckVersionFuncToAdd;
@@ -178,7 +212,7 @@ void CPckClassVersionDetect::FillGeneralVersionInfo()
 
 		SetAlgorithmId(lpPckIDs->AlgorithmId, &cPckVersionFuncToAdd);
 
-		cPckVersionFunc.push_back(cPckVersionFuncToAdd);
+		PckVersionList().push_back(cPckVersionFuncToAdd);
 
 		++lpPckIDs;
 	}
@@ -194,7 +228,7 @@ void CPckClassVersionDetect::FillSpecialVersionInfo()
 
 		memcpy(&cPckVersionFuncToAdd, lpPckVersionFuncSP, sizeof(PCK_VERSION_FUNC));
 
-		cPckVersionFunc.push_back(cPckVersionFuncToAdd);
+		PckVersionList().push_back(cPckVersionFuncToAdd);
 
 		++lpPckVersionFuncSP;
 	}
@@ -208,15 +242,15 @@ int CPckClassVersionDetect::FillUnknownVersionInfo(DWORD AlgorithmId, DWORD Vers
 
 		LPPCK_KEYS lpUnknownPckKeys = &cPckVersionFuncToAdd.cPckXorKeys;
 		LPPCK_VERSION_FUNC lpUnknownPckVersionFunc = &cPckVersionFuncToAdd;
-		lpUnknownPckKeys->id = cPckVersionFunc.size();
+		lpUnknownPckKeys->id = PckVersionList().size();
 		swprintf_s(lpUnknownPckKeys->name, 256, L"Unknown format recognized(ver=0x%x id=%d)", Version, AlgorithmId);
 		lpUnknownPckKeys->CategoryId = AFPCK_VERSION_202 == Version ? PCK_V2020 : PCK_V2030;
 		lpUnknownPckKeys->Version = Version;
 
 		SetAlgorithmId(AlgorithmId, &cPckVersionFuncToAdd);
-		cPckVersionFunc.push_back(cPckVersionFuncToAdd);
+		PckVersionList().push_back(cPckVersionFuncToAdd);
 
-		return cPckVersionFunc.size() - 1;
+		return PckVersionList().size() - 1;
 	}
 	return PCK_VERSION_INVALID;
 }
@@ -229,7 +263,7 @@ int CPckClassVersionDetect::FillUnknownVersionInfoByKeys(DWORD AlgorithmId, DWOR
 
 		LPPCK_KEYS lpUnknownPckKeys = &cPckVersionFuncToAdd.cPckXorKeys;
 		LPPCK_VERSION_FUNC lpUnknownPckVersionFunc = &cPckVersionFuncToAdd;
-		lpUnknownPckKeys->id = cPckVersionFunc.size();
+		lpUnknownPckKeys->id = PckVersionList().size();
 		if (Name && wcslen(Name) > 0) 
 		{
 			wcscpy_s(lpUnknownPckKeys->name, Name);
@@ -242,21 +276,23 @@ int CPckClassVersionDetect::FillUnknownVersionInfoByKeys(DWORD AlgorithmId, DWOR
 		lpUnknownPckKeys->Version = Version;
 
 		SetAlgorithmId(AlgorithmId, &cPckVersionFuncToAdd, CustomPckGuardByte0, CustomPckGuardByte1, CustomPckMaskDword, CustomPckCheckMask);
-		//cPckVersionFunc.push_back(cPckVersionFuncToAdd);
-		cPckVersionFunc.insert(cPckVersionFunc.begin(), cPckVersionFuncToAdd);
+		//PckVersionList().push_back(cPckVersionFuncToAdd);
+		PckVersionList().insert(PckVersionList().begin(), cPckVersionFuncToAdd);
 
-		return cPckVersionFunc.size() - 1;
+		return PckVersionList().size() - 1;
 	}
 	return PCK_VERSION_INVALID;
 }
 
 int	CPckClassVersionDetect::AddPckVersion(int AlgorithmId, int Version)
 {
+	std::lock_guard<std::mutex> lckVersion(cPckVersionLock);
 	return FillUnknownVersionInfo(AlgorithmId, Version);
 }
 
 int	CPckClassVersionDetect::AddPckVersionByKeys(int AlgorithmId, int Version, const wchar_t* Name, int CustomPckGuardByte0, int CustomPckGuardByte1, int CustomPckMaskDword, int CustomPckCheckMask)
 {
+	std::lock_guard<std::mutex> lckVersion(cPckVersionLock);
 	return FillUnknownVersionInfoByKeys(AlgorithmId, Version, Name, CustomPckGuardByte0, CustomPckGuardByte1, CustomPckMaskDword, CustomPckCheckMask);
 }
 
@@ -311,13 +347,15 @@ const PCK_KEYS* CPckClassVersionDetect::GetPckVersion()
 
 BOOL CPckClassVersionDetect::SetSavePckVersion(int verID)
 {
-	if (cPckVersionFunc.empty()) {
+	std::lock_guard<std::mutex> lckVersion(cPckVersionLock);
+
+	if (PckVersionList().empty()) {
 		FillGeneralVersionInfo();
 		FillSpecialVersionInfo();
 	}
 
-	if (0 <= verID && cPckVersionFunc.size() > verID) {
-		m_PckAllInfo.lpSaveAsPckVerFunc = &cPckVersionFunc[verID];
+	if (0 <= verID && PckVersionList().size() > verID) {
+		m_PckAllInfo.lpSaveAsPckVerFunc = &PckVersionList()[verID];
 		return TRUE;
 	}
 	else
@@ -328,18 +366,22 @@ BOOL CPckClassVersionDetect::SetSavePckVersion(int verID)
 
 const wchar_t* CPckClassVersionDetect::GetPckVersionNameById(int id)
 {
-	if ((id >= 0) && (cPckVersionFunc.size() > id))
-		return cPckVersionFunc[id].cPckXorKeys.name;
+	std::lock_guard<std::mutex> lckVersion(cPckVersionLock);
+
+	if ((id >= 0) && (PckVersionList().size() > id))
+		return PckVersionList()[id].cPckXorKeys.name;
 	return L"";
 }
 
 uint32_t CPckClassVersionDetect::GetPckVersionCount()
 {
-	if (cPckVersionFunc.empty()) {
+	std::lock_guard<std::mutex> lckVersion(cPckVersionLock);
+
+	if (PckVersionList().empty()) {
 		FillGeneralVersionInfo();
 		FillSpecialVersionInfo();
 	}
-	return cPckVersionFunc.size();
+	return PckVersionList().size();
 }
 
 
@@ -415,163 +457,158 @@ dect_err:
 #undef PRINT_HEAD_SIZE
 #undef PRINT_TAIL_SIZE
 
-//Read the file header and tail to determine the pck file version and return the version ID
-BOOL CPckClassVersionDetect::DetectPckVerion(LPCWSTR lpszPckFile, int next)
+//Read the file header and the bytes in front of the size recorded in it
+BOOL CPckClassVersionDetect::ReadPckHeadTail(LPCWSTR lpszPckFile, PCK_DETECT_DATA &cDetectData)
 {
-	PCKHEAD_V2020 cPckHead;
-	uint32_t	dwTailVals[4];
-	size_t		dwVerionDataCount = cPckVersionFunc.size();
-
-	int iDetectedPckID = PCK_VERSION_INVALID;
-	//Read file header
 	CMapViewFileMultiPckRead cRead;
+	const PCKHEAD_V2020 &cPckHead = cDetectData.cPckHead;
 
-	uint64_t qwSizeFileBefore = 0;
-	BOOL isFoundVer = FALSE;
-	PCK_CATEGORY ver = PCK_INVALID; // Assuming PCK_VERSION_INVALID is a valid default value
-	uint64_t qwPckSizeInHeader = 0;
+	memset(&cDetectData, 0, sizeof(PCK_DETECT_DATA));
 
 	if (!cRead.OpenPck(lpszPckFile)) {
 		Logger_el(TEXT_OPENNAME_FAIL, lpszPckFile);
-		goto dect_err;
+		goto read_err;
 	}
 
-	if (!cRead.Read(&cPckHead, sizeof(PCKHEAD_V2020))) {
+	if (!cRead.Read(&cDetectData.cPckHead, sizeof(PCKHEAD_V2020))) {
 		Logger_el(TEXT_READFILE_FAIL);
-		goto dect_err;
+		goto read_err;
 	}
 
 	//Determine whether the file size is 64-bit and whether the file size in the head matches the actual size.
-	qwPckSizeInHeader = (0x100 < cPckHead.dwHeadCheckTail) ? cPckHead.dwPckSize : ((PCKHEAD_V2030*)&cPckHead)->dwPckSize;
+	cDetectData.qwPckSizeInHeader = (0x100 < cPckHead.dwHeadCheckTail) ? cPckHead.dwPckSize : ((PCKHEAD_V2030*)&cPckHead)->dwPckSize;
 
-	if (qwPckSizeInHeader > cRead.GetFileSize())
-		throw MyException("size in header is bigger than file size");
+	cDetectData.qwFileSize = cRead.GetFileSize();
 
-	cRead.SetFilePointer(qwPckSizeInHeader - ((uint64_t)(sizeof(uint32_t) * 4)), FILE_BEGIN);
+	if (cDetectData.qwPckSizeInHeader > cDetectData.qwFileSize)
+		throw MyException("size in header is bigger than file size");
 
-	if (!cRead.Read(&dwTailVals, sizeof(uint32_t) * 4)) {
+	if ((sizeof(uint32_t) * 4) > cDetectData.qwPckSizeInHeader) {
 		Logger_el(TEXT_READFILE_FAIL);
-		goto dect_err;
+		goto read_err;
 	}
 
-	//dwTailVals[3] is the 4 bytes at the end of the file and generally stores the version
-	if (AFPCK_VERSION_203 == dwTailVals[3]) {
-		if (0 != dwTailVals[0])
-			dwTailVals[1] = dwTailVals[0];
+	cDetectData.dwTailSize = (PCK_DETECT_TAIL_SIZE < cDetectData.qwPckSizeInHeader) ? PCK_DETECT_TAIL_SIZE : (uint32_t)cDetectData.qwPckSizeInHeader;
 
-		for (int i = next; i < dwVerionDataCount; i++) {
-			if ((cPckVersionFunc[i].cPckXorKeys.Version == AFPCK_VERSION_203) &&
-				(cPckVersionFunc[i].cPckXorKeys.TailVerifyKey2 == dwTailVals[1]) &&
-				(cPckVersionFunc[i].cPckXorKeys.HeadVerifyKey1 == cPckHead.dwHeadCheckHead)) {
+	cRead.SetFilePointer(cDetectData.qwPckSizeInHeader - cDetectData.dwTailSize, FILE_BEGIN);
 
-				iDetectedPckID = i;
-				break;
-			}
-		}
+	if (!cRead.Read(cDetectData.szTail, cDetectData.dwTailSize)) {
+		Logger_el(TEXT_READFILE_FAIL);
+		goto read_err;
 	}
-	else {
 
-		//When the version is 202, the value of TailVerifyKey2 may be HeadVerifyKey2 or 0. This example has appeared on the pck file of the game: Gods and Demons.
-		for (int i = next; i < dwVerionDataCount; i++) {
-			if ((cPckVersionFunc[i].cPckXorKeys.Version == dwTailVals[3]) &&
-				(cPckVersionFunc[i].cPckXorKeys.TailVerifyKey2 == dwTailVals[1]) &&
-				(cPckVersionFunc[i].cPckXorKeys.HeadVerifyKey1 == cPckHead.dwHeadCheckHead) &&
-				((cPckVersionFunc[i].cPckXorKeys.HeadVerifyKey2 == cPckHead.dwHeadCheckTail) || (0 == cPckHead.dwHeadCheckTail))) {
+	return TRUE;
 
-				iDetectedPckID = i;
-				break;
-			}
-		}
+read_err:
+	PrintInvalidVersionDebugInfo(lpszPckFile);
+	return FALSE;
+}
+
+BOOL CPckClassVersionDetect::IsVersionMatched(const PCK_KEYS &cPckKeys, const PCKHEAD_V2020 &cPckHead, const uint32_t *dwTailVals)
+{
+	if ((cPckKeys.TailVerifyKey2 != dwTailVals[1]) || (cPckKeys.HeadVerifyKey1 != cPckHead.dwHeadCheckHead))
+		return FALSE;
+
+	if (AFPCK_VERSION_203 == dwTailVals[3])
+		return (AFPCK_VERSION_203 == cPckKeys.Version);
+
+	//When the version is 202, the value of TailVerifyKey2 may be HeadVerifyKey2 or 0. This example has appeared on the pck file of the game: Gods and Demons.
+	return (cPckKeys.Version == dwTailVals[3]) &&
+		((cPckKeys.HeadVerifyKey2 == cPckHead.dwHeadCheckTail) || (0 == cPckHead.dwHeadCheckTail));
+}
+
+//Check the tail with the keys of the version and take the index address from it
+BOOL CPckClassVersionDetect::ReadTailByVersion(const PCK_DETECT_DATA &cDetectData, const PCK_VERSION_FUNC &cPckVersionFunc)
+{
+	const PCK_KEYS &cPckKeys = cPckVersionFunc.cPckXorKeys;
+
+	switch (cPckKeys.CategoryId) {
+	case PCK_V2020:
+		return get_pckAllInfo_by_version<PCKTAIL_V2020>(cDetectData, m_PckAllInfo, &cDetectData.cPckHead, cPckKeys);
+
+	case PCK_V2030:
+		return get_pckAllInfo_by_version<PCKTAIL_V2030>(cDetectData, m_PckAllInfo, (const PCKHEAD_V2030*)&cDetectData.cPckHead, cPckKeys);
+
+	case PCK_VXAJH:
+		return get_pckAllInfo_by_version<PCKTAIL_VXAJH>(cDetectData, m_PckAllInfo, (const PCKHEAD_VXAJH*)&cDetectData.cPckHead, cPckKeys);
 	}
+	return FALSE;
+}
 
-	//All formats have been traversed and started to identify whether it is a standard pck format
-	if (PCK_VERSION_INVALID == iDetectedPckID) {
+//Determine the pck file version from the header and tail read by ReadPckHeadTail
+BOOL CPckClassVersionDetect::DetectPckVerion(LPCWSTR lpszPckFile, const PCK_DETECT_DATA &cDetectData, int &next)
+{
+	//Unknown versions found here are added to the shared list
+	std::lock_guard<std::mutex> lckVersion(cPckVersionLock);
+
+	const PCKHEAD_V2020 &cPckHead = cDetectData.cPckHead;
+	uint32_t	dwTailVals[4];
+	int			dwVerionDataCount = (int)PckVersionList().size();
 
-		if (AFPCK_SAFEHEAFER_TAG1 == cPckHead.dwHeadCheckHead) {
-			//Verify unknown formats, temporarily traverse to 10000 by default
-			for (int i = 0; i < MAX_SEARCH_DEPTH; i++) {
+	int iDetectedPckID = PCK_VERSION_INVALID;
+	uint64_t qwSizeFileBefore = 0;
 
-				CPckAlgorithmId AlgorithmId(i);
+	//dwTailVals[3] is the 4 bytes at the end of the file and generally stores the version
+	memcpy(dwTailVals, cDetectData.szTail + cDetectData.dwTailSize - sizeof(dwTailVals), sizeof(dwTailVals));
 
-				if (AlgorithmId.GetPckGuardByte1() == dwTailVals[1]) {
+	if ((AFPCK_VERSION_203 == dwTailVals[3]) && (0 != dwTailVals[0]))
+		dwTailVals[1] = dwTailVals[0];
 
-					iDetectedPckID = FillUnknownVersionInfo(i, dwTailVals[3]);
-					////Rebuild dialog pck list
-					//BuildSaveDlgFilterString();
-					break;
-				}
+	for (int i = next; i < dwVerionDataCount; i++) {
+		if (IsVersionMatched(PckVersionList()[i].cPckXorKeys, cPckHead, dwTailVals) && ReadTailByVersion(cDetectData, PckVersionList()[i])) {
 
-			}
+			iDetectedPckID = i;
+			break;
 		}
 	}
 
-	if (PCK_VERSION_INVALID == iDetectedPckID) {
+	//All formats have been traversed and started to identify whether it is a standard pck format
+	if ((PCK_VERSION_INVALID == iDetectedPckID) && (AFPCK_SAFEHEAFER_TAG1 == cPckHead.dwHeadCheckHead)) {
 
-		Logger_el(TEXT_VERSION_NOT_FOUND);
-		goto dect_err;
-	}
+		//A known version with these keys has been tried already
+		BOOL isTried = FALSE;
+		for (int i = 0; (i < next) && (i < dwVerionDataCount) && (!isTried); i++)
+			isTried = IsVersionMatched(PckVersionList()[i].cPckXorKeys, cPckHead, dwTailVals);
 
-	ver = cPckVersionFunc[iDetectedPckID].cPckXorKeys.CategoryId;
-	isFoundVer = FALSE;
+		if (!isTried) {
 
-	switch (ver) {
-	case PCK_V2020:
+			auto itGuardId = PckGuardIdMap().find(dwTailVals[1]);
 
-		try {
-			PCKTAIL_V2020 PckTail;
-			isFoundVer = get_pckAllInfo_by_version(cRead, PckTail, m_PckAllInfo, &cPckHead, iDetectedPckID, qwPckSizeInHeader);
-		}
-		catch (MyException ex) {
-			Logger.e(ex.what());
-			goto dect_err;
-		}
-		break;
+			if (PckGuardIdMap().end() != itGuardId) {
 
-	case PCK_V2030:
-		try {
-			PCKTAIL_V2030 PckTail;
-			isFoundVer = get_pckAllInfo_by_version(cRead, PckTail, m_PckAllInfo, (PCKHEAD_V2030*)&cPckHead, iDetectedPckID, qwPckSizeInHeader);
-		}
-		catch (MyException ex) {
-			Logger.e(ex.what());
-			goto dect_err;
-		}
-		break;
-	case PCK_VXAJH:
-		try {
-			PCKTAIL_VXAJH PckTail;
-			isFoundVer = get_pckAllInfo_by_version(cRead, PckTail, m_PckAllInfo, (PCKHEAD_VXAJH*)&cPckHead, iDetectedPckID, qwPckSizeInHeader);
-		}
-		catch (MyException ex) {
-			Logger.e(ex.what());
-			goto dect_err;
+				int iUnknownID = FillUnknownVersionInfo(itGuardId->second, dwTailVals[3]);
+
+				if ((PCK_VERSION_INVALID != iUnknownID) && ReadTailByVersion(cDetectData, PckVersionList()[iUnknownID]))
+					iDetectedPckID = iUnknownID;
+			}
 		}
-		break;
 	}
 
-	if (!isFoundVer) {
+	if (PCK_VERSION_INVALID == iDetectedPckID) {
+
 		Logger_el(TEXT_VERSION_NOT_FOUND);
 		goto dect_err;
 	}
 
+	next = iDetectedPckID + 1;
+
 	m_PckAllInfo.dwFinalFileCount = m_PckAllInfo.dwFileCountOld = m_PckAllInfo.dwFileCount = dwTailVals[2];
 	wcscpy_s(m_PckAllInfo.szFilename, lpszPckFile);
-	m_PckAllInfo.lpSaveAsPckVerFunc = m_PckAllInfo.lpDetectedPckVerFunc = &cPckVersionFunc[iDetectedPckID];
+	m_PckAllInfo.lpSaveAsPckVerFunc = m_PckAllInfo.lpDetectedPckVerFunc = &PckVersionList()[iDetectedPckID];
 
 	//Adjust file size
-	qwSizeFileBefore = cRead.GetFileSize();
+	qwSizeFileBefore = cDetectData.qwFileSize;
 
-	if (qwPckSizeInHeader < qwSizeFileBefore){
+	if (cDetectData.qwPckSizeInHeader < qwSizeFileBefore){
 
-		cRead.clear();
-		CMapViewFileMultiPckWrite cWrite(cPckVersionFunc[iDetectedPckID].cPckXorKeys.dwMaxSinglePckSize);
+		CMapViewFileMultiPckWrite cWrite(PckVersionList()[iDetectedPckID].cPckXorKeys.dwMaxSinglePckSize);
 		
 		if (cWrite.OpenPck(lpszPckFile, OPEN_EXISTING)) {
 			
-			cWrite.SetFilePointer(qwPckSizeInHeader);
+			cWrite.SetFilePointer(cDetectData.qwPckSizeInHeader);
 			cWrite.SetEndOfFile();
 
-			Logger.i("Pck file size does not match, adjusted from %llu to %llu", qwSizeFileBefore, qwPckSizeInHeader);
+			Logger.i("Pck file size does not match, adjusted from %llu to %llu", qwSizeFileBefore, cDetectData.qwPckSizeInHeader);
 
 		}
 	}
@@ -585,9 +622,8 @@ dect_err:
 }
 
 template<typename T>
-void* FillHeadData(LPPCK_ALL_INFOS lpPckAllInfo)
+void* FillHeadData(LPPCK_ALL_INFOS lpPckAllInfo, void *headbuf)
 { 
-	static DWORD headbuf[3]; 
 	T lpHead = (T)headbuf; 
 	lpHead->dwHeadCheckHead = lpPckAllInfo->lpSaveAsPckVerFunc->cPckXorKeys.HeadVerifyKey1; 
 	if (lpPckAllInfo->lpSaveAsPckVerFunc->cPckXorKeys.HeadVerifyKey2) { 
@@ -600,9 +636,8 @@ void* FillHeadData(LPPCK_ALL_INFOS lpPckAllInfo)
 }
 
 template<typename T>
-void* FillTailData(LPPCK_ALL_INFOS lpPckAllInfo)
+void* FillTailData(LPPCK_ALL_INFOS lpPckAllInfo, void *tailbuf)
 { 
-	static BYTE tailbuf[MAX_TAIL_LENGTH];
 	T lpTail = (T)tailbuf; 
 	lpTail->dwIndexTableCheckHead = lpPckAllInfo->lpSaveAsPckVerFunc->cPckXorKeys.TailVerifyKey1; 
 	lpTail->dwVersion0 = lpTail->dwVersion = lpPckAllInfo->lpSaveAsPckVerFunc->cPckXorKeys.Version; 
@@ -640,29 +675,29 @@ BOOL PickIndexData(LPPCKFILEINDEX lpFileIndex, T* lpPckIndexTableClear)
 
 
 //Data filling and data writing at the beginning and end of the file
-void* CPckClassVersionDetect::FillHeadData_V2020(void *param)
+void* CPckClassVersionDetect::FillHeadData_V2020(void *param, void *headbuf)
 {
-	return FillHeadData<LPPCKHEAD_V2020>((LPPCK_ALL_INFOS)param);
+	return FillHeadData<LPPCKHEAD_V2020>((LPPCK_ALL_INFOS)param, headbuf);
 }
 
-void* CPckClassVersionDetect::FillHeadData_V2030(void *param)
+void* CPckClassVersionDetect::FillHeadData_V2030(void *param, void *headbuf)
 {
-	return FillHeadData<LPPCKHEAD_V2030>((LPPCK_ALL_INFOS)param);
+	return FillHeadData<LPPCKHEAD_V2030>((LPPCK_ALL_INFOS)param, headbuf);
 }
 
-void* CPckClassVersionDetect::FillTailData_V2020(void *param)
+void* CPckClassVersionDetect::FillTailData_V2020(void *param, void *tailbuf)
 {
-	return FillTailData<LPPCKTAIL_V2020>((LPPCK_ALL_INFOS)param);
+	return FillTailData<LPPCKTAIL_V2020>((LPPCK_ALL_INFOS)param, tailbuf);
 }
 
-void* CPckClassVersionDetect::FillTailData_V2030(void *param)
+void* CPckClassVersionDetect::FillTailData_V2030(void *param, void *tailbuf)
 {
-	return FillTailData<LPPCKTAIL_V2030>((LPPCK_ALL_INFOS)param);
+	return FillTailData<LPPCKTAIL_V2030>((LPPCK_ALL_INFOS)param, tailbuf);
 }
 
-void* CPckClassVersionDetect::FillTailData_VXAJH(void *param)
+void* CPckClassVersionDetect::FillTailData_VXAJH(void *param, void *tailbuf)
 {
-	return FillTailData<LPPCKTAIL_VXAJH>((LPPCK_ALL_INFOS)param);
+	return FillTailData<LPPCKTAIL_VXAJH>((LPPCK_ALL_INFOS)param, tailbuf);
 }
 
 
@@ -64,8 +64,19 @@
 
 typedef PCKHEAD_V2030 PCKHEAD_VXAJH, *LPPCKHEAD_VXAJH;
 
+//Bytes read from the end of the pck, enough for the tail of every version
+#define PCK_DETECT_TAIL_SIZE	0x180
+
+//The header and tail of the pck file, read once and then compared with every version
+typedef struct _PCK_DETECT_DATA
+{
+	PCKHEAD_V2020	cPckHead;
+	uint64_t		qwFileSize;
+	uint64_t		qwPckSizeInHeader;
+	uint32_t		dwTailSize;						//Valid bytes in szTail, less than PCK_DETECT_TAIL_SIZE for tiny files
+	uint8_t			szTail[PCK_DETECT_TAIL_SIZE];	//The bytes in front of qwPckSizeInHeader
+}PCK_DETECT_DATA, *LPPCK_DETECT_DATA;
 
-static vector<PCK_VERSION_FUNC>	cPckVersionFunc;
 
 typedef struct _PCK_VERSION_ID
 {
@@ -94,8 +105,10 @@ public:
 	static	int		AddPckVersionByKeys(int id, int Version, const wchar_t* Name, int CustomPckGuardByte0, int CustomPckGuardByte1, int CustomPckMaskDword, int CustomPckCheckMask);
 
 protected:
-	//Detect the pck version and write it to iDetectedPckID, and read the file header and tail at the same time
-	BOOL	DetectPckVerion(LPCWSTR lpszPckFile, int next = 0);
+	//Read the file header and tail for DetectPckVerion
+	BOOL	ReadPckHeadTail(LPCWSTR lpszPckFile, PCK_DETECT_DATA &cDetectData);
+	//Detect the pck version from version next on, next is set to the version after the detected one
+	BOOL	DetectPckVerion(LPCWSTR lpszPckFile, const PCK_DETECT_DATA &cDetectData, int &next);
 
 private:
 
@@ -110,15 +123,17 @@ private:
 	static int		FillUnknownVersionInfoByKeys(DWORD AlgorithmId, DWORD Version, const wchar_t* Name, int CustomPckGuardByte0, int CustomPckGuardByte1, int CustomPckMaskDword, int CustomPckCheckMask);
 
 	//PCK version judgment
+	static BOOL		IsVersionMatched(const PCK_KEYS &cPckKeys, const PCKHEAD_V2020 &cPckHead, const uint32_t *dwTailVals);
+	BOOL			ReadTailByVersion(const PCK_DETECT_DATA &cDetectData, const PCK_VERSION_FUNC &cPckVersionFunc);
 	static void		SetAlgorithmId(DWORD id, LPPCK_VERSION_FUNC lpPckVersionFunc, int CustomPckGuardByte0 = 0, int CustomPckGuardByte1 = 0, int CustomPckMaskDword = 0, int CustomPckCheckMask = 0);
 
 	//Data filling and data writing at the beginning and end of the file
-	static void*	FillHeadData_V2020(void *param);
-	static void*	FillHeadData_V2030(void *param);
+	static void*	FillHeadData_V2020(void *param, void *headbuf);
+	static void*	FillHeadData_V2030(void *param, void *headbuf);
 
-	static void*	FillTailData_V2020(void *param);
-	static void*	FillTailData_V2030(void *param);
-	static void*	FillTailData_VXAJH(void *param);
+	static void*	FillTailData_V2020(void *param, void *tailbuf);
+	static void*	FillTailData_V2030(void *param, void *tailbuf);
+	static void*	FillTailData_VXAJH(void *param, void *tailbuf);
 
 	static void*	FillIndexData_V2020(void *param, void *pckFileIndexBuf);
 	static void*	FillIndexData_V2030(void *param, void *pckFileIndexBuf);
@@ -2,10 +2,9 @@
 
 //Data filling and data writing at the beginning and end of the file
 template<typename T>
-void* FillHeadData(void* param)
+void* FillHeadData(void* param, void* headbuf)
 {
 	LPPCK_ALL_INFOS lpPckAllInfo = (LPPCK_ALL_INFOS)param;
-	static DWORD headbuf[3];
 	T* lpHead = (T*)headbuf;
 	lpHead->dwHeadCheckHead = lpPckAllInfo->lpSaveAsPckVerFunc->cPckXorKeys.HeadVerifyKey1;
 	if (lpPckAllInfo->lpSaveAsPckVerFunc->cPckXorKeys.HeadVerifyKey2) {
@@ -19,10 +18,9 @@ void* FillHeadData(void* param)
 }
 
 template<typename T>
-void* FillTailData(void* param)
+void* FillTailData(void* param, void* tailbuf)
 {
 	LPPCK_ALL_INFOS lpPckAllInfo = (LPPCK_ALL_INFOS)param;
-	static BYTE tailbuf[MAX_TAIL_LENGTH] = { 0 };
 	T* lpTail = (T*)tailbuf;
 	lpTail->dwIndexTableCheckHead = lpPckAllInfo->lpSaveAsPckVerFunc->cPckXorKeys.TailVerifyKey1;
 	lpTail->dwVersion0 = lpTail->dwVersion = lpPckAllInfo->lpSaveAsPckVerFunc->cPckXorKeys.Version;
@@ -4,6 +4,8 @@
 #include "PckClassFileDisk.h"
 #include "PckThreadRunner.h"
 
+#include <unordered_map>
+
 class CPckClassWriteOperator :
 	public virtual CPckClassHeadTailWriter,
 	public virtual CPckClassIndexWriter,
@@ -22,6 +24,13 @@ protected:
 	BOOL	RebuildPckFile(const wchar_t * szRebuildPckFile);
 	BOOL	RecompressPckFile(const wchar_t * szRecompressPckFile, int isStripMode = PCK_STRIP_NONE);
 
+#pragma region PckClassRebuildLayout.cpp
+	//Valid index entries in the order their data is written, see PCK_LAYOUT_*
+	void	BuildRebuildOrder(vector<LPPCKINDEXTABLE> &lpOrderedIndex);
+private:
+	BOOL	ReadLayoutAccessList(const wchar_t *lpszListFile, std::unordered_map<wstring, uint32_t> &mapRank);
+#pragma endregion
+
 public:
 #pragma region Game streamlined
 	virtual BOOL	StripPck(const wchar_t * lpszStripedPckFile, int flag);
@@ -31,6 +40,11 @@ public:
 public:
 	//Create and update pck files
 	virtual BOOL	UpdatePckFile(const wchar_t * szPckFile, const vector<wstring> &lpszFilePath, const PCK_PATH_NODE* lpNodeToInsert);
+	//Add files of a zup without extracting them, the deflated data in the zup is used when its level matches
+	virtual BOOL	UpdatePckFileFromZup(const wchar_t * szPckFile, const wchar_t * szZupFile, vector<FILES_TO_COMPRESS> &lpZupFiles, const PCK_PATH_NODE* lpNodeToInsert);
+private:
+	//iDataSource = DATA_FROM_FILE or DATA_FROM_ZUP
+	BOOL	WriteFilesToBeAdded(const wchar_t * szPckFile, const PCK_PATH_NODE* lpNodeToInsert, DWORD dwNewFileCount, QWORD qwTotalNewFileSize, int iDataSource, CMapViewFileMultiPckRead *lpZupRead);
 #pragma endregion
 #pragma region PckClassRenamer.cpp
 
@@ -46,16 +46,32 @@ int CPckClassZlib::init_compressor(int level)
 	return m_compress_level;
 }
 
-int CPckClassZlib::check_zlib_header(void *data)
+int CPckClassZlib::check_zlib_header(const void *data)
 {
-	char cDeflateFlag = (*(char*)data) & 0xf;
+	char cDeflateFlag = (*(const char*)data) & 0xf;
 	if (Z_DEFLATED != cDeflateFlag)
 		return 0;
 
-	uint16_t header = _byteswap_ushort(*(uint16_t*)data);
+	uint16_t header = _byteswap_ushort(*(const uint16_t*)data);
 	return (0 == (header % 31));
 }
 
+int CPckClassZlib::check_zlib_level(const void *data)
+{
+	//FLEVEL, the same for zlib and libdeflate
+	int iLevelFlag;
+	if (2 > m_compress_level)
+		iLevelFlag = 0;
+	else if (6 > m_compress_level)
+		iLevelFlag = 1;
+	else if (6 == m_compress_level)
+		iLevelFlag = 2;
+	else
+		iLevelFlag = 3;
+
+	return (iLevelFlag == (((const uint8_t*)data)[1] >> 6));
+}
+
 uint32_t CPckClassZlib::compressBound(uint32_t sourceLen)
 {
 	try {
@@ -30,7 +30,10 @@ public:
 
 	int init_compressor(int level);
 
-	int check_zlib_header(void *data);
+	static int check_zlib_header(const void *data);
+	//Whether the FLEVEL of the zlib header is the one this compressor writes. It is an approximation,
+	//FLEVEL only tells the class of the level (0-1, 2-5, 6, 7 and above), not the level itself
+	int check_zlib_level(const void *data);
 	uint32_t compressBound(uint32_t sourceLen);
 	int	compress(void *dest, ulong_t *destLen, const void *source, uint32_t sourceLen);
 	int decompress(void *dest, ulong_t *destLen, const void *source, uint32_t sourceLen);
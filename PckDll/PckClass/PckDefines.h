@@ -55,6 +55,9 @@ typedef enum _PCKVER
 #define	TEXT_LOG_RENAME					"Rename (delete) files in package..."
 #define	TEXT_LOG_REBUILD				"Rebuild PCK file..."
 #define	TEXT_LOG_RECOMPRESS				"Recompress PCK files..."
+#define	TEXT_LOG_REBUILD_LAYOUT			"Data layout: %s"
+#define	TEXT_LOG_LAYOUT_LIST			"Access list: %d of %d entries matched"
+#define	TEXT_LOG_LAYOUT_LIST_FAIL		"Access list \"%ls\" can not be read, the data keeps its original order"
 
 
 #define	TEXT_LOG_CREATE					"New PCK file:%s..."
@@ -62,6 +65,10 @@ typedef enum _PCKVER
 #define	TEXT_LOG_COMPRESSOK				"Compression completed, index written..."
 
 #define	TEXT_LOG_EXTRACT				"unzip files..."
+#define	TEXT_LOG_VERIFY					"Verify files..."
+#define	TEXT_LOG_OVERLAY				"%d archives mounted, %u files in the overlay"
+#define	TEXT_LOG_CHECKPOINT_LOAD		"%u checkpoints of %u files loaded from \"%ls\""
+#define	TEXT_LOG_CHECKPOINT_SAVE		"%u checkpoints of %u files saved to \"%ls\""
 
 
 
@@ -74,6 +81,7 @@ typedef enum _PCKVER
 #define	TEXT_CREATEMAP_FAIL				"Failed to create file mapping!"
 #define	TEXT_CREATEMAPNAME_FAIL			"Mapping file \"%s\" failed!"
 #define	TEXT_OPENNAME_FAIL				"Failed to open file \"%s\"!"
+#define	TEXT_NOTFOUND_NAME				"\"%s\" not found!"
 #define	TEXT_VIEWMAP_FAIL				"Failed to create mapping view!"
 #define	TEXT_VIEWMAPNAME_FAIL			"Failed to create mapping view for file \"%s\"!"
 
@@ -88,10 +96,17 @@ typedef enum _PCKVER
 #define	TEXT_USERCANCLE					"User cancels exit!"
 
 #define	TEXT_COMPFILE_TOOBIG			"The compressed file is too large!"
+#define	TEXT_ADDFILE_TOOBIG				"File \"%ls\" is 4GB or larger and can not be stored in a pck!"
+#define	TEXT_ADDFILE_NAME_TOOLONG		"The path of file \"%ls\" is too long, skipped!"
 #define	TEXT_UNCOMP_FAIL				"Failed to decompress file!"
 
 #define	TEXT_UNCOMPRESSDATA_FAIL		"File %s \r\nData decompression failed!"
 #define	TEXT_UNCOMPRESSDATA_FAIL_REASON	"Data decompression failed: %s"
+#define	TEXT_VERIFY_FAIL				"%u of %u files could not be decompressed!"
+#define	TEXT_BATCH_OUTPUT_USED			"\"%ls\" is the output of another archive or the archive itself, skipped!"
+#define	TEXT_OVERLAY_OPEN_FAIL			"Failed to mount \"%ls\" in the overlay!"
+#define	TEXT_CHECKPOINT_FILE_INVALID	"The checkpoint file \"%ls\" is damaged or does not belong to this pck, it is ignored"
+#define	TEXT_UPDATE_INDEX_NOT_MERGED	"The index of the update is not merged into the opened pck, open it again"
 
 #define	TEXT_ERROR_OPEN_AFTER_UPDATE	"The opening failed. It may be that the last operation caused the file to be damaged. \r\nTry to restore to the last opened state?"
 #define	TEXT_ERROR_GET_RESTORE_DATA		"An error occurred while getting recovery information"
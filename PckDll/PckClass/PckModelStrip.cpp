@@ -120,7 +120,7 @@ BOOL CPckModelStrip::StripAtt(BYTE* buffer, LPPCKFILEINDEX lpFileIndex)
 		//Hook:\r\n
 		//Pos: 0.000000, 0.000000, 0.000000\r\n
 		//Copy the content from the previous position to "Path:"
-		while ('\r' != *lpszAttBuff && '\n' != *lpszAttBuff)
+		while (0 != *lpszAttBuff && '\r' != *lpszAttBuff && '\n' != *lpszAttBuff)
 		{
 			lpszAttBuff++;
 			nLen_src_last--;
@@ -151,7 +151,9 @@ BOOL CPckModelStrip::StripGfx(BYTE* buffer, LPPCKFILEINDEX lpFileIndex)
 	char* lpszAttBuff;
 	char* lpszAttBuff_Prev = lpszAttBuff = (char*)buffer;
 
-	if (NULL != (lpszAttBuff = strstr(lpszAttBuff_Prev, szDstStrGfx)))
+	//The count is replaced by "0\r\n", the buffer has one byte more than the file
+	if (NULL != (lpszAttBuff = strstr(lpszAttBuff_Prev, szDstStrGfx)) &&
+		(lpszAttBuff + strlen(szDstStrGfx) + 3 <= (char*)buffer + lpFileIndex->dwFileClearTextSize))
 	{
 		//
 
@@ -65,10 +65,10 @@ typedef struct _PCK_VERSION_FUNC
 	//read end
 	//read file index
 	BOOL(*PickIndexData)(void*, void*);
-	//Fill in the header
-	void*(*FillHeadData)(void*);
-	//Fill in the end
-	void*(*FillTailData)(void*);
+	//Fill in the header, buffer of MAX_HEAD_LENGTH
+	void*(*FillHeadData)(void*, void*);
+	//Fill in the end, buffer of MAX_TAIL_LENGTH
+	void*(*FillTailData)(void*, void*);
 	//Fill in file index
 	void*(*FillIndexData)(void*, void*);
 }PCK_VERSION_FUNC, *LPPCK_VERSION_FUNC;
@@ -266,13 +266,12 @@ typedef struct _FILES_TO_COMPRESS
 	int				id;
 #endif
 	uint32_t			dwCompressedflag;
-	uint32_t			dwFileSize;
-	uint32_t			nBytesToCopy;
-	char			szFilename[MAX_PATH];
-	wchar_t			szwFilename[MAX_PATH];
-	size_t			nFileTitleLen;
+	uint64_t			qwFileSize;
+	const wchar_t		*lpszFilename;			//Full path on disk, stored in the filename pool of CPckClassFileDisk
+	const wchar_t		*lpszFilenameInPck;		//Path relative to the node to add to, separated by '\'
 	_FILES_TO_COMPRESS	*next;
 	_PCK_INDEX_TABLE	*samePtr;
+	const _PCK_INDEX_TABLE	*lpZupSrcIndex;		//Entry of a zup holding the data, see DATA_FROM_ZUP
 }FILES_TO_COMPRESS, *LPFILES_TO_COMPRESS;
 
 
@@ -325,6 +324,7 @@ typedef struct _PCK_ALL_INFOS
 
 
 class CPckControlCenter;
+class CPckTaskEvents;
 
 
 
@@ -342,6 +342,7 @@ typedef struct _PCK_VARIETY_PARAMS {
 
 	LPCSTR		lpszAdditionalInfo;
 
+	//Bumped by several threads, use std::atomic_ref
 	uint32_t		dwUIProgress;
 	uint32_t		dwUIProgressUpper;
 
@@ -362,9 +363,13 @@ typedef struct _PCK_RUNTIME_PARAMS {
 	uint32_t		dwMTThread;			//Number of compression threads
 	uint32_t		dwCompressLevel;	//Data compression rate
 
+	int				iRebuildLayout;		//Data area layout when rebuilding, PCK_LAYOUT_*
+	const wchar_t	*lpszLayoutListFile;	//Access list used by PCK_LAYOUT_ACCESS_LIST
+
 	//int			code_page;			//pck file usage encoding
 
 	CPckControlCenter	*lpPckControlCenter;
+	CPckTaskEvents		*lpTaskEvents;		//Callbacks and waiting of the tasks
 
 }PCK_RUNTIME_PARAMS, *LPPCK_RUNTIME_PARAMS;
 
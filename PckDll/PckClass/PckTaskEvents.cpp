@@ -0,0 +1,118 @@
+//////////////////////////////////////////////////////////////////////
+// PckTaskEvents.cpp: progress, stage and completion events of a task
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "PckTaskEvents.h"
+#include <chrono>
+
+CPckTaskEvents::CPckTaskEvents()
+{}
+
+CPckTaskEvents::~CPckTaskEvents()
+{}
+
+uint64_t CPckTaskEvents::NowMs()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CPckTaskEvents::SetCallbacks(void* pTag, TaskProgressCallback lpProgress, TaskStageCallback lpStage, TaskCompleteCallback lpComplete, uint32_t dwProgressIntervalMs)
+{
+	std::lock_guard<std::mutex> lckCallback(m_LockCallback);
+
+	m_pTag = pTag;
+	m_lpProgress = lpProgress;
+	m_lpStage = lpStage;
+	m_lpComplete = lpComplete;
+	m_dwProgressIntervalMs = dwProgressIntervalMs;
+}
+
+void CPckTaskEvents::Submit()
+{
+	std::lock_guard<std::mutex> lckRunning(m_LockRunning);
+	++m_qwSubmitted;
+}
+
+void CPckTaskEvents::Finish()
+{
+	std::lock_guard<std::mutex> lckRunning(m_LockRunning);
+	++m_qwFinished;
+	m_cvTaskEnd.notify_all();
+}
+
+void CPckTaskEvents::Begin()
+{
+	std::lock_guard<std::mutex> lckRunning(m_LockRunning);
+	m_isRunning = TRUE;
+	m_qwNextProgressAt.store(0, std::memory_order_relaxed);
+}
+
+void CPckTaskEvents::SetStage(int32_t iStage, uint32_t dwProgress, uint32_t dwProgressUpper)
+{
+	//The last progress of the stage before
+	if (PCK_STAGE_IDLE != m_iStage.exchange(iStage, std::memory_order_relaxed))
+		Progress(dwProgress, dwProgressUpper, TRUE);
+
+	std::lock_guard<std::mutex> lckCallback(m_LockCallback);
+	if (nullptr != m_lpStage)
+		m_lpStage(m_pTag, iStage);
+}
+
+void CPckTaskEvents::Progress(uint32_t dwProgress, uint32_t dwProgressUpper, BOOL isForced)
+{
+	if (nullptr == m_lpProgress)
+		return;
+
+	uint64_t qwNow = NowMs();
+
+	if (!isForced) {
+
+		if (qwNow < m_qwNextProgressAt.load(std::memory_order_relaxed))
+			return;
+
+		//Another thread is reporting
+		std::unique_lock<std::mutex> lckCallback(m_LockCallback, std::try_to_lock);
+		if (!lckCallback.owns_lock())
+			return;
+
+		m_qwNextProgressAt.store(qwNow + m_dwProgressIntervalMs, std::memory_order_relaxed);
+		m_lpProgress(m_pTag, dwProgress, dwProgressUpper);
+	}
+	else {
+
+		std::lock_guard<std::mutex> lckCallback(m_LockCallback);
+		m_qwNextProgressAt.store(qwNow + m_dwProgressIntervalMs, std::memory_order_relaxed);
+		m_lpProgress(m_pTag, dwProgress, dwProgressUpper);
+	}
+}
+
+void CPckTaskEvents::End(int32_t iResult, uint32_t dwProgress, uint32_t dwProgressUpper)
+{
+	Progress(dwProgress, dwProgressUpper, TRUE);
+	m_iStage.store(PCK_STAGE_IDLE, std::memory_order_relaxed);
+
+	{
+		std::lock_guard<std::mutex> lckCallback(m_LockCallback);
+		if (nullptr != m_lpComplete)
+			m_lpComplete(m_pTag, iResult);
+	}
+
+	std::lock_guard<std::mutex> lckRunning(m_LockRunning);
+	m_isRunning = FALSE;
+	m_cvTaskEnd.notify_all();
+}
+
+BOOL CPckTaskEvents::Wait(uint32_t dwMilliseconds)
+{
+	std::unique_lock<std::mutex> lckRunning(m_LockRunning);
+
+	if (PCK_WAIT_INFINITE == dwMilliseconds) {
+		m_cvTaskEnd.wait(lckRunning, [this] { return !m_isRunning && (m_qwFinished == m_qwSubmitted); });
+		return TRUE;
+	}
+
+	return m_cvTaskEnd.wait_for(lckRunning, std::chrono::milliseconds(dwMilliseconds), [this] { return !m_isRunning && (m_qwFinished == m_qwSubmitted); });
+}
@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////
+// PckTaskEvents.h: progress, stage and completion events of a task
+//
+// The progress counters are bumped by every compress thread, the callback
+// is only called when the interval has passed, by the thread that gets
+// there first. A thread that finds another one reporting goes on working.
+// Waiting for the end of a task blocks on a condition variable. A task counts
+// from the call of its function, not from the start of its threads, so a wait
+// that comes before the threads started still waits for it
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "PckDefines.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#define TASK_DEFAULT_PROGRESS_INTERVAL	100
+
+class CPckTaskEvents
+{
+public:
+	CPckTaskEvents();
+	~CPckTaskEvents();
+
+	//Set while no task is running, NULL callbacks are not called
+	void	SetCallbacks(void* pTag, TaskProgressCallback lpProgress, TaskStageCallback lpStage, TaskCompleteCallback lpComplete, uint32_t dwProgressIntervalMs);
+
+	//Bumped by the functions of the tasks when they are called, before any check or preparation
+	void	Submit();
+	void	Finish();
+
+	void	Begin();
+	void	SetStage(int32_t iStage, uint32_t dwProgress, uint32_t dwProgressUpper);
+	void	Progress(uint32_t dwProgress, uint32_t dwProgressUpper, BOOL isForced = FALSE);
+	void	End(int32_t iResult, uint32_t dwProgress, uint32_t dwProgressUpper);
+
+	int32_t	GetStage() const { return m_iStage.load(std::memory_order_relaxed); }
+
+	//TRUE if no submitted task is left, dwMilliseconds = PCK_WAIT_INFINITE waits until they end
+	BOOL	Wait(uint32_t dwMilliseconds);
+
+private:
+
+	static uint64_t	NowMs();
+
+	void*					m_pTag = nullptr;
+	TaskProgressCallback	m_lpProgress = nullptr;
+	TaskStageCallback		m_lpStage = nullptr;
+	TaskCompleteCallback	m_lpComplete = nullptr;
+	uint32_t				m_dwProgressIntervalMs = TASK_DEFAULT_PROGRESS_INTERVAL;
+
+	std::atomic<int32_t>	m_iStage = PCK_STAGE_IDLE;
+	std::atomic<uint64_t>	m_qwNextProgressAt = 0;
+	//Only one callback runs at a time
+	std::mutex				m_LockCallback;
+
+	BOOL					m_isRunning = FALSE;
+	uint64_t				m_qwSubmitted = 0;
+	uint64_t				m_qwFinished = 0;
+	std::mutex				m_LockRunning;
+	std::condition_variable	m_cvTaskEnd;
+};
+
+//Counts a task as submitted from the call of its function until it returns
+class CPckTaskScope
+{
+public:
+	CPckTaskScope(CPckTaskEvents &cTaskEvents) : m_cTaskEvents(cTaskEvents) { m_cTaskEvents.Submit(); }
+	~CPckTaskScope() { m_cTaskEvents.Finish(); }
+
+private:
+	CPckTaskEvents	&m_cTaskEvents;
+};
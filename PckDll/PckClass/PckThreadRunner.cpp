@@ -1,7 +1,7 @@
 #include "PckThreadRunner.h"
+#include "PckWorkerPool.h"
 
 #include <vector>
-#include <thread>
 #include <algorithm>
 
 CPckThreadRunner::CPckThreadRunner(LPTHREAD_PARAMS threadparams) :
@@ -20,11 +20,13 @@ CPckThreadRunner::~CPckThreadRunner()
 	Logger.OutputVsIde(__FUNCTION__, "\r\n");
 }
 
-void CPckThreadRunner::start()
+BOOL CPckThreadRunner::start()
 {
+	BOOL rtn = FALSE;
 
 	try {
 
+		m_lpPckClassBase->SetParams_Stage(PCK_STAGE_COMPRESS);
 		startThread();
 
 		m_lpPckParams->cVarParams.dwMTMemoryUsed = 0;
@@ -34,8 +36,8 @@ void CPckThreadRunner::start()
 
 		uint64_t qwAddress = m_threadparams->lpPckAllInfo->dwAddressOfFileEntry;
 
-		m_lpPckClassBase->WriteAllIndex(m_threadparams->lpFileWrite, m_threadparams->lpPckAllInfo, qwAddress);
-		m_lpPckClassBase->WriteHeadAndTail(m_threadparams->lpFileWrite, m_threadparams->lpPckAllInfo, qwAddress);
+		rtn = m_lpPckClassBase->WriteAllIndex(m_threadparams->lpFileWrite, m_threadparams->lpPckAllInfo, qwAddress) &&
+			m_lpPckClassBase->WriteHeadAndTail(m_threadparams->lpFileWrite, m_threadparams->lpPckAllInfo, qwAddress);
 
 	}
 	catch (MyException ex)
@@ -43,6 +45,7 @@ void CPckThreadRunner::start()
 		;
 	}
 	m_lpPckClassBase->SetThreadFlag(FALSE);
+	return rtn;
 }
 
 void CPckThreadRunner::startThread()
@@ -53,25 +56,34 @@ void CPckThreadRunner::startThread()
 		pGetUncompressedData = std::bind(&CPckThreadRunner::GetUncompressedDataFromFile, this, &(m_threadparams->cDataFetchMethod), std::placeholders::_1);
 	else if (DATA_FROM_PCK == m_threadparams->pck_data_src)
 		pGetUncompressedData = std::bind(&CPckThreadRunner::GetUncompressedDataFromPCK, this, &(m_threadparams->cDataFetchMethod), std::placeholders::_1);
+	else if (DATA_FROM_ZUP == m_threadparams->pck_data_src)
+		pGetUncompressedData = std::bind(&CPckThreadRunner::GetUncompressedDataFromZup, this, &(m_threadparams->cDataFetchMethod), std::placeholders::_1);
 	else
 		throw MyExceptionEx("pck_data_src is invalid");
 
-	std::vector<std::thread> threads;
+	m_pCompressThread = std::bind(&CPckThreadRunner::CompressThread, this, pGetUncompressedData, std::placeholders::_1);
 
-	CompressThreadFunc pCompressThread = std::bind(&CPckThreadRunner::CompressThread, this, pGetUncompressedData);
-	WriteThreadFunc pWriteThread = std::bind(&CPckThreadRunner::WriteThread, this, m_threadparams);
+	int threadnum = std::max<int>(m_threadparams->pckParams->dwMTThread, 1);
 
-	int threadnum = m_threadparams->pckParams->dwMTThread;
+	m_dwCompressTasks = threadnum;
+	m_dwActiveCompress = threadnum;
+	m_dwMemoryBudget = m_lpPckParams->dwMTMaxMemory;
+	m_qwLastAdaptAt = CPckClassProfiler::Now();
+
+	//The writer stays on this thread, a compress task waiting for it never waits for a worker
+	CPckTaskGroup cCompressTasks(threadnum);
+	m_lpCompressTasks = &cCompressTasks;
 
 	for (int i = 0; i < threadnum; i++) {
-		threads.push_back(std::thread(pCompressThread));
+		cCompressTasks.Run(std::bind(m_pCompressThread, (uint32_t)i));
 	}
-	std::thread t(pWriteThread);
 
-	std::for_each(threads.begin(), threads.end(), std::mem_fn(&std::thread::join));
+	WriteThread(m_threadparams);
+
+	//Parked tasks are not needed any more
+	cCompressTasks.Wait();
+	m_lpCompressTasks = nullptr;
 	Logger.n(TEXT_LOG_FLUSH_CACHE);
-	if (t.joinable())
-		t.join();
 }
 
 void CPckThreadRunner::WriteThread(LPTHREAD_PARAMS threadparams)
@@ -100,6 +112,8 @@ void CPckThreadRunner::WriteThread(LPTHREAD_PARAMS threadparams)
 		//Process lpPckFileIndex->dwAddressOffset
 		if (0 != lpPckIndexTableComp.dwCompressedFilesize) {
 
+			CPckProfileScope cProfile(PROFILE_WRITE, lpPckIndexTableComp.dwCompressedFilesize);
+
 			if (!lpFileWrite->Write2(dwAddress, dataToWrite, lpPckIndexTableComp.dwCompressedFilesize)) {
 				m_lpPckClassBase->SetErrMsgFlag(PCK_ERR_VIEW);
 				result = FALSE;
@@ -110,6 +124,7 @@ void CPckThreadRunner::WriteThread(LPTHREAD_PARAMS threadparams)
 			freeMaxAndSubtractMemory(dataToWrite, lpPckIndexTableComp.dwMallocSize);
 		}
 
+		AdaptToLoad();
 	}
 
 	mt_dwAddressQueue = dwAddressDataAreaEndAt;
@@ -151,7 +166,7 @@ void CPckThreadRunner::WriteThread(LPTHREAD_PARAMS threadparams)
 	return;
 }
 
-void CPckThreadRunner::CompressThread(FETCHDATA_FUNC GetUncompressedData)
+void CPckThreadRunner::CompressThread(FETCHDATA_FUNC GetUncompressedData, uint32_t dwTask)
 {
 
 #if PCK_DEBUG_OUTPUT
@@ -165,7 +180,7 @@ void CPckThreadRunner::CompressThread(FETCHDATA_FUNC GetUncompressedData)
 	PCKINDEXTABLE		pckFileIndex = { 0 };
 
 	//Get compressed data
-	while (FD_OK == GetUncompressedData(pckFileIndex)) {
+	while (!ParkIfInactive(dwTask) && (FD_OK == GetUncompressedData(pckFileIndex))) {
 
 		//The file progress shown in the window
 		m_lpPckClassBase->SetParams_ProgressInc();
@@ -187,3 +202,78 @@ void CPckThreadRunner::CompressThread(FETCHDATA_FUNC GetUncompressedData)
 	Logger.logOutput(__FUNCTION__, "WakeConditionVariable(m_cvReadyToPut);\r\n");
 	return;
 }
+
+//A parked task ends instead of blocking its worker, AdaptToLoad runs it again
+BOOL CPckThreadRunner::ParkIfInactive(uint32_t dwTask)
+{
+	if (dwTask < m_dwActiveCompress.load(std::memory_order_acquire))
+		return FALSE;
+
+	std::lock_guard<std::mutex> lckActive(m_LockActive);
+
+	//The writer may have needed it meanwhile
+	if (dwTask < m_dwActiveCompress.load(std::memory_order_relaxed))
+		return FALSE;
+
+	m_dwParkedTasks.push_back(dwTask);
+	return TRUE;
+}
+
+void CPckThreadRunner::AdaptToLoad()
+{
+	uint64_t qwNow = CPckClassProfiler::Now();
+	uint64_t qwInterval = qwNow - m_qwLastAdaptAt;
+
+	if ((uint64_t)ADAPT_INTERVAL_MS * 1000000 > qwInterval)
+		return;
+
+	m_qwLastAdaptAt = qwNow;
+
+	uint64_t qwQueueWait = m_qwQueueWaitNs;
+	uint64_t qwMemoryWait = m_qwMemoryWaitNs.exchange(0, std::memory_order_relaxed);
+	m_qwQueueWaitNs = 0;
+
+	uint32_t dwActive = m_dwActiveCompress.load(std::memory_order_relaxed);
+	uint32_t dwBudget = m_dwMemoryBudget.load(std::memory_order_relaxed);
+	uint32_t dwMinBudget = std::min<uint32_t>(ADAPT_MIN_MEMORY_BUDGET, m_lpPckParams->dwMTMaxMemory);
+
+	uint32_t dwNewActive = dwActive, dwNewBudget = dwBudget;
+
+	//The writer waited for data, compressing is the slow side
+	if ((qwQueueWait * 100) >= (qwInterval * ADAPT_WAIT_PERCENT)) {
+
+		dwNewActive = std::min<uint32_t>(dwActive + 1, m_dwCompressTasks);
+		dwNewBudget = (uint32_t)std::min<uint64_t>((uint64_t)dwBudget + (dwBudget >> 1), m_lpPckParams->dwMTMaxMemory);
+	}
+	//Most of the running compress tasks waited for the writer to free memory, writing is the slow side
+	else if ((qwMemoryWait * 100) >= (qwInterval * dwActive * ADAPT_WAIT_PERCENT)) {
+
+		dwNewActive = std::max<uint32_t>(dwActive - 1, 1);
+		dwNewBudget = std::max<uint32_t>(dwBudget - (dwBudget >> 2), dwMinBudget);
+	}
+
+	if ((dwNewActive == dwActive) && (dwNewBudget == dwBudget))
+		return;
+
+	Logger.d("Compress tasks %u of %u, memory budget %u MB", dwNewActive, m_dwCompressTasks, dwNewBudget >> 20);
+
+	m_dwMemoryBudget.store(dwNewBudget, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lckActive(m_LockActive);
+		m_dwActiveCompress.store(dwNewActive, std::memory_order_release);
+
+		//Parked tasks that are needed again go back to the pool
+		auto itNeeded = std::partition(m_dwParkedTasks.begin(), m_dwParkedTasks.end(), [dwNewActive](uint32_t dwTask) {
+			return dwTask >= dwNewActive;
+		});
+
+		for (auto it = itNeeded; it != m_dwParkedTasks.end(); ++it)
+			m_lpCompressTasks->Run(std::bind(m_pCompressThread, *it));
+
+		m_dwParkedTasks.erase(itNeeded, m_dwParkedTasks.end());
+	}
+
+	//Tasks waiting for memory see the bigger budget
+	if (dwNewBudget > dwBudget)
+		m_cvMemoryNotEnough.notify_all();
+}
@@ -4,6 +4,7 @@
 #include "PckClassWriteOperator.h"
 #include "PckClassLog.h"
 
+#include <atomic>
 #include <functional>
 #include <deque>
 #include <mutex>
@@ -11,7 +12,8 @@
 
 
 //Get file method
-typedef enum { DATA_FROM_FILE, DATA_FROM_PCK } PCK_DATA_SOURCE;
+//DATA_FROM_ZUP: the files in ciFilesList are read from the zup opened in lpFileReadPCK
+typedef enum { DATA_FROM_FILE, DATA_FROM_PCK, DATA_FROM_ZUP } PCK_DATA_SOURCE;
 
 //Get file return value
 typedef enum { FD_OK, FD_END, FD_ERR, FD_CANCEL } FETCHDATA_RET;
@@ -26,7 +28,8 @@ typedef struct _DataFetchMethod
 	vector<FILES_TO_COMPRESS>::const_iterator ciFilesListEnd;
 
 	CMapViewFileMultiPckRead		*lpFileReadPCK;
-	LPPCKINDEXTABLE					lpPckIndexTablePtrSrc;
+	//Index entries to fetch from the pck, in the order they are written
+	LPPCKINDEXTABLE					*lpPckIndexTableOrdered;
 	uint32_t						dwProcessIndex;
 	uint32_t						dwTotalIndexCount;
 	int								iStripFlag;
@@ -57,6 +60,12 @@ typedef struct _ThreadParams
 
 #define MALLOCED_EMPTY_DATA			(1)
 
+//How often the writer looks at which side waited and adapts the running compress tasks and the memory budget
+#define ADAPT_INTERVAL_MS			250
+//Percent of the interval one side has to wait to be the slow one
+#define ADAPT_WAIT_PERCENT			50
+#define ADAPT_MIN_MEMORY_BUDGET		(32 * 1024 * 1024)
+
 template <typename T>
 _inline T * __fastcall mystrcpy(T * dest, const T *src)
 {
@@ -66,8 +75,9 @@ _inline T * __fastcall mystrcpy(T * dest, const T *src)
 }
 
 
-typedef std::function<void()> CompressThreadFunc;
-typedef std::function<void()> WriteThreadFunc;
+typedef std::function<void(uint32_t)> CompressThreadFunc;
+
+class CPckTaskGroup;
 
 class CPckThreadRunner
 {
@@ -77,7 +87,8 @@ public:
 	CPckThreadRunner(CPckThreadRunner const&) = delete;
 	CPckThreadRunner& operator=(CPckThreadRunner const&) = delete;
 
-	void start();
+	//TRUE when the index and the tail are written, the index then has the files written before a cancel
+	BOOL start();
 
 
 private:
@@ -111,15 +122,36 @@ private:
 	deque<PCKINDEXTABLE>		m_QueueContent;
 	vector<PCKINDEXTABLE_COMPRESS> m_Index_Compress;
 
+	//Compress tasks numbered below m_dwActiveCompress run. The others end and give their worker back
+	//to the pool, the writer runs them again in m_lpCompressTasks when it needs them
+	uint32_t					m_dwCompressTasks = 0;
+	std::atomic<uint32_t>		m_dwActiveCompress{ 0 };
+	std::mutex					m_LockActive;
+	vector<uint32_t>			m_dwParkedTasks;
+	CPckTaskGroup				*m_lpCompressTasks = nullptr;
+	CompressThreadFunc			m_pCompressThread;
+
+	//Memory the compressed data may take now, at most dwMTMaxMemory
+	std::atomic<uint32_t>		m_dwMemoryBudget{ 0 };
+	//Nanoseconds the compress tasks waited for memory and the writer waited for data since the last adaptation
+	std::atomic<uint64_t>		m_qwMemoryWaitNs{ 0 };
+	uint64_t					m_qwQueueWaitNs = 0;
+	uint64_t					m_qwLastAdaptAt = 0;
+
 
 
 private:
 
 	void startThread();
 
-	void CompressThread(FETCHDATA_FUNC GetUncompressedData);
+	void CompressThread(FETCHDATA_FUNC GetUncompressedData, uint32_t dwTask);
 	void WriteThread(LPTHREAD_PARAMS threadparams);
 
+	//CPU bound when the writer waits for data, I/O bound when the compress tasks wait for the writer to free memory
+	void	AdaptToLoad();
+	//TRUE if the task is not needed now and has to end
+	BOOL	ParkIfInactive(uint32_t dwTask);
+
 	//Memory usage when compressing
 	FETCHDATA_RET	detectMaxToAddMemory(DWORD dwMallocSize);
 	FETCHDATA_RET	detectMaxAndAddMemory(LPBYTE &_out_buffer, DWORD dwMallocSize);
@@ -134,6 +166,10 @@ private:
 	//Obtain compressed source data in multi-threaded operations
 	FETCHDATA_RET		GetUncompressedDataFromFile(LPDATA_FETCH_METHOD lpDataFetchMethod, PCKINDEXTABLE &pckFileIndex);
 	FETCHDATA_RET		GetUncompressedDataFromPCK(LPDATA_FETCH_METHOD lpDataFetchMethod, PCKINDEXTABLE &pckFileIndex);
+	FETCHDATA_RET		GetUncompressedDataFromZup(LPDATA_FETCH_METHOD lpDataFetchMethod, PCKINDEXTABLE &pckFileIndex);
+
+	//Name in pck of a file from the list, under the node to add to
+	void	SetFilenameInPck(LPDATA_FETCH_METHOD lpDataFetchMethod, const FILES_TO_COMPRESS *lpOneFile, PCKINDEXTABLE &pckFileIndex);
 
 };
 
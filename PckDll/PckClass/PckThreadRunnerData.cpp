@@ -1,6 +1,27 @@
 #include "PckThreadRunner.h"
 
 #include "PckModelStrip.h"
+#include "ZupInflateChain.h"
+
+//Stored data is stripped in place, it stays stored with the size it has after the strip
+static void StripStoredData(LPBYTE lpBuffer, LPPCKFILEINDEX lpFileIndex, int iStripFlag)
+{
+	if ((PCK_STRIP_NONE == iStripFlag) || (lpFileIndex->dwFileCipherTextSize != lpFileIndex->dwFileClearTextSize))
+		return;
+
+	CPckModelStrip cModelStrip;
+	cModelStrip.StripContent(lpBuffer, lpFileIndex, iStripFlag);
+	lpFileIndex->dwFileCipherTextSize = lpFileIndex->dwFileClearTextSize;
+}
+
+void CPckThreadRunner::SetFilenameInPck(LPDATA_FETCH_METHOD lpDataFetchMethod, const FILES_TO_COMPRESS *lpOneFile, PCKINDEXTABLE &pckFileIndex)
+{
+	wchar_t *lpszNameInPck = mystrcpy(pckFileIndex.cFileIndex.szwFilename, lpDataFetchMethod->szCurrentNodeString);
+	wcsncpy(lpszNameInPck, lpOneFile->lpszFilenameInPck, MAX_PATH_PCK_260 - 1 - (lpszNameInPck - pckFileIndex.cFileIndex.szwFilename));
+	pckFileIndex.cFileIndex.szwFilename[MAX_PATH_PCK_260 - 1] = 0;
+	//Convert Unicode filenames to CP936 ANSI
+	CPckClassCodepage::PckFilenameCode2Ansi(pckFileIndex.cFileIndex.szwFilename, pckFileIndex.cFileIndex.szFilename, sizeof(pckFileIndex.cFileIndex.szwFilename));
+}
 
 //Obtain uncompressed source data in multi-threaded operations
 FETCHDATA_RET CPckThreadRunner::GetUncompressedDataFromFile(LPDATA_FETCH_METHOD lpDataFetchMethod, PCKINDEXTABLE &pckFileIndex)
@@ -22,22 +43,24 @@ FETCHDATA_RET CPckThreadRunner::GetUncompressedDataFromFile(LPDATA_FETCH_METHOD
 #endif
 
 		LPBYTE lpCompressedBuffer = (BYTE*)MALLOCED_EMPTY_DATA;
-		pckFileIndex.dwMallocSize = m_lpPckClassBase->m_zlib.GetCompressBoundSizeByFileSize(pckFileIndex.cFileIndex.dwFileClearTextSize, pckFileIndex.cFileIndex.dwFileCipherTextSize, lpOneFile->dwFileSize);
+		pckFileIndex.dwMallocSize = m_lpPckClassBase->m_zlib.GetCompressBoundSizeByFileSize(pckFileIndex.cFileIndex.dwFileClearTextSize, pckFileIndex.cFileIndex.dwFileCipherTextSize, (uint32_t)lpOneFile->qwFileSize);
 
 		//Build file name
-		memcpy(mystrcpy(pckFileIndex.cFileIndex.szwFilename, lpDataFetchMethod->szCurrentNodeString), lpOneFile->szwFilename + lpOneFile->nFileTitleLen, lpOneFile->nBytesToCopy - lpDataFetchMethod->nCurrentNodeStringLen);
-		//Convert Unicode filenames to CP936 ANSI
-		CPckClassCodepage::PckFilenameCode2Ansi(pckFileIndex.cFileIndex.szwFilename, pckFileIndex.cFileIndex.szFilename, sizeof(pckFileIndex.cFileIndex.szwFilename));
+		SetFilenameInPck(lpDataFetchMethod, lpOneFile, pckFileIndex);
 
 		//If file size is 0, skip opening file step
 		if (0 != pckFileIndex.cFileIndex.dwFileClearTextSize) {
 			CMapViewFileRead		cFileRead;
 			LPBYTE					lpBufferToRead;
 			//Processing when the file is not 0
-			//Open the file to be compressed
-			if (NULL == (lpBufferToRead = cFileRead.OpenMappingViewAllRead(lpOneFile->szwFilename))) {
-				m_lpPckClassBase->SetErrMsgFlag(PCK_ERR_OPENMAPVIEWR);
-				return FD_ERR;
+			//Open the file to be compressed, the pages are read while compressing
+			{
+				CPckProfileScope cProfile(PROFILE_SOURCE_READ, pckFileIndex.cFileIndex.dwFileClearTextSize);
+
+				if (NULL == (lpBufferToRead = cFileRead.OpenMappingViewAllRead(lpOneFile->lpszFilename))) {
+					m_lpPckClassBase->SetErrMsgFlag(PCK_ERR_OPENMAPVIEWR);
+					return FD_ERR;
+				}
 			}
 
 			//Determine whether the memory used exceeds the maximum value
@@ -47,6 +70,7 @@ FETCHDATA_RET CPckThreadRunner::GetUncompressedDataFromFile(LPDATA_FETCH_METHOD
 			}
 
 			if (PCK_BEGINCOMPRESS_SIZE < pckFileIndex.cFileIndex.dwFileClearTextSize) {
+				CPckProfileScope cProfile(PROFILE_DEFLATE, pckFileIndex.cFileIndex.dwFileClearTextSize);
 				m_lpPckClassBase->m_zlib.compress(lpCompressedBuffer, &pckFileIndex.cFileIndex.dwFileCipherTextSize,
 					lpBufferToRead, pckFileIndex.cFileIndex.dwFileClearTextSize);
 			}
@@ -73,13 +97,14 @@ FETCHDATA_RET CPckThreadRunner::GetUncompressedDataFromPCK(LPDATA_FETCH_METHOD l
 
 		DATA_FETCH_METHOD cDataFetchMethod;
 		memcpy(&cDataFetchMethod, lpDataFetchMethod, sizeof(DATA_FETCH_METHOD));
-		++(lpDataFetchMethod->lpPckIndexTablePtrSrc);
 		++(lpDataFetchMethod->dwProcessIndex);
 		lckCompressedflag.unlock();
 
 		Logger.logOutput(__FUNCTION__, "dwProcessIndex=%d\r\n", cDataFetchMethod.dwProcessIndex);
 
-		if (cDataFetchMethod.lpPckIndexTablePtrSrc->isInvalid)
+		LPPCKINDEXTABLE	lpPckIndexTablePtrSrc = cDataFetchMethod.lpPckIndexTableOrdered[cDataFetchMethod.dwProcessIndex];
+
+		if (lpPckIndexTablePtrSrc->isInvalid)
 			continue;
 
 		LPBYTE				lpBufferToRead;
@@ -88,7 +113,6 @@ FETCHDATA_RET CPckThreadRunner::GetUncompressedDataFromPCK(LPDATA_FETCH_METHOD l
 		//Save source data for heavily compressed data
 		LPBYTE				lpSourceBuffer = NULL;
 
-		LPPCKINDEXTABLE	lpPckIndexTablePtrSrc = cDataFetchMethod.lpPckIndexTablePtrSrc;
 		ulong_t dwNumberOfBytesToMap = lpPckIndexTablePtrSrc->cFileIndex.dwFileCipherTextSize;
 		ulong_t dwFileClearTextSize = lpPckIndexTablePtrSrc->cFileIndex.dwFileClearTextSize;
 
@@ -123,34 +147,38 @@ FETCHDATA_RET CPckThreadRunner::GetUncompressedDataFromPCK(LPDATA_FETCH_METHOD l
 					return rtn;
 				}
 
-				std::unique_lock<std::mutex> lckCReadFileMap(m_LockReadFileMap);
-				if (NULL == (lpBufferToRead = cDataFetchMethod.lpFileReadPCK->View(lpPckIndexTablePtrSrc->cFileIndex.dwAddressOffset, dwNumberOfBytesToMap))) {
-					lckCReadFileMap.unlock();
-					freeMaxAndSubtractMemory(lpSourceBuffer, dwNumberOfBytesToMap);
-					freeMaxAndSubtractMemory(lpDecompressBuffer, dwFileClearTextSize);
+				{
+					CPckProfileScope cProfile(PROFILE_SOURCE_READ, dwNumberOfBytesToMap);
 
-					return FD_ERR;
-					break;
-				}
+					std::unique_lock<std::mutex> lckCReadFileMap(m_LockReadFileMap);
+					if (NULL == (lpBufferToRead = cDataFetchMethod.lpFileReadPCK->View(lpPckIndexTablePtrSrc->cFileIndex.dwAddressOffset, dwNumberOfBytesToMap))) {
+						lckCReadFileMap.unlock();
+						freeMaxAndSubtractMemory(lpSourceBuffer, dwNumberOfBytesToMap);
+						freeMaxAndSubtractMemory(lpDecompressBuffer, dwFileClearTextSize);
 
-				memcpy(lpSourceBuffer, lpBufferToRead, dwNumberOfBytesToMap);
-				cDataFetchMethod.lpFileReadPCK->UnmapViewAll();
-				lckCReadFileMap.unlock();
+						return FD_ERR;
+					}
+
+					memcpy(lpSourceBuffer, lpBufferToRead, dwNumberOfBytesToMap);
+					cDataFetchMethod.lpFileReadPCK->UnmapViewAll();
+				}
 
 				if (m_lpPckClassBase->m_zlib.check_zlib_header(lpSourceBuffer)) {
 
-					m_lpPckClassBase->m_zlib.decompress(lpDecompressBuffer, &dwFileClearTextSize, lpSourceBuffer, dwNumberOfBytesToMap);
+					{
+						CPckProfileScope cProfile(PROFILE_INFLATE, dwFileClearTextSize);
+						m_lpPckClassBase->m_zlib.decompress(lpDecompressBuffer, &dwFileClearTextSize, lpSourceBuffer, dwNumberOfBytesToMap);
+					}
 
 					if (dwFileClearTextSize == lpPckIndexTablePtrSrc->cFileIndex.dwFileClearTextSize) {
 
-						/*
-						Add minified code here
-						*/
-						/*if (PCK_STRIP_NONE != cDataFetchMethod.iStripFlag) {
+						//Strip the content while the data is decompressed, it may get shorter
+						if (PCK_STRIP_NONE != cDataFetchMethod.iStripFlag) {
 							CPckModelStrip cModelStrip;
 							cModelStrip.StripContent(lpDecompressBuffer, &pckFileIndex.cFileIndex, cDataFetchMethod.iStripFlag);
-						}*/
+						}
 
+						CPckProfileScope cProfile(PROFILE_DEFLATE, pckFileIndex.cFileIndex.dwFileClearTextSize);
 						m_lpPckClassBase->m_zlib.compress(lpCompressedBuffer, &pckFileIndex.cFileIndex.dwFileCipherTextSize, lpDecompressBuffer, pckFileIndex.cFileIndex.dwFileClearTextSize);
 					}
 					else {
@@ -162,6 +190,7 @@ FETCHDATA_RET CPckThreadRunner::GetUncompressedDataFromPCK(LPDATA_FETCH_METHOD l
 				else {
 					memcpy(lpCompressedBuffer, lpSourceBuffer, dwNumberOfBytesToMap);
 					pckFileIndex.cFileIndex.dwFileCipherTextSize = lpPckIndexTablePtrSrc->cFileIndex.dwFileCipherTextSize;
+					StripStoredData(lpCompressedBuffer, &pckFileIndex.cFileIndex, cDataFetchMethod.iStripFlag);
 				}
 
 				freeMaxAndSubtractMemory(lpSourceBuffer, dwNumberOfBytesToMap);
@@ -171,14 +200,20 @@ FETCHDATA_RET CPckThreadRunner::GetUncompressedDataFromPCK(LPDATA_FETCH_METHOD l
 			}
 			else {
 #pragma region FileRead
-				std::lock_guard<std::mutex> lckCReadFileMap(m_LockReadFileMap);
+				{
+					CPckProfileScope cProfile(PROFILE_SOURCE_READ, dwNumberOfBytesToMap);
+					std::lock_guard<std::mutex> lckCReadFileMap(m_LockReadFileMap);
 
-				if (NULL == (lpBufferToRead = cDataFetchMethod.lpFileReadPCK->View(lpPckIndexTablePtrSrc->cFileIndex.dwAddressOffset, dwNumberOfBytesToMap)))
-					return FD_ERR;
+					if (NULL == (lpBufferToRead = cDataFetchMethod.lpFileReadPCK->View(lpPckIndexTablePtrSrc->cFileIndex.dwAddressOffset, dwNumberOfBytesToMap)))
+						return FD_ERR;
 
-				memcpy(lpCompressedBuffer, lpBufferToRead, dwNumberOfBytesToMap);
-				cDataFetchMethod.lpFileReadPCK->UnmapViewAll();
+					memcpy(lpCompressedBuffer, lpBufferToRead, dwNumberOfBytesToMap);
+					cDataFetchMethod.lpFileReadPCK->UnmapViewAll();
+				}
 #pragma endregion
+				//Small files are stored without compression, they never pass the strip after the inflate
+				if (dwNumberOfBytesToMap == dwFileClearTextSize)
+					StripStoredData(lpCompressedBuffer, &pckFileIndex.cFileIndex, cDataFetchMethod.iStripFlag);
 			}
 
 		}
@@ -187,4 +222,162 @@ FETCHDATA_RET CPckThreadRunner::GetUncompressedDataFromPCK(LPDATA_FETCH_METHOD l
 		return FD_OK;
 	}
 	return FD_END;
-}
\ No newline at end of file
+}
+
+//The data of a file in a zup is [size][inner data] compressed again, the inner data is a zlib stream
+//of the file when it is not stored. A stream whose FLEVEL matches the level of the compressor is used as is,
+//the exact level it was written with is not known
+FETCHDATA_RET CPckThreadRunner::GetUncompressedDataFromZup(LPDATA_FETCH_METHOD lpDataFetchMethod, PCKINDEXTABLE &pckFileIndex)
+{
+	std::unique_lock<std::mutex> lckCompressedflag(m_LockCompressedflag);
+
+	if (lpDataFetchMethod->ciFilesList == lpDataFetchMethod->ciFilesListEnd)
+		return FD_END;
+
+	vector<FILES_TO_COMPRESS>::const_pointer lpOneFile = &lpDataFetchMethod->ciFilesList[0];
+	lpDataFetchMethod->ciFilesList++;
+	lckCompressedflag.unlock();
+
+	const PCKFILEINDEX *lpSrcIndex = &lpOneFile->lpZupSrcIndex->cFileIndex;
+	ulong_t dwSrcCipherTextSize = lpSrcIndex->dwFileCipherTextSize;
+	ulong_t dwSrcClearTextSize = lpSrcIndex->dwFileClearTextSize;
+
+	memset(&pckFileIndex.cFileIndex, 0, sizeof(PCKFILEINDEX));
+	SetFilenameInPck(lpDataFetchMethod, lpOneFile, pckFileIndex);
+
+	pckFileIndex.cFileIndex.dwFileClearTextSize = pckFileIndex.cFileIndex.dwFileCipherTextSize = (ulong_t)lpOneFile->qwFileSize;
+	pckFileIndex.compressed_file_data = (BYTE*)MALLOCED_EMPTY_DATA;
+	pckFileIndex.dwMallocSize = 0;
+
+	if (0 == pckFileIndex.cFileIndex.dwFileClearTextSize)
+		return FD_OK;
+
+	if (0 == dwSrcCipherTextSize) {
+		Logger_el(TEXT_UNCOMPRESSDATA_FAIL, pckFileIndex.cFileIndex.szFilename);
+		m_lpPckClassBase->SetErrMsgFlag(PCK_ERROR);
+		return FD_ERR;
+	}
+
+	FETCHDATA_RET rtn;
+	LPBYTE	lpSourceBuffer = NULL;
+
+	if (FD_OK != (rtn = detectMaxAndAddMemory(lpSourceBuffer, dwSrcCipherTextSize)))
+		return rtn;
+
+	{
+		CPckProfileScope cProfile(PROFILE_SOURCE_READ, dwSrcCipherTextSize);
+		std::lock_guard<std::mutex> lckCReadFileMap(m_LockReadFileMap);
+
+		LPBYTE lpBufferToRead;
+		if (NULL == (lpBufferToRead = lpDataFetchMethod->lpFileReadPCK->View(lpSrcIndex->dwAddressOffset, dwSrcCipherTextSize))) {
+			freeMaxAndSubtractMemory(lpSourceBuffer, dwSrcCipherTextSize);
+			m_lpPckClassBase->SetErrMsgFlag(PCK_ERR_VIEW);
+			return FD_ERR;
+		}
+
+		memcpy(lpSourceBuffer, lpBufferToRead, dwSrcCipherTextSize);
+		lpDataFetchMethod->lpFileReadPCK->UnmapViewAll();
+	}
+
+	BOOL isOuterStored = (dwSrcClearTextSize == dwSrcCipherTextSize);
+
+	//Files not longer than PCK_BEGINCOMPRESS_SIZE are stored in a pck
+	if (PCK_BEGINCOMPRESS_SIZE < pckFileIndex.cFileIndex.dwFileClearTextSize) {
+
+		LPBYTE	lpPlainBuffer = NULL;
+		ulong_t	dwPlainSize = dwSrcCipherTextSize;
+		ulong_t	dwPlainMallocSize = dwSrcCipherTextSize;
+
+		if (!m_lpPckClassBase->m_zlib.check_zlib_header(lpSourceBuffer)) {
+
+			lpPlainBuffer = lpSourceBuffer;
+			lpSourceBuffer = NULL;
+		}
+		else {
+
+			if (FD_OK != (rtn = detectMaxAndAddMemory(lpPlainBuffer, dwSrcClearTextSize))) {
+				freeMaxAndSubtractMemory(lpSourceBuffer, dwSrcCipherTextSize);
+				return rtn;
+			}
+
+			dwPlainSize = dwPlainMallocSize = dwSrcClearTextSize;
+
+			CPckProfileScope cProfile(PROFILE_INFLATE, dwSrcClearTextSize);
+			if (!m_lpPckClassBase->m_zlib.decompress(lpPlainBuffer, &dwPlainSize, lpSourceBuffer, dwSrcCipherTextSize))
+				dwPlainSize = 0;
+		}
+
+		//Move the inner stream to the start of the buffer and write it as the file data
+		if ((6 <= dwPlainSize) && m_lpPckClassBase->m_zlib.check_zlib_header(lpPlainBuffer + 4) && m_lpPckClassBase->m_zlib.check_zlib_level(lpPlainBuffer + 4)) {
+
+			if (NULL != lpSourceBuffer)
+				freeMaxAndSubtractMemory(lpSourceBuffer, dwSrcCipherTextSize);
+
+			memmove(lpPlainBuffer, lpPlainBuffer + 4, dwPlainSize - 4);
+
+			pckFileIndex.cFileIndex.dwFileCipherTextSize = dwPlainSize - 4;
+			pckFileIndex.dwMallocSize = dwPlainMallocSize;
+			pckFileIndex.compressed_file_data = lpPlainBuffer;
+			return FD_OK;
+		}
+
+		if (NULL == lpSourceBuffer) {
+			lpSourceBuffer = lpPlainBuffer;
+		}
+		else {
+			freeMaxAndSubtractMemory(lpPlainBuffer, dwPlainMallocSize);
+		}
+	}
+
+	//Inflate the file and compress it again
+	LPBYTE	lpDecompressBuffer = NULL;
+	ulong_t	dwFileClearTextSize = pckFileIndex.cFileIndex.dwFileClearTextSize;
+
+	if (FD_OK != (rtn = detectMaxAndAddMemory(lpDecompressBuffer, dwFileClearTextSize))) {
+		freeMaxAndSubtractMemory(lpSourceBuffer, dwSrcCipherTextSize);
+		return rtn;
+	}
+
+	//The size of the inner data, as CZupClass::BuildDirTree sets it
+	ulong_t dwInnerSize = isOuterStored ? (dwSrcCipherTextSize - 4) : dwSrcClearTextSize;
+
+	BOOL isDecompressed;
+	{
+		CPckProfileScope cProfile(PROFILE_INFLATE, dwFileClearTextSize);
+		isDecompressed = CZupInflateChain::Decompress(lpSourceBuffer, dwSrcCipherTextSize, isOuterStored,
+			lpDecompressBuffer, &dwFileClearTextSize, dwInnerSize == pckFileIndex.cFileIndex.dwFileClearTextSize);
+	}
+
+	freeMaxAndSubtractMemory(lpSourceBuffer, dwSrcCipherTextSize);
+
+	if (!isDecompressed || (dwFileClearTextSize != pckFileIndex.cFileIndex.dwFileClearTextSize)) {
+		Logger_el(TEXT_UNCOMPRESSDATA_FAIL, pckFileIndex.cFileIndex.szFilename);
+		freeMaxAndSubtractMemory(lpDecompressBuffer, pckFileIndex.cFileIndex.dwFileClearTextSize);
+		m_lpPckClassBase->SetErrMsgFlag(PCK_ERROR);
+		return FD_ERR;
+	}
+
+	if (PCK_BEGINCOMPRESS_SIZE >= dwFileClearTextSize) {
+
+		pckFileIndex.dwMallocSize = dwFileClearTextSize;
+		pckFileIndex.compressed_file_data = lpDecompressBuffer;
+		return FD_OK;
+	}
+
+	LPBYTE lpCompressedBuffer = NULL;
+	pckFileIndex.dwMallocSize = pckFileIndex.cFileIndex.dwFileCipherTextSize = m_lpPckClassBase->m_zlib.compressBound(dwFileClearTextSize);
+
+	if (FD_OK != (rtn = detectMaxAndAddMemory(lpCompressedBuffer, pckFileIndex.dwMallocSize))) {
+		freeMaxAndSubtractMemory(lpDecompressBuffer, dwFileClearTextSize);
+		return rtn;
+	}
+
+	{
+		CPckProfileScope cProfile(PROFILE_DEFLATE, dwFileClearTextSize);
+		m_lpPckClassBase->m_zlib.compress(lpCompressedBuffer, &pckFileIndex.cFileIndex.dwFileCipherTextSize, lpDecompressBuffer, dwFileClearTextSize);
+	}
+	freeMaxAndSubtractMemory(lpDecompressBuffer, dwFileClearTextSize);
+
+	pckFileIndex.compressed_file_data = lpCompressedBuffer;
+	return FD_OK;
+}
@@ -7,12 +7,17 @@ FETCHDATA_RET CPckThreadRunner::detectMaxToAddMemory(DWORD dwMallocSize)
 
 		if (!m_lpPckClassBase->CheckIfNeedForcedStopWorking()) {
 
-			if (m_lpPckParams->cVarParams.dwMTMemoryUsed >= m_lpPckParams->dwMTMaxMemory) {
+			if (m_lpPckParams->cVarParams.dwMTMemoryUsed >= m_dwMemoryBudget.load(std::memory_order_relaxed)) {
 
 				Logger.logOutput(__FUNCTION__, "_Sleep", "SleepConditionVariableSRW, dwMTMemoryUsed = %u, dwMTMaxMemory = %u\r\n", m_lpPckParams->cVarParams.dwMTMemoryUsed, m_lpPckParams->dwMTMaxMemory);
 				m_memoryNotEnoughBlocked = TRUE;
 
-				if (m_cvMemoryNotEnough.wait_for(lckMaxMemory, std::chrono::seconds(5)) == std::cv_status::timeout)
+				CPckProfileScope cProfile(PROFILE_MEMORY_WAIT);
+				uint64_t qwWaitFrom = CPckClassProfiler::Now();
+				std::cv_status status = m_cvMemoryNotEnough.wait_for(lckMaxMemory, std::chrono::seconds(5));
+				m_qwMemoryWaitNs.fetch_add(CPckClassProfiler::Now() - qwWaitFrom, std::memory_order_relaxed);
+
+				if (status == std::cv_status::timeout)
 					Logger.logOutput(__FUNCTION__, "_Sleep", "TimeOut, dwMTMemoryUsed = %u, dwMTMaxMemory = %u\r\n", m_lpPckParams->cVarParams.dwMTMemoryUsed, m_lpPckParams->dwMTMaxMemory);
 				else
 					Logger.logOutput(__FUNCTION__, "_Sleep", "Awake, dwMTMemoryUsed = %u, dwMTMaxMemory = %u\r\n", m_lpPckParams->cVarParams.dwMTMemoryUsed, m_lpPckParams->dwMTMaxMemory);
@@ -53,7 +53,10 @@ BOOL CPckThreadRunner::getCompressedDataQueue(LPBYTE &lpBuffer, PCKINDEXTABLE_CO
 			Logger.logOutput(__FUNCTION__, "_Sleep", "SleepConditionVariableSRW\r\n");
 
 			//std::unique_lock<std::mutex> lckQueue(m_LockQueue);
+			CPckProfileScope cProfile(PROFILE_QUEUE_WAIT);
+			uint64_t qwWaitFrom = CPckClassProfiler::Now();
 			m_cvReadyToPut.wait(lckQueue);
+			m_qwQueueWaitNs += CPckClassProfiler::Now() - qwWaitFrom;
 		}
 		else {
 			//m_LockQueue.unlock();
@@ -0,0 +1,288 @@
+//////////////////////////////////////////////////////////////////////
+// PckVirtualFile.cpp: a file in a pck read like a file on disk
+//
+// The zlib stream is inflated raw after its 2 byte header, so the inflater
+// can be restarted in the middle of the data at a checkpoint
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "zlib.h"
+#include "PckVirtualFile.h"
+#include "PckClassZlib.h"
+#include "PckClassLog.h"
+#include <algorithm>
+#include <string.h>
+
+#define ZLIB_HEADER_SIZE	2
+
+CPckVirtualFile::CPckVirtualFile() :
+	m_lpData(NULL),
+	m_dwDataSize(0),
+	m_isCompressed(FALSE),
+	m_qwSize(0),
+	m_qwPosition(0),
+	m_lpStream(NULL),
+	m_qwStreamOut(0),
+	m_qwReadAheadAt(0),
+	m_nReadAhead(0)
+{}
+
+CPckVirtualFile::~CPckVirtualFile()
+{
+	if (NULL != m_lpStream) {
+		inflateEnd(m_lpStream);
+		delete m_lpStream;
+	}
+}
+
+void CPckVirtualFile::UseCheckpoints(std::shared_ptr<CPckEntryCheckpoints> lpCheckpoints)
+{
+	m_lpCheckpoints = std::move(lpCheckpoints);
+}
+
+BOOL CPckVirtualFile::OpenStream(const wchar_t *lpszPckFile, const PCKFILEINDEX *lpFileIndex)
+{
+	m_qwSize = lpFileIndex->dwFileClearTextSize;
+	m_dwDataSize = lpFileIndex->dwFileCipherTextSize;
+
+	if ((0 == m_qwSize) || (0 == m_dwDataSize))
+		return TRUE;
+
+	if (!m_cFileRead.OpenPckAndMappingRead(lpszPckFile)) {
+		Logger_el(UCSTEXT(TEXT_OPENNAME_FAIL), lpszPckFile);
+		return FALSE;
+	}
+
+	if (NULL == (m_lpData = m_cFileRead.View(lpFileIndex->dwAddressOffset, m_dwDataSize))) {
+		Logger_el(UCSTEXT(TEXT_VIEWMAPNAME_FAIL), lpszPckFile);
+		return FALSE;
+	}
+
+	//Small files are stored as they are, the same test as GetSingleFileData
+	m_isCompressed = (m_qwSize != m_dwDataSize) && (ZLIB_HEADER_SIZE <= m_dwDataSize) && CPckClassZlib::check_zlib_header(m_lpData);
+
+	if (!m_isCompressed) {
+		m_qwSize = std::min<uint64_t>(m_qwSize, m_dwDataSize);
+		m_lpCheckpoints = nullptr;
+		return TRUE;
+	}
+
+	if ((nullptr == m_lpCheckpoints) && (VFS_SEEK_POINT_INTERVAL < m_qwSize))
+		m_lpCheckpoints = std::make_shared<CPckEntryCheckpoints>(VFS_SEEK_POINT_INTERVAL);
+	m_ReadAhead.resize(VFS_READ_AHEAD_SIZE);
+
+	return InitInflate();
+}
+
+BOOL CPckVirtualFile::OpenBuffer(std::vector<char> &&data)
+{
+	m_Data = std::move(data);
+
+	m_lpData = (const uint8_t*)m_Data.data();
+	m_dwDataSize = (uint32_t)m_Data.size();
+	m_qwSize = m_Data.size();
+	return TRUE;
+}
+
+uint64_t CPckVirtualFile::GetSize() const
+{
+	return m_qwSize;
+}
+
+uint64_t CPckVirtualFile::Tell() const
+{
+	return m_qwPosition;
+}
+
+int64_t CPckVirtualFile::Seek(int64_t iOffset, int iOrigin)
+{
+	int64_t iBase;
+
+	switch (iOrigin) {
+	case PCK_SEEK_SET:
+		iBase = 0;
+		break;
+	case PCK_SEEK_CUR:
+		iBase = (int64_t)m_qwPosition;
+		break;
+	case PCK_SEEK_END:
+		iBase = (int64_t)m_qwSize;
+		break;
+	default:
+		return -1;
+	}
+
+	if (0 > (iBase + iOffset))
+		return -1;
+
+	//The data is inflated by the next read
+	m_qwPosition = iBase + iOffset;
+	return (int64_t)m_qwPosition;
+}
+
+int64_t CPckVirtualFile::Read(void *buffer, size_t nSize)
+{
+	if (m_qwPosition >= m_qwSize)
+		return 0;
+
+	nSize = (size_t)std::min<uint64_t>(nSize, m_qwSize - m_qwPosition);
+
+	if (!m_isCompressed) {
+		memcpy(buffer, m_lpData + m_qwPosition, nSize);
+		m_qwPosition += nSize;
+		return nSize;
+	}
+
+	uint8_t *lpDest = (uint8_t*)buffer;
+	size_t nDone = 0;
+
+	while (nSize > nDone) {
+
+		//Already in the read-ahead buffer
+		if ((m_qwReadAheadAt <= m_qwPosition) && (m_qwPosition < (m_qwReadAheadAt + m_nReadAhead))) {
+
+			size_t nOffset = (size_t)(m_qwPosition - m_qwReadAheadAt);
+			size_t nCopy = std::min(nSize - nDone, m_nReadAhead - nOffset);
+
+			memcpy(lpDest + nDone, m_ReadAhead.data() + nOffset, nCopy);
+			nDone += nCopy;
+			m_qwPosition += nCopy;
+			continue;
+		}
+
+		//Behind the inflater, or a checkpoint is closer than it
+		const PCK_CHECKPOINT *lpPoint = (nullptr == m_lpCheckpoints) ? NULL : m_lpCheckpoints->Find(m_qwPosition);
+
+		if ((m_qwPosition < m_qwStreamOut) || ((NULL != lpPoint) && (m_qwStreamOut < lpPoint->qwOut))) {
+			if (!RestartAt(lpPoint))
+				return -1;
+		}
+
+		//Large reads are inflated to the caller
+		if ((m_qwPosition == m_qwStreamOut) && (VFS_READ_AHEAD_SIZE <= (nSize - nDone))) {
+
+			int64_t iMade = Inflate(lpDest + nDone, nSize - nDone);
+			if (0 >= iMade)
+				return -1;
+
+			nDone += (size_t)iMade;
+			m_qwPosition += iMade;
+			m_nReadAhead = 0;
+			continue;
+		}
+
+		//The bytes before a forward seek are inflated to the buffer and dropped
+		if (!FillReadAhead())
+			return -1;
+	}
+
+	return nDone;
+}
+
+BOOL CPckVirtualFile::InitInflate()
+{
+	m_lpStream = new z_stream();
+
+	if (Z_OK != inflateInit2(m_lpStream, -MAX_WBITS)) {
+		delete m_lpStream;
+		m_lpStream = NULL;
+		return FALSE;
+	}
+
+	return RestartAt(NULL);
+}
+
+BOOL CPckVirtualFile::RestartAt(const PCK_CHECKPOINT *lpPoint)
+{
+	if (Z_OK != inflateReset(m_lpStream))
+		return FALSE;
+
+	m_nReadAhead = 0;
+
+	if (NULL == lpPoint) {
+
+		m_lpStream->next_in = (Bytef*)m_lpData + ZLIB_HEADER_SIZE;
+		m_lpStream->avail_in = m_dwDataSize - ZLIB_HEADER_SIZE;
+		m_qwStreamOut = 0;
+		return TRUE;
+	}
+
+	if ((0 != lpPoint->iBits) && (Z_OK != inflatePrime(m_lpStream, lpPoint->iBits, m_lpData[lpPoint->dwIn - 1] >> (8 - lpPoint->iBits))))
+		return FALSE;
+
+	if (Z_OK != inflateSetDictionary(m_lpStream, lpPoint->lpWindow.data(), (uInt)lpPoint->lpWindow.size()))
+		return FALSE;
+
+	m_lpStream->next_in = (Bytef*)m_lpData + lpPoint->dwIn;
+	m_lpStream->avail_in = m_dwDataSize - lpPoint->dwIn;
+	m_qwStreamOut = lpPoint->qwOut;
+	return TRUE;
+}
+
+int64_t CPckVirtualFile::Inflate(uint8_t *lpDest, size_t nSize)
+{
+	nSize = (size_t)std::min<uint64_t>(nSize, m_qwSize - m_qwStreamOut);
+
+	m_lpStream->next_out = lpDest;
+	m_lpStream->avail_out = (uInt)nSize;
+
+	//Z_BLOCK stops at the end of each deflate block, where a checkpoint can be taken
+	int iFlush = (nullptr != m_lpCheckpoints) ? Z_BLOCK : Z_NO_FLUSH;
+
+	while (0 != m_lpStream->avail_out) {
+
+		int rtn = inflate(m_lpStream, iFlush);
+
+		if (Z_STREAM_END == rtn)
+			break;
+
+		if (Z_OK != rtn) {
+			Logger_el(TEXT_UNCOMPRESSDATA_FAIL_REASON, (NULL == m_lpStream->msg) ? "" : m_lpStream->msg);
+			return -1;
+		}
+
+		//At the end of a block that is not the last one
+		if ((nullptr != m_lpCheckpoints) && (m_lpStream->data_type & 128) && !(m_lpStream->data_type & 64))
+			AddCheckpoint(m_qwStreamOut + (nSize - m_lpStream->avail_out));
+	}
+
+	size_t nMade = nSize - m_lpStream->avail_out;
+	m_qwStreamOut += nMade;
+	return nMade;
+}
+
+BOOL CPckVirtualFile::FillReadAhead()
+{
+	m_qwReadAheadAt = m_qwStreamOut;
+	m_nReadAhead = 0;
+
+	int64_t iMade = Inflate(m_ReadAhead.data(), m_ReadAhead.size());
+
+	//The entry ends before the size in its index
+	if (0 >= iMade)
+		return FALSE;
+
+	m_nReadAhead = (size_t)iMade;
+	return TRUE;
+}
+
+void CPckVirtualFile::AddCheckpoint(uint64_t qwOut)
+{
+	if (!m_lpCheckpoints->IsWanted(qwOut))
+		return;
+
+	PCK_CHECKPOINT cPoint;
+	cPoint.qwOut = qwOut;
+	cPoint.dwIn = (uint32_t)(m_lpStream->next_in - m_lpData);
+	cPoint.iBits = m_lpStream->data_type & 7;
+	cPoint.lpWindow.resize(CHECKPOINT_WINDOW_SIZE);
+
+	uInt dwWindowSize = CHECKPOINT_WINDOW_SIZE;
+	if (Z_OK != inflateGetDictionary(m_lpStream, cPoint.lpWindow.data(), &dwWindowSize))
+		return;
+
+	cPoint.lpWindow.resize(dwWindowSize);
+	m_lpCheckpoints->Add(std::move(cPoint));
+}
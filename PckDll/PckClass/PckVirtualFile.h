@@ -0,0 +1,80 @@
+//////////////////////////////////////////////////////////////////////
+// PckVirtualFile.h: a file in a pck read like a file on disk
+//
+// The compressed data of the entry is mapped and inflated while it is
+// read, only a bounded read-ahead buffer of decompressed data is kept.
+// Large entries remember checkpoints while they are read, a seek restarts
+// at the nearest one instead of at the start of the entry. The checkpoints
+// are the file's own or shared with the other readers of the entry
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "pck_default_vars.h"
+#include "PckStructs.h"
+#include "PckCheckpointIndex.h"
+#include "MapViewFileMultiPck.h"
+#include <memory>
+#include <vector>
+
+//Decompressed bytes inflated ahead of the reads, reads this big go to the caller directly
+#define VFS_READ_AHEAD_SIZE				(256 * 1024)
+//Bytes of decompressed data between two checkpoints of a file that does not share them, smaller entries have none
+#define VFS_SEEK_POINT_INTERVAL			(4 * 1024 * 1024)
+
+struct z_stream_s;
+
+class CPckVirtualFile
+{
+public:
+	CPckVirtualFile();
+	~CPckVirtualFile();
+
+	//Use the checkpoints of the entry shared with other readers, before OpenStream
+	void		UseCheckpoints(std::shared_ptr<CPckEntryCheckpoints> lpCheckpoints);
+	//The data of lpFileIndex is inflated from the pck while it is read
+	BOOL		OpenStream(const wchar_t *lpszPckFile, const PCKFILEINDEX *lpFileIndex);
+	//The data is already decompressed, for the entries that can not be streamed
+	BOOL		OpenBuffer(std::vector<char> &&data);
+
+	uint64_t	GetSize() const;
+	uint64_t	Tell() const;
+	//Like lseek, the new position or -1, a position after the end is allowed
+	int64_t		Seek(int64_t iOffset, int iOrigin);
+	//Bytes read, 0 at the end of the file, -1 on error
+	int64_t		Read(void *buffer, size_t nSize);
+
+private:
+
+	BOOL		InitInflate();
+	//Restart the inflater at the checkpoint, NULL - at the start of the entry
+	BOOL		RestartAt(const PCK_CHECKPOINT *lpPoint);
+	//Inflate up to nSize bytes at m_qwStreamOut, the bytes made or -1
+	int64_t		Inflate(uint8_t *lpDest, size_t nSize);
+	BOOL		FillReadAhead();
+	void		AddCheckpoint(uint64_t qwOut);
+
+	CMapViewFileMultiPckRead	m_cFileRead;
+	std::vector<char>			m_Data;
+
+	//The stored or compressed data of the entry
+	const uint8_t	*m_lpData;
+	uint32_t		m_dwDataSize;
+	BOOL			m_isCompressed;
+
+	uint64_t		m_qwSize;
+	uint64_t		m_qwPosition;
+
+	z_stream_s		*m_lpStream;
+	//Decompressed bytes the inflater made so far
+	uint64_t		m_qwStreamOut;
+
+	std::vector<uint8_t>	m_ReadAhead;
+	uint64_t		m_qwReadAheadAt;
+	size_t			m_nReadAhead;
+
+	//NULL - the entry is too small to need them
+	std::shared_ptr<CPckEntryCheckpoints>	m_lpCheckpoints;
+};
@@ -0,0 +1,183 @@
+//////////////////////////////////////////////////////////////////////
+// PckWorkerPool.cpp: threads shared by every parallel stage of the library
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "PckWorkerPool.h"
+#include "PckClassLog.h"
+#include "PckClassProfiler.h"
+#include <algorithm>
+#include <atomic>
+
+CPckWorkerPool& WorkerPool = CPckWorkerPool::GetInstance();
+
+CPckWorkerPool::CPckWorkerPool()
+{
+	//The workers log and count until they are stopped, so both have to be destroyed after this
+	CPckClassLog::GetInstance();
+	CPckClassProfiler::GetInstance();
+}
+
+CPckWorkerPool::~CPckWorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lckTasks(m_LockTasks);
+		m_isStop = TRUE;
+	}
+	m_cvTasks.notify_all();
+
+	for (std::thread &t : m_Threads)
+		t.join();
+}
+
+void CPckWorkerPool::Reserve(uint32_t dwThreads)
+{
+	dwThreads = std::min<uint32_t>(dwThreads, POOL_MAX_THREADS);
+
+	std::lock_guard<std::mutex> lckThreads(m_LockThreads);
+
+	while (m_Threads.size() < dwThreads)
+		m_Threads.emplace_back(&CPckWorkerPool::WorkerThread, this);
+}
+
+uint32_t CPckWorkerPool::GetThreadCount()
+{
+	std::lock_guard<std::mutex> lckThreads(m_LockThreads);
+	return (uint32_t)m_Threads.size();
+}
+
+void CPckWorkerPool::Submit(std::function<void()> &&lpTask, CPckTaskGroup *lpGroup)
+{
+	{
+		std::lock_guard<std::mutex> lckTasks(m_LockTasks);
+		m_Tasks.push_back({ std::move(lpTask), lpGroup });
+	}
+	m_cvTasks.notify_one();
+}
+
+BOOL CPckWorkerPool::TakeTask(CPckTaskGroup *lpGroup, POOL_TASK &cTask)
+{
+	std::lock_guard<std::mutex> lckTasks(m_LockTasks);
+
+	auto it = std::find_if(m_Tasks.begin(), m_Tasks.end(), [lpGroup](const POOL_TASK &cWaiting) {
+		return lpGroup == cWaiting.lpGroup;
+	});
+
+	if (m_Tasks.end() == it)
+		return FALSE;
+
+	cTask = std::move(*it);
+	m_Tasks.erase(it);
+	return TRUE;
+}
+
+void CPckWorkerPool::WorkerThread()
+{
+	for (;;) {
+
+		POOL_TASK cTask;
+		{
+			std::unique_lock<std::mutex> lckTasks(m_LockTasks);
+			m_cvTasks.wait(lckTasks, [this] { return m_isStop || !m_Tasks.empty(); });
+
+			if (m_Tasks.empty())
+				return;
+
+			cTask = std::move(m_Tasks.front());
+			m_Tasks.pop_front();
+		}
+
+		RunTask(cTask);
+	}
+}
+
+void CPckWorkerPool::RunTask(POOL_TASK &cTask)
+{
+	//A worker that throws would end the process, the group would never be done
+	try {
+		cTask.lpTask();
+	}
+	catch (std::exception &ex) {
+		Logger.e("A task of the worker pool failed: %s", ex.what());
+	}
+	catch (...) {
+		Logger.e("A task of the worker pool failed");
+	}
+
+	cTask.lpGroup->Done();
+}
+
+CPckTaskGroup::CPckTaskGroup(uint32_t dwThreads)
+{
+	WorkerPool.Reserve(std::max<uint32_t>(dwThreads, 1));
+}
+
+CPckTaskGroup::~CPckTaskGroup()
+{
+	Wait();
+}
+
+void CPckTaskGroup::Run(std::function<void()> lpTask)
+{
+	{
+		std::lock_guard<std::mutex> lckPending(m_LockPending);
+		++m_dwPending;
+	}
+	WorkerPool.Submit(std::move(lpTask), this);
+}
+
+void CPckTaskGroup::Wait()
+{
+	CPckWorkerPool::POOL_TASK cTask;
+
+	//The workers may all be busy with other stages
+	while (WorkerPool.TakeTask(this, cTask))
+		CPckWorkerPool::RunTask(cTask);
+
+	std::unique_lock<std::mutex> lckPending(m_LockPending);
+	m_cvDone.wait(lckPending, [this] { return 0 == m_dwPending; });
+}
+
+void CPckTaskGroup::Done()
+{
+	//Notified under the lock, the group may be gone as soon as the waiter sees 0
+	std::lock_guard<std::mutex> lckPending(m_LockPending);
+
+	if (0 == --m_dwPending)
+		m_cvDone.notify_all();
+}
+
+void RunBlocksInPool(uint32_t dwCount, uint32_t dwBlockSize, uint32_t dwThreads, const std::function<void(uint32_t, uint32_t)> &lpBlock)
+{
+	dwBlockSize = std::max<uint32_t>(dwBlockSize, 1);
+
+	const uint32_t dwBlockCount = (uint32_t)(((uint64_t)dwCount + dwBlockSize - 1) / dwBlockSize);
+	const uint32_t threadnum = std::min<uint32_t>(std::max<uint32_t>(dwThreads, 1), dwBlockCount);
+
+	std::atomic<uint32_t> dwNextBlock(0);
+
+	auto RunBlocks = [&]() {
+
+		uint32_t i;
+		while (dwBlockCount > (i = dwNextBlock++)) {
+
+			uint32_t dwBegin = i * dwBlockSize;
+			lpBlock(dwBegin, std::min<uint32_t>(dwCount - dwBegin, dwBlockSize) + dwBegin);
+		}
+	};
+
+	//A small table is not worth a task
+	if (1 >= threadnum) {
+		RunBlocks();
+		return;
+	}
+
+	CPckTaskGroup cTasks(threadnum);
+	for (uint32_t i = 1; i < threadnum; ++i)
+		cTasks.Run(RunBlocks);
+
+	RunBlocks();
+	cTasks.Wait();
+}
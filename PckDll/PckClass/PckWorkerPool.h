@@ -0,0 +1,104 @@
+//////////////////////////////////////////////////////////////////////
+// PckWorkerPool.h: threads shared by every parallel stage of the library
+//
+// The workers are started the first time a stage needs them and live
+// until the library is unloaded, so archives processed one after the other
+// do not start and join threads each time, and stages of archives opened
+// on different handles share the same threads. A stage starts its tasks in
+// a CPckTaskGroup and waits for them, the waiting thread runs the tasks of
+// its group that no worker has taken yet. A task may wait for the thread
+// that started it, never for a task that is still waiting for a worker
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "PckDefines.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define POOL_MAX_THREADS	256
+
+class CPckTaskGroup;
+
+class CPckWorkerPool
+{
+private:
+	CPckWorkerPool();
+	CPckWorkerPool(const CPckWorkerPool&) = delete;
+	~CPckWorkerPool();
+
+	const CPckWorkerPool& operator=(const CPckWorkerPool&) = delete;
+
+public:
+
+	static CPckWorkerPool& GetInstance() {
+		static CPckWorkerPool onlyInstance;
+		return onlyInstance;
+	}
+
+	//Starts workers until there are dwThreads of them
+	void		Reserve(uint32_t dwThreads);
+	uint32_t	GetThreadCount();
+
+private:
+
+	friend class CPckTaskGroup;
+
+	typedef struct _POOL_TASK
+	{
+		std::function<void()>	lpTask;
+		CPckTaskGroup			*lpGroup;
+	}POOL_TASK;
+
+	void	Submit(std::function<void()> &&lpTask, CPckTaskGroup *lpGroup);
+	//Takes a task of the group that no worker has started, FALSE if there is none
+	BOOL	TakeTask(CPckTaskGroup *lpGroup, POOL_TASK &cTask);
+
+	void		WorkerThread();
+	static void	RunTask(POOL_TASK &cTask);
+
+	std::mutex				m_LockTasks;
+	std::condition_variable	m_cvTasks;
+	std::deque<POOL_TASK>	m_Tasks;
+	BOOL					m_isStop = FALSE;
+
+	std::mutex				m_LockThreads;
+	std::vector<std::thread>	m_Threads;
+};
+
+extern CPckWorkerPool& WorkerPool;
+
+//Tasks of one stage, the destructor waits for them
+class CPckTaskGroup
+{
+public:
+	//dwThreads is the number of tasks that should run at the same time
+	CPckTaskGroup(uint32_t dwThreads);
+	~CPckTaskGroup();
+
+	CPckTaskGroup(const CPckTaskGroup&) = delete;
+	CPckTaskGroup& operator=(const CPckTaskGroup&) = delete;
+
+	void	Run(std::function<void()> lpTask);
+	void	Wait();
+
+private:
+
+	friend class CPckWorkerPool;
+
+	void	Done();
+
+	uint32_t				m_dwPending = 0;
+	std::mutex				m_LockPending;
+	std::condition_variable	m_cvDone;
+};
+
+//Calls lpBlock(dwBegin, dwEnd) for every block of dwBlockSize items in [0, dwCount) on up to dwThreads threads,
+//the calling thread included, and returns when all blocks are done
+void	RunBlocksInPool(uint32_t dwCount, uint32_t dwBlockSize, uint32_t dwThreads, const std::function<void(uint32_t, uint32_t)> &lpBlock);
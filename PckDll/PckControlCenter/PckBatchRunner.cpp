@@ -0,0 +1,243 @@
+//////////////////////////////////////////////////////////////////////
+// PckBatchRunner.cpp: one operation on many pck files at the same time
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "PckBatchRunner.h"
+#include "PckControlCenter.h"
+#include "PckSystemLimits.h"
+#include "PckWorkerPool.h"
+#include "MapViewFileMultiPck.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+
+CPckBatchRunner::CPckBatchRunner(const PCK_BATCH_PARAMS &cParams, std::function<void(int, int)> lpItemDone) :
+	m_cParams(cParams),
+	m_lpItemDone(std::move(lpItemDone))
+{}
+
+CPckBatchRunner::~CPckBatchRunner()
+{}
+
+BOOL CPckBatchRunner::IsValidParams(const PCK_BATCH_PARAMS &cParams)
+{
+	if ((PCK_BATCH_VERIFY > cParams.iOperation) || (PCK_BATCH_MAX < cParams.iOperation))
+		return FALSE;
+
+	//Everything but verify writes under the destination
+	if ((PCK_BATCH_VERIFY != cParams.iOperation) && ((nullptr == cParams.lpszDestDirectory) || (0 == *cParams.lpszDestDirectory)))
+		return FALSE;
+
+	return (MAX_COMPRESS_LEVEL >= cParams.dwCompressLevel);
+}
+
+BOOL CPckBatchRunner::IsParallelOperation()
+{
+	//A rebuild only copies the data, that runs on one thread
+	return (PCK_BATCH_VERIFY == m_cParams.iOperation) || (PCK_BATCH_EXTRACT == m_cParams.iOperation) ||
+		(PCK_BATCH_RECOMPRESS == m_cParams.iOperation) || (PCK_BATCH_STRIP == m_cParams.iOperation);
+}
+
+//lpszDestDirectory/a.pck for a rebuilt pck, lpszDestDirectory/a for the files of a.pck
+std::wstring CPckBatchRunner::GetOutputPath(const wchar_t *lpszPckFile)
+{
+	if (PCK_BATCH_VERIFY == m_cParams.iOperation)
+		return std::wstring();
+
+	std::wstring szName(lpszPckFile);
+
+	size_t nSlash = szName.find_last_of(L"\\/");
+	if (std::wstring::npos != nSlash)
+		szName.erase(0, nSlash + 1);
+
+	if (PCK_BATCH_EXTRACT == m_cParams.iOperation) {
+
+		size_t nDot = szName.rfind(L'.');
+		if ((std::wstring::npos != nDot) && (0 != nDot))
+			szName.resize(nDot);
+	}
+
+	std::wstring szOutput(m_cParams.lpszDestDirectory);
+
+	if ((L'\\' != szOutput.back()) && (L'/' != szOutput.back()))
+		szOutput.push_back(L'/');
+
+	return szOutput.append(szName);
+}
+
+uint64_t CPckBatchRunner::GetPckSize(const wchar_t *lpszPckFile)
+{
+	CMapViewFileMultiPckRead cFileRead;
+
+	if (!cFileRead.OpenPck(lpszPckFile))
+		return 0;
+
+	return cFileRead.GetFileSize();
+}
+
+BOOL CPckBatchRunner::IsSameFile(const wchar_t *lpszFile1, const wchar_t *lpszFile2)
+{
+	wchar_t szFullPath1[MAX_PATH], szFullPath2[MAX_PATH];
+
+	if ((0 == GetFullPathNameW(lpszFile1, MAX_PATH, szFullPath1, NULL)) || (0 == GetFullPathNameW(lpszFile2, MAX_PATH, szFullPath2, NULL)))
+		return (0 == wcscmp(lpszFile1, lpszFile2));
+
+	return (0 == wcscmp(szFullPath1, szFullPath2));
+}
+
+uint32_t CPckBatchRunner::Run(const wchar_t **lpszPckFiles, int nFileCount)
+{
+	if (0 >= nFileCount)
+		return 0;
+
+	uint32_t dwAllThreads = std::min<uint32_t>((0 == m_cParams.dwThreads) ? CPckSystemLimits::GetCpuCount() : m_cParams.dwThreads, POOL_MAX_THREADS);
+
+	//The outputs of the archives are made in it
+	if (PCK_BATCH_VERIFY != m_cParams.iOperation)
+		CreateDirectoryW(m_cParams.lpszDestDirectory, NULL);
+
+	std::vector<BATCH_ITEM> cItems;
+	std::set<std::wstring> cOutputs;
+	uint64_t qwBytesLeft = 0;
+
+	std::mutex lckItemDone;
+	std::atomic<uint32_t> dwSuccessCount(0);
+
+	auto ItemDone = [&](int iIndex, int iResult) {
+
+		if (PCK_OK == iResult)
+			++dwSuccessCount;
+
+		std::lock_guard<std::mutex> lckCallback(lckItemDone);
+		if (m_lpItemDone)
+			m_lpItemDone(iIndex, iResult);
+	};
+
+	for (int i = 0; i < nFileCount; i++) {
+
+		if ((nullptr == lpszPckFiles[i]) || (0 == *lpszPckFiles[i])) {
+			ItemDone(i, PCK_ERR_OPENMAPVIEWR);
+			continue;
+		}
+
+		BATCH_ITEM cItem = { i, GetPckSize(lpszPckFiles[i]), GetOutputPath(lpszPckFiles[i]) };
+
+		//Two archives of the same name, or an archive rebuilt onto itself
+		if ((!cItem.szOutput.empty()) && (IsSameFile(cItem.szOutput.c_str(), lpszPckFiles[i]) || (!cOutputs.insert(cItem.szOutput).second))) {
+			Logger.e(TEXT_BATCH_OUTPUT_USED, cItem.szOutput.c_str());
+			ItemDone(i, PCK_ERROR);
+			continue;
+		}
+
+		qwBytesLeft += cItem.qwSize;
+		cItems.push_back(std::move(cItem));
+	}
+
+	std::stable_sort(cItems.begin(), cItems.end(), [](const BATCH_ITEM &a, const BATCH_ITEM &b) {
+		return a.qwSize > b.qwSize;
+	});
+
+	//The stages of all archives together never start more tasks than this
+	WorkerPool.Reserve(dwAllThreads);
+
+	std::mutex				lckThreads;
+	std::condition_variable	cvThreads;
+	uint32_t				dwFreeThreads = dwAllThreads;
+
+	std::vector<std::thread> tItems;
+	tItems.reserve(cItems.size());
+
+	for (const BATCH_ITEM &cItem : cItems) {
+
+		//The share of the threads is the share of the bytes of the archives not started yet
+		uint32_t dwItemThreads = 1;
+
+		if (IsParallelOperation() && (0 != qwBytesLeft))
+			dwItemThreads = (uint32_t)std::clamp<uint64_t>((dwAllThreads * cItem.qwSize + qwBytesLeft - 1) / qwBytesLeft, 1, dwAllThreads);
+
+		qwBytesLeft -= cItem.qwSize;
+
+		{
+			std::unique_lock<std::mutex> lckFree(lckThreads);
+			cvThreads.wait(lckFree, [&dwFreeThreads] { return 0 != dwFreeThreads; });
+
+			dwItemThreads = std::min(dwItemThreads, dwFreeThreads);
+			dwFreeThreads -= dwItemThreads;
+		}
+
+		const wchar_t *lpszPckFile = lpszPckFiles[cItem.iIndex];
+
+		tItems.emplace_back([&, lpszPckFile, dwItemThreads]() {
+
+			ItemDone(cItem.iIndex, RunItem(lpszPckFile, cItem.szOutput, dwItemThreads, dwAllThreads));
+
+			{
+				std::lock_guard<std::mutex> lckFree(lckThreads);
+				dwFreeThreads += dwItemThreads;
+			}
+			cvThreads.notify_one();
+		});
+	}
+
+	for (std::thread &t : tItems)
+		t.join();
+
+	return dwSuccessCount;
+}
+
+int CPckBatchRunner::RunItem(const wchar_t *lpszPckFile, const std::wstring &szOutput, uint32_t dwThreads, uint32_t dwAllThreads)
+{
+	CPckControlCenter cCenter(FALSE);
+
+	if (!(cCenter.Open(lpszPckFile) && cCenter.IsValidPck()))
+		return PCK_ERR_OPENMAPVIEWR;
+
+	cCenter.setMaxThread(dwThreads);
+	cCenter.setCompressLevel((0 == m_cParams.dwCompressLevel) ? CPckControlCenter::getDefaultCompressLevel() : m_cParams.dwCompressLevel);
+	//The memory is shared like the threads
+	cCenter.setMTMaxMemory((uint32_t)std::max<uint64_t>((uint64_t)CPckControlCenter::getMaxMemoryAllowed() * dwThreads / dwAllThreads, SYSTEM_MIN_MEMORY_BUDGET));
+
+	BOOL rtn = FALSE;
+
+	switch (m_cParams.iOperation) {
+
+	case PCK_BATCH_VERIFY:
+		rtn = cCenter.VerifyAllFiles();
+		break;
+
+	case PCK_BATCH_EXTRACT:
+		if ((nullptr != m_cParams.lpszPathInPck) && (0 != *m_cParams.lpszPathInPck)) {
+
+			LPCENTRY lpFileEntry = cCenter.GetFileEntryByPath(m_cParams.lpszPathInPck);
+
+			if (NULL == lpFileEntry)
+				return PCK_ERR_NOT_FILE;
+
+			rtn = cCenter.ExtractFiles(&lpFileEntry, 1, szOutput.c_str());
+		}
+		else {
+			rtn = cCenter.ExtractAllFiles(szOutput.c_str());
+		}
+		break;
+
+	case PCK_BATCH_REBUILD:
+	case PCK_BATCH_RECOMPRESS:
+		rtn = cCenter.RebuildPckFile(m_cParams.lpszScriptFile, szOutput.c_str(), PCK_BATCH_RECOMPRESS == m_cParams.iOperation);
+		break;
+
+	case PCK_BATCH_STRIP:
+		rtn = cCenter.StripPck(szOutput.c_str(), m_cParams.iStripFlag);
+		break;
+	}
+
+	if (rtn)
+		return PCK_OK;
+
+	return cCenter.isLastOptSuccess() ? PCK_ERROR : cCenter.GetLastErrorMsg();
+}
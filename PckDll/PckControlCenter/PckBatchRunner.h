@@ -0,0 +1,51 @@
+//////////////////////////////////////////////////////////////////////
+// PckBatchRunner.h: one operation on many pck files at the same time
+//
+// Every archive is opened in its own CPckControlCenter and runs on its
+// own thread, the threads of its parallel stages are taken from one budget
+// for the whole batch. The largest archives start first and get the larger
+// part of the budget, the smaller ones take the threads that are left, so
+// the cores stay busy until the last large archive is done
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "pck_dependencies.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+class CPckBatchRunner
+{
+public:
+	//lpItemDone(iIndex, iResult) when an archive ended, iResult is PCK_OK or the error, never called at the same time
+	CPckBatchRunner(const PCK_BATCH_PARAMS &cParams, std::function<void(int, int)> lpItemDone);
+	~CPckBatchRunner();
+
+	static BOOL	IsValidParams(const PCK_BATCH_PARAMS &cParams);
+
+	//Returns when all archives ended, the number of archives that succeeded
+	uint32_t	Run(const wchar_t **lpszPckFiles, int nFileCount);
+
+private:
+
+	typedef struct _BATCH_ITEM
+	{
+		int				iIndex;
+		uint64_t		qwSize;
+		std::wstring	szOutput;
+	}BATCH_ITEM;
+
+	//Only these use more than one thread for an archive
+	BOOL		IsParallelOperation();
+	std::wstring	GetOutputPath(const wchar_t *lpszPckFile);
+	static uint64_t	GetPckSize(const wchar_t *lpszPckFile);
+	static BOOL		IsSameFile(const wchar_t *lpszFile1, const wchar_t *lpszFile2);
+
+	int			RunItem(const wchar_t *lpszPckFile, const std::wstring &szOutput, uint32_t dwThreads, uint32_t dwAllThreads);
+
+	PCK_BATCH_PARAMS				m_cParams;
+	std::function<void(int, int)>	m_lpItemDone;
+};
@@ -11,16 +11,18 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "PckControlCenter.h"
+#include "PckSystemLimits.h"
 #include "PckClass.h"
 #include "PckClassLog.h"
 #include <thread>
 	
 //const DWORD	CPckControlCenter::m_dwNumberOfProcessors = thread::hardware_concurrency();
 
-CPckControlCenter::CPckControlCenter():
+CPckControlCenter::CPckControlCenter(BOOL isFeedbackEnabled):
 	m_lpClassPck(NULL),
 	m_lpPckRootNode(NULL),
 	m_emunFileFormat(FMTPCK_UNKNOWN),
+	m_isFeedbackEnabled(isFeedbackEnabled),
 	cParams({ 0 })
 {
 	init();
@@ -29,7 +31,8 @@ CPckControlCenter::CPckControlCenter():
 
 CPckControlCenter::~CPckControlCenter()
 {
-	regMsgFeedback(NULL, DefaultFeedbackCallback);
+	if (m_isFeedbackEnabled)
+		regMsgFeedback(NULL, DefaultFeedbackCallback);
 	Close();
 	uninit();
 	Logger.OutputVsIde(__FUNCTION__, "\r\n");
@@ -38,10 +41,14 @@ CPckControlCenter::~CPckControlCenter()
 void CPckControlCenter::init()
 {
 	cParams.lpPckControlCenter = this;
+	cParams.lpTaskEvents = &m_cTaskEvents;
 	//cParams.code_page = 936;
 	cParams.dwCompressLevel = getDefaultCompressLevel();
-	cParams.dwMTThread = thread::hardware_concurrency();
+	cParams.dwMTThread = CPckSystemLimits::GetCpuCount();
 	cParams.dwMTMaxMemory = getMaxMemoryAllowed();
+	cParams.iRebuildLayout = PCK_LAYOUT_ORIGINAL;
+	cParams.lpszLayoutListFile = nullptr;
+	m_iSearchMode = PCK_SEARCH_SUBSTRING;
 }
 
 void CPckControlCenter::uninit()
@@ -54,3 +61,11 @@ void CPckControlCenter::Reset(uint32_t dwUIProgressUpper)
 	memset(&cParams.cVarParams, 0, sizeof(PCK_VARIETY_PARAMS));
 	cParams.cVarParams.dwUIProgressUpper = dwUIProgressUpper;
 }
+
+void CPckControlCenter::ResetIndexCaches()
+{
+	m_cDataCache.Clear();
+	m_cCheckpoints.Clear();
+	m_cSearchIndex.Clear();
+	m_cListCursor.Reset();
+}
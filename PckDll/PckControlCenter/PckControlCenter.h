@@ -14,6 +14,11 @@
 #include <string>
 #include "PckStructs.h"
 #include "PckClassLog.h"
+#include "PckDataCache.h"
+#include "PckCheckpointIndex.h"
+#include "PckSearchIndex.h"
+#include "PckListCursor.h"
+#include "PckTaskEvents.h"
 #include <vector>
 
 typedef struct _PCK_PATH_NODE * LPPCK_PATH_NODE;
@@ -33,12 +38,14 @@ typedef struct _PCK_RUNTIME_PARAMS * LPPCK_RUNTIME_PARAMS;
 
 class CPckClass;
 class CPckClassLog;
+class CPckVirtualFile;
 
 class EXPORT_CLASS CPckControlCenter
 {
 	//function
 public:
-	CPckControlCenter();
+	//isFeedbackEnabled = FALSE for instances that are not shown in the UI, they do not send open/close events
+	CPckControlCenter(BOOL isFeedbackEnabled = TRUE);
 	virtual ~CPckControlCenter();
 
 	void	New();
@@ -48,6 +55,8 @@ private:
 	void	init();
 	void	uninit();
 	void	Reset(uint32_t dwUIProgressUpper = 1);
+	//Drop the data built from the index when the index changes
+	void	ResetIndexCaches();
 #pragma region Open and close files
 
 	void	Close();
@@ -70,10 +79,18 @@ public:
 
 	//Preview file
 	BOOL		GetSingleFileData(LPCENTRY lpFileEntry, char *buffer, size_t sizeOfBuffer = 0);
+	//Preview many files, lpStatus[i] = PCK_OK or error code, return the number of files read successfully
+	uint32_t	GetBatchFileData(const PCK_UNIFIED_FILE_ENTRY **lpFileEntryArray, int nEntryCount, char **lpBuffers, const size_t *lpSizeOfBuffers, int *lpStatus);
+	//Read a file a part at a time, cFile keeps working after the pck is closed
+	BOOL		OpenVirtualFile(LPCENTRY lpFileEntry, CPckVirtualFile &cFile);
+	//Decompressed bytes of the file from qwOffset, the bytes read or -1
+	int64_t		GetFileDataAt(LPCENTRY lpFileEntry, uint64_t qwOffset, char *buffer, size_t sizeOfBuffer);
 
 	//unzip files
 	BOOL		ExtractFiles(const PCK_UNIFIED_FILE_ENTRY **lpFileEntryArray, int nEntryCount, LPCWSTR lpszDestDirectory);
 	BOOL		ExtractAllFiles(LPCWSTR lpszDestDirectory);
+	//Decompress every file without writing it
+	BOOL		VerifyAllFiles();
 
 #pragma endregion
 
@@ -96,6 +113,8 @@ public:
 	void	StringArrayReset();
 	void	StringArrayAppend(LPCWSTR lpszFilePath);
 	BOOL	UpdatePckFileSubmit(LPCWSTR szPckFile, LPCENTRY lpFileEntry);
+	//Add the files under lpszZupFolder of a zup to the opened pck
+	BOOL	ApplyZupSubmit(LPCWSTR szPckFile, LPCWSTR szZupFile, LPCWSTR lpszZupFolder, LPCENTRY lpFileEntry);
 
 #pragma endregion
 
@@ -172,12 +191,23 @@ public:
 	uint32_t		SearchByName(LPCWSTR lpszSearchString, void* _in_param, SHOW_LIST_CALLBACK _showListCallback);
 	static uint32_t	ListByNode(LPCENTRY lpFileEntry, void* _in_param, SHOW_LIST_CALLBACK _showListCallback);
 
+	//Fill the lists into packed arrays, see pck_listByNodeToArray
+	uint32_t		SearchByNameToArray(LPCWSTR lpszSearchString, uint32_t dwOffset, uint32_t dwMaxRecords, LPPCK_LIST_RECORD lpRecords, wchar_t *lpNames, uint32_t dwNamesChars, uint32_t *lpTotal);
+	uint32_t		ListByNodeToArray(LPCENTRY lpFileEntry, uint32_t dwOffset, uint32_t dwMaxRecords, LPPCK_LIST_RECORD lpRecords, wchar_t *lpNames, uint32_t dwNamesChars, uint32_t *lpTotal);
+	//Pages of folders of the tree of lpRootNode go on from cOwnCursor, entries of other trees are walked from the first one
+	static uint32_t	ListByNodeToArray(CPckListCursor &cOwnCursor, LPCENTRY lpRootNode, LPCENTRY lpFileEntry, uint32_t dwOffset, uint32_t dwMaxRecords, LPPCK_LIST_RECORD lpRecords, wchar_t *lpNames, uint32_t dwNamesChars, uint32_t *lpTotal);
+
 #pragma endregion
 
 #pragma region thread control
 	//Thread running parameters
 	BOOL			isThreadWorking();
 	void			ForceBreakThreadWorking();
+
+	//Events of the tasks and waiting for them
+	BOOL			regTaskCallbacks(void* pTag, TaskProgressCallback _ProgressCallBack, TaskStageCallback _StageCallBack, TaskCompleteCallback _CompleteCallBack, uint32_t dwProgressIntervalMs);
+	int32_t			getTaskStage();
+	BOOL			waitForTask(uint32_t dwMilliseconds);
 #pragma endregion
 
 	//error no
@@ -215,6 +245,40 @@ public:
 	static uint32_t	getDefaultCompressLevel();
 #pragma endregion
 
+#pragma region Rebuild layout
+
+	//Data area layout used by rebuild/recompress, PCK_LAYOUT_*
+	int		getRebuildLayout();
+	BOOL	setRebuildLayout(int iLayout, LPCWSTR lpszListFile = nullptr);
+
+#pragma endregion
+
+#pragma region Search mode
+
+	//PCK_SEARCH_* used by SearchByName
+	int		getSearchMode();
+	BOOL	setSearchMode(int iSearchMode);
+
+#pragma endregion
+
+#pragma region Data cache
+
+	//Bytes of decompressed data kept for GetSingleFileData, 0 - disabled
+	size_t	getDataCacheSize();
+	void	setDataCacheSize(size_t nMaxSize);
+
+#pragma endregion
+
+#pragma region Checkpoints
+
+	//Decompressed bytes between two checkpoints of the large files, 0 - disabled
+	uint32_t	getCheckpointInterval();
+	void		setCheckpointInterval(uint32_t dwInterval);
+	//Save the checkpoints made so far next to the pck
+	BOOL		SaveCheckpointIndex();
+
+#pragma endregion
+
 #pragma region Progress related
 
 	uint32_t	getUIProgress();
@@ -237,17 +301,34 @@ private:
 
 	FMTPCK	GetPckTypeFromFilename(const wchar_t * lpszFile);
 
+	static void	NextListedNode(CPckListCursor &cCursor);
+	static void	RewindListCursor(CPckListCursor &cCursor);
+
 	LPPCK_PATH_NODE				m_lpPckRootNode;
 	std::vector<std::wstring>	lpszFilePathToAdd;	//Provide data when adding multiple files
 
 	std::wstring				szUpdateResultString;
+	std::wstring				szLayoutListFile;	//Access list of PCK_LAYOUT_ACCESS_LIST
 
 	PCK_RUNTIME_PARAMS			cParams;
+	CPckTaskEvents				m_cTaskEvents;
 	CPckClass					*m_lpClassPck;
 
+	//Recently previewed files, keyed by index entry
+	CPckDataCache				m_cDataCache;
+	//Random access points of the large files, shared by their readers
+	CPckCheckpointIndex			m_cCheckpoints;
+	//Filenames for SearchByName, built by the first search
+	CPckSearchIndex				m_cSearchIndex;
+	int							m_iSearchMode;
+	//Where the last page of ListByNodeToArray ended in the tree
+	CPckListCursor				m_cListCursor;
+
 	//Format
 	FMTPCK						m_emunFileFormat;
 
+	BOOL						m_isFeedbackEnabled;
+
 	static FeedbackCallback		pFeedbackCallBack;
 	static void*				pTag;
 
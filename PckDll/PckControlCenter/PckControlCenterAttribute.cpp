@@ -157,6 +157,7 @@ BOOL CPckControlCenter::SetAdditionalInfo(LPCSTR lpszAdditionalInfo)
 	if (NULL == m_lpClassPck)
 		return FALSE;
 
+	ResetIndexCaches();
 	return m_lpClassPck->SetAdditionalInfo(lpszAdditionalInfo);
 }
 
@@ -201,84 +202,17 @@ BOOL CPckControlCenter::GetCurrentNodeString(LPWSTR szCurrentNodePathString, LPC
 
 LPCENTRY CPckControlCenter::GetFileEntryByPath(LPCWSTR _in_szCurrentNodePathString)
 {
-	const PCK_PATH_NODE* lpCurrentNode = (PCK_PATH_NODE*)GetRootNode();
-	const PCK_PATH_NODE* lpCurrentNodeToFind = lpCurrentNode;
-
-	if (NULL == _in_szCurrentNodePathString)
+	if ((NULL == _in_szCurrentNodePathString) || (NULL == m_lpClassPck))
 		return NULL;
 
-	if (0 == *_in_szCurrentNodePathString)
-		return (LPPCK_UNIFIED_FILE_ENTRY)lpCurrentNode;
-
-	wchar_t szPath2Parse[MAX_PATH];
-	wchar_t *lpszPaths[MAX_PATH] = { NULL };
-	wcscpy_s(szPath2Parse, _in_szCurrentNodePathString);
-
-	szPath2Parse[MAX_PATH - 1] = 0;
-	wchar_t *lpszSearch = szPath2Parse;
-	int nDirCount = 0;
-
-	if ('\\' == *lpszSearch)
-		lpszSearch++;
-
-	lpszPaths[nDirCount] = lpszSearch;
-	++nDirCount;
-
-	for (int i = 0; i < MAX_PATH; i++) {
-
-		if (0 == *lpszSearch)
-			break;
-		else if ('\\' == *lpszSearch)
-		{
-			*lpszSearch = 0;
-			if (0 != *(lpszSearch + 1)) {
-				lpszPaths[nDirCount] = lpszSearch + 1;
-				++nDirCount;
-			}
-		}
-		lpszSearch++;
-	}
-
-	wchar_t	**lpCurrentDir = lpszPaths;
-
-	for (int i = 0; i < nDirCount; i++) {
-
-		if (0 == **lpCurrentDir)return (LPPCK_UNIFIED_FILE_ENTRY)lpCurrentNode;
-
-		//If it is a folder
-		if (PCK_ENTRY_TYPE_FOLDER == (PCK_ENTRY_TYPE_FOLDER & lpCurrentNodeToFind->entryType)) {
-			lpCurrentNode = lpCurrentNodeToFind = lpCurrentNodeToFind->child;
-		}
-		else {
-			return NULL;
-		}
-
-		BOOL isDirFound = FALSE;
+	while (('\\' == *_in_szCurrentNodePathString) || ('/' == *_in_szCurrentNodePathString))
+		++_in_szCurrentNodePathString;
 
-		while (NULL != lpCurrentNodeToFind) {
-
-			if (0 == wcscmp(lpCurrentNodeToFind->szName, *lpCurrentDir)) {
-
-				lpCurrentNode = lpCurrentNodeToFind;
-				isDirFound = TRUE;
-				break;
-			}
-
-			lpCurrentNodeToFind = lpCurrentNodeToFind->next;
-		}
-
-		if (!isDirFound) {
-#if PCK_DEBUG_OUTPUT
-			printf("node not found\n");
-#endif
-			return NULL;
-			//return (LPPCK_UNIFIED_FILE_ENTRY)lpCurrentNode;
-		}
-
-		lpCurrentDir++;
+	if (0 == *_in_szCurrentNodePathString)
+		return GetRootNode();
 
-	}
-	return (LPPCK_UNIFIED_FILE_ENTRY)lpCurrentNode;
+	//Looked up through the full path table of the tree
+	return (LPCENTRY)m_lpClassPck->FindNodeByPath(_in_szCurrentNodePathString);
 }
 
 #pragma endregion
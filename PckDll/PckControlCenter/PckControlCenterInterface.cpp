@@ -133,58 +133,63 @@ uint32_t CPckControlCenter::SearchByName(LPCWSTR lpszSearchString, void* _in_par
 		0,
 		(void*)GetRootNode());
 
-	for (uint32_t i = 0; i < dwFileCount; i++) {
-		//while(PCK_ENTRY_TYPE_TAIL_INDEX != lpPckIndexTable->entryType){
-		if (NULL != wcsstr(lpPckIndexTable->cFileIndex.szwFilename, lpszSearchString)) {
+	std::vector<uint32_t> lpFoundIds;
+	m_cSearchIndex.Search(lpPckIndexTable, dwFileCount, lpszSearchString, m_iSearchMode, cParams.dwMTThread, lpFoundIds);
 
-			_showList(_in_param,
-				dwFoundCount,
-				lpPckIndexTable->cFileIndex.szwFilename,
-				lpPckIndexTable->entryType,
-				lpPckIndexTable->cFileIndex.dwFileClearTextSize,
-				lpPckIndexTable->cFileIndex.dwFileCipherTextSize,
-				(void*)lpPckIndexTable);
+	for (uint32_t id : lpFoundIds) {
 
-			dwFoundCount++;
-		}
-		lpPckIndexTable++;
+		const PCKINDEXTABLE	* lpFoundIndexTable = lpPckIndexTable + id;
+
+		_showList(_in_param,
+			dwFoundCount,
+			lpFoundIndexTable->cFileIndex.szwFilename,
+			lpFoundIndexTable->entryType,
+			lpFoundIndexTable->cFileIndex.dwFileClearTextSize,
+			lpFoundIndexTable->cFileIndex.dwFileCipherTextSize,
+			(void*)lpFoundIndexTable);
+
+		dwFoundCount++;
 	}
 	return dwFoundCount;
 }
 
-uint32_t CPckControlCenter::ListByNode(LPCENTRY lpFileEntry, void* _in_param, SHOW_LIST_CALLBACK _showListCallback)
+//The first node of the list shown for lpFileEntry, NULL if it is not a folder
+static const PCK_PATH_NODE* GetNodesToList(LPCENTRY lpFileEntry)
 {
-	if (NULL == lpFileEntry) {
-		return 0;
-	}
-
-	SHOW_LIST_CALLBACK _showList = _showListCallback;
-
-	if (NULL == _showListCallback) {
-		_showList = DefaultShowFilelistCallback;
-	}
-
-	//If it is a .. folder, the previous layer will be displayed; if not, the next layer will be displayed.
-	const PCK_PATH_NODE* lpNodeToShow = (LPPCK_PATH_NODE)lpFileEntry;
-
 	int entry_type = lpFileEntry->entryType;
 	//The first thing is the folder
 	if (PCK_ENTRY_TYPE_FOLDER != (PCK_ENTRY_TYPE_FOLDER & entry_type)) {
 #if PCK_DEBUG_OUTPUT
 		printf("%s:is not a folder\n", __FUNCTION__);
 #endif
-		return 0;
+		return NULL;
 	}
 
+	//If it is a .. folder, the previous layer will be displayed; if not, the next layer will be displayed.
 	//Enter a non-..folder
 	if (PCK_ENTRY_TYPE_DOTDOT != (PCK_ENTRY_TYPE_DOTDOT & entry_type)){
-		lpNodeToShow = ((LPPCK_PATH_NODE)lpFileEntry)->child;
+		return ((LPPCK_PATH_NODE)lpFileEntry)->child;
 
 	}//What remains is the ..folder
 	else {
-		lpNodeToShow = ((LPPCK_PATH_NODE)lpFileEntry)->parentfirst;
+		return ((LPPCK_PATH_NODE)lpFileEntry)->parentfirst;
+	}
+}
+
+uint32_t CPckControlCenter::ListByNode(LPCENTRY lpFileEntry, void* _in_param, SHOW_LIST_CALLBACK _showListCallback)
+{
+	if (NULL == lpFileEntry) {
+		return 0;
+	}
+
+	SHOW_LIST_CALLBACK _showList = _showListCallback;
+
+	if (NULL == _showListCallback) {
+		_showList = DefaultShowFilelistCallback;
 	}
 
+	const PCK_PATH_NODE* lpNodeToShow = GetNodesToList(lpFileEntry);
+
 	//Is lpNodeToShow NULL?
 	if (NULL == lpNodeToShow) {
 		return 0;
@@ -250,3 +255,246 @@ uint32_t CPckControlCenter::ListByNode(LPCENTRY lpFileEntry, void* _in_param, SH
 }
 
 #pragma endregion
+
+#pragma region Listing into arrays
+
+typedef struct _LIST_TO_ARRAY_PARAM
+{
+	uint32_t			dwOffset;
+	uint32_t			dwMaxRecords;
+	LPPCK_LIST_RECORD	lpRecords;
+	wchar_t				*lpNames;
+	uint32_t			dwNamesChars;
+
+	uint32_t			dwRecords;
+	uint32_t			dwNamesUsed;
+	uint32_t			dwTotal;
+	//The page is full, the rest is only counted
+	BOOL				isFull;
+}LIST_TO_ARRAY_PARAM;
+
+static void ListToArrayCallback(void* _in_param, int32_t sn, const wchar_t *lpszFilename, int32_t entry_type, uint64_t qwFileSize, uint64_t qwFileSizeCompressed, void* fileEntry)
+{
+	LIST_TO_ARRAY_PARAM *lpParam = (LIST_TO_ARRAY_PARAM*)_in_param;
+	uint32_t dwIndex = lpParam->dwTotal++;
+
+	if (lpParam->isFull || (dwIndex < lpParam->dwOffset))
+		return;
+
+	if (lpParam->dwRecords >= lpParam->dwMaxRecords) {
+		lpParam->isFull = TRUE;
+		return;
+	}
+
+	uint32_t dwNameLength = (uint32_t)wcsnlen(lpszFilename, MAX_PATH_PCK_260);
+	if ((lpParam->dwNamesChars - lpParam->dwNamesUsed) <= dwNameLength) {
+		lpParam->isFull = TRUE;
+		return;
+	}
+
+	wchar_t *lpName = lpParam->lpNames + lpParam->dwNamesUsed;
+	wmemcpy(lpName, lpszFilename, dwNameLength);
+	lpName[dwNameLength] = 0;
+
+	LPPCK_LIST_RECORD lpRecord = lpParam->lpRecords + lpParam->dwRecords;
+	lpRecord->fileEntry = fileEntry;
+	lpRecord->qwFileSize = qwFileSize;
+	lpRecord->qwFileSizeCompressed = qwFileSizeCompressed;
+	lpRecord->entryType = entry_type;
+	lpRecord->dwNameOffset = lpParam->dwNamesUsed;
+	lpRecord->dwNameLength = dwNameLength;
+	lpRecord->dwReserved = 0;
+
+	lpParam->dwNamesUsed += dwNameLength + 1;
+	++lpParam->dwRecords;
+}
+
+static void InitListToArrayParam(LIST_TO_ARRAY_PARAM &cParam, uint32_t dwOffset, uint32_t dwMaxRecords, LPPCK_LIST_RECORD lpRecords, wchar_t *lpNames, uint32_t dwNamesChars)
+{
+	memset(&cParam, 0, sizeof(cParam));
+	cParam.dwOffset = dwOffset;
+
+	//Without buffers only the total is returned
+	if ((NULL != lpRecords) && (NULL != lpNames)) {
+		cParam.dwMaxRecords = dwMaxRecords;
+		cParam.lpRecords = lpRecords;
+		cParam.lpNames = lpNames;
+		cParam.dwNamesChars = dwNamesChars;
+	}
+}
+
+uint32_t CPckControlCenter::SearchByNameToArray(LPCWSTR lpszSearchString, uint32_t dwOffset, uint32_t dwMaxRecords, LPPCK_LIST_RECORD lpRecords, wchar_t *lpNames, uint32_t dwNamesChars, uint32_t *lpTotal)
+{
+	LIST_TO_ARRAY_PARAM cParam;
+	InitListToArrayParam(cParam, dwOffset, dwMaxRecords, lpRecords, lpNames, dwNamesChars);
+
+	if (NULL == m_lpClassPck) {
+		if (NULL != lpTotal)
+			*lpTotal = 0;
+		return 0;
+	}
+
+	const PCKINDEXTABLE	* lpPckIndexTable = m_lpClassPck->GetPckIndexTable();
+
+	//Entry 0 is the top layer, the found files follow it, as SearchByName lists them
+	if (0 == dwOffset)
+		ListToArrayCallback(&cParam, 0, L"<--", PCK_ENTRY_TYPE_DOTDOT, 0, 0, (void*)GetRootNode());
+
+	//The found ids are kept by m_cSearchIndex, a page does not search again
+	std::vector<uint32_t> lpFoundIds;
+	uint32_t dwFoundCount = m_cSearchIndex.SearchPage(lpPckIndexTable, GetPckFileCount(), lpszSearchString, m_iSearchMode, cParams.dwMTThread,
+		(0 == dwOffset) ? 0 : (dwOffset - 1), cParam.dwMaxRecords, lpFoundIds);
+
+	cParam.dwTotal = std::max<uint32_t>(dwOffset, 1);
+
+	for (uint32_t id : lpFoundIds) {
+
+		const PCKINDEXTABLE	* lpFoundIndexTable = lpPckIndexTable + id;
+
+		ListToArrayCallback(&cParam,
+			cParam.dwTotal,
+			lpFoundIndexTable->cFileIndex.szwFilename,
+			lpFoundIndexTable->entryType,
+			lpFoundIndexTable->cFileIndex.dwFileClearTextSize,
+			lpFoundIndexTable->cFileIndex.dwFileCipherTextSize,
+			(void*)lpFoundIndexTable);
+	}
+
+	if (NULL != lpTotal)
+		*lpTotal = dwFoundCount + 1;
+	return cParam.dwRecords;
+}
+
+//lpNode or the first node after it that is listed in the pass of folders or of files
+static const PCK_PATH_NODE* FindListedNode(const PCK_PATH_NODE *lpNode, BOOL isFolders)
+{
+	for (; (NULL != lpNode) && (0 != *lpNode->szName); lpNode = lpNode->next) {
+
+		if (isFolders == (PCK_ENTRY_TYPE_FOLDER == (PCK_ENTRY_TYPE_FOLDER & lpNode->entryType)))
+			return lpNode;
+	}
+	return NULL;
+}
+
+//TRUE if lpNodeToShow is a list of the tree of lpRootNode, the .. nodes lead up to its first list
+static BOOL IsListInTree(const PCK_PATH_NODE *lpNodeToShow, LPCENTRY lpRootNode)
+{
+	if (NULL == lpRootNode)
+		return FALSE;
+
+	while (NULL != lpNodeToShow->parentfirst)
+		lpNodeToShow = lpNodeToShow->parentfirst;
+
+	return lpNodeToShow == ((const PCK_PATH_NODE*)lpRootNode)->child;
+}
+
+void CPckControlCenter::NextListedNode(CPckListCursor &cCursor)
+{
+	++cCursor.m_dwNext;
+	cCursor.m_lpNextNode = FindListedNode(cCursor.m_lpNextNode->next, cCursor.m_isFolders);
+
+	//Folders are listed before files like ListByNode does
+	if ((NULL == cCursor.m_lpNextNode) && cCursor.m_isFolders) {
+		cCursor.m_isFolders = FALSE;
+		cCursor.m_lpNextNode = FindListedNode(cCursor.m_lpFirstNode, FALSE);
+	}
+}
+
+void CPckControlCenter::RewindListCursor(CPckListCursor &cCursor)
+{
+	cCursor.m_dwNext = 0;
+	cCursor.m_isFolders = TRUE;
+	cCursor.m_lpNextNode = FindListedNode(cCursor.m_lpFirstNode, TRUE);
+
+	if (NULL == cCursor.m_lpNextNode) {
+		cCursor.m_isFolders = FALSE;
+		cCursor.m_lpNextNode = FindListedNode(cCursor.m_lpFirstNode, FALSE);
+	}
+}
+
+uint32_t CPckControlCenter::ListByNodeToArray(LPCENTRY lpFileEntry, uint32_t dwOffset, uint32_t dwMaxRecords, LPPCK_LIST_RECORD lpRecords, wchar_t *lpNames, uint32_t dwNamesChars, uint32_t *lpTotal)
+{
+	return ListByNodeToArray(m_cListCursor, GetRootNode(), lpFileEntry, dwOffset, dwMaxRecords, lpRecords, lpNames, dwNamesChars, lpTotal);
+}
+
+uint32_t CPckControlCenter::ListByNodeToArray(CPckListCursor &cOwnCursor, LPCENTRY lpRootNode, LPCENTRY lpFileEntry, uint32_t dwOffset, uint32_t dwMaxRecords, LPPCK_LIST_RECORD lpRecords, wchar_t *lpNames, uint32_t dwNamesChars, uint32_t *lpTotal)
+{
+	LIST_TO_ARRAY_PARAM cParam;
+	InitListToArrayParam(cParam, dwOffset, dwMaxRecords, lpRecords, lpNames, dwNamesChars);
+
+	const PCK_PATH_NODE* lpNodeToShow = (NULL == lpFileEntry) ? NULL : GetNodesToList(lpFileEntry);
+
+	if (NULL == lpNodeToShow) {
+		if (NULL != lpTotal)
+			*lpTotal = 0;
+		return 0;
+	}
+
+	//Nodes of another tree may be freed without the owner of cOwnCursor knowing, they are listed from a cursor of this call
+	CPckListCursor	cCallCursor;
+	CPckListCursor	&cCursor = IsListInTree(lpNodeToShow, lpRootNode) ? cOwnCursor : cCallCursor;
+
+	std::lock_guard<std::mutex> lckCursor(cCursor.m_Lock);
+
+	//Pages of the same folder go on from the cursor, another folder is counted once
+	if ((lpFileEntry != cCursor.m_lpFileEntry) || (lpNodeToShow != cCursor.m_lpFirstNode) ||
+		(lpNodeToShow->dwFilesCount != cCursor.m_dwFilesCount) || (lpNodeToShow->dwDirsCount != cCursor.m_dwDirsCount)) {
+
+		cCursor.m_lpFileEntry = lpFileEntry;
+		cCursor.m_lpFirstNode = lpNodeToShow;
+		cCursor.m_dwFilesCount = lpNodeToShow->dwFilesCount;
+		cCursor.m_dwDirsCount = lpNodeToShow->dwDirsCount;
+		cCursor.m_dwTotal = 0;
+
+		for (const PCK_PATH_NODE *lpNode = lpNodeToShow; (NULL != lpNode) && (0 != *lpNode->szName); lpNode = lpNode->next)
+			++cCursor.m_dwTotal;
+
+		RewindListCursor(cCursor);
+	}
+
+	//A page before the cursor is found from the first entry
+	if (dwOffset < cCursor.m_dwNext)
+		RewindListCursor(cCursor);
+
+	while ((cCursor.m_dwNext < dwOffset) && (NULL != cCursor.m_lpNextNode))
+		NextListedNode(cCursor);
+
+	cParam.dwTotal = cCursor.m_dwNext;
+
+	while ((NULL != cCursor.m_lpNextNode) && (cParam.dwRecords < cParam.dwMaxRecords)) {
+
+		const PCK_PATH_NODE *lpNode = cCursor.m_lpNextNode;
+
+		if (cCursor.m_isFolders) {
+			ListToArrayCallback(&cParam,
+				cCursor.m_dwNext,
+				lpNode->szName,
+				lpNode->entryType,
+				(NULL != lpNode->child) ? lpNode->child->qdwDirClearTextSize : 0,
+				(NULL != lpNode->child) ? lpNode->child->qdwDirCipherTextSize : 0,
+				(void*)lpNode);
+		}
+		else {
+			ListToArrayCallback(&cParam,
+				cCursor.m_dwNext,
+				lpNode->szName,
+				lpNode->lpPckIndexTable->entryType,
+				lpNode->lpPckIndexTable->cFileIndex.dwFileClearTextSize,
+				lpNode->lpPckIndexTable->cFileIndex.dwFileCipherTextSize,
+				(void*)lpNode);
+		}
+
+		//The names buffer is full, this entry starts the next page
+		if (cParam.isFull)
+			break;
+
+		NextListedNode(cCursor);
+	}
+
+	if (NULL != lpTotal)
+		*lpTotal = cCursor.m_dwTotal;
+	return cParam.dwRecords;
+}
+
+#pragma endregion
+
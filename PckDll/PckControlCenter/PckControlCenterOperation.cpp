@@ -67,7 +67,8 @@ BOOL CPckControlCenter::Open(const wchar_t * lpszFile)
 			m_lpPckRootNode = m_lpClassPck->GetPckPathNode();
 
 			//Open successfully, refresh title
-			pFeedbackCallBack(pTag, PCK_FILE_OPEN_SUCESS, NULL, (ssize_t)(m_lpClassPck->GetPckVersion()->name));
+			if (m_isFeedbackEnabled)
+				pFeedbackCallBack(pTag, PCK_FILE_OPEN_SUCESS, NULL, (ssize_t)(m_lpClassPck->GetPckVersion()->name));
 			return TRUE;
 
 		} else {
@@ -84,6 +85,8 @@ void CPckControlCenter::Close()
 		if(IsValidPck())
 			Logger.i(TEXT_LOG_CLOSEFILE);
 
+		ResetIndexCaches();
+
 		delete m_lpClassPck;
 		m_lpClassPck = NULL;
 
@@ -96,7 +99,8 @@ void CPckControlCenter::Close()
 	Reset();
 
 	//Close the file and refresh the title
-	pFeedbackCallBack(pTag, PCK_FILE_CLOSE, NULL, NULL);
+	if (m_isFeedbackEnabled)
+		pFeedbackCallBack(pTag, PCK_FILE_CLOSE, NULL, NULL);
 }
 
 #pragma endregion
@@ -108,6 +112,8 @@ BOOL CPckControlCenter::RenameEntry(LPENTRY lpFileEntry, LPCWSTR lpszReplaceStri
 	if (NULL == m_lpClassPck)
 		return FALSE;
 
+	ResetIndexCaches();
+
 	int entryType = lpFileEntry->entryType;
 	if (PCK_ENTRY_TYPE_NODE == entryType) {
 
@@ -130,6 +136,7 @@ BOOL CPckControlCenter::RenameSubmit()
 	if (NULL == m_lpClassPck)
 		return FALSE;
 
+	ResetIndexCaches();
 	return m_lpClassPck->RenameFilename();
 }
 
@@ -149,12 +156,98 @@ BOOL CPckControlCenter::GetSingleFileData(LPCENTRY lpFileEntry, char *buffer, si
 	else
 		lpPckFileIndexTable = ((LPPCK_PATH_NODE)lpFileEntry)->lpPckIndexTable;
 
-	return m_lpClassPck->GetSingleFileData(lpPckFileIndexTable, buffer, sizeOfBuffer);
+	if (!m_cDataCache.IsEnabled())
+		return m_lpClassPck->GetSingleFileData(lpPckFileIndexTable, buffer, sizeOfBuffer);
+
+	if (m_cDataCache.Get(lpPckFileIndexTable, buffer, sizeOfBuffer))
+		return TRUE;
+
+	size_t nClearTextSize = lpPckFileIndexTable->cFileIndex.dwFileClearTextSize;
+
+	//Only whole files are cached, a partial read would leave the rest of the data unknown
+	if (((0 != sizeOfBuffer) && (sizeOfBuffer < nClearTextSize)) || !m_cDataCache.IsCacheable(nClearTextSize))
+		return m_lpClassPck->GetSingleFileData(lpPckFileIndexTable, buffer, sizeOfBuffer);
+
+	std::vector<char> data(nClearTextSize);
+	if (!m_lpClassPck->GetSingleFileData(lpPckFileIndexTable, data.data(), nClearTextSize))
+		return FALSE;
+
+	memcpy(buffer, data.data(), nClearTextSize);
+	m_cDataCache.Put(lpPckFileIndexTable, std::move(data));
+	return TRUE;
+}
+
+BOOL CPckControlCenter::OpenVirtualFile(LPCENTRY lpFileEntry, CPckVirtualFile &cFile)
+{
+	if ((NULL == m_lpClassPck) || (NULL == lpFileEntry))
+		return FALSE;
+
+	const PCKINDEXTABLE* lpPckFileIndexTable = NULL;
+	if (PCK_ENTRY_TYPE_INDEX == lpFileEntry->entryType)
+		lpPckFileIndexTable = (LPPCKINDEXTABLE)lpFileEntry;
+	else
+		lpPckFileIndexTable = ((LPPCK_PATH_NODE)lpFileEntry)->lpPckIndexTable;
+
+	//A folder
+	if (NULL == lpPckFileIndexTable)
+		return FALSE;
+
+	if (m_cCheckpoints.IsEnabled())
+		cFile.UseCheckpoints(m_cCheckpoints.Get(m_lpClassPck->GetPckFilename(), m_lpClassPck->GetPckSize(), &lpPckFileIndexTable->cFileIndex));
+
+	return m_lpClassPck->OpenVirtualFile(lpPckFileIndexTable, cFile);
+}
+
+int64_t CPckControlCenter::GetFileDataAt(LPCENTRY lpFileEntry, uint64_t qwOffset, char *buffer, size_t sizeOfBuffer)
+{
+	CPckVirtualFile cFile;
+
+	if (!OpenVirtualFile(lpFileEntry, cFile))
+		return -1;
+
+	if (0 > cFile.Seek((int64_t)qwOffset, PCK_SEEK_SET))
+		return -1;
+
+	return cFile.Read(buffer, sizeOfBuffer);
+}
+
+BOOL CPckControlCenter::SaveCheckpointIndex()
+{
+	if (NULL == m_lpClassPck)
+		return FALSE;
+
+	return m_cCheckpoints.Save(m_lpClassPck->GetPckFilename(), m_lpClassPck->GetPckSize());
+}
+
+uint32_t CPckControlCenter::GetBatchFileData(const PCK_UNIFIED_FILE_ENTRY **lpFileEntryArray, int nEntryCount, char **lpBuffers, const size_t *lpSizeOfBuffers, int *lpStatus)
+{
+	if ((NULL == m_lpClassPck) || (NULL == lpFileEntryArray) || (NULL == lpBuffers) || (0 >= nEntryCount))
+		return 0;
+
+	std::vector<const PCKINDEXTABLE*> lpIndexArray(nEntryCount);
+
+	for (int i = 0; i < nEntryCount; i++) {
+
+		LPCENTRY lpFileEntry = lpFileEntryArray[i];
+
+		if (NULL == lpFileEntry)
+			lpIndexArray[i] = NULL;
+		else if (PCK_ENTRY_TYPE_INDEX == lpFileEntry->entryType)
+			lpIndexArray[i] = (LPPCKINDEXTABLE)lpFileEntry;
+		else if (PCK_ENTRY_TYPE_FOLDER == (PCK_ENTRY_TYPE_FOLDER & lpFileEntry->entryType))
+			lpIndexArray[i] = NULL;
+		else
+			lpIndexArray[i] = ((LPPCK_PATH_NODE)lpFileEntry)->lpPckIndexTable;
+	}
+
+	return m_lpClassPck->GetBatchFileData(lpIndexArray.data(), nEntryCount, lpBuffers, lpSizeOfBuffers, lpStatus);
 }
 
 //unzip files
 BOOL CPckControlCenter::ExtractFiles(const PCK_UNIFIED_FILE_ENTRY **lpFileEntryArray, int nEntryCount, LPCWSTR lpszDestDirectory)
 {
+	CPckTaskScope cTaskScope(m_cTaskEvents);
+
 	if (NULL == m_lpClassPck)
 		return FALSE;
 
@@ -163,11 +256,23 @@ BOOL CPckControlCenter::ExtractFiles(const PCK_UNIFIED_FILE_ENTRY **lpFileEntryA
 
 BOOL CPckControlCenter::ExtractAllFiles(LPCWSTR lpszDestDirectory)
 {
+	CPckTaskScope cTaskScope(m_cTaskEvents);
+
 	if (NULL == m_lpClassPck)
 		return FALSE;
 
 	return m_lpClassPck->ExtractAllFiles(lpszDestDirectory);
 }
+
+BOOL CPckControlCenter::VerifyAllFiles()
+{
+	CPckTaskScope cTaskScope(m_cTaskEvents);
+
+	if (NULL == m_lpClassPck)
+		return FALSE;
+
+	return m_lpClassPck->VerifyAllFiles();
+}
 #pragma endregion
 
 #pragma region Rebuild pck file
@@ -181,6 +286,8 @@ BOOL CPckControlCenter::TestScript(LPCWSTR lpszScriptFile)
 
 BOOL CPckControlCenter::RebuildPckFile(LPCWSTR lpszScriptFile, LPCWSTR szRebuildPckFile, BOOL bUseRecompress)
 {
+	CPckTaskScope cTaskScope(m_cTaskEvents);
+
 	if (NULL == m_lpClassPck)
 		return FALSE;
 
@@ -192,6 +299,8 @@ BOOL CPckControlCenter::RebuildPckFile(LPCWSTR lpszScriptFile, LPCWSTR szRebuild
 #pragma region Game streamlined
 BOOL CPckControlCenter::StripPck(LPCWSTR lpszStripedPckFile, int flag)
 {
+	CPckTaskScope cTaskScope(m_cTaskEvents);
+
 	if (NULL == m_lpClassPck)
 		return FALSE;
 
@@ -218,18 +327,55 @@ void CPckControlCenter::StringArrayAppend(LPCWSTR lpszFilePath)
 
 BOOL CPckControlCenter::UpdatePckFileSubmit(LPCWSTR szPckFile, LPCENTRY lpFileEntry)
 {
+	CPckTaskScope cTaskScope(m_cTaskEvents);
+
 	if (NULL == m_lpClassPck)
 		return FALSE;
 
 	BOOL rtn = FALSE;
 
 	if (0 != lpszFilePathToAdd.size()) {
+		ResetIndexCaches();
 		rtn = m_lpClassPck->UpdatePckFile(szPckFile, lpszFilePathToAdd, (const PCK_PATH_NODE*)lpFileEntry);
 		StringArrayReset();
 	}
 	return rtn;
 }
 
+BOOL CPckControlCenter::ApplyZupSubmit(LPCWSTR szPckFile, LPCWSTR szZupFile, LPCWSTR lpszZupFolder, LPCENTRY lpFileEntry)
+{
+	CPckTaskScope cTaskScope(m_cTaskEvents);
+
+	if ((NULL == m_lpClassPck) || (NULL == szZupFile))
+		return FALSE;
+
+	//The zup is only read while the files are added
+	CZupClass	cZupClass(&cParams);
+
+	Logger.i(UCSTEXT(TEXT_LOG_OPENFILE), szZupFile);
+
+	if (!cZupClass.Init(szZupFile))
+		return FALSE;
+
+	const PCK_PATH_NODE* lpZupFolder = NULL;
+
+	if ((NULL != lpszZupFolder) && (0 != *lpszZupFolder)) {
+
+		if (NULL == (lpZupFolder = cZupClass.FindNodeByPath(lpszZupFolder))) {
+			Logger_el(UCSTEXT(TEXT_NOTFOUND_NAME), lpszZupFolder);
+			return FALSE;
+		}
+	}
+
+	vector<FILES_TO_COMPRESS> lpZupFiles;
+
+	if (!cZupClass.GetFilesToApply(lpZupFolder, lpZupFiles))
+		return FALSE;
+
+	ResetIndexCaches();
+	return m_lpClassPck->UpdatePckFileFromZup(szPckFile, szZupFile, lpZupFiles, (const PCK_PATH_NODE*)lpFileEntry);
+}
+
 #pragma region Delete node
 //Delete a node
 BOOL CPckControlCenter::DeleteEntry(LPCENTRY lpFileEntry)
@@ -237,6 +383,8 @@ BOOL CPckControlCenter::DeleteEntry(LPCENTRY lpFileEntry)
 	if ((NULL == m_lpClassPck) || (NULL == lpFileEntry))
 		return FALSE;
 
+	ResetIndexCaches();
+
 	if (PCK_ENTRY_TYPE_INDEX == lpFileEntry->entryType)
 		m_lpClassPck->DeleteNode((LPPCKINDEXTABLE)lpFileEntry);
 	else if (PCK_ENTRY_TYPE_FOLDER == (PCK_ENTRY_TYPE_FOLDER & lpFileEntry->entryType))
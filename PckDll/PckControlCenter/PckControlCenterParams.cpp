@@ -11,6 +11,9 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "PckControlCenter.h"
+#include "PckSystemLimits.h"
+#include <algorithm>
+#include <atomic>
 #include <thread>
 
 #pragma region thread control
@@ -18,7 +21,7 @@
 //Thread running parameters
 BOOL CPckControlCenter::isThreadWorking()
 {
-	return cParams.cVarParams.bThreadRunning;
+	return std::atomic_ref<BOOL>(cParams.cVarParams.bThreadRunning).load();
 }
 
 void CPckControlCenter::ForceBreakThreadWorking()
@@ -26,6 +29,25 @@ void CPckControlCenter::ForceBreakThreadWorking()
 	cParams.cVarParams.bForcedStopWorking = TRUE;
 }
 
+BOOL CPckControlCenter::regTaskCallbacks(void* pTag, TaskProgressCallback _ProgressCallBack, TaskStageCallback _StageCallBack, TaskCompleteCallback _CompleteCallBack, uint32_t dwProgressIntervalMs)
+{
+	if (isThreadWorking())
+		return FALSE;
+
+	m_cTaskEvents.SetCallbacks(pTag, _ProgressCallBack, _StageCallBack, _CompleteCallBack, dwProgressIntervalMs);
+	return TRUE;
+}
+
+int32_t CPckControlCenter::getTaskStage()
+{
+	return m_cTaskEvents.GetStage();
+}
+
+BOOL CPckControlCenter::waitForTask(uint32_t dwMilliseconds)
+{
+	return m_cTaskEvents.Wait(dwMilliseconds);
+}
+
 #pragma endregion
 
 
@@ -66,10 +88,15 @@ uint32_t CPckControlCenter::getMTMaxMemory()
 	return cParams.dwMTMaxMemory;
 }
 
-//Maximum memory getDefaultMaxMemoryAllowed
+//Maximum memory getDefaultMaxMemoryAllowed, a part of the memory the process may use
 uint32_t CPckControlCenter::getMaxMemoryAllowed()
 {
-	return MT_MAX_MEMORY;
+	uint64_t qwMemoryLimit = CPckSystemLimits::GetMemoryLimit();
+
+	if (0 == qwMemoryLimit)
+		return MT_MAX_MEMORY;
+
+	return (uint32_t)std::clamp<uint64_t>(qwMemoryLimit / SYSTEM_MEMORY_BUDGET_DIVISOR, SYSTEM_MIN_MEMORY_BUDGET, MT_MAX_MEMORY);
 }
 
 #pragma endregion
@@ -90,7 +117,8 @@ void CPckControlCenter::setMaxThread(uint32_t dwThread)
 //Thread default parameters
 uint32_t CPckControlCenter::getMaxThreadUpperLimit()
 {
-	return (thread::hardware_concurrency() + ((thread::hardware_concurrency() + (thread::hardware_concurrency() & 1)) >> 1));
+	uint32_t dwCpuCount = CPckSystemLimits::GetCpuCount();
+	return (dwCpuCount + ((dwCpuCount + (dwCpuCount & 1)) >> 1));
 }
 
 #pragma endregion
@@ -123,21 +151,84 @@ uint32_t CPckControlCenter::getMaxCompressLevel()
 #pragma endregion
 
 
+#pragma region Rebuild layout
+
+int CPckControlCenter::getRebuildLayout()
+{
+	return cParams.iRebuildLayout;
+}
+
+BOOL CPckControlCenter::setRebuildLayout(int iLayout, LPCWSTR lpszListFile)
+{
+	if ((PCK_LAYOUT_ORIGINAL > iLayout) || (PCK_LAYOUT_MAX < iLayout))
+		return FALSE;
+
+	if (PCK_LAYOUT_ACCESS_LIST == iLayout) {
+
+		if ((nullptr == lpszListFile) || (0 == *lpszListFile))
+			return FALSE;
+
+		szLayoutListFile = lpszListFile;
+		cParams.lpszLayoutListFile = szLayoutListFile.c_str();
+	}
+	else {
+		szLayoutListFile.clear();
+		cParams.lpszLayoutListFile = nullptr;
+	}
+
+	cParams.iRebuildLayout = iLayout;
+	return TRUE;
+}
+
+#pragma endregion
+
+#pragma region Search mode
+
+int CPckControlCenter::getSearchMode()
+{
+	return m_iSearchMode;
+}
+
+BOOL CPckControlCenter::setSearchMode(int iSearchMode)
+{
+	if (PCK_SEARCH_REGEX < (iSearchMode & PCK_SEARCH_TYPE_MASK))
+		return FALSE;
+
+	m_iSearchMode = iSearchMode;
+	return TRUE;
+}
+
+#pragma endregion
+
+#pragma region Data cache
+
+size_t CPckControlCenter::getDataCacheSize()
+{
+	return m_cDataCache.GetMaxSize();
+}
+
+void CPckControlCenter::setDataCacheSize(size_t nMaxSize)
+{
+	m_cDataCache.SetMaxSize(nMaxSize);
+}
+
+#pragma endregion
+
 #pragma region Progress related
 
 uint32_t CPckControlCenter::getUIProgress()
 {
-	return cParams.cVarParams.dwUIProgress;
+	return std::atomic_ref<uint32_t>(cParams.cVarParams.dwUIProgress).load(std::memory_order_relaxed);
 }
 
 void CPckControlCenter::setUIProgress(uint32_t dwUIProgress)
 {
-	cParams.cVarParams.dwUIProgress = dwUIProgress;
+	std::atomic_ref<uint32_t>(cParams.cVarParams.dwUIProgress).store(dwUIProgress, std::memory_order_relaxed);
 }
 
 uint32_t CPckControlCenter::getUIProgressUpper()
 {
-	return cParams.cVarParams.dwUIProgressUpper;
+	return std::atomic_ref<uint32_t>(cParams.cVarParams.dwUIProgressUpper).load(std::memory_order_relaxed);
 }
 
 //void CPckControlCenter::setUIProgressUpper(DWORD dwUIProgressUpper)
@@ -175,3 +266,17 @@ uint32_t CPckControlCenter::GetUpdateResult_FinalFileCount()
 }
 
 #pragma endregion
+
+#pragma region Checkpoints
+
+uint32_t CPckControlCenter::getCheckpointInterval()
+{
+	return m_cCheckpoints.GetInterval();
+}
+
+void CPckControlCenter::setCheckpointInterval(uint32_t dwInterval)
+{
+	m_cCheckpoints.SetInterval(dwInterval);
+}
+
+#pragma endregion
@@ -0,0 +1,87 @@
+//////////////////////////////////////////////////////////////////////
+// PckDataCache.cpp: LRU cache of decompressed file data for repeated previews
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "PckDataCache.h"
+#include <string.h>
+
+void CPckDataCache::SetMaxSize(size_t nMaxSize)
+{
+	std::lock_guard<std::mutex> lckCache(m_LockCache);
+	m_nMaxSize = nMaxSize;
+	EvictTo(nMaxSize);
+}
+
+size_t CPckDataCache::GetMaxSize()
+{
+	return m_nMaxSize;
+}
+
+size_t CPckDataCache::GetUsedSize()
+{
+	std::lock_guard<std::mutex> lckCache(m_LockCache);
+	return m_nUsedSize;
+}
+
+bool CPckDataCache::Get(const void *lpKey, char *buffer, size_t sizeOfBuffer)
+{
+	std::lock_guard<std::mutex> lckCache(m_LockCache);
+
+	auto it = m_mapItems.find(lpKey);
+	if (m_mapItems.end() == it)
+		return false;
+
+	m_lstItems.splice(m_lstItems.begin(), m_lstItems, it->second);
+
+	const std::vector<char> &data = it->second->data;
+	size_t nSizeToCopy = data.size();
+	if ((0 != sizeOfBuffer) && (sizeOfBuffer < nSizeToCopy))
+		nSizeToCopy = sizeOfBuffer;
+
+	memcpy(buffer, data.data(), nSizeToCopy);
+	return true;
+}
+
+void CPckDataCache::Put(const void *lpKey, std::vector<char> &&data)
+{
+	std::lock_guard<std::mutex> lckCache(m_LockCache);
+
+	if (data.size() > m_nMaxSize)
+		return;
+
+	auto it = m_mapItems.find(lpKey);
+	if (m_mapItems.end() != it) {
+		m_nUsedSize -= it->second->data.size();
+		m_lstItems.erase(it->second);
+		m_mapItems.erase(it);
+	}
+
+	EvictTo(m_nMaxSize - data.size());
+
+	m_nUsedSize += data.size();
+	m_lstItems.push_front(CACHE_ITEM{ lpKey, std::move(data) });
+	m_mapItems[lpKey] = m_lstItems.begin();
+}
+
+void CPckDataCache::Clear()
+{
+	std::lock_guard<std::mutex> lckCache(m_LockCache);
+	m_lstItems.clear();
+	m_mapItems.clear();
+	m_nUsedSize = 0;
+}
+
+//Called with m_LockCache held
+void CPckDataCache::EvictTo(size_t nMaxSize)
+{
+	while ((m_nUsedSize > nMaxSize) && !m_lstItems.empty()) {
+
+		CACHE_ITEM &item = m_lstItems.back();
+		m_nUsedSize -= item.data.size();
+		m_mapItems.erase(item.lpKey);
+		m_lstItems.pop_back();
+	}
+}
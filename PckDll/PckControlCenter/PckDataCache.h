@@ -0,0 +1,60 @@
+//////////////////////////////////////////////////////////////////////
+// PckDataCache.h: LRU cache of decompressed file data for repeated previews
+//
+// The cache is limited by the total bytes of the cached data, the least
+// recently used files are dropped first. Disabled when the size is 0
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class CPckDataCache
+{
+public:
+	CPckDataCache() = default;
+	~CPckDataCache() = default;
+
+	//0 - disabled, the cached data is dropped down to the new size
+	void	SetMaxSize(size_t nMaxSize);
+	size_t	GetMaxSize();
+	size_t	GetUsedSize();
+
+	bool	IsEnabled() { return 0 != m_nMaxSize; }
+	//Whether a file of this size may be cached
+	bool	IsCacheable(size_t nSize) { return (0 != nSize) && (nSize <= m_nMaxSize); }
+
+	//Copy the cached data of lpKey to buffer, sizeOfBuffer = 0 copies all
+	bool	Get(const void *lpKey, char *buffer, size_t sizeOfBuffer);
+	void	Put(const void *lpKey, std::vector<char> &&data);
+
+	//The keys are index entries, call this when they are changed or freed
+	void	Clear();
+
+private:
+
+	typedef struct _CACHE_ITEM
+	{
+		const void			*lpKey;
+		std::vector<char>	data;
+	}CACHE_ITEM;
+
+	typedef std::list<CACHE_ITEM> CACHE_LIST;
+
+	void	EvictTo(size_t nMaxSize);
+
+	std::mutex	m_LockCache;
+	//Most recently used at the front
+	CACHE_LIST	m_lstItems;
+	std::unordered_map<const void*, CACHE_LIST::iterator> m_mapItems;
+
+	size_t		m_nUsedSize = 0;
+	std::atomic<size_t>	m_nMaxSize = 0;
+};
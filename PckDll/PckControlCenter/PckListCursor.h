@@ -0,0 +1,50 @@
+//////////////////////////////////////////////////////////////////////
+// PckListCursor.h: where the last page of a folder listing ended
+//
+// Every control center and overlay keeps one for the nodes of its own
+// tree, the next page of the same folder goes on from there instead of
+// walking the folder again. The owner resets it before its tree is freed
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "PckStructs.h"
+#include <mutex>
+
+class CPckListCursor
+{
+public:
+	CPckListCursor() = default;
+	~CPckListCursor() = default;
+
+	CPckListCursor(const CPckListCursor&) = delete;
+	CPckListCursor& operator=(const CPckListCursor&) = delete;
+
+	//The nodes of the tree are being freed
+	void	Reset()
+	{
+		std::lock_guard<std::mutex> lckCursor(m_Lock);
+		m_lpFirstNode = nullptr;
+		m_lpNextNode = nullptr;
+	}
+
+private:
+
+	friend class CPckControlCenter;
+
+	std::mutex				m_Lock;
+
+	LPCENTRY				m_lpFileEntry = nullptr;
+	const PCK_PATH_NODE		*m_lpFirstNode = nullptr;
+	//Counts of m_lpFirstNode when the cursor was made, they change when the folder changes
+	uint32_t				m_dwFilesCount = 0;
+	uint32_t				m_dwDirsCount = 0;
+
+	uint32_t				m_dwTotal = 0;
+	//Entry m_dwNext is m_lpNextNode, a folder while m_isFolders
+	uint32_t				m_dwNext = 0;
+	const PCK_PATH_NODE		*m_lpNextNode = nullptr;
+	BOOL					m_isFolders = TRUE;
+};
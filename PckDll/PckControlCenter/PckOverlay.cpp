@@ -0,0 +1,397 @@
+//////////////////////////////////////////////////////////////////////
+// PckOverlay.cpp: several pck files mounted over each other
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "PckOverlay.h"
+#include "PckControlCenter.h"
+#include "PckClassLog.h"
+#include "MapViewFileMultiPck.h"
+#include <wctype.h>
+#include <algorithm>
+
+//The same folding as the path table
+static std::wstring FoldName(const wchar_t *lpszName)
+{
+	std::wstring szFolded(lpszName);
+
+	for (wchar_t &ch : szFolded) {
+		if (0x80 > ch)
+			ch = ((L'A' <= ch) && (L'Z' >= ch)) ? (ch | 0x20) : ch;
+		else
+			ch = towlower(ch);
+	}
+	return szFolded;
+}
+
+static std::wstring JoinPath(const std::wstring &szDirectory, const wchar_t *lpszName)
+{
+	std::wstring szPath(szDirectory);
+
+	if ((!szPath.empty()) && (L'\\' != szPath.back()) && (L'/' != szPath.back()))
+		szPath.push_back(L'/');
+
+	return szPath.append(lpszName);
+}
+
+CPckOverlay::CPckOverlay() :
+	m_RootNode(),
+	m_dwFileCount(0)
+{
+	m_RootNode.cNode.entryType = PCK_ENTRY_TYPE_NODE | PCK_ENTRY_TYPE_FOLDER | PCK_ENTRY_TYPE_ROOT;
+}
+
+CPckOverlay::~CPckOverlay()
+{}
+
+BOOL CPckOverlay::Open(const wchar_t **lpszPckFiles, int nFileCount)
+{
+	if ((NULL == lpszPckFiles) || (0 >= nFileCount) || !m_Layers.empty())
+		return FALSE;
+
+	for (int i = 0; i < nFileCount; i++) {
+
+		std::unique_ptr<CPckControlCenter> lpLayer(new CPckControlCenter(FALSE));
+
+		if ((NULL == lpszPckFiles[i]) || !(lpLayer->Open(lpszPckFiles[i]) && lpLayer->IsValidPck())) {
+			Logger.e(TEXT_OVERLAY_OPEN_FAIL, (NULL == lpszPckFiles[i]) ? L"" : lpszPckFiles[i]);
+			return FALSE;
+		}
+
+		m_Layers.push_back(std::move(lpLayer));
+		m_LayerFiles.push_back(lpszPckFiles[i]);
+	}
+
+	AddDotDot(&m_RootNode.cNode, NULL);
+	m_RootNode.cNode.child->entryType |= PCK_ENTRY_TYPE_ROOT;
+
+	for (uint32_t i = 0; i < m_Layers.size(); i++)
+		MergeFolder(&m_RootNode.cNode, (const PCK_PATH_NODE*)m_Layers[i]->GetRootNode(), i);
+
+	CountFolder(&m_RootNode.cNode);
+	m_dwFileCount = m_RootNode.cNode.child->dwFilesCount;
+
+	m_PathTable.Build(&m_RootNode.cNode);
+
+	Logger.i(TEXT_LOG_OVERLAY, nFileCount, m_dwFileCount);
+	return TRUE;
+}
+
+CPckOverlay::LPOVERLAY_NODE CPckOverlay::NewNode(LPPCK_PATH_NODE lpFolder, uint32_t dwLayer)
+{
+	m_Nodes.emplace_back();
+
+	LPOVERLAY_NODE lpNode = &m_Nodes.back();
+	lpNode->cNode.parent = lpFolder;
+	lpNode->dwLayer = dwLayer;
+	return lpNode;
+}
+
+void CPckOverlay::AddDotDot(LPPCK_PATH_NODE lpFolder, LPPCK_PATH_NODE lpParentDotDot)
+{
+	LPPCK_PATH_NODE lpDotDot = &NewNode(lpFolder, ((LPOVERLAY_NODE)lpFolder)->dwLayer)->cNode;
+
+	lpDotDot->parentfirst = lpParentDotDot;
+	//The .. node has the length of the path of its folder, as AddFileToNode does it
+	if (NULL != lpParentDotDot)
+		lpDotDot->nNameSizeAnsi = lpParentDotDot->nNameSizeAnsi + lpFolder->nNameSizeAnsi + 1;
+	lpDotDot->entryType = PCK_ENTRY_TYPE_NODE | PCK_ENTRY_TYPE_FOLDER | PCK_ENTRY_TYPE_DOTDOT;
+	wcscpy(lpDotDot->szName, L"..");
+
+	lpFolder->child = lpDotDot;
+}
+
+void CPckOverlay::MergeFolder(LPPCK_PATH_NODE lpFolder, const PCK_PATH_NODE *lpLayerFolder, uint32_t dwLayer)
+{
+	if ((NULL == lpLayerFolder) || (NULL == lpLayerFolder->child))
+		return;
+
+	//What the folder has from the layers before
+	std::unordered_map<std::wstring, LPOVERLAY_NODE> cChildren;
+	LPPCK_PATH_NODE lpLastNode = lpFolder->child;
+
+	for (LPPCK_PATH_NODE lpNode = lpFolder->child->next; NULL != lpNode; lpNode = lpNode->next) {
+		cChildren.emplace(FoldName(lpNode->szName), (LPOVERLAY_NODE)lpNode);
+		lpLastNode = lpNode;
+	}
+
+	//Skip the .. node
+	for (const PCK_PATH_NODE *lpLayerNode = lpLayerFolder->child->next; NULL != lpLayerNode; lpLayerNode = lpLayerNode->next) {
+
+		if (0 == *lpLayerNode->szName)
+			continue;
+
+		std::wstring szFolded = FoldName(lpLayerNode->szName);
+		auto it = cChildren.find(szFolded);
+		LPOVERLAY_NODE lpNode;
+
+		if (cChildren.end() == it) {
+
+			lpNode = NewNode(lpFolder, dwLayer);
+			lpLastNode->next = &lpNode->cNode;
+			lpLastNode = &lpNode->cNode;
+
+			cChildren.emplace(std::move(szFolded), lpNode);
+			lpNode->cNode.nMaxNameSizeAnsi = lpLayerNode->nMaxNameSizeAnsi;
+		}
+		else {
+			lpNode = it->second;
+
+			//A folder can be renamed only as far as the files of every layer allow, a file is the one of the last layer
+			if ((PCK_ENTRY_TYPE_FOLDER & lpLayerNode->entryType) && (PCK_ENTRY_TYPE_FOLDER & lpNode->cNode.entryType))
+				lpNode->cNode.nMaxNameSizeAnsi = std::min(lpNode->cNode.nMaxNameSizeAnsi, lpLayerNode->nMaxNameSizeAnsi);
+			else
+				lpNode->cNode.nMaxNameSizeAnsi = lpLayerNode->nMaxNameSizeAnsi;
+		}
+
+		//The name of the last layer is the one shown
+		wcscpy(lpNode->cNode.szName, lpLayerNode->szName);
+		lpNode->cNode.nNameSizeAnsi = lpLayerNode->nNameSizeAnsi;
+		lpNode->dwLayer = dwLayer;
+
+		if (PCK_ENTRY_TYPE_FOLDER & lpLayerNode->entryType) {
+
+			//New folder or a folder replacing a file
+			if (!(PCK_ENTRY_TYPE_FOLDER & lpNode->cNode.entryType) || (NULL == lpNode->cNode.child)) {
+
+				lpNode->cNode.entryType = PCK_ENTRY_TYPE_NODE | PCK_ENTRY_TYPE_FOLDER;
+				lpNode->cNode.lpPckIndexTable = NULL;
+				AddDotDot(&lpNode->cNode, lpFolder->child);
+			}
+
+			MergeFolder(&lpNode->cNode, lpLayerNode, dwLayer);
+		}
+		else {
+			//A file replacing a folder drops everything under it
+			lpNode->cNode.entryType = PCK_ENTRY_TYPE_NODE;
+			lpNode->cNode.child = NULL;
+			lpNode->cNode.lpPckIndexTable = lpLayerNode->lpPckIndexTable;
+		}
+	}
+}
+
+void CPckOverlay::CountFolder(LPPCK_PATH_NODE lpFolder)
+{
+	LPPCK_PATH_NODE lpDotDot = lpFolder->child;
+
+	for (LPPCK_PATH_NODE lpNode = lpDotDot->next; NULL != lpNode; lpNode = lpNode->next) {
+
+		if (PCK_ENTRY_TYPE_FOLDER & lpNode->entryType) {
+
+			CountFolder(lpNode);
+
+			lpDotDot->dwDirsCount += lpNode->child->dwDirsCount + 1;
+			lpDotDot->dwFilesCount += lpNode->child->dwFilesCount;
+			lpDotDot->qdwDirClearTextSize += lpNode->child->qdwDirClearTextSize;
+			lpDotDot->qdwDirCipherTextSize += lpNode->child->qdwDirCipherTextSize;
+		}
+		else {
+			++lpDotDot->dwFilesCount;
+			lpDotDot->qdwDirClearTextSize += lpNode->lpPckIndexTable->cFileIndex.dwFileClearTextSize;
+			lpDotDot->qdwDirCipherTextSize += lpNode->lpPckIndexTable->cFileIndex.dwFileCipherTextSize;
+		}
+	}
+}
+
+uint32_t CPckOverlay::GetLayerCount()
+{
+	return (uint32_t)m_Layers.size();
+}
+
+LPCWSTR CPckOverlay::GetLayerFile(uint32_t dwLayer)
+{
+	if (m_LayerFiles.size() <= dwLayer)
+		return NULL;
+
+	return m_LayerFiles[dwLayer].c_str();
+}
+
+uint32_t CPckOverlay::GetFileCount()
+{
+	return m_dwFileCount;
+}
+
+LPCENTRY CPckOverlay::GetRootNode()
+{
+	if (m_Layers.empty())
+		return NULL;
+
+	return (LPCENTRY)&m_RootNode.cNode;
+}
+
+LPCENTRY CPckOverlay::GetFileEntryByPath(LPCWSTR lpszPath)
+{
+	if ((NULL == lpszPath) || m_Layers.empty())
+		return NULL;
+
+	while (('\\' == *lpszPath) || ('/' == *lpszPath))
+		++lpszPath;
+
+	if (0 == *lpszPath)
+		return GetRootNode();
+
+	return (LPCENTRY)m_PathTable.Find(NULL, lpszPath, TRUE);
+}
+
+uint32_t CPckOverlay::ListByNodeToArray(LPCENTRY lpFileEntry, uint32_t dwOffset, uint32_t dwMaxRecords, LPPCK_LIST_RECORD lpRecords, wchar_t *lpNames, uint32_t dwNamesChars, uint32_t *lpTotal)
+{
+	return CPckControlCenter::ListByNodeToArray(m_cListCursor, GetRootNode(), lpFileEntry, dwOffset, dwMaxRecords, lpRecords, lpNames, dwNamesChars, lpTotal);
+}
+
+int32_t CPckOverlay::GetEntryLayer(LPCENTRY lpFileEntry)
+{
+	if ((NULL == lpFileEntry) || (PCK_ENTRY_TYPE_INDEX == lpFileEntry->entryType))
+		return -1;
+
+	return (int32_t)((const OVERLAY_NODE*)lpFileEntry)->dwLayer;
+}
+
+BOOL CPckOverlay::GetSingleFileData(LPCENTRY lpFileEntry, char *buffer, size_t sizeOfBuffer)
+{
+	if ((NULL == lpFileEntry) || (PCK_ENTRY_TYPE_NODE != lpFileEntry->entryType))
+		return FALSE;
+
+	//The node points to the index of its layer
+	return m_Layers[GetEntryLayer(lpFileEntry)]->GetSingleFileData(lpFileEntry, buffer, sizeOfBuffer);
+}
+
+BOOL CPckOverlay::OpenVirtualFile(LPCENTRY lpFileEntry, CPckVirtualFile &cFile)
+{
+	if ((NULL == lpFileEntry) || (PCK_ENTRY_TYPE_NODE != lpFileEntry->entryType))
+		return FALSE;
+
+	return m_Layers[GetEntryLayer(lpFileEntry)]->OpenVirtualFile(lpFileEntry, cFile);
+}
+
+void CPckOverlay::CollectFiles(const PCK_PATH_NODE *lpNode, const std::wstring &szPath, std::vector<EXTRACT_FILE> &lpFiles)
+{
+	if (PCK_ENTRY_TYPE_FOLDER & lpNode->entryType) {
+
+		//The root node has no name, its files go to the destination itself
+		if (0 != *lpNode->szName)
+			CreateDirectoryW(szPath.c_str(), NULL);
+
+		for (const PCK_PATH_NODE *lpChild = lpNode->child->next; NULL != lpChild; lpChild = lpChild->next)
+			CollectFiles(lpChild, JoinPath(szPath, lpChild->szName), lpFiles);
+	}
+	else {
+		lpFiles.push_back({ (const OVERLAY_NODE*)lpNode, szPath });
+	}
+}
+
+BOOL CPckOverlay::ExtractFiles(const PCK_UNIFIED_FILE_ENTRY **lpFileEntryArray, int nEntryCount, LPCWSTR lpszDestDirectory)
+{
+	if ((NULL == lpFileEntryArray) || (0 >= nEntryCount) || (NULL == lpszDestDirectory) || (0 == *lpszDestDirectory) || m_Layers.empty())
+		return FALSE;
+
+	Logger.i(TEXT_LOG_EXTRACT);
+
+	CreateDirectoryW(lpszDestDirectory, NULL);
+
+	std::vector<EXTRACT_FILE> cFiles;
+
+	for (int i = 0; i < nEntryCount; i++) {
+
+		const PCK_PATH_NODE *lpNode = (const PCK_PATH_NODE*)lpFileEntryArray[i];
+
+		if ((NULL == lpNode) || (PCK_ENTRY_TYPE_DOTDOT & lpNode->entryType))
+			continue;
+
+		CollectFiles(lpNode, (0 == *lpNode->szName) ? std::wstring(lpszDestDirectory) : JoinPath(lpszDestDirectory, lpNode->szName), cFiles);
+	}
+
+	//Every archive is read in one pass
+	std::vector<std::vector<const EXTRACT_FILE*>> lpLayerFiles(m_Layers.size());
+
+	for (const EXTRACT_FILE &cFile : cFiles)
+		lpLayerFiles[cFile.lpNode->dwLayer].push_back(&cFile);
+
+	for (uint32_t i = 0; i < m_Layers.size(); i++) {
+
+		if (!(lpLayerFiles[i].empty() || ExtractLayer(i, lpLayerFiles[i])))
+			return FALSE;
+	}
+
+	Logger.i(TEXT_LOG_WORKING_DONE);
+	return TRUE;
+}
+
+BOOL CPckOverlay::ExtractAllFiles(LPCWSTR lpszDestDirectory)
+{
+	LPCENTRY lpRootNode = GetRootNode();
+	return ExtractFiles(&lpRootNode, 1, lpszDestDirectory);
+}
+
+BOOL CPckOverlay::ExtractLayer(uint32_t dwLayer, const std::vector<const EXTRACT_FILE*> &lpFiles)
+{
+	size_t nFirst = 0;
+
+	while (lpFiles.size() > nFirst) {
+
+		//Files of the chunk, at least one
+		size_t nLast = nFirst;
+		size_t nChunkSize = 0;
+
+		do {
+			nChunkSize += lpFiles[nLast]->lpNode->cNode.lpPckIndexTable->cFileIndex.dwFileClearTextSize;
+			++nLast;
+		} while ((lpFiles.size() > nLast) &&
+			(OVERLAY_EXTRACT_CHUNK_SIZE >= (nChunkSize + lpFiles[nLast]->lpNode->cNode.lpPckIndexTable->cFileIndex.dwFileClearTextSize)));
+
+		const int nCount = (int)(nLast - nFirst);
+
+		std::vector<char> cData(nChunkSize + 1);
+		std::vector<LPCENTRY> lpEntries(nCount);
+		std::vector<char*> lpBuffers(nCount);
+		std::vector<size_t> nSizes(nCount);
+		std::vector<int> iStatus(nCount);
+
+		size_t nOffset = 0;
+
+		for (int i = 0; i < nCount; i++) {
+
+			const OVERLAY_NODE *lpNode = lpFiles[nFirst + i]->lpNode;
+
+			lpEntries[i] = (LPCENTRY)&lpNode->cNode;
+			lpBuffers[i] = cData.data() + nOffset;
+			nSizes[i] = lpNode->cNode.lpPckIndexTable->cFileIndex.dwFileClearTextSize;
+			nOffset += nSizes[i];
+		}
+
+		m_Layers[dwLayer]->GetBatchFileData(lpEntries.data(), nCount, lpBuffers.data(), nSizes.data(), iStatus.data());
+
+		for (int i = 0; i < nCount; i++) {
+
+			if (PCK_OK != iStatus[i]) {
+				Logger_el(TEXT_UNCOMP_FAIL);
+				return FALSE;
+			}
+
+			if (!WriteDiskFile(lpFiles[nFirst + i]->szPath, lpBuffers[i], nSizes[i]))
+				return FALSE;
+		}
+
+		nFirst = nLast;
+	}
+
+	return TRUE;
+}
+
+BOOL CPckOverlay::WriteDiskFile(const std::wstring &szPath, const char *buffer, size_t nSize)
+{
+	CMapViewFileWrite cFileWrite;
+
+	if (!cFileWrite.Open(szPath.c_str(), CREATE_ALWAYS)) {
+		Logger_el(TEXT_OPENWRITENAME_FAIL, szPath.c_str());
+		return FALSE;
+	}
+
+	if ((0 != nSize) && (nSize != cFileWrite.Write((LPVOID)buffer, (DWORD)nSize))) {
+		Logger_el(TEXT_WRITEFILE_FAIL);
+		return FALSE;
+	}
+
+	return TRUE;
+}
@@ -0,0 +1,96 @@
+//////////////////////////////////////////////////////////////////////
+// PckOverlay.h: several pck files mounted over each other
+//
+// The archives are opened in order, a file of a later archive replaces the
+// file of the same path in the earlier ones. Their trees are merged into one
+// tree of the same nodes as the tree of a pck, every file node points to the
+// index of the archive it is read from, so the functions for the nodes of a
+// pck work on it and a path is found with one probe of its path table
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "PckStructs.h"
+#include "PckClassPathTable.h"
+#include "PckListCursor.h"
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//Bytes of decompressed data read from an archive at a time while extracting
+#define OVERLAY_EXTRACT_CHUNK_SIZE		(64 * 1024 * 1024)
+
+class CPckControlCenter;
+class CPckVirtualFile;
+
+class CPckOverlay
+{
+public:
+	CPckOverlay();
+	~CPckOverlay();
+
+	//lpszPckFiles[0] is the base archive, the ones after it override it, FALSE if one of them can not be opened
+	BOOL		Open(const wchar_t **lpszPckFiles, int nFileCount);
+
+	uint32_t	GetLayerCount();
+	LPCWSTR		GetLayerFile(uint32_t dwLayer);
+	//Files of the merged tree
+	uint32_t	GetFileCount();
+
+	LPCENTRY	GetRootNode();
+	//Pages of a folder of the merged tree, see pck_listByNodeToArray
+	uint32_t	ListByNodeToArray(LPCENTRY lpFileEntry, uint32_t dwOffset, uint32_t dwMaxRecords, LPPCK_LIST_RECORD lpRecords, wchar_t *lpNames, uint32_t dwNamesChars, uint32_t *lpTotal);
+	//Names are compared without case, like the game does
+	LPCENTRY	GetFileEntryByPath(LPCWSTR lpszPath);
+	//Archive the file is read from, for a folder the last archive that has it
+	static int32_t	GetEntryLayer(LPCENTRY lpFileEntry);
+
+	BOOL		GetSingleFileData(LPCENTRY lpFileEntry, char *buffer, size_t sizeOfBuffer = 0);
+	BOOL		OpenVirtualFile(LPCENTRY lpFileEntry, CPckVirtualFile &cFile);
+
+	BOOL		ExtractFiles(const PCK_UNIFIED_FILE_ENTRY **lpFileEntryArray, int nEntryCount, LPCWSTR lpszDestDirectory);
+	BOOL		ExtractAllFiles(LPCWSTR lpszDestDirectory);
+
+private:
+
+	//The node is the first member, the entries given out are the nodes
+	typedef struct _OVERLAY_NODE
+	{
+		PCK_PATH_NODE	cNode;
+		uint32_t		dwLayer;
+	}OVERLAY_NODE, *LPOVERLAY_NODE;
+
+	typedef struct _EXTRACT_FILE
+	{
+		const OVERLAY_NODE	*lpNode;
+		std::wstring		szPath;
+	}EXTRACT_FILE;
+
+	LPOVERLAY_NODE	NewNode(LPPCK_PATH_NODE lpFolder, uint32_t dwLayer);
+	//Add the .. node of the folder, every folder has one like in the tree of a pck
+	void			AddDotDot(LPPCK_PATH_NODE lpFolder, LPPCK_PATH_NODE lpParentDotDot);
+
+	void			MergeFolder(LPPCK_PATH_NODE lpFolder, const PCK_PATH_NODE *lpLayerFolder, uint32_t dwLayer);
+	//Files, folders and sizes under the folder, the .. nodes hold them
+	void			CountFolder(LPPCK_PATH_NODE lpFolder);
+
+	void			CollectFiles(const PCK_PATH_NODE *lpNode, const std::wstring &szPath, std::vector<EXTRACT_FILE> &lpFiles);
+	BOOL			ExtractLayer(uint32_t dwLayer, const std::vector<const EXTRACT_FILE*> &lpFiles);
+	static BOOL		WriteDiskFile(const std::wstring &szPath, const char *buffer, size_t nSize);
+
+	std::vector<std::unique_ptr<CPckControlCenter>>	m_Layers;
+	std::vector<std::wstring>	m_LayerFiles;
+
+	//A deque keeps the nodes where they are
+	std::deque<OVERLAY_NODE>	m_Nodes;
+	OVERLAY_NODE				m_RootNode;
+	uint32_t					m_dwFileCount;
+
+	CPckClassPathTable			m_PathTable;
+	//Where the last page of ListByNodeToArray ended in the merged tree
+	CPckListCursor				m_cListCursor;
+};
@@ -0,0 +1,470 @@
+//////////////////////////////////////////////////////////////////////
+// PckSearchIndex.cpp: filename index for searching in the opened pck
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "PckSearchIndex.h"
+#include "PckClassLog.h"
+#include "PckWorkerPool.h"
+
+#include <string.h>
+#include <wctype.h>
+#include <algorithm>
+#include <regex>
+
+#define SEARCH_INDEX_BLOCK			32
+#define SEARCH_TRIGRAM_BITS			18
+#define SEARCH_TRIGRAM_BUCKETS		(1 << SEARCH_TRIGRAM_BITS)
+//A thread is only started for at least this many blocks
+#define SEARCH_BLOCKS_PER_THREAD	256
+
+#define TEXT_SEARCH_REGEX_FAIL		"Invalid regular expression: %s"
+
+#pragma region Names
+
+//lpOut holds at least 4 * nLen bytes, return the bytes written
+static size_t LowerUtf8(char *lpOut, const wchar_t *lpszText, size_t nLen)
+{
+	char *p = lpOut;
+
+	for (size_t i = 0; i < nLen; ++i) {
+
+		uint32_t ch = (uint32_t)lpszText[i];
+
+		//Most names are ascii, towlower is slow
+		if (0x80 > ch) {
+			*p++ = (char)((((uint32_t)'A' <= ch) && ((uint32_t)'Z' >= ch)) ? (ch | 0x20) : ch);
+			continue;
+		}
+
+		ch = (uint32_t)towlower((wint_t)ch);
+
+		if (0x80 > ch) {
+			*p++ = (char)ch;
+		}
+		else if (0x800 > ch) {
+			*p++ = (char)(0xc0 | (ch >> 6));
+			*p++ = (char)(0x80 | (ch & 0x3f));
+		}
+		else if (0x10000 > ch) {
+			*p++ = (char)(0xe0 | (ch >> 12));
+			*p++ = (char)(0x80 | ((ch >> 6) & 0x3f));
+			*p++ = (char)(0x80 | (ch & 0x3f));
+		}
+		else {
+			*p++ = (char)(0xf0 | ((ch >> 18) & 0x07));
+			*p++ = (char)(0x80 | ((ch >> 12) & 0x3f));
+			*p++ = (char)(0x80 | ((ch >> 6) & 0x3f));
+			*p++ = (char)(0x80 | (ch & 0x3f));
+		}
+	}
+	return p - lpOut;
+}
+
+static void AppendLowerUtf8(std::string &szOut, const wchar_t *lpszText, size_t nLen)
+{
+	size_t nOldSize = szOut.size();
+
+	szOut.resize(nOldSize + nLen * 4);
+	szOut.resize(nOldSize + LowerUtf8(&szOut[nOldSize], lpszText, nLen));
+}
+
+//Different trigrams may share a bucket, the matches are always checked against the name
+static inline uint32_t TrigramBucket(const char *p)
+{
+	uint32_t key = ((uint32_t)(uint8_t)p[0] << 16) | ((uint32_t)(uint8_t)p[1] << 8) | (uint8_t)p[2];
+	return (key * 2654435761u) >> (32 - SEARCH_TRIGRAM_BITS);
+}
+
+static BOOL GlobMatch(const wchar_t *lpszName, const wchar_t *lpszPattern, BOOL isIgnoreCase)
+{
+	const wchar_t *lpStar = nullptr, *lpStarName = nullptr;
+
+	while (*lpszName) {
+
+		if (L'*' == *lpszPattern) {
+			lpStar = lpszPattern++;
+			lpStarName = lpszName;
+		}
+		else if ((0 != *lpszPattern) && ((L'?' == *lpszPattern) || (*lpszPattern == *lpszName) ||
+			(isIgnoreCase && (towlower(*lpszPattern) == towlower(*lpszName))))) {
+			++lpszPattern;
+			++lpszName;
+		}
+		else if (nullptr != lpStar) {
+			//Let the last '*' take one more character
+			lpszPattern = lpStar + 1;
+			lpszName = ++lpStarName;
+		}
+		else {
+			return FALSE;
+		}
+	}
+
+	while (L'*' == *lpszPattern)
+		++lpszPattern;
+
+	return (0 == *lpszPattern);
+}
+
+#pragma endregion
+
+//Run func(0) .. func(dwThreadCount - 1) at the same time, the last one on this thread
+template<typename T>
+static void RunThreads(uint32_t dwThreadCount, T func)
+{
+	CPckTaskGroup cTasks(dwThreadCount);
+
+	for (uint32_t t = 0; t + 1 < dwThreadCount; ++t)
+		cTasks.Run([&func, t]() { func(t); });
+
+	func(dwThreadCount - 1);
+	cTasks.Wait();
+}
+
+//First block of the range of thread t, blocks are shared out evenly
+static inline uint32_t ThreadFirstBlock(uint32_t dwBlockCount, uint32_t dwThreadCount, uint32_t t)
+{
+	return (uint32_t)((uint64_t)dwBlockCount * t / dwThreadCount);
+}
+
+static inline uint32_t GetThreadCount(uint32_t dwThreads, uint32_t dwBlockCount)
+{
+	return std::max(1u, std::min(dwThreads, dwBlockCount / SEARCH_BLOCKS_PER_THREAD));
+}
+
+void CPckSearchIndex::Clear()
+{
+	{
+		std::lock_guard<std::mutex> lckLastQuery(m_LockLastQuery);
+		m_isLastQueryValid = FALSE;
+		std::vector<uint32_t>().swap(m_LastFoundIds);
+	}
+
+	std::lock_guard<std::mutex> lckBuild(m_LockBuild);
+
+	m_isBuilt = FALSE;
+	m_lpPckIndexTable = nullptr;
+	m_dwFileCount = 0;
+
+	std::string().swap(m_szNames);
+	std::vector<uint32_t>().swap(m_NameOffsets);
+	std::vector<uint32_t>().swap(m_BucketOffsets);
+	std::vector<uint32_t>().swap(m_BucketBlocks);
+}
+
+//Called with m_LockBuild held
+void CPckSearchIndex::Build(const PCKINDEXTABLE *lpPckIndexTable, uint32_t dwFileCount, uint32_t dwThreads)
+{
+	m_lpPckIndexTable = lpPckIndexTable;
+	m_dwFileCount = dwFileCount;
+
+	uint32_t dwBlockCount = (dwFileCount + SEARCH_INDEX_BLOCK - 1) / SEARCH_INDEX_BLOCK;
+	uint32_t dwThreadCount = GetThreadCount(dwThreads, dwBlockCount);
+
+	//Each thread converts the names of its blocks, the parts are joined in order
+	std::vector<std::string>			lpNameParts(dwThreadCount);
+	std::vector<std::vector<uint32_t>>	lpBucketCounts(dwThreadCount);
+
+	m_NameOffsets.resize((size_t)dwFileCount + 1);
+
+	RunThreads(dwThreadCount, [&](uint32_t t) {
+
+		uint32_t dwFirstId = std::min(dwFileCount, ThreadFirstBlock(dwBlockCount, dwThreadCount, t) * SEARCH_INDEX_BLOCK);
+		uint32_t dwEndId = std::min(dwFileCount, ThreadFirstBlock(dwBlockCount, dwThreadCount, t + 1) * SEARCH_INDEX_BLOCK);
+
+		std::string &szNames = lpNameParts[t];
+		char szName[MAX_PATH_PCK_260 * 4 + 1];
+
+		szNames.reserve((size_t)(dwEndId - dwFirstId) * 48);
+
+		for (uint32_t i = dwFirstId; i < dwEndId; ++i) {
+
+			const wchar_t *lpszName = lpPckIndexTable[i].cFileIndex.szwFilename;
+			size_t nLen = LowerUtf8(szName, lpszName, wcsnlen(lpszName, MAX_PATH_PCK_260));
+
+			szName[nLen] = 0;
+			//Relative to the part for now
+			m_NameOffsets[i] = (uint32_t)szNames.size();
+			szNames.append(szName, nLen + 1);
+		}
+	});
+
+	size_t nNamesSize = 0;
+	for (const auto &szPart : lpNameParts)
+		nNamesSize += szPart.size();
+
+	m_szNames.clear();
+	m_szNames.reserve(nNamesSize);
+
+	for (uint32_t t = 0; t < dwThreadCount; ++t) {
+
+		uint32_t dwFirstId = std::min(dwFileCount, ThreadFirstBlock(dwBlockCount, dwThreadCount, t) * SEARCH_INDEX_BLOCK);
+		uint32_t dwEndId = std::min(dwFileCount, ThreadFirstBlock(dwBlockCount, dwThreadCount, t + 1) * SEARCH_INDEX_BLOCK);
+
+		for (uint32_t i = dwFirstId; i < dwEndId; ++i)
+			m_NameOffsets[i] += (uint32_t)m_szNames.size();
+
+		m_szNames.append(lpNameParts[t]);
+		std::string().swap(lpNameParts[t]);
+	}
+	m_NameOffsets[dwFileCount] = (uint32_t)m_szNames.size();
+
+	//Each block is listed once per bucket, the blocks are visited in order so checking the last one is enough
+	auto ForEachBlockTrigram = [&](uint32_t t, auto AddBlock) {
+
+		std::vector<uint32_t> lastBlock(SEARCH_TRIGRAM_BUCKETS, UINT32_MAX);
+		uint32_t dwEndBlock = ThreadFirstBlock(dwBlockCount, dwThreadCount, t + 1);
+
+		for (uint32_t b = ThreadFirstBlock(dwBlockCount, dwThreadCount, t); b < dwEndBlock; ++b) {
+
+			const char *p = m_szNames.data() + m_NameOffsets[b * SEARCH_INDEX_BLOCK];
+			const char *pEnd = m_szNames.data() + m_NameOffsets[std::min(dwFileCount, (b + 1) * SEARCH_INDEX_BLOCK)];
+
+			//A trigram with the 0 at the end of a name is skipped
+			for (; p + 3 <= pEnd; ++p) {
+
+				if ((0 == p[1]) || (0 == p[2]) || (0 == p[0]))
+					continue;
+
+				uint32_t dwBucket = TrigramBucket(p);
+				if (b != lastBlock[dwBucket]) {
+					lastBlock[dwBucket] = b;
+					AddBlock(dwBucket, b);
+				}
+			}
+		}
+	};
+
+	RunThreads(dwThreadCount, [&](uint32_t t) {
+
+		std::vector<uint32_t> &lpCounts = lpBucketCounts[t];
+		lpCounts.assign(SEARCH_TRIGRAM_BUCKETS, 0);
+		ForEachBlockTrigram(t, [&lpCounts](uint32_t dwBucket, uint32_t) { ++lpCounts[dwBucket]; });
+	});
+
+	//Bucket by bucket, the blocks of thread 0 first, so each list stays sorted.
+	//The counts of each thread become the positions it writes to
+	m_BucketOffsets.resize(SEARCH_TRIGRAM_BUCKETS + 1);
+
+	uint32_t dwPos = 0;
+	for (uint32_t i = 0; i < SEARCH_TRIGRAM_BUCKETS; ++i) {
+
+		m_BucketOffsets[i] = dwPos;
+		for (uint32_t t = 0; t < dwThreadCount; ++t) {
+			uint32_t dwCount = lpBucketCounts[t][i];
+			lpBucketCounts[t][i] = dwPos;
+			dwPos += dwCount;
+		}
+	}
+	m_BucketOffsets[SEARCH_TRIGRAM_BUCKETS] = dwPos;
+	m_BucketBlocks.resize(dwPos);
+
+	RunThreads(dwThreadCount, [&](uint32_t t) {
+
+		std::vector<uint32_t> &lpFillPos = lpBucketCounts[t];
+		ForEachBlockTrigram(t, [this, &lpFillPos](uint32_t dwBucket, uint32_t dwBlock) { m_BucketBlocks[lpFillPos[dwBucket]++] = dwBlock; });
+	});
+
+	m_isBuilt = TRUE;
+}
+
+BOOL CPckSearchIndex::FindCandidateBlocks(const std::vector<std::string> &lpLiterals, std::vector<uint32_t> &lpBlocks)
+{
+	std::vector<uint32_t> buckets;
+
+	for (const std::string &szLiteral : lpLiterals) {
+		for (size_t i = 0; i + 3 <= szLiteral.size(); ++i)
+			buckets.push_back(TrigramBucket(szLiteral.data() + i));
+	}
+
+	if (buckets.empty())
+		return FALSE;
+
+	std::sort(buckets.begin(), buckets.end());
+	buckets.erase(std::unique(buckets.begin(), buckets.end()), buckets.end());
+
+	//Start from the shortest list, the intersection only gets smaller
+	auto BucketSize = [this](uint32_t dwBucket) { return m_BucketOffsets[dwBucket + 1] - m_BucketOffsets[dwBucket]; };
+	std::sort(buckets.begin(), buckets.end(), [&BucketSize](uint32_t a, uint32_t b) { return BucketSize(a) < BucketSize(b); });
+
+	lpBlocks.assign(m_BucketBlocks.begin() + m_BucketOffsets[buckets[0]], m_BucketBlocks.begin() + m_BucketOffsets[buckets[0] + 1]);
+
+	std::vector<uint32_t> intersection;
+	for (size_t i = 1; (i < buckets.size()) && !lpBlocks.empty(); ++i) {
+
+		intersection.clear();
+		std::set_intersection(lpBlocks.begin(), lpBlocks.end(),
+			m_BucketBlocks.begin() + m_BucketOffsets[buckets[i]], m_BucketBlocks.begin() + m_BucketOffsets[buckets[i] + 1],
+			std::back_inserter(intersection));
+		lpBlocks.swap(intersection);
+	}
+	return TRUE;
+}
+
+BOOL CPckSearchIndex::Search(const PCKINDEXTABLE *lpPckIndexTable, uint32_t dwFileCount, LPCWSTR lpszSearchString, int iSearchMode, uint32_t dwThreads, std::vector<uint32_t> &lpFoundIds)
+{
+	lpFoundIds.clear();
+
+	if ((nullptr == lpPckIndexTable) || (nullptr == lpszSearchString))
+		return FALSE;
+
+	int		iSearchType = iSearchMode & PCK_SEARCH_TYPE_MASK;
+	BOOL	isIgnoreCase = (0 != (PCK_SEARCH_IGNORE_CASE & iSearchMode));
+
+	//Every match contains szFilter in its lowercase name, empty - no filter
+	std::string					szFilter;
+	std::vector<std::string>	lpLiterals;
+	std::wregex					cRegex;
+
+	switch (iSearchType) {
+	case PCK_SEARCH_SUBSTRING:
+
+		AppendLowerUtf8(szFilter, lpszSearchString, wcslen(lpszSearchString));
+		lpLiterals.push_back(szFilter);
+		break;
+
+	case PCK_SEARCH_GLOB:
+
+		//Every part between the wildcards must be in the name
+		for (const wchar_t *p = lpszSearchString; *p; ) {
+			size_t nLen = wcscspn(p, L"*?");
+			if (0 != nLen) {
+				lpLiterals.emplace_back();
+				AppendLowerUtf8(lpLiterals.back(), p, nLen);
+			}
+			p += nLen;
+			if (*p)
+				++p;
+		}
+
+		for (const std::string &szLiteral : lpLiterals) {
+			if (szFilter.size() < szLiteral.size())
+				szFilter = szLiteral;
+		}
+		break;
+
+	case PCK_SEARCH_REGEX:
+
+		try {
+			cRegex.assign(lpszSearchString, isIgnoreCase ? (std::regex::ECMAScript | std::regex::icase) : std::regex::ECMAScript);
+		}
+		catch (const std::regex_error &e) {
+			Logger.w(TEXT_SEARCH_REGEX_FAIL, e.what());
+			return FALSE;
+		}
+		break;
+
+	default:
+		return FALSE;
+	}
+
+	{
+		std::lock_guard<std::mutex> lckBuild(m_LockBuild);
+		if (!m_isBuilt || (lpPckIndexTable != m_lpPckIndexTable) || (dwFileCount != m_dwFileCount))
+			Build(lpPckIndexTable, dwFileCount, dwThreads);
+	}
+
+	std::vector<uint32_t>	lpBlocks;
+	BOOL					isIndexed = FindCandidateBlocks(lpLiterals, lpBlocks);
+	uint32_t				dwBlockCount = isIndexed ? (uint32_t)lpBlocks.size() : ((dwFileCount + SEARCH_INDEX_BLOCK - 1) / SEARCH_INDEX_BLOCK);
+
+	const char		*lpNames = m_szNames.data();
+	const uint32_t	*lpOffsets = m_NameOffsets.data();
+
+	auto IsMatch = [&](uint32_t id) -> BOOL {
+
+		const wchar_t *lpszName = lpPckIndexTable[id].cFileIndex.szwFilename;
+
+		switch (iSearchType) {
+		case PCK_SEARCH_SUBSTRING:
+			//The lowercase name already contains the lowercase string
+			return isIgnoreCase || (nullptr != wcsstr(lpszName, lpszSearchString));
+		case PCK_SEARCH_GLOB:
+			return GlobMatch(lpszName, lpszSearchString, isIgnoreCase);
+		default:
+			return std::regex_search(lpszName, cRegex);
+		}
+	};
+
+	//Check the blocks [dwFirst, dwLast) of the candidates
+	auto SearchBlocks = [&](uint32_t dwFirst, uint32_t dwLast, std::vector<uint32_t> &lpIds) {
+
+		for (uint32_t n = dwFirst; n < dwLast; ++n) {
+
+			uint32_t dwBlock = isIndexed ? lpBlocks[n] : n;
+			uint32_t dwFirstId = dwBlock * SEARCH_INDEX_BLOCK;
+			uint32_t dwEndId = std::min(dwFileCount, dwFirstId + SEARCH_INDEX_BLOCK);
+
+			//One memmem over the names of the whole block, then find the name of each hit
+			const char *p = lpNames + lpOffsets[dwFirstId];
+			const char *pEnd = lpNames + lpOffsets[dwEndId];
+			const char *lpHit;
+
+			while ((p < pEnd) && (nullptr != (lpHit = (const char*)memmem(p, pEnd - p, szFilter.data(), szFilter.size())))) {
+
+				uint32_t id = (uint32_t)(std::upper_bound(lpOffsets + dwFirstId, lpOffsets + dwEndId, (uint32_t)(lpHit - lpNames)) - lpOffsets) - 1;
+
+				//A hit can not run over the end of the name, the names are separated by 0
+				if (IsMatch(id))
+					lpIds.push_back(id);
+
+				p = lpNames + lpOffsets[id + 1];
+			}
+		}
+	};
+
+	uint32_t dwThreadCount = GetThreadCount(dwThreads, dwBlockCount);
+
+	if (1 == dwThreadCount) {
+		SearchBlocks(0, dwBlockCount, lpFoundIds);
+		return TRUE;
+	}
+
+	//Each thread takes a continuous range, joining the results in order keeps the index order
+	std::vector<std::vector<uint32_t>> lpThreadIds(dwThreadCount);
+
+	RunThreads(dwThreadCount, [&](uint32_t t) {
+		SearchBlocks(ThreadFirstBlock(dwBlockCount, dwThreadCount, t), ThreadFirstBlock(dwBlockCount, dwThreadCount, t + 1), lpThreadIds[t]);
+	});
+
+	for (const auto &ids : lpThreadIds)
+		lpFoundIds.insert(lpFoundIds.end(), ids.begin(), ids.end());
+
+	return TRUE;
+}
+
+uint32_t CPckSearchIndex::SearchPage(const PCKINDEXTABLE *lpPckIndexTable, uint32_t dwFileCount, LPCWSTR lpszSearchString, int iSearchMode, uint32_t dwThreads, uint32_t dwOffset, uint32_t dwMaxIds, std::vector<uint32_t> &lpPageIds)
+{
+	lpPageIds.clear();
+
+	if ((nullptr == lpPckIndexTable) || (nullptr == lpszSearchString))
+		return 0;
+
+	std::lock_guard<std::mutex> lckLastQuery(m_LockLastQuery);
+
+	if (!m_isLastQueryValid || (iSearchMode != m_iLastSearchMode) || (lpPckIndexTable != m_lpLastIndexTable) ||
+		(dwFileCount != m_dwLastFileCount) || (m_szLastQuery != lpszSearchString)) {
+
+		m_isLastQueryValid = FALSE;
+
+		//A query that fails is not kept, its warning is logged again
+		if (!Search(lpPckIndexTable, dwFileCount, lpszSearchString, iSearchMode, dwThreads, m_LastFoundIds))
+			return 0;
+
+		m_isLastQueryValid = TRUE;
+		m_szLastQuery = lpszSearchString;
+		m_iLastSearchMode = iSearchMode;
+		m_lpLastIndexTable = lpPckIndexTable;
+		m_dwLastFileCount = dwFileCount;
+	}
+
+	uint32_t dwFoundCount = (uint32_t)m_LastFoundIds.size();
+
+	if (dwOffset < dwFoundCount)
+		lpPageIds.assign(m_LastFoundIds.begin() + dwOffset, m_LastFoundIds.begin() + std::min<uint64_t>((uint64_t)dwOffset + dwMaxIds, dwFoundCount));
+
+	return dwFoundCount;
+}
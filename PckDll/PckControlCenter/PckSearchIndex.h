@@ -0,0 +1,65 @@
+//////////////////////////////////////////////////////////////////////
+// PckSearchIndex.h: filename index for searching in the opened pck
+//
+// The names are kept lowercase in UTF-8 one after another, and every
+// block of SEARCH_INDEX_BLOCK names is listed under the hashed trigrams
+// it contains. A query only checks the blocks that have all its trigrams,
+// queries without trigrams scan the names with memmem on several threads
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "PckStructs.h"
+#include <mutex>
+#include <string>
+#include <vector>
+
+class CPckSearchIndex
+{
+public:
+	CPckSearchIndex() = default;
+	~CPckSearchIndex() = default;
+
+	//Drop the index, it is built again by the next search
+	void	Clear();
+
+	//Find the entries of lpPckIndexTable matching lpszSearchString, iSearchMode = PCK_SEARCH_*
+	//lpFoundIds receives the numbers of the entries in index order
+	BOOL	Search(const PCKINDEXTABLE *lpPckIndexTable, uint32_t dwFileCount, LPCWSTR lpszSearchString, int iSearchMode, uint32_t dwThreads, std::vector<uint32_t> &lpFoundIds);
+	//The found ids dwOffset .. dwOffset + dwMaxIds - 1 of Search, return the count of all found ids
+	//The ids of the last query are kept, its next pages are not searched again
+	uint32_t	SearchPage(const PCKINDEXTABLE *lpPckIndexTable, uint32_t dwFileCount, LPCWSTR lpszSearchString, int iSearchMode, uint32_t dwThreads, uint32_t dwOffset, uint32_t dwMaxIds, std::vector<uint32_t> &lpPageIds);
+
+private:
+
+	void	Build(const PCKINDEXTABLE *lpPckIndexTable, uint32_t dwFileCount, uint32_t dwThreads);
+
+	//Blocks that may contain all trigrams of the strings, FALSE if the strings have none
+	BOOL	FindCandidateBlocks(const std::vector<std::string> &lpLiterals, std::vector<uint32_t> &lpBlocks);
+
+	std::mutex				m_LockBuild;
+
+	const PCKINDEXTABLE		*m_lpPckIndexTable = nullptr;
+	uint32_t				m_dwFileCount = 0;
+	BOOL					m_isBuilt = FALSE;
+
+	//Lowercase UTF-8 names, each one ends with 0
+	std::string				m_szNames;
+	//Start of each name in m_szNames, m_dwFileCount + 1 items
+	std::vector<uint32_t>	m_NameOffsets;
+
+	//Blocks of trigram bucket i are m_BucketBlocks[m_BucketOffsets[i] .. m_BucketOffsets[i + 1] - 1]
+	std::vector<uint32_t>	m_BucketOffsets;
+	std::vector<uint32_t>	m_BucketBlocks;
+
+	//The last query of SearchPage and its ids
+	std::mutex				m_LockLastQuery;
+	BOOL					m_isLastQueryValid = FALSE;
+	std::wstring			m_szLastQuery;
+	int						m_iLastSearchMode = 0;
+	const PCKINDEXTABLE		*m_lpLastIndexTable = nullptr;
+	uint32_t				m_dwLastFileCount = 0;
+	std::vector<uint32_t>	m_LastFoundIds;
+};
@@ -0,0 +1,211 @@
+//////////////////////////////////////////////////////////////////////
+// PckSystemLimits.cpp: processors and memory this process may really use
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "PckSystemLimits.h"
+#include <algorithm>
+#include <thread>
+
+#ifndef _WIN32
+#include <sched.h>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+
+#define CGROUP_MOUNT			"/sys/fs/cgroup"
+//cgroup v2 next to v1 controllers
+#define CGROUP_MOUNT_HYBRID		"/sys/fs/cgroup/unified"
+//Values of memory.limit_in_bytes at least this big mean no limit
+#define CGROUP_V1_NO_LIMIT		(1ULL << 60)
+
+//Path of the cgroup of the controller in /proc/self/cgroup, lpszController = "" for the cgroup v2 one
+static BOOL GetCgroupPath(const char *lpszController, std::string &szPath)
+{
+	std::ifstream fin("/proc/self/cgroup");
+	std::string szLine;
+
+	while (std::getline(fin, szLine)) {
+
+		//hierarchy-ID:controller-list:path
+		size_t nFirst = szLine.find(':');
+		size_t nSecond = (std::string::npos == nFirst) ? std::string::npos : szLine.find(':', nFirst + 1);
+
+		if (std::string::npos == nSecond)
+			continue;
+
+		std::string szControllers = szLine.substr(nFirst + 1, nSecond - nFirst - 1);
+		BOOL isMatch = FALSE;
+
+		if (0 == *lpszController)
+			isMatch = szControllers.empty() && (0 == szLine.compare(0, nFirst, "0"));
+		else
+			isMatch = (std::string::npos != ("," + szControllers + ",").find(std::string(",") + lpszController + ","));
+
+		if (isMatch) {
+			szPath = szLine.substr(nSecond + 1);
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static BOOL ReadFirstLine(const std::string &szFile, std::string &szLine)
+{
+	std::ifstream fin(szFile);
+	return fin.is_open() && (bool)std::getline(fin, szLine);
+}
+
+//func(szFolder) for the cgroup and each of its parents that is visible under the mount,
+//a limit of a parent applies to its children too
+template<typename T>
+static void ForEachCgroupLevel(const char *lpszMount, std::string szPath, T func)
+{
+	for (;;) {
+
+		while ((!szPath.empty()) && ('/' == szPath.back()))
+			szPath.pop_back();
+
+		func(std::string(lpszMount) + szPath);
+
+		if (szPath.empty())
+			break;
+
+		size_t nSlash = szPath.rfind('/');
+		szPath.resize((std::string::npos == nSlash) ? 0 : nSlash);
+	}
+}
+
+static uint32_t GetCgroupCpuQuota()
+{
+	uint32_t dwCpus = UINT32_MAX;
+	std::string szPath;
+
+	//cpu.max: "$MAX $PERIOD", $MAX is "max" when there is no quota
+	auto ReadCpuMax = [&dwCpus](const std::string &szFolder) {
+
+		std::string szLine;
+		unsigned long long qwQuota, qwPeriod;
+
+		if (ReadFirstLine(szFolder + "/cpu.max", szLine) &&
+			(2 == sscanf(szLine.c_str(), "%llu %llu", &qwQuota, &qwPeriod)) && (0 != qwPeriod))
+			dwCpus = std::min<uint32_t>(dwCpus, (uint32_t)std::max<unsigned long long>((qwQuota + qwPeriod - 1) / qwPeriod, 1));
+	};
+
+	if (GetCgroupPath("", szPath)) {
+		ForEachCgroupLevel(CGROUP_MOUNT, szPath, ReadCpuMax);
+		ForEachCgroupLevel(CGROUP_MOUNT_HYBRID, szPath, ReadCpuMax);
+	}
+
+	//cgroup v1, cpu.cfs_quota_us is -1 when there is no quota
+	auto ReadCfsQuota = [&dwCpus](const std::string &szFolder) {
+
+		std::string szQuota, szPeriod;
+		long long llQuota, llPeriod;
+
+		if (ReadFirstLine(szFolder + "/cpu.cfs_quota_us", szQuota) && ReadFirstLine(szFolder + "/cpu.cfs_period_us", szPeriod) &&
+			(1 == sscanf(szQuota.c_str(), "%lld", &llQuota)) && (1 == sscanf(szPeriod.c_str(), "%lld", &llPeriod)) &&
+			(0 < llQuota) && (0 < llPeriod))
+			dwCpus = std::min<uint32_t>(dwCpus, (uint32_t)std::max<long long>((llQuota + llPeriod - 1) / llPeriod, 1));
+	};
+
+	if (GetCgroupPath("cpu", szPath)) {
+		ForEachCgroupLevel(CGROUP_MOUNT "/cpu", szPath, ReadCfsQuota);
+		ForEachCgroupLevel(CGROUP_MOUNT "/cpu,cpuacct", szPath, ReadCfsQuota);
+	}
+
+	return dwCpus;
+}
+
+static uint64_t GetCgroupMemoryLimit()
+{
+	uint64_t qwLimit = UINT64_MAX;
+	std::string szPath;
+
+	//memory.max is "max" when there is no limit
+	auto ReadMemoryMax = [&qwLimit](const std::string &szFolder) {
+
+		std::string szLine;
+		unsigned long long qwValue;
+
+		if (ReadFirstLine(szFolder + "/memory.max", szLine) && (1 == sscanf(szLine.c_str(), "%llu", &qwValue)))
+			qwLimit = std::min<uint64_t>(qwLimit, qwValue);
+	};
+
+	if (GetCgroupPath("", szPath)) {
+		ForEachCgroupLevel(CGROUP_MOUNT, szPath, ReadMemoryMax);
+		ForEachCgroupLevel(CGROUP_MOUNT_HYBRID, szPath, ReadMemoryMax);
+	}
+
+	auto ReadLimitInBytes = [&qwLimit](const std::string &szFolder) {
+
+		std::string szLine;
+		unsigned long long qwValue;
+
+		if (ReadFirstLine(szFolder + "/memory.limit_in_bytes", szLine) && (1 == sscanf(szLine.c_str(), "%llu", &qwValue)) &&
+			(CGROUP_V1_NO_LIMIT > qwValue))
+			qwLimit = std::min<uint64_t>(qwLimit, qwValue);
+	};
+
+	if (GetCgroupPath("memory", szPath))
+		ForEachCgroupLevel(CGROUP_MOUNT "/memory", szPath, ReadLimitInBytes);
+
+	return qwLimit;
+}
+#endif
+
+uint32_t CPckSystemLimits::GetCpuCount()
+{
+	return GetLimits().dwCpuCount;
+}
+
+uint64_t CPckSystemLimits::GetMemoryLimit()
+{
+	return GetLimits().qwMemoryLimit;
+}
+
+const CPckSystemLimits::SYSTEM_LIMITS& CPckSystemLimits::GetLimits()
+{
+	static const SYSTEM_LIMITS cLimits = Detect();
+	return cLimits;
+}
+
+CPckSystemLimits::SYSTEM_LIMITS CPckSystemLimits::Detect()
+{
+	SYSTEM_LIMITS cLimits;
+
+	cLimits.dwCpuCount = std::max<uint32_t>(std::thread::hardware_concurrency(), 1);
+	cLimits.qwMemoryLimit = 0;
+
+#ifdef _WIN32
+	MEMORYSTATUSEX cMemoryStatus;
+	cMemoryStatus.dwLength = sizeof(cMemoryStatus);
+
+	if (GlobalMemoryStatusEx(&cMemoryStatus))
+		cLimits.qwMemoryLimit = cMemoryStatus.ullTotalPhys;
+#else
+	cpu_set_t cCpuSet;
+	CPU_ZERO(&cCpuSet);
+
+	//Processors the process may run on, taskset or a cpuset cgroup
+	if (0 == sched_getaffinity(0, sizeof(cCpuSet), &cCpuSet))
+		cLimits.dwCpuCount = std::min<uint32_t>(cLimits.dwCpuCount, std::max(CPU_COUNT(&cCpuSet), 1));
+
+	cLimits.dwCpuCount = std::min<uint32_t>(cLimits.dwCpuCount, GetCgroupCpuQuota());
+
+	long lPages = sysconf(_SC_PHYS_PAGES);
+	long lPageSize = sysconf(_SC_PAGESIZE);
+
+	if ((0 < lPages) && (0 < lPageSize))
+		cLimits.qwMemoryLimit = (uint64_t)lPages * (uint64_t)lPageSize;
+
+	uint64_t qwCgroupLimit = GetCgroupMemoryLimit();
+
+	if ((UINT64_MAX != qwCgroupLimit) && ((0 == cLimits.qwMemoryLimit) || (qwCgroupLimit < cLimits.qwMemoryLimit)))
+		cLimits.qwMemoryLimit = qwCgroupLimit;
+#endif
+
+	return cLimits;
+}
@@ -0,0 +1,38 @@
+//////////////////////////////////////////////////////////////////////
+// PckSystemLimits.h: processors and memory this process may really use
+//
+// In a container the host's processors and memory are visible, but the
+// cgroup quota, the affinity mask and memory.max decide what the process
+// gets. They are read once, the defaults of the threads and of the memory
+// used while compressing are taken from them
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "PckDefines.h"
+
+//Part of the memory limit the compressed data waiting to be written may take
+#define SYSTEM_MEMORY_BUDGET_DIVISOR	4
+#define SYSTEM_MIN_MEMORY_BUDGET		(32 * 1024 * 1024)
+
+class CPckSystemLimits
+{
+public:
+	//At least 1
+	static uint32_t	GetCpuCount();
+	//The smaller of the physical memory and the cgroup limit, 0 if neither is known
+	static uint64_t	GetMemoryLimit();
+
+private:
+
+	typedef struct _SYSTEM_LIMITS
+	{
+		uint32_t	dwCpuCount;
+		uint64_t	qwMemoryLimit;
+	}SYSTEM_LIMITS;
+
+	static const SYSTEM_LIMITS&	GetLimits();
+	static SYSTEM_LIMITS		Detect();
+};
@@ -94,7 +94,8 @@ void CZupClass::BuildDirTree()
 
 BOOL CZupClass::Init(LPCWSTR szFile)
 {
-	wcscpy_s(m_PckAllInfo.szFilename, szFile);
+	if(0 == GetFullPathNameW(szFile, MAX_PATH, m_PckAllInfo.szFilename, NULL))
+		wcscpy_s(m_PckAllInfo.szFilename, szFile);
 	GetFileTitleW(m_PckAllInfo.szFilename, m_PckAllInfo.szFileTitle, MAX_PATH);
 
 	if(MountPckFile(m_PckAllInfo.szFilename)) {
@@ -104,7 +105,7 @@ BOOL CZupClass::Init(LPCWSTR szFile)
 		}
 
 		//The first loop reads the inc file and creates a dictionary
-		m_lpDictHash = new CDictHash();
+		m_lpDictHash = new CDictHash(m_PckAllInfo.dwFileCount);
 		if(BuildZupBaseDict()) {
 
 			//The second loop decodes the file name and creates a directory tree.
@@ -13,6 +13,7 @@
 #include "ZupHeader.h"
 #include "DictHash.h"
 #include "PckClassLog.h"
+#include <functional>
 
 #if !defined(_ZUPCLASS_H_)
 #define _ZUPCLASS_H_
@@ -35,6 +36,10 @@ public:
 
 	//Create and update pck files
 	virtual BOOL	UpdatePckFile(LPCWSTR szPckFile, const vector<wstring> &lpszFilePath, const PCK_PATH_NODE* lpNodeToInsert) override { Logger.e(TEXT_NOTSUPPORT);return FALSE; }
+	virtual BOOL	UpdatePckFileFromZup(LPCWSTR szPckFile, LPCWSTR szZupFile, vector<FILES_TO_COMPRESS> &lpZupFiles, const PCK_PATH_NODE* lpNodeToInsert) override { Logger.e(TEXT_NOTSUPPORT);return FALSE; }
+
+	//Files under the folder lpFolder (NULL for all) to add to a pck by UpdatePckFileFromZup, their names are relative to the folder
+	BOOL	GetFilesToApply(const PCK_PATH_NODE* lpFolder, vector<FILES_TO_COMPRESS> &lpFilesList);
 
 	//Rename file
 	virtual BOOL	RenameFilename() override { Logger.e(TEXT_NOTSUPPORT);return FALSE; }
@@ -50,6 +55,7 @@ public:
 
 	//Preview file
 	virtual BOOL	GetSingleFileData(const PCKINDEXTABLE* const lpZupFileIndexTable, char *buffer, size_t sizeOfBuffer = 0) override;
+	virtual BOOL	OpenVirtualFile(const PCKINDEXTABLE* const lpZupFileIndexTable, CPckVirtualFile &cFile) override;
 protected:
 	virtual BOOL	GetSingleFileData(LPVOID lpvoidFileRead, const PCKINDEXTABLE* const lpPckFileIndexTable, char *buffer, size_t sizeOfBuffer = 0) override;
 
@@ -64,9 +70,11 @@ private:
 	BOOL	BuildZupBaseDict();
 	void	DecodeFilename(char *_dst, wchar_t *_wdst, char *_src);
 
-	_inline void	DecodeDict(LPZUP_FILENAME_DICT lpZupDict);
-	//void	AddDict(char *&lpszStringToAdd);
-	void	AddDict(std::string& base_file);
+	//Inc files are read and the names decoded on several threads, the keys are added on the calling one
+	void	ReadDictKeys(LPVOID lpvoidFileRead, const PCKINDEXTABLE* lpIncIndex, std::vector<std::string> &lpKeys);
+	void	AddDictKeys(std::string& base_file, std::vector<std::string> &lpKeys);
+	static void	DecodeDict(const ZUP_FILENAME_DICT *lpZupDict, std::string &szRealStr, std::wstring &szwRealStr);
+	static void	RunDictThreads(const std::function<void()> &lpWorker, size_t nThreads);
 
 	const PCKINDEXTABLE* GetBaseFileIndex(const PCKINDEXTABLE* lpIndex, const PCKINDEXTABLE* lpZeroBaseIndex);
 
@@ -10,137 +10,64 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "ZupClass.h"
-#include <functional>
+#include "ZupInflateChain.h"
 
 #pragma warning ( disable : 4267 )
 
 BOOL CZupClass::GetSingleFileData(const PCKINDEXTABLE* const lpZupFileIndexTable, char *buffer, size_t sizeOfBuffer)
 {
+	CMapViewFileMultiPckRead	cFileRead;
 
-	const PCKINDEXTABLE* lpPckFileIndexTable = nullptr;
-
-	//"element\" = 0x6d656c65, 0x5c746e656d656c65
-	if(0x6d656c65 == *(uint32_t*)lpZupFileIndexTable->cFileIndex.szFilename) {
-
-		lpPckFileIndexTable = GetBaseFileIndex(lpZupFileIndexTable, m_lpZupIndexTable);
-
-		ulong_t	dwFileLengthDecompress2 = lpZupFileIndexTable->cFileIndex.dwFileClearTextSize;
-		ulong_t	dwFileLengthDecompress1 = lpPckFileIndexTable->cFileIndex.dwFileClearTextSize;
-
-		if(0 != sizeOfBuffer && sizeOfBuffer < dwFileLengthDecompress2) {
-			dwFileLengthDecompress2 = sizeOfBuffer;
-			if(sizeOfBuffer < dwFileLengthDecompress1)
-				dwFileLengthDecompress1 = sizeOfBuffer;
-		}
-
-		char	*_cipherbuf = (char*)malloc(dwFileLengthDecompress1);
-
-		if(NULL == _cipherbuf) {
-			Logger_el(TEXT_MALLOC_FAIL);
-			return FALSE;
-		}
-
-		if(CPckClass::GetSingleFileData(lpPckFileIndexTable, _cipherbuf, dwFileLengthDecompress1)) {
-
-			if(m_zlib.check_zlib_header(_cipherbuf + 4)) {
-
-				if(Z_OK != m_zlib.decompress_part((uint8_t*)buffer, &dwFileLengthDecompress2,
-					(uint8_t*)_cipherbuf + 4, dwFileLengthDecompress1 - 4, lpZupFileIndexTable->cFileIndex.dwFileClearTextSize)) {
-					if(lpZupFileIndexTable->cFileIndex.dwFileClearTextSize == lpZupFileIndexTable->cFileIndex.dwFileCipherTextSize) {
-						memcpy(buffer, _cipherbuf + 4, dwFileLengthDecompress2);
-					} else {
-						assert(FALSE);
-						Logger_el(TEXT_UNCOMPRESSDATA_FAIL, lpZupFileIndexTable->cFileIndex.szFilename);
-					}
-				}
-			} else {
-				memcpy(buffer, _cipherbuf + 4, dwFileLengthDecompress2);
-			}
-
-			free(_cipherbuf);
-
-		} else {
-			free(_cipherbuf);
-			return FALSE;
-		}
-
-
-	} else {
-
-		lpPckFileIndexTable = lpZupFileIndexTable;
-		return CPckClass::GetSingleFileData(lpPckFileIndexTable, buffer, sizeOfBuffer);
+	if (!cFileRead.OpenPckAndMappingRead(m_PckAllInfo.szFilename)) {
+		return FALSE;
 	}
+	return GetSingleFileData(&cFileRead, lpZupFileIndexTable, buffer, sizeOfBuffer);
+}
 
-	return TRUE;
+BOOL CZupClass::OpenVirtualFile(const PCKINDEXTABLE* const lpZupFileIndexTable, CPckVirtualFile &cFile)
+{
+	//"element\" files are compressed twice and can not be inflated in parts, they are decompressed at once
+	if (0x6d656c65 != *(uint32_t*)lpZupFileIndexTable->cFileIndex.szFilename)
+		return CPckClass::OpenVirtualFile(lpZupFileIndexTable, cFile);
+
+	std::vector<char> data(lpZupFileIndexTable->cFileIndex.dwFileClearTextSize);
 
+	if (!GetSingleFileData(lpZupFileIndexTable, data.data(), data.size()))
+		return FALSE;
 
-	//PCK_GETDATA pPckGetSingleFileData = std::bind((BOOL (CPckClass::*)(const PCKINDEXTABLE* const, char*, size_t))&CPckClass::GetSingleFileData, static_cast<CPckClass*>(this), std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
-	//return ZupGetSingleFileData(lpZupFileIndexTable, buffer, sizeOfBuffer, pPckGetSingleFileData);
+	return cFile.OpenBuffer(std::move(data));
 }
 
 BOOL CZupClass::GetSingleFileData(LPVOID lpvoidFileRead, const PCKINDEXTABLE* const lpZupFileIndexTable, char *buffer, size_t sizeOfBuffer)
 {
-
-	const PCKINDEXTABLE* lpPckFileIndexTable = nullptr;
-
 	//"element\" = 0x6d656c65, 0x5c746e656d656c65
-	if (0x6d656c65 == *(uint32_t*)lpZupFileIndexTable->cFileIndex.szFilename) {
-
-		lpPckFileIndexTable = GetBaseFileIndex(lpZupFileIndexTable, m_lpZupIndexTable);
-
-		ulong_t	dwFileLengthDecompress2 = lpZupFileIndexTable->cFileIndex.dwFileClearTextSize;
-		ulong_t	dwFileLengthDecompress1 = lpPckFileIndexTable->cFileIndex.dwFileClearTextSize;
-
-		if (0 != sizeOfBuffer && sizeOfBuffer < dwFileLengthDecompress2) {
-			dwFileLengthDecompress2 = sizeOfBuffer;
-			if (sizeOfBuffer < dwFileLengthDecompress1)
-				dwFileLengthDecompress1 = sizeOfBuffer;
-		}
-
-		char	*_cipherbuf = (char*)malloc(dwFileLengthDecompress1);
+	if (0x6d656c65 != *(uint32_t*)lpZupFileIndexTable->cFileIndex.szFilename)
+		return CPckClass::GetSingleFileData(lpvoidFileRead, lpZupFileIndexTable, buffer, sizeOfBuffer);
 
-		if (NULL == _cipherbuf) {
-			Logger_el(TEXT_MALLOC_FAIL);
-			return FALSE;
-		}
+	CMapViewFileMultiPckRead	*lpFileRead = (CMapViewFileMultiPckRead*)lpvoidFileRead;
+	const PCKFILEINDEX* lpPckFileIndex = &GetBaseFileIndex(lpZupFileIndexTable, m_lpZupIndexTable)->cFileIndex;
+	const PCKFILEINDEX* lpZupFileIndex = &lpZupFileIndexTable->cFileIndex;
 
-		if (CPckClass::GetSingleFileData(lpvoidFileRead, lpPckFileIndexTable, _cipherbuf, dwFileLengthDecompress1)) {
-
-			if (m_zlib.check_zlib_header(_cipherbuf + 4)) {
-
-				if (Z_OK != m_zlib.decompress_part((uint8_t*)buffer, &dwFileLengthDecompress2,
-					(uint8_t*)_cipherbuf + 4, dwFileLengthDecompress1 - 4, lpZupFileIndexTable->cFileIndex.dwFileClearTextSize)) {
-					if (lpZupFileIndexTable->cFileIndex.dwFileClearTextSize == lpZupFileIndexTable->cFileIndex.dwFileCipherTextSize) {
-						memcpy(buffer, _cipherbuf + 4, dwFileLengthDecompress2);
-					}
-					else {
-						assert(FALSE);
-						Logger_el(TEXT_UNCOMPRESSDATA_FAIL, lpZupFileIndexTable->cFileIndex.szFilename);
-					}
-				}
-			}
-			else {
-				memcpy(buffer, _cipherbuf + 4, dwFileLengthDecompress2);
-			}
+	BYTE *lpMapAddress;
+	if (NULL == (lpMapAddress = lpFileRead->View(lpPckFileIndex->dwAddressOffset, lpPckFileIndex->dwFileCipherTextSize))) {
+		Logger_el(UCSTEXT(TEXT_VIEWMAPNAME_FAIL), m_PckAllInfo.szFilename);
+		return FALSE;
+	}
 
-			free(_cipherbuf);
+	ulong_t	dwFileLengthToWrite = lpZupFileIndex->dwFileClearTextSize;
 
-		}
-		else {
-			free(_cipherbuf);
-			return FALSE;
-		}
+	if (0 != sizeOfBuffer && sizeOfBuffer < dwFileLengthToWrite)
+		dwFileLengthToWrite = sizeOfBuffer;
 
+	//Both layers are inflated in one pass, the data of the base entry is not copied
+	BOOL rtn = CZupInflateChain::Decompress(lpMapAddress, lpPckFileIndex->dwFileCipherTextSize, lpPckFileIndex->dwFileClearTextSize == lpPckFileIndex->dwFileCipherTextSize,
+		(uint8_t*)buffer, &dwFileLengthToWrite, lpZupFileIndex->dwFileClearTextSize == lpZupFileIndex->dwFileCipherTextSize);
 
+	if (!rtn) {
+		assert(FALSE);
+		Logger_el(TEXT_UNCOMPRESSDATA_FAIL, lpZupFileIndex->szFilename);
 	}
-	else {
 
-		lpPckFileIndexTable = lpZupFileIndexTable;
-		return CPckClass::GetSingleFileData(lpvoidFileRead, lpPckFileIndexTable, buffer, sizeOfBuffer);
-	}
-
-	return TRUE;
-
-	//PCK_GETDATA pPckGetSingleFileData = std::bind((BOOL(CPckClass::*)(LPVOID, const PCKINDEXTABLE* const, char*, size_t))&CPckClass::GetSingleFileData, static_cast<CPckClass*>(this), lpvoidFileRead, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
-	//return ZupGetSingleFileData(lpZupFileIndexTable, buffer, sizeOfBuffer, pPckGetSingleFileData);
-}
\ No newline at end of file
+	lpFileRead->UnmapViewAll();
+	return rtn;
+}
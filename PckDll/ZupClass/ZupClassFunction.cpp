@@ -11,52 +11,79 @@
 
 #include "ZupClass.h"
 #include "../../base64/base64.h"
-#ifdef _WIN32
-#include <intrin.h>
-#else
-#include <emmintrin.h>  // SSE2 intrinsics on Linux
-#endif
 #include "CharsCodeConv.h"
 #include "TextLineSpliter.h"
+#include "PckWorkerPool.h"
 
-_inline void CZupClass::DecodeDict(LPZUP_FILENAME_DICT lpZupDict)
+#include <algorithm>
+#include <atomic>
+
+//Keys of the dictionary are counted by thread in blocks of this size when decoding
+#define ZUP_DICT_DECODE_BLOCK	256
+
+void CZupClass::DecodeDict(const ZUP_FILENAME_DICT *lpZupDict, std::string &szRealStr, std::wstring &szwRealStr)
 {
-	char			szUTF8str[MAX_PATH_PCK];
+	char			szUTF8str[MAX_PATH_PCK] = { 0 };
+	char			szAnsiStr[MAX_PATH_PCK];
+	wchar_t			szwStr[MAX_PATH_PCK];
 
 	//base64 decoding
-	DWORD	dwRealLen = lpZupDict->realstrlength;
+	DWORD	dwRealLen = lpZupDict->base64strlength;
 	base64_decode(lpZupDict->realbase64str, dwRealLen, szUTF8str);
 
-	lpZupDict->wrealstrlength = U8toW(szUTF8str, lpZupDict->wrealstr, MAX_PATH_PCK, -1) - 1;
-	lpZupDict->realstrlength = CPckClassCodepage::PckFilenameCode2Ansi(lpZupDict->wrealstr, lpZupDict->realstr, MAX_PATH_PCK);
+	int		nWRealLen = U8toW(szUTF8str, szwStr, MAX_PATH_PCK, -1);
+	if (0 >= nWRealLen)
+		return;
 
+	size_t	realstrlength = CPckClassCodepage::PckFilenameCode2Ansi(szwStr, szAnsiStr, MAX_PATH_PCK);
 
+	szRealStr.assign(szAnsiStr, realstrlength);
+	szwRealStr.assign(szwStr, nWRealLen - 1);
 }
 
-void CZupClass::AddDict(std::string& base_file)
+void CZupClass::AddDictKeys(std::string& base_file, std::vector<std::string> &lpKeys)
 {
 	char ch[2] = { 0 };
 	*ch = base_file.at(0);
 
 	if ('/' == *ch || '\\' == *ch)
 	{
-		std::vector<std::string> line_content;
-		CTextUnitsA::Split(base_file, line_content, ch, LINE_EMPTY_DELETE);
-
-		for (int i = 0; i < line_content.size(); i++) {
-			LPZUP_FILENAME_DICT lpZupDict;
-			if (NULL != (lpZupDict = m_lpDictHash->add(line_content[i].c_str()))) {
-				DecodeDict(lpZupDict);
-			}
-		}
+		CTextUnitsA::Split(base_file, lpKeys, ch, LINE_EMPTY_DELETE);
 	}
 	else {
+		lpKeys.push_back(base_file);
+	}
+}
+
+void CZupClass::ReadDictKeys(LPVOID lpvoidFileRead, const PCKINDEXTABLE* lpIncIndex, std::vector<std::string> &lpKeys)
+{
+	//Read inc file
+	char	*_incbuf = (char*)malloc(lpIncIndex->cFileIndex.dwFileClearTextSize + 1);
+
+	if (NULL == _incbuf) {
+		Logger_el(TEXT_MALLOC_FAIL);
+		return;
+	}
+
+	if (CPckClass::GetSingleFileData(lpvoidFileRead, lpIncIndex, _incbuf)) {
+
+		_incbuf[lpIncIndex->cFileIndex.dwFileClearTextSize] = 0;
+		std::vector<std::string> lines;
+
+		CTextUnitsA::SplitLine(_incbuf, lines, LINE_TRIM_LEFT | LINE_TRIM_RIGHT | LINE_EMPTY_DELETE);
 
-		LPZUP_FILENAME_DICT lpZupDict;
-		if (NULL != (lpZupDict = m_lpDictHash->add(base_file.c_str()))) {
-			DecodeDict(lpZupDict);
+		for (int j = 0; j < lines.size(); j++) {
+
+			std::string& oneline = lines[j];
+			if (oneline.at(0) == '!' || oneline.at(0) == '+') {
+				std::vector<std::string> line_content;
+				CTextUnitsA::Split(oneline, line_content, " ");
+				if (1 < line_content.size())
+					AddDictKeys(line_content[1], lpKeys);
+			}
 		}
 	}
+	free(_incbuf);
 }
 
 void CZupClass::DecodeFilename(char *_dst, wchar_t *_wdst, char *_src)
@@ -69,10 +96,9 @@ void CZupClass::DecodeFilename(char *_dst, wchar_t *_wdst, char *_src)
 	//memcpy(_dst, _src, 8);
 	//_dst -> _wdst
 
-	__m128i xmm0 = _mm_setzero_si128();
-	__m128i xmm1 = _mm_loadl_epi64((__m128i*)_src);
-	__m128i xmm2 = _mm_unpacklo_epi8(xmm1, xmm0);
-	_mm_storeu_si128((__m128i*)_wdst, xmm2);
+	//wchar_t is 4 bytes on linux, widen each char instead of unpacking to 16 bit
+	for(int i = 0;i < 8;i++)
+		_wdst[i] = (unsigned char)_src[i];
 
 	_dst += 8, _src += 8, _wdst += 8;
 
@@ -110,47 +136,120 @@ void CZupClass::DecodeFilename(char *_dst, wchar_t *_wdst, char *_src)
 
 BOOL CZupClass::BuildZupBaseDict()
 {
+	//The inc files are named "v-*", 0x2D76 = "v-"
+	std::vector<const PCKINDEXTABLE*> lpIncIndexes;
 	LPPCKINDEXTABLE	lpPckIndexTable = m_PckAllInfo.lpPckIndexTable;
 
 	for(uint32_t i = 0;i < m_PckAllInfo.dwFileCount;i++) {
-		//Everything starting with element\ needs to be decoded
-		//Other direct copies
-		//"element\" = 0x6d656c65, 0x5c746e656d656c65
-		//0x2D76 = "v-"
-		if(0x2D76 == *(uint16_t*)lpPckIndexTable->cFileIndex.szFilename) {
-			//wID = atoul(lpNode->szName + 2, NULL, 10);
-			//Read inc file
-			char	*_incbuf = (char*)malloc(lpPckIndexTable->cFileIndex.dwFileClearTextSize+1);
-
-			if(NULL == _incbuf) {
-				//lpNode = lpNode->next;
-				continue;
-			}
+		if(0x2D76 == *(uint16_t*)lpPckIndexTable->cFileIndex.szFilename)
+			lpIncIndexes.push_back(lpPckIndexTable);
+		lpPckIndexTable++;
+	}
 
-			if(GetSingleFileData(lpPckIndexTable, _incbuf)) {
+	if(lpIncIndexes.empty())
+		return TRUE;
 
-				_incbuf[lpPckIndexTable->cFileIndex.dwFileClearTextSize] = 0;
-				std::vector<std::string> lines;
+	uint32_t dwThreads = std::max<uint32_t>(m_lpPckParams->dwMTThread, 1);
 
-				CTextUnitsA::SplitLine(_incbuf, lines, LINE_TRIM_LEFT | LINE_TRIM_RIGHT | LINE_EMPTY_DELETE);
-				
-				for (int j = 0; j < lines.size(); j++) {
+	//Read and split the inc files, one file per thread at a time
+	std::vector<std::vector<std::string>> lpIncKeys(lpIncIndexes.size());
+	std::atomic<size_t>	nNextInc(0);
 
-					std::string& oneline = lines[j];
-					if (oneline.at(0) == '!' || oneline.at(0) == '+') {
-						std::vector<std::string> line_content;
-						CTextUnitsA::Split(oneline, line_content, " ");
-						AddDict(line_content[1]);
-					}
-				}
-			}
-			free(_incbuf);
+	auto ReadIncFiles = [&]() {
+
+		CMapViewFileMultiPckRead	cFileRead;
+
+		if(!cFileRead.OpenPckAndMappingRead(m_PckAllInfo.szFilename)) {
+			Logger_el(UCSTEXT(TEXT_OPENNAME_FAIL), m_PckAllInfo.szFilename);
+			return;
 		}
-		lpPckIndexTable++;
+
+		size_t i;
+		while(lpIncIndexes.size() > (i = nNextInc++))
+			ReadDictKeys(&cFileRead, lpIncIndexes[i], lpIncKeys[i]);
+	};
+
+	RunDictThreads(ReadIncFiles, std::min<size_t>(dwThreads, lpIncIndexes.size()));
+
+	//Add the keys in file order, only the new ones need decoding
+	std::vector<LPZUP_FILENAME_DICT> lpNewDicts;
+
+	for(std::vector<std::string> &lpKeys : lpIncKeys) {
+		for(const std::string &szKey : lpKeys) {
+
+			LPZUP_FILENAME_DICT lpZupDict;
+			if(NULL != (lpZupDict = m_lpDictHash->add(szKey.c_str())))
+				lpNewDicts.push_back(lpZupDict);
+		}
+		std::vector<std::string>().swap(lpKeys);
+	}
+
+	//Decode the names by blocks on all threads, then store them in the dictionary
+	std::vector<std::string>	lpRealStrs(lpNewDicts.size());
+	std::vector<std::wstring>	lpwRealStrs(lpNewDicts.size());
+	std::atomic<size_t>	nNextBlock(0);
+
+	auto DecodeKeys = [&]() {
+
+		size_t nStart;
+		while(lpNewDicts.size() > (nStart = ZUP_DICT_DECODE_BLOCK * nNextBlock++)) {
+
+			size_t nEnd = std::min<size_t>(nStart + ZUP_DICT_DECODE_BLOCK, lpNewDicts.size());
+			for(size_t i = nStart;i < nEnd;i++)
+				DecodeDict(lpNewDicts[i], lpRealStrs[i], lpwRealStrs[i]);
+		}
+	};
+
+	size_t nBlocks = (lpNewDicts.size() + ZUP_DICT_DECODE_BLOCK - 1) / ZUP_DICT_DECODE_BLOCK;
+	RunDictThreads(DecodeKeys, std::min<size_t>(dwThreads, nBlocks));
+
+	for(size_t i = 0;i < lpNewDicts.size();i++) {
+		if(!lpwRealStrs[i].empty())
+			m_lpDictHash->setdecoded(lpNewDicts[i], lpRealStrs[i].c_str(), lpRealStrs[i].size(), lpwRealStrs[i].c_str(), lpwRealStrs[i].size());
+	}
+
+	return TRUE;
+}
+
+void CZupClass::RunDictThreads(const std::function<void()> &lpWorker, size_t nThreads)
+{
+	CPckTaskGroup cDictTasks((uint32_t)nThreads);
+	for(size_t i = 1;i < nThreads;++i)
+		cDictTasks.Run(lpWorker);
+
+	lpWorker();
+	cDictTasks.Wait();
+}
+
+BOOL CZupClass::GetFilesToApply(const PCK_PATH_NODE* lpFolder, vector<FILES_TO_COMPRESS> &lpFilesList)
+{
+	wchar_t		szFolder[MAX_PATH_PCK_260];
+
+	if((NULL != lpFolder) && (PCK_ENTRY_TYPE_FOLDER != (PCK_ENTRY_TYPE_FOLDER & lpFolder->entryType)))
+		return FALSE;
+
+	if(!GetCurrentNodeString(szFolder, lpFolder))
+		return FALSE;
+
+	size_t		nFolderLen = wcslen(szFolder);
+	LPPCKINDEXTABLE	lpZupIndexTable = m_lpZupIndexTable;
+
+	for(uint32_t i = 0;i < m_PckAllInfo.dwFileCount;i++, lpZupIndexTable++) {
+
+		//Only the files under element\ are packed twice, the inc files are not for the pck
+		if(0x6d656c65 != *(uint32_t*)lpZupIndexTable->cFileIndex.szFilename)
+			continue;
+
+		if(0 != wcsncmp(lpZupIndexTable->cFileIndex.szwFilename, szFolder, nFolderLen))
+			continue;
+
+		FILES_TO_COMPRESS cFile = { 0 };
+		cFile.qwFileSize = lpZupIndexTable->cFileIndex.dwFileClearTextSize;
+		cFile.lpszFilenameInPck = lpZupIndexTable->cFileIndex.szwFilename + nFolderLen;
+		cFile.lpZupSrcIndex = GetBaseFileIndex(lpZupIndexTable, m_lpZupIndexTable);
+
+		lpFilesList.push_back(cFile);
 	}
-	//if(NULL == m_lpZupDict)
-	//	return FALSE;
-	//else
 	return TRUE;
 }
 
@@ -0,0 +1,230 @@
+//////////////////////////////////////////////////////////////////////
+// ZupInflateChain.cpp: two stage decompression of the files in a zup
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "ZupInflateChain.h"
+#include "PckClassZlib.h"
+#include "zlib.h"
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#define ZUP_CHAIN_BUFFER_SIZE	(64 * 1024)
+//The size of the file in front of the inner data
+#define ZUP_SIZE_PREFIX			4
+//The size and the zlib header of the inner data
+#define ZUP_HEAD_SIZE			(ZUP_SIZE_PREFIX + 2)
+
+//Streams and buffer of one thread, reset for each file
+class CZupInflateState
+{
+public:
+	CZupInflateState() :
+		m_Buffer(ZUP_CHAIN_BUFFER_SIZE)
+	{}
+
+	~CZupInflateState()
+	{
+		if (m_isOuterInit)
+			inflateEnd(&m_cOuter);
+		if (m_isInnerInit)
+			inflateEnd(&m_cInner);
+	}
+
+	BOOL	ResetOuter() { return Reset(m_cOuter, m_isOuterInit); }
+	BOOL	ResetInner() { return Reset(m_cInner, m_isInnerInit); }
+
+	z_stream				m_cOuter;
+	z_stream				m_cInner;
+	std::vector<uint8_t>	m_Buffer;
+
+private:
+
+	BOOL Reset(z_stream &cStream, BOOL &isInit)
+	{
+		if (isInit)
+			return (Z_OK == inflateReset(&cStream));
+
+		memset(&cStream, 0, sizeof(z_stream));
+		return (isInit = (Z_OK == inflateInit(&cStream)));
+	}
+
+	BOOL	m_isOuterInit = FALSE;
+	BOOL	m_isInnerInit = FALSE;
+};
+
+static CZupInflateState& GetInflateState()
+{
+	static thread_local CZupInflateState cState;
+	return cState;
+}
+
+BOOL CZupInflateChain::Decompress(const uint8_t *lpSource, uint32_t dwSourceLen, BOOL isOuterStored, uint8_t *lpDest, ulong_t *lpdwDestLen, BOOL isInnerStored)
+{
+	ulong_t	dwDestSize = *lpdwDestLen;
+	BOOL	isOuterZlib = (2 <= dwSourceLen) && CPckClassZlib::check_zlib_header(lpSource);
+
+	CHAIN_RESULT rtn = Run(lpSource, dwSourceLen, isOuterZlib, TRUE, lpDest, lpdwDestLen);
+
+	//Stored data that only looks like a zlib stream
+	if ((CHAIN_OUTER_ERROR == rtn) && isOuterZlib && isOuterStored) {
+
+		isOuterZlib = FALSE;
+		*lpdwDestLen = dwDestSize;
+		rtn = Run(lpSource, dwSourceLen, isOuterZlib, TRUE, lpDest, lpdwDestLen);
+	}
+
+	if ((CHAIN_INNER_ERROR == rtn) && isInnerStored) {
+
+		*lpdwDestLen = dwDestSize;
+		rtn = Run(lpSource, dwSourceLen, isOuterZlib, FALSE, lpDest, lpdwDestLen);
+	}
+
+	return (CHAIN_OK == rtn);
+}
+
+CZupInflateChain::CHAIN_RESULT CZupInflateChain::Run(const uint8_t *lpSource, uint32_t dwSourceLen, BOOL isOuterZlib, BOOL isInnerAuto, uint8_t *lpDest, ulong_t *lpdwDestLen)
+{
+	CZupInflateState &cState = GetInflateState();
+	z_stream	&cOuter = cState.m_cOuter;
+	z_stream	&cInner = cState.m_cInner;
+
+	ulong_t	dwDestSize = *lpdwDestLen;
+	*lpdwDestLen = 0;
+
+	if (isOuterZlib) {
+
+		if (!cState.ResetOuter())
+			return CHAIN_OUTER_ERROR;
+
+		cOuter.next_in = (Bytef*)lpSource;
+		cOuter.avail_in = dwSourceLen;
+	}
+
+	//Output of the outer layer, a stored layer is one chunk
+	const uint8_t	*lpChunk = nullptr;
+	size_t			nChunk = 0;
+	BOOL			isOuterEnd = FALSE;
+
+	//1 - got a chunk, 0 - no more data, -1 - error
+	auto NextChunk = [&]() -> int {
+
+		if (isOuterEnd)
+			return 0;
+
+		if (!isOuterZlib) {
+			lpChunk = lpSource;
+			nChunk = dwSourceLen;
+			isOuterEnd = TRUE;
+			return 1;
+		}
+
+		cOuter.next_out = cState.m_Buffer.data();
+		cOuter.avail_out = ZUP_CHAIN_BUFFER_SIZE;
+
+		int rtn = inflate(&cOuter, Z_NO_FLUSH);
+
+		if (Z_STREAM_END == rtn)
+			isOuterEnd = TRUE;
+		//A truncated stream ends here
+		else if (Z_BUF_ERROR == rtn)
+			return 0;
+		else if (Z_OK != rtn)
+			return -1;
+
+		lpChunk = cState.m_Buffer.data();
+		nChunk = ZUP_CHAIN_BUFFER_SIZE - cOuter.avail_out;
+		return 1;
+	};
+
+	//The size and the first bytes of the inner layer
+	uint8_t	szHead[ZUP_HEAD_SIZE];
+	size_t	nHead = 0;
+
+	while (ZUP_HEAD_SIZE > nHead) {
+
+		if (0 == nChunk) {
+			int rtn = NextChunk();
+			if (0 > rtn)
+				return CHAIN_OUTER_ERROR;
+			if (0 == rtn)
+				break;
+			continue;
+		}
+
+		size_t nCopy = std::min<size_t>(nChunk, ZUP_HEAD_SIZE - nHead);
+		memcpy(szHead + nHead, lpChunk, nCopy);
+
+		nHead += nCopy;
+		lpChunk += nCopy;
+		nChunk -= nCopy;
+	}
+
+	if (ZUP_SIZE_PREFIX > nHead)
+		return CHAIN_OUTER_ERROR;
+
+	BOOL isInnerZlib = isInnerAuto && (ZUP_HEAD_SIZE == nHead) && CPckClassZlib::check_zlib_header(szHead + ZUP_SIZE_PREFIX);
+
+	if (isInnerZlib) {
+
+		if (!cState.ResetInner())
+			return CHAIN_INNER_ERROR;
+
+		cInner.next_out = lpDest;
+		cInner.avail_out = dwDestSize;
+	}
+
+	ulong_t	dwCopied = 0;
+
+	//1 - needs more data, 0 - the file is complete, -1 - error
+	auto Feed = [&](const uint8_t *lpData, size_t nData) -> int {
+
+		if (!isInnerZlib) {
+
+			size_t nCopy = std::min<size_t>(nData, dwDestSize - dwCopied);
+			memcpy(lpDest + dwCopied, lpData, nCopy);
+			dwCopied += nCopy;
+			return (dwDestSize > dwCopied) ? 1 : 0;
+		}
+
+		cInner.next_in = (Bytef*)lpData;
+		cInner.avail_in = nData;
+
+		while ((0 != cInner.avail_in) && (0 != cInner.avail_out)) {
+
+			int rtn = inflate(&cInner, Z_NO_FLUSH);
+
+			if (Z_STREAM_END == rtn)
+				return 0;
+			if (Z_OK != rtn)
+				return -1;
+		}
+		return (0 == cInner.avail_out) ? 0 : 1;
+	};
+
+	int iFeed = Feed(szHead + ZUP_SIZE_PREFIX, nHead - ZUP_SIZE_PREFIX);
+
+	while (1 == iFeed) {
+
+		if (0 == nChunk) {
+			int rtn = NextChunk();
+			if (0 > rtn)
+				return CHAIN_OUTER_ERROR;
+			if (0 == rtn)
+				break;
+			continue;
+		}
+
+		iFeed = Feed(lpChunk, nChunk);
+		nChunk = 0;
+	}
+
+	if (0 > iFeed)
+		return CHAIN_INNER_ERROR;
+
+	*lpdwDestLen = isInnerZlib ? (dwDestSize - cInner.avail_out) : dwCopied;
+	return CHAIN_OK;
+}
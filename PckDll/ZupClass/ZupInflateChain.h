@@ -0,0 +1,30 @@
+//////////////////////////////////////////////////////////////////////
+// ZupInflateChain.h: two stage decompression of the files in a zup
+//
+// The data of a file under element\ is a pck entry holding the size of
+// the file in 4 bytes and then the file compressed again. The output of
+// the outer inflate goes to the inner one through a small buffer, so the
+// file is decompressed in one pass without a copy of the middle layer.
+// The streams and the buffer are kept per thread
+//
+// This code is open source. Please retain the original author information for any modified release based on this code.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "PckDefines.h"
+
+class CZupInflateChain
+{
+public:
+
+	//lpSource is the data of the pck entry, isOuterStored/isInnerStored: the layer may be stored as is if inflating it fails
+	//*lpdwDestLen is the size to get and receives the size got
+	static BOOL	Decompress(const uint8_t *lpSource, uint32_t dwSourceLen, BOOL isOuterStored, uint8_t *lpDest, ulong_t *lpdwDestLen, BOOL isInnerStored);
+
+private:
+
+	typedef enum { CHAIN_OK, CHAIN_OUTER_ERROR, CHAIN_INNER_ERROR } CHAIN_RESULT;
+
+	static CHAIN_RESULT	Run(const uint8_t *lpSource, uint32_t dwSourceLen, BOOL isOuterZlib, BOOL isInnerAuto, uint8_t *lpDest, ulong_t *lpdwDestLen);
+};
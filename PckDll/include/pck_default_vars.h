@@ -79,13 +79,26 @@ typedef char *				LPSTR;
 #define PCK_ERR_VIEW			5	/* View failed */
 #define PCK_ERR_OPENMAPVIEWR	6	/* OpenMappingViewAllRead failed */
 #define PCK_ERR_MALLOC			7	/* Memory request failed */
+#define PCK_ERR_NOT_FILE		8	/* Entry is a folder or empty */
 
 /* end-of-error-codes */
 
+//Stages of a task, TaskStageCallback
+#define PCK_STAGE_IDLE			0
+#define PCK_STAGE_COMPRESS		1	/* Files are compressed into the pck */
+#define PCK_STAGE_COPY			2	/* Data is copied to a rebuilt pck */
+#define PCK_STAGE_EXTRACT		3
+#define PCK_STAGE_WRITE_INDEX	4
+#define PCK_STAGE_VERIFY		5	/* Files are decompressed and checked */
+
+//pck_waitForTask
+#define PCK_WAIT_INFINITE		0xffffffff
+
 //The length of the string used when converting numbers to characters
 #define CHAR_NUM_LEN 12
 
 #define	MAX_INDEXTABLE_CLEARTEXT_LENGTH	0x120
+#define MAX_HEAD_LENGTH					12
 #define MAX_TAIL_LENGTH					300
 
 #define	PCK_BEGINCOMPRESS_SIZE			20
@@ -102,5 +115,32 @@ typedef char *				LPSTR;
 #define PCK_ENTRY_TYPE_TAIL_INDEX		0x80000000
 //#define PCK_ENTRY_TYPE_TAIL_INDEX		0x100000000
 
+//Data area layout when rebuilding/recompressing
+#define PCK_LAYOUT_ORIGINAL				0	//Keep the order of the source index
+#define PCK_LAYOUT_BY_DIRECTORY			1	//Files of the same directory are stored next to each other
+#define PCK_LAYOUT_BY_EXTENSION			2	//Files of the same type are stored next to each other
+#define PCK_LAYOUT_ACCESS_LIST			3	//Order by an access list file (one path per line), unlisted files follow
+#define PCK_LAYOUT_MAX					PCK_LAYOUT_ACCESS_LIST
+
+//Search by name, one type, optionally | PCK_SEARCH_IGNORE_CASE
+#define PCK_SEARCH_SUBSTRING			0	//The name contains the string
+#define PCK_SEARCH_GLOB					1	//The whole name matches a pattern with '*' and '?'
+#define PCK_SEARCH_REGEX				2	//ECMAScript regular expression found in the name
+#define PCK_SEARCH_TYPE_MASK			0x0f
+#define PCK_SEARCH_IGNORE_CASE			0x10
+
+//Operation of pck_runBatch, the output of a.pck is lpszDestDirectory/a.pck, for extract lpszDestDirectory/a
+#define PCK_BATCH_VERIFY				0	//Decompress every file, nothing is written
+#define PCK_BATCH_EXTRACT				1	//All files, or lpszPathInPck only
+#define PCK_BATCH_REBUILD				2	//Copy the data, lpszScriptFile filters the files
+#define PCK_BATCH_RECOMPRESS			3	//Recompress the data, lpszScriptFile filters the files
+#define PCK_BATCH_STRIP					4	//iStripFlag = PCK_STRIP_*
+#define PCK_BATCH_MAX					PCK_BATCH_STRIP
+
+//Origin of pck_vfsSeek, the same as SEEK_SET/SEEK_CUR/SEEK_END
+#define PCK_SEEK_SET					0
+#define PCK_SEEK_CUR					1
+#define PCK_SEEK_END					2
+
 #define	PCK_ADDITIONAL_KEY				"Angelica File Package"
 #define	PCK_ADDITIONAL_INFO				PCK_ADDITIONAL_KEY", Perfect World Co. Ltd. 2002~2008. All Rights Reserved.\r\nCreated by WinPCK v" WINPCK_VERSION  
@@ -7,6 +7,17 @@
 typedef void(*SHOW_LIST_CALLBACK)(void*, int32_t, const wchar_t *, int32_t, uint64_t, uint64_t, void*);
 typedef int32_t(*FeedbackCallback)(void* pTag, int32_t eventId, size_t wParam, ssize_t lParam);
 
+//Events of a task, called on the threads of the task and never at the same time
+//Progress changed, at most once per interval and once when the stage or task ends
+typedef void(*TaskProgressCallback)(void* pTag, uint32_t dwProgress, uint32_t dwProgressUpper);
+//A stage of the task started, PCK_STAGE_*
+typedef void(*TaskStageCallback)(void* pTag, int32_t iStage);
+//The task ended, iResult is PCK_OK or the error, PCK_MSG_USERCANCELED when it was stopped
+typedef void(*TaskCompleteCallback)(void* pTag, int32_t iResult);
+
+//An archive of pck_runBatch ended, iIndex in the list of files, iResult is WINPCK_OK or the error
+typedef void(*BatchItemCallback)(void* pTag, int32_t iIndex, int32_t iResult);
+
 //Log echo callback function
 typedef void(*ShowLogA)(const char log_level, const char *str);
 typedef void(*ShowLogW)(const char log_level, const wchar_t *str);
@@ -18,3 +29,25 @@ typedef struct _PCK_UNIFIED_FILEENTRY {
 
 typedef PCK_UNIFIED_FILE_ENTRY*			LPENTRY;
 typedef const PCK_UNIFIED_FILE_ENTRY*	LPCENTRY;
+
+//One entry of pck_listByNodeToArray/pck_searchByNameToArray, the same values as SHOW_LIST_CALLBACK
+typedef struct _PCK_LIST_RECORD {
+	void*			fileEntry;
+	uint64_t		qwFileSize;
+	uint64_t		qwFileSizeCompressed;
+	int32_t			entryType;
+	uint32_t		dwNameOffset;	//Offset of the name in the name buffer, in wchar_t
+	uint32_t		dwNameLength;	//Length of the name without the terminating 0, in wchar_t
+	uint32_t		dwReserved;
+}PCK_LIST_RECORD, *LPPCK_LIST_RECORD;
+
+//Parameters of pck_runBatch
+typedef struct _PCK_BATCH_PARAMS {
+	int32_t			iOperation;			//PCK_BATCH_*
+	const wchar_t*	lpszDestDirectory;	//Not used by PCK_BATCH_VERIFY
+	const wchar_t*	lpszPathInPck;		//PCK_BATCH_EXTRACT, NULL for all files
+	const wchar_t*	lpszScriptFile;		//PCK_BATCH_REBUILD/PCK_BATCH_RECOMPRESS, NULL for no filter
+	int32_t			iStripFlag;			//PCK_BATCH_STRIP
+	uint32_t		dwThreads;			//Threads of the whole batch, 0 - one per processor the process may use
+	uint32_t		dwCompressLevel;	//0 - default
+}PCK_BATCH_PARAMS, *LPPCK_BATCH_PARAMS;
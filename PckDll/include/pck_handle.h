@@ -106,6 +106,15 @@ WINPCK_API PCKRTN		do_RenameEntry(LPCWSTR  szPckFile, LPCWSTR lpFullPathToRename
 
 //Preview file
 WINPCK_API PCKRTN		pck_GetSingleFileData(LPCENTRY lpFileEntry, LPSTR _inout_buffer, size_t _in_sizeOfBuffer = 0);
+//Up to _in_size decompressed bytes of the file from qwOffset, the bytes read or -1.
+//With checkpoints (pck_setCheckpointInterval) a read deep in a large file inflates at most one interval
+WINPCK_API int64_t		pck_GetFileDataAt(LPCENTRY lpFileEntry, uint64_t qwOffset, LPSTR _out_buffer, size_t _in_size);
+//Preview many files in one call, they are decompressed in parallel without opening the pck for every file.
+//_inout_buffers[i] receives lpFileEntryArray[i], the buffers can be slices of one arena.
+//_in_sizeOfBuffers can be NULL when every buffer holds the whole file, a size of 0 is the same as in pck_GetSingleFileData.
+//_out_status[i] = WINPCK_OK, WINPCK_NOTFOUND (folder or NULL entry/buffer) or WINPCK_ERROR, can be NULL.
+//return WINPCK_OK when all files were read
+WINPCK_API PCKRTN		pck_GetBatchFileData(LPCENTRY* lpFileEntryArray, int nEntryCount, LPSTR* _inout_buffers, const size_t* _in_sizeOfBuffers, PCKRTN* _out_status);
 
 //unzip files
 WINPCK_API PCKRTN		pck_ExtractFilesByEntrys(LPCENTRY* lpFileEntryArray, int nEntryCount, LPCWSTR  lpszDestDirectory);
@@ -119,6 +128,9 @@ WINPCK_API PCKRTN		pck_RebuildPckFile(LPCWSTR szRebuildPckFile, BOOL bUseRecompr
 //set lpszScriptFile = NULL to disable Script filter function
 WINPCK_API PCKRTN		pck_RebuildPckFileWithScript(LPCWSTR  lpszScriptFile, LPCWSTR szRebuildPckFile, BOOL bUseRecompress);
 WINPCK_API PCKRTN		do_RebuildPckFileWithScript(LPCWSTR szSrcPckFile, LPCWSTR  lpszScriptFile, LPCWSTR szDstRebuildPckFile, BOOL bUseRecompress, int level = 9);
+//Data area layout of rebuild/recompress, iLayout = PCK_LAYOUT_*, lpszListFile is only used by PCK_LAYOUT_ACCESS_LIST
+WINPCK_API PCKRTN		pck_setRebuildLayout(int iLayout, LPCWSTR lpszListFile = NULL);
+WINPCK_API int			pck_getRebuildLayout();
 //Game streamlined
 WINPCK_API PCKRTN		pck_StripPck(LPCWSTR szStripedPckFile, int flag);
 WINPCK_API PCKRTN		do_StripPck(LPCWSTR szSrcPckFile, LPCWSTR szStripedPckFile, int flag, int level);
@@ -126,11 +138,21 @@ WINPCK_API PCKRTN		do_StripPck(LPCWSTR szSrcPckFile, LPCWSTR szStripedPckFile, i
 //Create and update pck files
 WINPCK_API void			pck_StringArrayReset();
 WINPCK_API void			pck_StringArrayAppend(LPCWSTR  lpszFilePath);
+//When szPckFile is the opened pck, its entries and folders have the added files afterwards without opening it again,
+//entries of the index type got before are no longer valid, the folder and file entries stay valid.
+//pck_IsValidPck() is FALSE if the pck has to be opened again
 WINPCK_API PCKRTN		pck_UpdatePckFileSubmit(LPCWSTR  szPckFile, LPCENTRY lpFileEntry);
 //Add files to pck
 WINPCK_API PCKRTN		do_AddFileToPckFile(LPCWSTR  lpszFilePathSrc, LPCWSTR  szDstPckFile, LPCWSTR  lpszPathInPckToAdd, int level = 9);
 //Create new pck file
 WINPCK_API PCKRTN		do_CreatePckFile(LPCWSTR  lpszFilePathSrc, LPCWSTR  szDstPckFile, int _versionId = 0, int level = 9);
+//Add the files under lpszZupFolder of a zup/cup to the opened pck under lpFileEntry, without extracting them
+//lpszZupFolder = NULL or "" for all files, the names in pck are relative to the folder, e.g. "element" for a pck of the client
+//The opened pck has the added files afterwards as with pck_UpdatePckFileSubmit
+//A zlib stream in the zup is kept as it is when its header names the same level class as the compress level.
+//The header only has 4 classes (0-1, 2-5, 6, 7 and above), so e.g. a stream of level 7 is kept with level 9
+WINPCK_API PCKRTN		pck_ApplyZupSubmit(LPCWSTR  szPckFile, LPCWSTR  szZupFile, LPCWSTR  lpszZupFolder, LPCENTRY lpFileEntry);
+WINPCK_API PCKRTN		do_ApplyZupToPck(LPCWSTR  szZupFile, LPCWSTR  lpszZupFolder, LPCWSTR  szDstPckFile, LPCWSTR  lpszPathInPckToAdd, int level = 9);
 
 //Delete a node and apply changes via commit
 WINPCK_API PCKRTN		pck_DeleteEntry(LPCENTRY lpFileEntry);
@@ -144,6 +166,13 @@ WINPCK_API PCKRTN		do_DeleteFromPck(LPCWSTR  szSrcPckFile, int count, ...);
 WINPCK_API uint32_t		pck_searchByName(LPCWSTR  lpszSearchString, void* _in_param, SHOW_LIST_CALLBACK showListCallback);
 WINPCK_API uint32_t		pck_listByNode(LPCENTRY lpFileEntry, void* _in_param, SHOW_LIST_CALLBACK _showListCallback);
 WINPCK_API PCKRTN		do_listPathInPck(LPCWSTR  szSrcPckFile, LPCWSTR  lpszListPath, void* _in_param, SHOW_LIST_CALLBACK _showListCallback);
+//The same lists filled into arrays in one call, entries dwOffset .. dwOffset + return value - 1
+//Names are stored 0 terminated in _out_names, dwMaxRecords * MAX_PATH_PCK_260 wchar_t always holds a full page
+//The page ends early when _out_names is full, _out_total = count of all entries, _out_records = NULL only counts them
+//The next page of a folder of the opened pck goes on from where the last one ended, the results of the last search are kept for its pages
+//Folders of a handle or an overlay are walked from the first entry, pckh_listByNodeToArray/pcko_listByNodeToArray page them from where they ended
+WINPCK_API uint32_t		pck_listByNodeToArray(LPCENTRY lpFileEntry, uint32_t dwOffset, uint32_t dwMaxRecords, PCK_LIST_RECORD* _out_records, wchar_t* _out_names, uint32_t dwNamesChars, uint32_t* _out_total);
+WINPCK_API uint32_t		pck_searchByNameToArray(LPCWSTR lpszSearchString, uint32_t dwOffset, uint32_t dwMaxRecords, PCK_LIST_RECORD* _out_records, wchar_t* _out_names, uint32_t dwNamesChars, uint32_t* _out_total);
 
 //multi-threaded tasks
 //yes -1, no - 0
@@ -151,6 +180,15 @@ WINPCK_API BOOL			pck_isThreadWorking();
 WINPCK_API void			pck_forceBreakThreadWorking();
 WINPCK_API BOOL			pck_isLastOptSuccess();
 WINPCK_API BOOL			pck_getLastErrorMsg();
+//Events of the tasks instead of polling pck_getUIProgress and pck_isThreadWorking, NULL callbacks are not called
+//dwProgressIntervalMs - the least time between two progress events. WINPCK_WORKING if a task is running
+WINPCK_API PCKRTN		pck_regTaskCallbacks(void* pTag, TaskProgressCallback _ProgressCallBack, TaskStageCallback _StageCallBack, TaskCompleteCallback _CompleteCallBack, uint32_t dwProgressIntervalMs);
+//PCK_STAGE_* of the running task
+WINPCK_API int32_t		pck_getTaskStage();
+//Wait up to dwMilliseconds (PCK_WAIT_INFINITE) for the running task to end, TRUE if no task is running
+//A task counts as running from the call of its function (extract, verify, rebuild, strip, update, apply zup)
+//to its return, also before its threads started
+WINPCK_API BOOL			pck_waitForTask(uint32_t dwMilliseconds);
 
 //Memory usage
 WINPCK_API uint32_t		pck_getMTMemoryUsed();
@@ -166,6 +204,19 @@ WINPCK_API uint32_t		pck_getMaxCompressLevel();
 WINPCK_API uint32_t		pck_getDefaultCompressLevel();
 WINPCK_API uint32_t		pck_getCompressLevel();
 WINPCK_API void			pck_setCompressLevel(uint32_t dwCompressLevel);
+//Mode of pck_searchByName/pck_searchByNameToArray, PCK_SEARCH_* (default PCK_SEARCH_SUBSTRING)
+WINPCK_API int			pck_getSearchMode();
+WINPCK_API PCKRTN		pck_setSearchMode(int iSearchMode);
+//Cache of decompressed data for pck_GetSingleFileData, 0 - disabled (default)
+WINPCK_API uint32_t		pck_getDataCacheSize();
+WINPCK_API void			pck_setDataCacheSize(uint32_t dwCacheSizeInBytes);
+//Random access checkpoints of the large compressed files, one every dwIntervalInBytes of decompressed data
+//(at least 256KB, 0 - disabled, the default). They are made while a file is read through pck_GetFileDataAt or
+//a virtual file and shared by all readers, each one keeps 32KB of data. pck_saveCheckpointIndex writes them to
+//<pck>.ckpt, they are loaded from there by the first read while the pck keeps its size
+WINPCK_API uint32_t		pck_getCheckpointInterval();
+WINPCK_API void			pck_setCheckpointInterval(uint32_t dwIntervalInBytes);
+WINPCK_API PCKRTN		pck_saveCheckpointIndex();
 //schedule
 WINPCK_API uint32_t		pck_getUIProgress();
 WINPCK_API void			pck_setUIProgress(uint32_t dwUIProgress);
@@ -180,7 +231,12 @@ WINPCK_API uint32_t		pck_getUpdateResult_DuplicateFileCount();
 WINPCK_API uint32_t		pck_getUpdateResult_FinalFileCount();
 
 //log
+//While a task runs the callback is called by a log thread of the dll, one message at a time, otherwise by the thread that logs.
+//A UI has to pass the message to its own thread, the text is only valid during the call
 WINPCK_API void			log_regShowFunc(ShowLogW _ShowLogCallBack);
+//Messages below the level ('D', 'I', 'N', 'W', 'E') are not formatted, 'D' shows all
+WINPCK_API void			log_setLevel(char chLevel);
+WINPCK_API char			log_getLevel();
 
 WINPCK_API void			pck_logNA(LPCSTR  _fmt, ...);
 WINPCK_API void			pck_logNW(LPCWSTR  _fmt, ...);
@@ -211,9 +267,141 @@ WINPCK_API void			pck_logDW(LPCWSTR  _fmt, ...);
 #define pck_logD pck_logDA
 #endif
 
+//Stage timing of create, add, rebuild, extract and index work
+//Counting restarts from zero on every start, a Chrome trace is written to lpszTraceFile on stop if it is not NULL.
+//Setting the environment variable WINPCK_TRACE to a file name starts profiling with a trace when the library is loaded
+WINPCK_API void			pck_startProfile(const wchar_t *lpszTraceFile = NULL);
+//return FALSE if profiling was not started or the trace could not be written
+WINPCK_API BOOL			pck_stopProfile();
+WINPCK_API uint32_t		pck_getProfileStageCount();
+WINPCK_API LPCSTR		pck_getProfileStageName(uint32_t dwStage);
+//Sums of all threads, the time in nanoseconds
+WINPCK_API BOOL			pck_getProfileStage(uint32_t dwStage, uint64_t *lpqwNanoseconds, uint64_t *lpqwCount, uint64_t *lpqwBytes);
+
 //Open, close, restore and other event registration
 WINPCK_API void			pck_regMsgFeedback(void* pTag, FeedbackCallback _FeedbackCallBack);
 
+//Handle based interface
+//Every handle owns one opened pck/zup, so several files can be opened at the same time.
+//Calls on different handles never block each other. Queries, preview and search on one handle
+//can be made from several threads at once, tasks with progress (extract, rebuild, strip) run one at a time per handle.
+//Rebuild and strip change the loaded index while they run, the other calls on the handle wait for them.
+//Entries returned by a handle stay valid until pckh_close, the pck_getXxxInEntry/pck_listByNode/pck_listByNodeToArray functions accept them.
+typedef struct _PCK_HANDLE *PCKHANDLE;
+
+//return NULL if the file can not be opened
+WINPCK_API PCKHANDLE	pckh_open(const wchar_t *lpszFile);
+//Stop the running task of the handle, wait for it and release the handle
+WINPCK_API PCKRTN		pckh_close(PCKHANDLE hPck);
+
+WINPCK_API BOOL			pckh_IsValidPck(PCKHANDLE hPck);
+WINPCK_API int			pckh_getVersion(PCKHANDLE hPck);
+WINPCK_API PCKRTN		pckh_setVersion(PCKHANDLE hPck, int verID);
+WINPCK_API LPCWSTR		pckh_GetCurrentVersionName(PCKHANDLE hPck);
+WINPCK_API LPCSTR		pckh_GetAdditionalInfo(PCKHANDLE hPck);
+
+WINPCK_API uint64_t		pckh_filesize(PCKHANDLE hPck);
+WINPCK_API uint64_t		pckh_file_data_area_size(PCKHANDLE hPck);
+WINPCK_API uint64_t		pckh_file_redundancy_data_size(PCKHANDLE hPck);
+WINPCK_API uint32_t		pckh_filecount(PCKHANDLE hPck);
+
+WINPCK_API LPCENTRY		pckh_getRootNode(PCKHANDLE hPck);
+WINPCK_API LPCENTRY		pckh_getFileEntryByPath(PCKHANDLE hPck, LPCWSTR lpszPathInPck);
+
+WINPCK_API PCKRTN		pckh_GetSingleFileData(PCKHANDLE hPck, LPCENTRY lpFileEntry, LPSTR _inout_buffer, size_t _in_sizeOfBuffer = 0);
+WINPCK_API int64_t		pckh_GetFileDataAt(PCKHANDLE hPck, LPCENTRY lpFileEntry, uint64_t qwOffset, LPSTR _out_buffer, size_t _in_size);
+WINPCK_API PCKRTN		pckh_GetBatchFileData(PCKHANDLE hPck, LPCENTRY* lpFileEntryArray, int nEntryCount, LPSTR* _inout_buffers, const size_t* _in_sizeOfBuffers, PCKRTN* _out_status);
+WINPCK_API uint32_t		pckh_searchByName(PCKHANDLE hPck, LPCWSTR lpszSearchString, void* _in_param, SHOW_LIST_CALLBACK _showListCallback);
+WINPCK_API uint32_t		pckh_listByNodeToArray(PCKHANDLE hPck, LPCENTRY lpFileEntry, uint32_t dwOffset, uint32_t dwMaxRecords, PCK_LIST_RECORD* _out_records, wchar_t* _out_names, uint32_t dwNamesChars, uint32_t* _out_total);
+WINPCK_API uint32_t		pckh_searchByNameToArray(PCKHANDLE hPck, LPCWSTR lpszSearchString, uint32_t dwOffset, uint32_t dwMaxRecords, PCK_LIST_RECORD* _out_records, wchar_t* _out_names, uint32_t dwNamesChars, uint32_t* _out_total);
+
+WINPCK_API PCKRTN		pckh_ExtractFilesByEntrys(PCKHANDLE hPck, LPCENTRY* lpFileEntryArray, int nEntryCount, LPCWSTR lpszDestDirectory);
+WINPCK_API PCKRTN		pckh_ExtractAllFiles(PCKHANDLE hPck, LPCWSTR lpszDestDirectory);
+WINPCK_API PCKRTN		pckh_RebuildPckFileWithScript(PCKHANDLE hPck, LPCWSTR lpszScriptFile, LPCWSTR szRebuildPckFile, BOOL bUseRecompress);
+WINPCK_API PCKRTN		pckh_setRebuildLayout(PCKHANDLE hPck, int iLayout, LPCWSTR lpszListFile = NULL);
+WINPCK_API PCKRTN		pckh_StripPck(PCKHANDLE hPck, LPCWSTR szStripedPckFile, int flag);
+
+//Parameters of the tasks of the handle
+WINPCK_API void			pckh_setMaxThread(PCKHANDLE hPck, uint32_t dwThread);
+WINPCK_API void			pckh_setCompressLevel(PCKHANDLE hPck, uint32_t dwCompressLevel);
+WINPCK_API void			pckh_setMTMaxMemory(PCKHANDLE hPck, uint32_t dwMTMaxMemoryInBytes);
+WINPCK_API void			pckh_setDataCacheSize(PCKHANDLE hPck, uint32_t dwCacheSizeInBytes);
+WINPCK_API void			pckh_setCheckpointInterval(PCKHANDLE hPck, uint32_t dwIntervalInBytes);
+WINPCK_API PCKRTN		pckh_saveCheckpointIndex(PCKHANDLE hPck);
+WINPCK_API PCKRTN		pckh_setSearchMode(PCKHANDLE hPck, int iSearchMode);
+
+//State of the running task, can be called while the task is running
+WINPCK_API BOOL			pckh_isThreadWorking(PCKHANDLE hPck);
+WINPCK_API void			pckh_forceBreakThreadWorking(PCKHANDLE hPck);
+WINPCK_API BOOL			pckh_isLastOptSuccess(PCKHANDLE hPck);
+WINPCK_API uint32_t		pckh_getUIProgress(PCKHANDLE hPck);
+WINPCK_API uint32_t		pckh_getUIProgressUpper(PCKHANDLE hPck);
+WINPCK_API PCKRTN		pckh_regTaskCallbacks(PCKHANDLE hPck, void* pTag, TaskProgressCallback _ProgressCallBack, TaskStageCallback _StageCallBack, TaskCompleteCallback _CompleteCallBack, uint32_t dwProgressIntervalMs);
+WINPCK_API int32_t		pckh_getTaskStage(PCKHANDLE hPck);
+WINPCK_API BOOL			pckh_waitForTask(PCKHANDLE hPck, uint32_t dwMilliseconds);
+
+//Batch of archives
+//One operation on many pck files at the same time, each archive is opened on its own.
+//The archives share dwThreads threads: the largest start first with the larger share, the smaller ones
+//fill the threads that are left. Returns when all archives ended, WINPCK_OK if all of them succeeded.
+//_ItemCallBack is called when an archive ended, never at the same time, it may be NULL.
+//_out_status[i] receives the result of lpszPckFiles[i], WINPCK_INVALIDPCK if it could not be opened, it may be NULL.
+WINPCK_API PCKRTN		pck_runBatch(const PCK_BATCH_PARAMS* lpParams, LPCWSTR* lpszPckFiles, int nFileCount, void* pTag, BatchItemCallback _ItemCallBack, PCKRTN* _out_status);
+
+//Overlay of archives
+//A base pck and the patches over it mounted in order, a file of a later archive replaces the file
+//of the same path in the earlier ones. Paths are compared without case, a file replaces a folder of
+//the same path and the other way around. Lookups take one probe of the merged index, listing and reading
+//go straight to the archive that holds the file. The overlay can not be changed, it can be used from several threads.
+//Entries of an overlay stay valid until pcko_close, the pck_getXxxInEntry/pck_getNodeRelativePath/pck_listByNode/pck_listByNodeToArray functions accept them.
+typedef struct _PCK_OVERLAY *PCKOVERLAY;
+
+//lpszPckFiles[0] is the base archive, return NULL if one of the files can not be opened
+WINPCK_API PCKOVERLAY	pcko_open(LPCWSTR* lpszPckFiles, int nFileCount);
+WINPCK_API PCKRTN		pcko_close(PCKOVERLAY hOverlay);
+
+WINPCK_API uint32_t		pcko_getLayerCount(PCKOVERLAY hOverlay);
+WINPCK_API LPCWSTR		pcko_getLayerFile(PCKOVERLAY hOverlay, uint32_t dwLayer);
+//Files the game sees
+WINPCK_API uint32_t		pcko_filecount(PCKOVERLAY hOverlay);
+
+WINPCK_API LPCENTRY		pcko_getRootNode(PCKOVERLAY hOverlay);
+//Pages of a folder of the overlay, see pck_listByNodeToArray
+WINPCK_API uint32_t		pcko_listByNodeToArray(PCKOVERLAY hOverlay, LPCENTRY lpFileEntry, uint32_t dwOffset, uint32_t dwMaxRecords, PCK_LIST_RECORD* _out_records, wchar_t* _out_names, uint32_t dwNamesChars, uint32_t* _out_total);
+WINPCK_API LPCENTRY		pcko_getFileEntryByPath(PCKOVERLAY hOverlay, LPCWSTR lpszPathInPck);
+//Layer the file is read from, for a folder the last layer that has it, -1 on error
+WINPCK_API int32_t		pcko_getEntryLayer(PCKOVERLAY hOverlay, LPCENTRY lpFileEntry);
+
+WINPCK_API PCKRTN		pcko_GetSingleFileData(PCKOVERLAY hOverlay, LPCENTRY lpFileEntry, LPSTR _inout_buffer, size_t _in_sizeOfBuffer = 0);
+WINPCK_API PCKRTN		pcko_ExtractFilesByEntrys(PCKOVERLAY hOverlay, LPCENTRY* lpFileEntryArray, int nEntryCount, LPCWSTR lpszDestDirectory);
+WINPCK_API PCKRTN		pcko_ExtractAllFiles(PCKOVERLAY hOverlay, LPCWSTR lpszDestDirectory);
+
+//Virtual files
+//A file of a pck, a handle or an overlay read and seeked like a file on disk, without decompressing all of it.
+//The data is inflated while it is read through a small read-ahead buffer, large compressed files remember
+//checkpoints while they are read so a seek restarts near the position instead of at the start of the file.
+//The files of a pck or a handle share the checkpoints of pck_setCheckpointInterval/pckh_setCheckpointInterval.
+//An opened virtual file does not use the pck, handle or overlay any more and stays valid after they are closed.
+//One virtual file is used by one thread at a time, open the file again to read it from several threads.
+typedef struct _PCK_VFILE *PCKVFILE;
+
+//return NULL if the path is not a file or it can not be read
+WINPCK_API PCKVFILE		pck_vfsOpen(LPCWSTR lpszPathInPck);
+WINPCK_API PCKVFILE		pck_vfsOpenEntry(LPCENTRY lpFileEntry);
+WINPCK_API PCKVFILE		pckh_vfsOpen(PCKHANDLE hPck, LPCWSTR lpszPathInPck);
+WINPCK_API PCKVFILE		pckh_vfsOpenEntry(PCKHANDLE hPck, LPCENTRY lpFileEntry);
+WINPCK_API PCKVFILE		pcko_vfsOpen(PCKOVERLAY hOverlay, LPCWSTR lpszPathInPck);
+WINPCK_API PCKVFILE		pcko_vfsOpenEntry(PCKOVERLAY hOverlay, LPCENTRY lpFileEntry);
+WINPCK_API PCKRTN		pck_vfsClose(PCKVFILE hFile);
+
+//Bytes read, 0 at the end of the file, -1 on error
+WINPCK_API int64_t		pck_vfsRead(PCKVFILE hFile, void* _out_buffer, size_t _in_size);
+//iOrigin = PCK_SEEK_SET, PCK_SEEK_CUR or PCK_SEEK_END, return the new position or -1, a position after the end is allowed
+WINPCK_API int64_t		pck_vfsSeek(PCKVFILE hFile, int64_t iOffset, int iOrigin);
+WINPCK_API uint64_t		pck_vfsTell(PCKVFILE hFile);
+//Decompressed size of the file
+WINPCK_API uint64_t		pck_vfsSize(PCKVFILE hFile);
+
 #endif //WINPCK_DLL_H
 
 
@@ -1,5 +1,6 @@
 #include "pck_handle.h"
 #include "PckControlCenter.h"
+#include "PckClassProfiler.h"
 #include "PckDefines.h"
 #include <thread>
 
@@ -317,6 +318,73 @@ WINPCK_API PCKRTN pck_GetSingleFileData(LPCENTRY lpFileEntry, LPSTR _inout_buffe
 	return this_handle.GetSingleFileData(lpFileEntry, _inout_buffer, _in_sizeOfBuffer) ? WINPCK_OK : WINPCK_ERROR;
 }
 
+WINPCK_API int64_t pck_GetFileDataAt(LPCENTRY lpFileEntry, uint64_t qwOffset, LPSTR _out_buffer, size_t _in_size)
+{
+	if ((NULL == _out_buffer) || !checkIfValidPck() || checkIfWorking())
+		return -1;
+
+	return this_handle.GetFileDataAt(lpFileEntry, qwOffset, _out_buffer, _in_size);
+}
+
+//Shared by pck_GetBatchFileData and pckh_GetBatchFileData
+PCKRTN GetBatchFileDataByCenter(CPckControlCenter &cCenter, LPCENTRY* lpFileEntryArray, int nEntryCount, LPSTR* _inout_buffers, const size_t* _in_sizeOfBuffers, PCKRTN* _out_status)
+{
+	if (0 >= nEntryCount)
+		return WINPCK_OK;
+
+	std::vector<int> status(nEntryCount, PCK_ERROR);
+
+	uint32_t dwSuccessCount = cCenter.GetBatchFileData(lpFileEntryArray, nEntryCount, _inout_buffers, _in_sizeOfBuffers, status.data());
+
+	if (NULL != _out_status) {
+		for (int i = 0; i < nEntryCount; i++) {
+			switch (status[i]) {
+			case PCK_OK:
+				_out_status[i] = WINPCK_OK;
+				break;
+			case PCK_ERR_NOT_FILE:
+				_out_status[i] = WINPCK_NOTFOUND;
+				break;
+			default:
+				_out_status[i] = WINPCK_ERROR;
+				break;
+			}
+		}
+	}
+
+	return (nEntryCount == dwSuccessCount) ? WINPCK_OK : WINPCK_ERROR;
+}
+
+WINPCK_API PCKRTN pck_GetBatchFileData(LPCENTRY* lpFileEntryArray, int nEntryCount, LPSTR* _inout_buffers, const size_t* _in_sizeOfBuffers, PCKRTN* _out_status)
+{
+	if (!checkIfValidPck())
+		return WINPCK_INVALIDPCK;
+
+	if (checkIfWorking())
+		return WINPCK_WORKING;
+
+	return GetBatchFileDataByCenter(this_handle, lpFileEntryArray, nEntryCount, _inout_buffers, _in_sizeOfBuffers, _out_status);
+}
+
+//pck_handle_vfs.cpp
+PCKVFILE OpenVirtualFileByCenter(CPckControlCenter &cCenter, LPCENTRY lpFileEntry);
+
+WINPCK_API PCKVFILE pck_vfsOpen(LPCWSTR lpszPathInPck)
+{
+	if ((NULL == lpszPathInPck) || !checkIfValidPck() || checkIfWorking())
+		return NULL;
+
+	return OpenVirtualFileByCenter(this_handle, this_handle.GetFileEntryByPath(lpszPathInPck));
+}
+
+WINPCK_API PCKVFILE pck_vfsOpenEntry(LPCENTRY lpFileEntry)
+{
+	if (!checkIfValidPck() || checkIfWorking())
+		return NULL;
+
+	return OpenVirtualFileByCenter(this_handle, lpFileEntry);
+}
+
 //unzip files
 WINPCK_API PCKRTN	pck_ExtractFilesByEntrys(LPCENTRY* lpFileEntryArray, int nEntryCount, LPCWSTR lpszDestDirectory)
 {
@@ -431,6 +499,19 @@ WINPCK_API PCKRTN do_RebuildPckFileWithScript(LPCWSTR szSrcPckFile, LPCWSTR lpsz
 	return rtn ? WINPCK_OK : WINPCK_ERROR;
 }
 
+WINPCK_API PCKRTN	pck_setRebuildLayout(int iLayout, LPCWSTR lpszListFile)
+{
+	if (checkIfWorking())
+		return WINPCK_WORKING;
+
+	return this_handle.setRebuildLayout(iLayout, lpszListFile) ? WINPCK_OK : WINPCK_ERROR;
+}
+
+WINPCK_API int	pck_getRebuildLayout()
+{
+	return this_handle.getRebuildLayout();
+}
+
 //Game streamlined
 WINPCK_API PCKRTN pck_StripPck(LPCWSTR szStripedPckFile, int flag)
 {
@@ -530,6 +611,41 @@ WINPCK_API PCKRTN	do_CreatePckFile(LPCWSTR lpszFilePathSrc, LPCWSTR szPckFile, i
 	return rtn ? WINPCK_OK : WINPCK_ERROR;
 }
 
+WINPCK_API PCKRTN	pck_ApplyZupSubmit(LPCWSTR szPckFile, LPCWSTR szZupFile, LPCWSTR lpszZupFolder, LPCENTRY lpFileEntry)
+{
+	if (checkIfWorking())
+		return WINPCK_WORKING;
+
+	return this_handle.ApplyZupSubmit(szPckFile, szZupFile, lpszZupFolder, lpFileEntry) ? WINPCK_OK : WINPCK_ERROR;
+}
+
+//Add the files of a zup to pck
+WINPCK_API PCKRTN	do_ApplyZupToPck(LPCWSTR szZupFile, LPCWSTR lpszZupFolder, LPCWSTR szPckFile, LPCWSTR lpszPathInPckToAdd, int level)
+{
+
+	BOOL rtn = FALSE;
+
+	if (this_handle.Open(szPckFile)) {
+		if (this_handle.IsValidPck()) {
+
+			LPCENTRY lpFileEntry = this_handle.GetFileEntryByPath(lpszPathInPckToAdd);
+
+			if (NULL == lpFileEntry) {
+				this_handle.New();
+				return WINPCK_NOTFOUND;
+			}
+
+			this_handle.setCompressLevel(level);
+
+			rtn = this_handle.ApplyZupSubmit(szPckFile, szZupFile, lpszZupFolder, lpFileEntry);
+		}
+	}
+
+	this_handle.New();
+
+	return rtn ? WINPCK_OK : WINPCK_ERROR;
+}
+
 //Delete a node
 WINPCK_API PCKRTN pck_DeleteEntry(LPCENTRY lpFileEntry)
 {
@@ -605,6 +721,25 @@ WINPCK_API uint32_t pck_listByNode(LPCENTRY lpFileEntry, void* _in_param, SHOW_L
 	return CPckControlCenter::ListByNode(lpFileEntry, _in_param, _showListCallback);
 }
 
+WINPCK_API uint32_t pck_listByNodeToArray(LPCENTRY lpFileEntry, uint32_t dwOffset, uint32_t dwMaxRecords, PCK_LIST_RECORD* _out_records, wchar_t* _out_names, uint32_t dwNamesChars, uint32_t* _out_total)
+{
+	return this_handle.ListByNodeToArray(lpFileEntry, dwOffset, dwMaxRecords, _out_records, _out_names, dwNamesChars, _out_total);
+}
+
+WINPCK_API uint32_t pck_searchByNameToArray(LPCWSTR lpszSearchString, uint32_t dwOffset, uint32_t dwMaxRecords, PCK_LIST_RECORD* _out_records, wchar_t* _out_names, uint32_t dwNamesChars, uint32_t* _out_total)
+{
+	if (NULL != _out_total)
+		*_out_total = 0;
+
+	if ((NULL == lpszSearchString) || !checkIfValidPck())
+		return 0;
+
+	if (checkIfWorking())
+		return 0;
+
+	return this_handle.SearchByNameToArray(lpszSearchString, dwOffset, dwMaxRecords, _out_records, _out_names, dwNamesChars, _out_total);
+}
+
 WINPCK_API PCKRTN do_listPathInPck(LPCWSTR szSrcPckFile, LPCWSTR lpszListPath, void* _in_param, SHOW_LIST_CALLBACK _showListCallback)
 {
 	if (NULL == lpszListPath)
@@ -655,6 +790,21 @@ WINPCK_API BOOL	pck_getLastErrorMsg()
 	return this_handle.GetLastErrorMsg();
 }
 
+WINPCK_API PCKRTN	pck_regTaskCallbacks(void* pTag, TaskProgressCallback _ProgressCallBack, TaskStageCallback _StageCallBack, TaskCompleteCallback _CompleteCallBack, uint32_t dwProgressIntervalMs)
+{
+	return this_handle.regTaskCallbacks(pTag, _ProgressCallBack, _StageCallBack, _CompleteCallBack, dwProgressIntervalMs) ? WINPCK_OK : WINPCK_WORKING;
+}
+
+WINPCK_API int32_t	pck_getTaskStage()
+{
+	return this_handle.getTaskStage();
+}
+
+WINPCK_API BOOL	pck_waitForTask(uint32_t dwMilliseconds)
+{
+	return this_handle.waitForTask(dwMilliseconds);
+}
+
 //Memory usage
 WINPCK_API uint32_t	pck_getMTMemoryUsed()
 {
@@ -722,6 +872,50 @@ WINPCK_API void		pck_setCompressLevel(uint32_t dwCompressLevel)
 	return this_handle.setCompressLevel(dwCompressLevel);
 }
 
+//Search mode
+WINPCK_API int		pck_getSearchMode()
+{
+	return this_handle.getSearchMode();
+}
+
+WINPCK_API PCKRTN	pck_setSearchMode(int iSearchMode)
+{
+	if (checkIfWorking())
+		return WINPCK_WORKING;
+
+	return this_handle.setSearchMode(iSearchMode) ? WINPCK_OK : WINPCK_ERROR;
+}
+
+//Cache of decompressed data
+WINPCK_API uint32_t	pck_getDataCacheSize()
+{
+	return (uint32_t)this_handle.getDataCacheSize();
+}
+
+WINPCK_API void		pck_setDataCacheSize(uint32_t dwCacheSize)
+{
+	this_handle.setDataCacheSize(dwCacheSize);
+}
+
+//Checkpoints of the large files
+WINPCK_API uint32_t	pck_getCheckpointInterval()
+{
+	return this_handle.getCheckpointInterval();
+}
+
+WINPCK_API void		pck_setCheckpointInterval(uint32_t dwIntervalInBytes)
+{
+	this_handle.setCheckpointInterval(dwIntervalInBytes);
+}
+
+WINPCK_API PCKRTN	pck_saveCheckpointIndex()
+{
+	if (!checkIfValidPck())
+		return WINPCK_INVALIDPCK;
+
+	return this_handle.SaveCheckpointIndex() ? WINPCK_OK : WINPCK_ERROR;
+}
+
 WINPCK_API uint32_t	pck_getUIProgress()
 {
 	return this_handle.getUIProgress();
@@ -769,6 +963,16 @@ WINPCK_API void		log_regShowFunc(ShowLogW _ShowLogW)
 	Logger.PckClassLog_func_register(_ShowLogW);
 }
 
+WINPCK_API void		log_setLevel(char chLevel)
+{
+	Logger.SetLevel(chLevel);
+}
+
+WINPCK_API char		log_getLevel()
+{
+	return Logger.GetLevel();
+}
+
 
 #define define_one_pck_log(_level) \
 WINPCK_API void		pck_log##_level##A(LPCSTR  _fmt, ...)\
@@ -794,6 +998,36 @@ define_one_pck_log(D);
 
 #undef define_one_pck_log
 
+//profile
+WINPCK_API void		pck_startProfile(const wchar_t *lpszTraceFile)
+{
+	Profiler.Start(lpszTraceFile);
+}
+
+WINPCK_API BOOL		pck_stopProfile()
+{
+	return Profiler.Stop();
+}
+
+WINPCK_API uint32_t	pck_getProfileStageCount()
+{
+	return PROFILE_STAGE_COUNT;
+}
+
+WINPCK_API LPCSTR	pck_getProfileStageName(uint32_t dwStage)
+{
+	return CPckClassProfiler::GetStageName((PCK_PROFILE_STAGE)dwStage);
+}
+
+WINPCK_API BOOL		pck_getProfileStage(uint32_t dwStage, uint64_t *lpqwNanoseconds, uint64_t *lpqwCount, uint64_t *lpqwBytes)
+{
+	if (PROFILE_STAGE_COUNT <= dwStage)
+		return FALSE;
+
+	Profiler.GetStage((PCK_PROFILE_STAGE)dwStage, lpqwNanoseconds, lpqwCount, lpqwBytes);
+	return TRUE;
+}
+
 
 //Open, close, restore and other event registration
 WINPCK_API void		pck_regMsgFeedback(void* pTag, FeedbackCallback _FeedbackCallBack)
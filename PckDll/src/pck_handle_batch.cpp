@@ -0,0 +1,36 @@
+#include "pck_handle.h"
+#include "PckBatchRunner.h"
+
+WINPCK_API PCKRTN pck_runBatch(const PCK_BATCH_PARAMS* lpParams, LPCWSTR* lpszPckFiles, int nFileCount, void* pTag, BatchItemCallback _ItemCallBack, PCKRTN* _out_status)
+{
+	if ((NULL == lpParams) || !CPckBatchRunner::IsValidParams(*lpParams) || ((0 < nFileCount) && (NULL == lpszPckFiles)))
+		return WINPCK_ERROR;
+
+	CPckBatchRunner cBatch(*lpParams, [=](int iIndex, int iResult) {
+
+		PCKRTN rtn;
+
+		switch (iResult) {
+		case PCK_OK:
+			rtn = WINPCK_OK;
+			break;
+		case PCK_ERR_OPENMAPVIEWR:
+			rtn = WINPCK_INVALIDPCK;
+			break;
+		case PCK_ERR_NOT_FILE:
+			rtn = WINPCK_NOTFOUND;
+			break;
+		default:
+			rtn = WINPCK_ERROR;
+			break;
+		}
+
+		if (NULL != _out_status)
+			_out_status[iIndex] = rtn;
+
+		if (NULL != _ItemCallBack)
+			_ItemCallBack(pTag, iIndex, rtn);
+	});
+
+	return (nFileCount == (int)cBatch.Run(lpszPckFiles, nFileCount)) ? WINPCK_OK : WINPCK_ERROR;
+}
@@ -0,0 +1,415 @@
+#include "pck_handle.h"
+#include "PckControlCenter.h"
+#include "PckDefines.h"
+#include <mutex>
+#include <shared_mutex>
+
+//One opened file of the handle based interface
+struct _PCK_HANDLE
+{
+	_PCK_HANDLE() :
+		cCenter(FALSE)
+	{}
+
+	CPckControlCenter	cCenter;
+	//shared - reading the index and the data of the file, unique - changing the opened file
+	std::shared_mutex	lockFile;
+	//Tasks share the progress and error parameters of cCenter, so only one runs at a time
+	std::mutex			lockTask;
+};
+
+//pck_handle.cpp
+PCKRTN GetBatchFileDataByCenter(CPckControlCenter &cCenter, LPCENTRY* lpFileEntryArray, int nEntryCount, LPSTR* _inout_buffers, const size_t* _in_sizeOfBuffers, PCKRTN* _out_status);
+//pck_handle_vfs.cpp
+PCKVFILE OpenVirtualFileByCenter(CPckControlCenter &cCenter, LPCENTRY lpFileEntry);
+
+typedef std::shared_lock<std::shared_mutex>	PCKH_READ_LOCK;
+typedef std::unique_lock<std::shared_mutex>	PCKH_WRITE_LOCK;
+typedef std::lock_guard<std::mutex>			PCKH_TASK_LOCK;
+
+WINPCK_API PCKHANDLE pckh_open(const wchar_t *lpszFile)
+{
+	if (NULL == lpszFile)
+		return NULL;
+
+	PCKHANDLE hPck = new _PCK_HANDLE();
+
+	if (hPck->cCenter.Open(lpszFile) && hPck->cCenter.IsValidPck())
+		return hPck;
+
+	delete hPck;
+	return NULL;
+}
+
+WINPCK_API PCKRTN pckh_close(PCKHANDLE hPck)
+{
+	if (NULL == hPck)
+		return WINPCK_INVALIDPCK;
+
+	if (hPck->cCenter.isThreadWorking())
+		hPck->cCenter.ForceBreakThreadWorking();
+
+	{
+		//Wait for the calls that are still running
+		PCKH_WRITE_LOCK lckFile(hPck->lockFile);
+		PCKH_TASK_LOCK lckTask(hPck->lockTask);
+	}
+
+	delete hPck;
+	return WINPCK_OK;
+}
+
+WINPCK_API BOOL pckh_IsValidPck(PCKHANDLE hPck)
+{
+	if (NULL == hPck)
+		return FALSE;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return hPck->cCenter.IsValidPck();
+}
+
+WINPCK_API int pckh_getVersion(PCKHANDLE hPck)
+{
+	if (NULL == hPck)
+		return -1;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return hPck->cCenter.GetPckVersion();
+}
+
+WINPCK_API PCKRTN pckh_setVersion(PCKHANDLE hPck, int verID)
+{
+	if (NULL == hPck)
+		return WINPCK_INVALIDPCK;
+
+	PCKH_WRITE_LOCK lckFile(hPck->lockFile);
+	return hPck->cCenter.SetPckVersion(verID) ? WINPCK_OK : WINPCK_ERROR;
+}
+
+WINPCK_API LPCWSTR pckh_GetCurrentVersionName(PCKHANDLE hPck)
+{
+	if (NULL == hPck)
+		return NULL;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return hPck->cCenter.GetCurrentVersionName();
+}
+
+WINPCK_API LPCSTR pckh_GetAdditionalInfo(PCKHANDLE hPck)
+{
+	if (NULL == hPck)
+		return NULL;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return hPck->cCenter.GetAdditionalInfo();
+}
+
+WINPCK_API uint64_t pckh_filesize(PCKHANDLE hPck)
+{
+	if (NULL == hPck)
+		return -1;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return hPck->cCenter.GetPckSize();
+}
+
+WINPCK_API uint64_t pckh_file_data_area_size(PCKHANDLE hPck)
+{
+	if (NULL == hPck)
+		return -1;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return hPck->cCenter.GetPckDataAreaSize();
+}
+
+WINPCK_API uint64_t pckh_file_redundancy_data_size(PCKHANDLE hPck)
+{
+	if (NULL == hPck)
+		return -1;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return hPck->cCenter.GetPckRedundancyDataSize();
+}
+
+WINPCK_API uint32_t pckh_filecount(PCKHANDLE hPck)
+{
+	if (NULL == hPck)
+		return -1;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return hPck->cCenter.GetPckFileCount();
+}
+
+WINPCK_API LPCENTRY pckh_getRootNode(PCKHANDLE hPck)
+{
+	if (NULL == hPck)
+		return NULL;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return hPck->cCenter.GetRootNode();
+}
+
+WINPCK_API LPCENTRY pckh_getFileEntryByPath(PCKHANDLE hPck, LPCWSTR lpszPathInPck)
+{
+	if ((NULL == hPck) || (NULL == lpszPathInPck))
+		return NULL;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return hPck->cCenter.GetFileEntryByPath(lpszPathInPck);
+}
+
+WINPCK_API PCKRTN pckh_GetSingleFileData(PCKHANDLE hPck, LPCENTRY lpFileEntry, LPSTR _inout_buffer, size_t _in_sizeOfBuffer)
+{
+	if (NULL == hPck)
+		return WINPCK_INVALIDPCK;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return hPck->cCenter.GetSingleFileData(lpFileEntry, _inout_buffer, _in_sizeOfBuffer) ? WINPCK_OK : WINPCK_ERROR;
+}
+
+WINPCK_API PCKRTN pckh_GetBatchFileData(PCKHANDLE hPck, LPCENTRY* lpFileEntryArray, int nEntryCount, LPSTR* _inout_buffers, const size_t* _in_sizeOfBuffers, PCKRTN* _out_status)
+{
+	if (NULL == hPck)
+		return WINPCK_INVALIDPCK;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return GetBatchFileDataByCenter(hPck->cCenter, lpFileEntryArray, nEntryCount, _inout_buffers, _in_sizeOfBuffers, _out_status);
+}
+
+WINPCK_API int64_t pckh_GetFileDataAt(PCKHANDLE hPck, LPCENTRY lpFileEntry, uint64_t qwOffset, LPSTR _out_buffer, size_t _in_size)
+{
+	if ((NULL == hPck) || (NULL == _out_buffer))
+		return -1;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return hPck->cCenter.GetFileDataAt(lpFileEntry, qwOffset, _out_buffer, _in_size);
+}
+
+WINPCK_API PCKVFILE pckh_vfsOpen(PCKHANDLE hPck, LPCWSTR lpszPathInPck)
+{
+	if ((NULL == hPck) || (NULL == lpszPathInPck))
+		return NULL;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return OpenVirtualFileByCenter(hPck->cCenter, hPck->cCenter.GetFileEntryByPath(lpszPathInPck));
+}
+
+WINPCK_API PCKVFILE pckh_vfsOpenEntry(PCKHANDLE hPck, LPCENTRY lpFileEntry)
+{
+	if (NULL == hPck)
+		return NULL;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return OpenVirtualFileByCenter(hPck->cCenter, lpFileEntry);
+}
+
+WINPCK_API uint32_t pckh_searchByName(PCKHANDLE hPck, LPCWSTR lpszSearchString, void* _in_param, SHOW_LIST_CALLBACK _showListCallback)
+{
+	if ((NULL == hPck) || (NULL == lpszSearchString))
+		return 0;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return hPck->cCenter.SearchByName(lpszSearchString, _in_param, _showListCallback);
+}
+
+WINPCK_API uint32_t pckh_listByNodeToArray(PCKHANDLE hPck, LPCENTRY lpFileEntry, uint32_t dwOffset, uint32_t dwMaxRecords, PCK_LIST_RECORD* _out_records, wchar_t* _out_names, uint32_t dwNamesChars, uint32_t* _out_total)
+{
+	if (NULL != _out_total)
+		*_out_total = 0;
+
+	if (NULL == hPck)
+		return 0;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return hPck->cCenter.ListByNodeToArray(lpFileEntry, dwOffset, dwMaxRecords, _out_records, _out_names, dwNamesChars, _out_total);
+}
+
+WINPCK_API uint32_t pckh_searchByNameToArray(PCKHANDLE hPck, LPCWSTR lpszSearchString, uint32_t dwOffset, uint32_t dwMaxRecords, PCK_LIST_RECORD* _out_records, wchar_t* _out_names, uint32_t dwNamesChars, uint32_t* _out_total)
+{
+	if (NULL != _out_total)
+		*_out_total = 0;
+
+	if ((NULL == hPck) || (NULL == lpszSearchString))
+		return 0;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return hPck->cCenter.SearchByNameToArray(lpszSearchString, dwOffset, dwMaxRecords, _out_records, _out_names, dwNamesChars, _out_total);
+}
+
+WINPCK_API PCKRTN pckh_ExtractFilesByEntrys(PCKHANDLE hPck, LPCENTRY* lpFileEntryArray, int nEntryCount, LPCWSTR lpszDestDirectory)
+{
+	if (NULL == hPck)
+		return WINPCK_INVALIDPCK;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	PCKH_TASK_LOCK lckTask(hPck->lockTask);
+	return hPck->cCenter.ExtractFiles(lpFileEntryArray, nEntryCount, lpszDestDirectory) ? WINPCK_OK : WINPCK_ERROR;
+}
+
+WINPCK_API PCKRTN pckh_ExtractAllFiles(PCKHANDLE hPck, LPCWSTR lpszDestDirectory)
+{
+	if (NULL == hPck)
+		return WINPCK_INVALIDPCK;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	PCKH_TASK_LOCK lckTask(hPck->lockTask);
+	return hPck->cCenter.ExtractAllFiles(lpszDestDirectory) ? WINPCK_OK : WINPCK_ERROR;
+}
+
+WINPCK_API PCKRTN pckh_RebuildPckFileWithScript(PCKHANDLE hPck, LPCWSTR lpszScriptFile, LPCWSTR szRebuildPckFile, BOOL bUseRecompress)
+{
+	if (NULL == hPck)
+		return WINPCK_INVALIDPCK;
+
+	//The filter marks entries of the loaded index as deleted until it is done, no reader may see them meanwhile
+	PCKH_WRITE_LOCK lckFile(hPck->lockFile);
+	PCKH_TASK_LOCK lckTask(hPck->lockTask);
+	return hPck->cCenter.RebuildPckFile(lpszScriptFile, szRebuildPckFile, bUseRecompress) ? WINPCK_OK : WINPCK_ERROR;
+}
+
+WINPCK_API PCKRTN pckh_setRebuildLayout(PCKHANDLE hPck, int iLayout, LPCWSTR lpszListFile)
+{
+	if (NULL == hPck)
+		return WINPCK_INVALIDPCK;
+
+	PCKH_TASK_LOCK lckTask(hPck->lockTask);
+	return hPck->cCenter.setRebuildLayout(iLayout, lpszListFile) ? WINPCK_OK : WINPCK_ERROR;
+}
+
+WINPCK_API PCKRTN pckh_StripPck(PCKHANDLE hPck, LPCWSTR szStripedPckFile, int flag)
+{
+	if (NULL == hPck)
+		return WINPCK_INVALIDPCK;
+
+	//The filter marks entries of the loaded index as deleted until it is done, no reader may see them meanwhile
+	PCKH_WRITE_LOCK lckFile(hPck->lockFile);
+	PCKH_TASK_LOCK lckTask(hPck->lockTask);
+	return hPck->cCenter.StripPck(szStripedPckFile, flag) ? WINPCK_OK : WINPCK_ERROR;
+}
+
+WINPCK_API void pckh_setMaxThread(PCKHANDLE hPck, uint32_t dwThread)
+{
+	if (NULL == hPck)
+		return;
+
+	PCKH_TASK_LOCK lckTask(hPck->lockTask);
+	hPck->cCenter.setMaxThread(dwThread);
+}
+
+WINPCK_API void pckh_setCompressLevel(PCKHANDLE hPck, uint32_t dwCompressLevel)
+{
+	if (NULL == hPck)
+		return;
+
+	PCKH_TASK_LOCK lckTask(hPck->lockTask);
+	hPck->cCenter.setCompressLevel(dwCompressLevel);
+}
+
+WINPCK_API void pckh_setMTMaxMemory(PCKHANDLE hPck, uint32_t dwMTMaxMemoryInBytes)
+{
+	if (NULL == hPck)
+		return;
+
+	PCKH_TASK_LOCK lckTask(hPck->lockTask);
+	hPck->cCenter.setMTMaxMemory(dwMTMaxMemoryInBytes);
+}
+
+WINPCK_API void pckh_setDataCacheSize(PCKHANDLE hPck, uint32_t dwCacheSizeInBytes)
+{
+	if (NULL == hPck)
+		return;
+
+	//The cache has its own lock, reads may go on meanwhile
+	hPck->cCenter.setDataCacheSize(dwCacheSizeInBytes);
+}
+
+WINPCK_API void pckh_setCheckpointInterval(PCKHANDLE hPck, uint32_t dwIntervalInBytes)
+{
+	if (NULL == hPck)
+		return;
+
+	//The index has its own lock as well
+	hPck->cCenter.setCheckpointInterval(dwIntervalInBytes);
+}
+
+WINPCK_API PCKRTN pckh_saveCheckpointIndex(PCKHANDLE hPck)
+{
+	if (NULL == hPck)
+		return WINPCK_INVALIDPCK;
+
+	PCKH_READ_LOCK lckFile(hPck->lockFile);
+	return hPck->cCenter.SaveCheckpointIndex() ? WINPCK_OK : WINPCK_ERROR;
+}
+
+WINPCK_API PCKRTN pckh_setSearchMode(PCKHANDLE hPck, int iSearchMode)
+{
+	if (NULL == hPck)
+		return WINPCK_INVALIDPCK;
+
+	PCKH_WRITE_LOCK lckFile(hPck->lockFile);
+	return hPck->cCenter.setSearchMode(iSearchMode) ? WINPCK_OK : WINPCK_ERROR;
+}
+
+WINPCK_API BOOL pckh_isThreadWorking(PCKHANDLE hPck)
+{
+	if (NULL == hPck)
+		return FALSE;
+
+	return hPck->cCenter.isThreadWorking();
+}
+
+WINPCK_API void pckh_forceBreakThreadWorking(PCKHANDLE hPck)
+{
+	if ((NULL == hPck) || !hPck->cCenter.isThreadWorking())
+		return;
+
+	hPck->cCenter.ForceBreakThreadWorking();
+}
+
+WINPCK_API BOOL pckh_isLastOptSuccess(PCKHANDLE hPck)
+{
+	if (NULL == hPck)
+		return FALSE;
+
+	return hPck->cCenter.isLastOptSuccess();
+}
+
+WINPCK_API uint32_t pckh_getUIProgress(PCKHANDLE hPck)
+{
+	if (NULL == hPck)
+		return 0;
+
+	return hPck->cCenter.getUIProgress();
+}
+
+WINPCK_API uint32_t pckh_getUIProgressUpper(PCKHANDLE hPck)
+{
+	if (NULL == hPck)
+		return 0;
+
+	return hPck->cCenter.getUIProgressUpper();
+}
+
+WINPCK_API PCKRTN pckh_regTaskCallbacks(PCKHANDLE hPck, void* pTag, TaskProgressCallback _ProgressCallBack, TaskStageCallback _StageCallBack, TaskCompleteCallback _CompleteCallBack, uint32_t dwProgressIntervalMs)
+{
+	if (NULL == hPck)
+		return WINPCK_INVALIDPCK;
+
+	return hPck->cCenter.regTaskCallbacks(pTag, _ProgressCallBack, _StageCallBack, _CompleteCallBack, dwProgressIntervalMs) ? WINPCK_OK : WINPCK_WORKING;
+}
+
+WINPCK_API int32_t pckh_getTaskStage(PCKHANDLE hPck)
+{
+	if (NULL == hPck)
+		return PCK_STAGE_IDLE;
+
+	return hPck->cCenter.getTaskStage();
+}
+
+WINPCK_API BOOL pckh_waitForTask(PCKHANDLE hPck, uint32_t dwMilliseconds)
+{
+	if (NULL == hPck)
+		return TRUE;
+
+	return hPck->cCenter.waitForTask(dwMilliseconds);
+}
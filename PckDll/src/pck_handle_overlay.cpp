@@ -0,0 +1,133 @@
+#include "pck_handle.h"
+#include "PckOverlay.h"
+
+//Archives mounted over each other
+struct _PCK_OVERLAY
+{
+	CPckOverlay		cOverlay;
+};
+
+//pck_handle_vfs.cpp
+PCKVFILE OpenVirtualFileByOverlay(CPckOverlay &cOverlay, LPCENTRY lpFileEntry);
+
+WINPCK_API PCKOVERLAY pcko_open(LPCWSTR* lpszPckFiles, int nFileCount)
+{
+	if ((NULL == lpszPckFiles) || (0 >= nFileCount))
+		return NULL;
+
+	PCKOVERLAY hOverlay = new _PCK_OVERLAY();
+
+	if (hOverlay->cOverlay.Open(lpszPckFiles, nFileCount))
+		return hOverlay;
+
+	delete hOverlay;
+	return NULL;
+}
+
+WINPCK_API PCKRTN pcko_close(PCKOVERLAY hOverlay)
+{
+	if (NULL == hOverlay)
+		return WINPCK_INVALIDPCK;
+
+	delete hOverlay;
+	return WINPCK_OK;
+}
+
+WINPCK_API uint32_t pcko_getLayerCount(PCKOVERLAY hOverlay)
+{
+	if (NULL == hOverlay)
+		return 0;
+
+	return hOverlay->cOverlay.GetLayerCount();
+}
+
+WINPCK_API LPCWSTR pcko_getLayerFile(PCKOVERLAY hOverlay, uint32_t dwLayer)
+{
+	if (NULL == hOverlay)
+		return NULL;
+
+	return hOverlay->cOverlay.GetLayerFile(dwLayer);
+}
+
+WINPCK_API uint32_t pcko_filecount(PCKOVERLAY hOverlay)
+{
+	if (NULL == hOverlay)
+		return 0;
+
+	return hOverlay->cOverlay.GetFileCount();
+}
+
+WINPCK_API LPCENTRY pcko_getRootNode(PCKOVERLAY hOverlay)
+{
+	if (NULL == hOverlay)
+		return NULL;
+
+	return hOverlay->cOverlay.GetRootNode();
+}
+
+WINPCK_API uint32_t pcko_listByNodeToArray(PCKOVERLAY hOverlay, LPCENTRY lpFileEntry, uint32_t dwOffset, uint32_t dwMaxRecords, PCK_LIST_RECORD* _out_records, wchar_t* _out_names, uint32_t dwNamesChars, uint32_t* _out_total)
+{
+	if (NULL != _out_total)
+		*_out_total = 0;
+
+	if (NULL == hOverlay)
+		return 0;
+
+	return hOverlay->cOverlay.ListByNodeToArray(lpFileEntry, dwOffset, dwMaxRecords, _out_records, _out_names, dwNamesChars, _out_total);
+}
+
+WINPCK_API LPCENTRY pcko_getFileEntryByPath(PCKOVERLAY hOverlay, LPCWSTR lpszPathInPck)
+{
+	if ((NULL == hOverlay) || (NULL == lpszPathInPck))
+		return NULL;
+
+	return hOverlay->cOverlay.GetFileEntryByPath(lpszPathInPck);
+}
+
+WINPCK_API int32_t pcko_getEntryLayer(PCKOVERLAY hOverlay, LPCENTRY lpFileEntry)
+{
+	if (NULL == hOverlay)
+		return -1;
+
+	return CPckOverlay::GetEntryLayer(lpFileEntry);
+}
+
+WINPCK_API PCKRTN pcko_GetSingleFileData(PCKOVERLAY hOverlay, LPCENTRY lpFileEntry, LPSTR _inout_buffer, size_t _in_sizeOfBuffer)
+{
+	if (NULL == hOverlay)
+		return WINPCK_INVALIDPCK;
+
+	return hOverlay->cOverlay.GetSingleFileData(lpFileEntry, _inout_buffer, _in_sizeOfBuffer) ? WINPCK_OK : WINPCK_ERROR;
+}
+
+WINPCK_API PCKRTN pcko_ExtractFilesByEntrys(PCKOVERLAY hOverlay, LPCENTRY* lpFileEntryArray, int nEntryCount, LPCWSTR lpszDestDirectory)
+{
+	if (NULL == hOverlay)
+		return WINPCK_INVALIDPCK;
+
+	return hOverlay->cOverlay.ExtractFiles(lpFileEntryArray, nEntryCount, lpszDestDirectory) ? WINPCK_OK : WINPCK_ERROR;
+}
+
+WINPCK_API PCKRTN pcko_ExtractAllFiles(PCKOVERLAY hOverlay, LPCWSTR lpszDestDirectory)
+{
+	if (NULL == hOverlay)
+		return WINPCK_INVALIDPCK;
+
+	return hOverlay->cOverlay.ExtractAllFiles(lpszDestDirectory) ? WINPCK_OK : WINPCK_ERROR;
+}
+
+WINPCK_API PCKVFILE pcko_vfsOpen(PCKOVERLAY hOverlay, LPCWSTR lpszPathInPck)
+{
+	if ((NULL == hOverlay) || (NULL == lpszPathInPck))
+		return NULL;
+
+	return OpenVirtualFileByOverlay(hOverlay->cOverlay, hOverlay->cOverlay.GetFileEntryByPath(lpszPathInPck));
+}
+
+WINPCK_API PCKVFILE pcko_vfsOpenEntry(PCKOVERLAY hOverlay, LPCENTRY lpFileEntry)
+{
+	if (NULL == hOverlay)
+		return NULL;
+
+	return OpenVirtualFileByOverlay(hOverlay->cOverlay, lpFileEntry);
+}
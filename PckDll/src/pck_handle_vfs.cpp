@@ -0,0 +1,80 @@
+#include "pck_handle.h"
+#include "PckControlCenter.h"
+#include "PckOverlay.h"
+#include "PckVirtualFile.h"
+
+//A file of a pck opened like a file on disk
+struct _PCK_VFILE
+{
+	CPckVirtualFile		cFile;
+};
+
+//Shared by pck_vfsOpen and pckh_vfsOpen
+PCKVFILE OpenVirtualFileByCenter(CPckControlCenter &cCenter, LPCENTRY lpFileEntry)
+{
+	if (NULL == lpFileEntry)
+		return NULL;
+
+	PCKVFILE hFile = new _PCK_VFILE();
+
+	if (cCenter.OpenVirtualFile(lpFileEntry, hFile->cFile))
+		return hFile;
+
+	delete hFile;
+	return NULL;
+}
+
+PCKVFILE OpenVirtualFileByOverlay(CPckOverlay &cOverlay, LPCENTRY lpFileEntry)
+{
+	if (NULL == lpFileEntry)
+		return NULL;
+
+	PCKVFILE hFile = new _PCK_VFILE();
+
+	if (cOverlay.OpenVirtualFile(lpFileEntry, hFile->cFile))
+		return hFile;
+
+	delete hFile;
+	return NULL;
+}
+
+WINPCK_API PCKRTN pck_vfsClose(PCKVFILE hFile)
+{
+	if (NULL == hFile)
+		return WINPCK_INVALIDPCK;
+
+	delete hFile;
+	return WINPCK_OK;
+}
+
+WINPCK_API int64_t pck_vfsRead(PCKVFILE hFile, void* _out_buffer, size_t _in_size)
+{
+	if ((NULL == hFile) || (NULL == _out_buffer))
+		return -1;
+
+	return hFile->cFile.Read(_out_buffer, _in_size);
+}
+
+WINPCK_API int64_t pck_vfsSeek(PCKVFILE hFile, int64_t iOffset, int iOrigin)
+{
+	if (NULL == hFile)
+		return -1;
+
+	return hFile->cFile.Seek(iOffset, iOrigin);
+}
+
+WINPCK_API uint64_t pck_vfsTell(PCKVFILE hFile)
+{
+	if (NULL == hFile)
+		return 0;
+
+	return hFile->cFile.Tell();
+}
+
+WINPCK_API uint64_t pck_vfsSize(PCKVFILE hFile)
+{
+	if (NULL == hFile)
+		return 0;
+
+	return hFile->cFile.GetSize();
+}
@@ -88,6 +88,20 @@ BOOL TInstDlg::OpenPckFile(const wchar_t *lpszFileToOpen, BOOL isReOpen)
 
 }
 
+VOID TInstDlg::RefreshPckFile()
+{
+	int	iListTopView = ListView_GetTopIndex(GetDlgItem(IDC_LIST));
+
+	m_currentNodeOnShow = NULL;
+
+	SetStatusBarFileSize(pck_filesize());
+	SetStatusBarFileCount(pck_filecount());
+
+	ShowPckFiles(pck_getFileEntryByPath(m_FolderBrowsed));
+	ListView_EnsureVisible(GetDlgItem(IDC_LIST), iListTopView, NULL);
+	ListView_EnsureVisible(GetDlgItem(IDC_LIST), iListTopView + ListView_GetCountPerPage(GetDlgItem(IDC_LIST)) - 1, NULL);
+}
+
 void ShowFilelistCallback(void* _in_param, int sn, const wchar_t *lpszFilename, int entry_type, unsigned __int64 qwFileSize, unsigned __int64 qwFileSizeCompressed, void* fileEntry)
 {
 	TInstDlg * const pThis = (TInstDlg*)_in_param;
@@ -229,6 +229,17 @@ BOOL TLogDlg::EvClose()
 	return TRUE;
 }
 
+BOOL TLogDlg::EventUser(UINT uMsg, WPARAM wParam, LPARAM lParam)
+{
+	if (WM_LOG_INSERT != uMsg)
+		return FALSE;
+
+	wchar_t *lpszText = (wchar_t*)lParam;
+	InsertLogToList((char)wParam, lpszText);
+	delete[] lpszText;
+	return TRUE;
+}
+
 wchar_t*  TLogDlg::pszLogFileName()
 {
 	static wchar_t logfile[MAX_PATH];
@@ -265,6 +276,17 @@ wchar_t*  TLogDlg::pszTargetListLog(int iItem)
 
 void TLogDlg::InsertLogToList(const char _loglevel, const wchar_t *_logtext)
 {
+	//While a task runs the dll logs from its own thread, the list is only changed by the thread of the dialog
+	if (GetCurrentThreadId() != GetWindowThreadProcessId(hWnd, NULL)) {
+
+		size_t nTextLen = wcslen(_logtext) + 1;
+		wchar_t *lpszText = new wchar_t[nTextLen];
+		wcscpy_s(lpszText, nTextLen, _logtext);
+
+		if (!PostMessage(WM_LOG_INSERT, (WPARAM)_loglevel, (LPARAM)lpszText))
+			delete[] lpszText;
+		return;
+	}
 
 	if ('N' == _loglevel) {
 		LogUnits.SetStatusBarInfo(_logtext);
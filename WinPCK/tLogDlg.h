@@ -3,6 +3,9 @@
 #include "tlib.h"
 #include "resource.h"
 
+//A message logged by another thread, shown by the thread of the dialog
+#define WM_LOG_INSERT				(WM_USER + 2)
+
 class TLogDlg : public TDlg
 {
 private:
@@ -29,6 +32,7 @@ public:
 	virtual BOOL	EvSize(UINT fwSizeType, WORD nWidth, WORD nHeight);
 	virtual BOOL	EvClose();
 	virtual BOOL	EvNotify(UINT ctlID, NMHDR *pNmHdr);
+	virtual BOOL	EventUser(UINT uMsg, WPARAM wParam, LPARAM lParam);
 
 	void	InsertLogToList(const char, const wchar_t *);
 };
@@ -131,6 +131,10 @@ VOID TInstDlg::UpdatePckFile(VOID *pParam)
 
 			pThis->OpenPckFile(szFilenameToSave, TRUE);
 		}
+		else if (pck_IsValidPck()) {
+			//The added files are merged into the opened pck
+			pThis->RefreshPckFile();
+		}
 		else {
 			pThis->OpenPckFile(pThis->m_Filename, TRUE);
 		}
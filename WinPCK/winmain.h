@@ -93,6 +93,8 @@ private:
 
 	//mainfunc.cpp
 	BOOL OpenPckFile(const wchar_t *lpszFileToOpen = L"", BOOL isReOpen = FALSE);
+	//Show the opened pck again after it is changed in place, the list keeps its position
+	VOID RefreshPckFile();
 	VOID SearchPckFiles();
 	VOID ShowPckFiles(const PCK_UNIFIED_FILE_ENTRY* lpNodeToShow);
 
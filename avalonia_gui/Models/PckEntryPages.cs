@@ -0,0 +1,120 @@
+using System;
+using System.Collections;
+using System.Collections.Generic;
+
+namespace WinPCK.Avalonia.Models;
+
+// Reads entries offset .. offset + maxCount - 1 of a listing, total is the count of all its entries
+public delegate List<PckFileEntry> PckPageReader(uint offset, uint maxCount, out uint total);
+
+// Entries of a folder or of a search, read from the library a page at a time.
+// The list asks only for the items it shows, so only their pages are read.
+public sealed class PckEntryPages : IList, IReadOnlyList<PckFileEntry>
+{
+    // Entries read per page when the list scrolls to them
+    public const uint PageSize = 256;
+
+    public static readonly PckEntryPages Empty = new();
+
+    private readonly PckPageReader? _readPage;
+    private readonly int _count;
+    private readonly Dictionary<int, List<PckFileEntry>> _pages = new();
+    // Position of every entry read so far, the selection finds items by it
+    private readonly Dictionary<PckFileEntry, int> _indexes = new(ReferenceEqualityComparer.Instance);
+    private readonly object _lock = new();
+
+    private PckEntryPages()
+    {
+    }
+
+    // Reads the first page, call it off the UI thread
+    public PckEntryPages(PckPageReader readPage)
+    {
+        _readPage = readPage;
+
+        var entries = readPage(0, PageSize, out uint total);
+        _count = (int)Math.Min(total, int.MaxValue);
+        AddPage(0, entries);
+    }
+
+    public int Count => _count;
+
+    public PckFileEntry this[int index]
+    {
+        get
+        {
+            if (index < 0 || index >= _count)
+                throw new ArgumentOutOfRangeException(nameof(index));
+
+            var page = GetPage(index / (int)PageSize);
+            int i = index % (int)PageSize;
+
+            // The pck changed since the count was read
+            return i < page.Count ? page[i] : new PckFileEntry();
+        }
+    }
+
+    private List<PckFileEntry> GetPage(int pageNumber)
+    {
+        lock (_lock)
+        {
+            if (_pages.TryGetValue(pageNumber, out var page))
+                return page;
+
+            var entries = _readPage!((uint)pageNumber * PageSize, PageSize, out _);
+            AddPage(pageNumber, entries);
+            return entries;
+        }
+    }
+
+    private void AddPage(int pageNumber, List<PckFileEntry> entries)
+    {
+        _pages[pageNumber] = entries;
+
+        int first = pageNumber * (int)PageSize;
+        for (int i = 0; i < entries.Count; i++)
+            _indexes[entries[i]] = first + i;
+    }
+
+    public IEnumerator<PckFileEntry> GetEnumerator()
+    {
+        for (int i = 0; i < _count; i++)
+            yield return this[i];
+    }
+
+    IEnumerator IEnumerable.GetEnumerator() => GetEnumerator();
+
+    // Items that were never read can not be selected, so they are not searched
+    public int IndexOf(object? value)
+    {
+        lock (_lock)
+        {
+            return value is PckFileEntry entry && _indexes.TryGetValue(entry, out int index) ? index : -1;
+        }
+    }
+
+    public bool Contains(object? value) => IndexOf(value) >= 0;
+
+    object? IList.this[int index]
+    {
+        get => this[index];
+        set => throw new NotSupportedException();
+    }
+
+    public bool IsReadOnly => true;
+    public bool IsFixedSize => true;
+    public bool IsSynchronized => false;
+    public object SyncRoot => _lock;
+
+    public void CopyTo(Array array, int index)
+    {
+        for (int i = 0; i < _count; i++)
+            array.SetValue(this[i], index + i);
+    }
+
+    public int Add(object? value) => throw new NotSupportedException();
+    public void Clear() => throw new NotSupportedException();
+    public void Insert(int index, object? value) => throw new NotSupportedException();
+    public void Remove(object? value) => throw new NotSupportedException();
+    public void RemoveAt(int index) => throw new NotSupportedException();
+}
@@ -15,9 +15,6 @@ public partial class PckTreeNode : ObservableObject
     [ObservableProperty]
     private ObservableCollection<PckTreeNode> _children = new();
 
-    [ObservableProperty]
-    private ObservableCollection<PckFileEntry> _files = new();
-
     public IntPtr EntryPointer { get; set; }
     public bool IsFolder { get; set; } = true;
 }
@@ -25,6 +25,26 @@ public static class PckNative
     public const int PCK_ENTRY_TYPE_FOLDER = 2;
     public const int PCK_ENTRY_TYPE_DOTDOT = 4;
 
+    // Longest name of one list record, in wchar_t
+    public const int MAX_PATH_PCK_260 = 260;
+
+    #endregion
+
+    #region Structs
+
+    // PCK_LIST_RECORD, one entry of pck_listByNodeToArray/pck_searchByNameToArray
+    [StructLayout(LayoutKind.Sequential)]
+    public struct PckListRecord
+    {
+        public IntPtr FileEntry;
+        public ulong FileSize;
+        public ulong FileSizeCompressed;
+        public int EntryType;
+        public uint NameOffset;  // in wchar_t (4 bytes) from the start of the name buffer
+        public uint NameLength;  // in wchar_t, without the terminating 0
+        public uint Reserved;
+    }
+
     #endregion
 
     #region Delegates
@@ -42,6 +62,15 @@ public static class PckNative
         ulong fileSizeCompressed,
         IntPtr fileEntry);
 
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    public delegate void TaskProgressCallback(IntPtr tag, uint progress, uint progressUpper);
+
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    public delegate void TaskStageCallback(IntPtr tag, int stage);
+
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    public delegate void TaskCompleteCallback(IntPtr tag, int result);
+
     #endregion
 
     #region Helper Methods
@@ -206,6 +235,40 @@ public static class PckNative
         IntPtr param,
         ShowListCallback callback);
 
+    // Names are UTF-32, namesChars counts wchar_t, so names must hold namesChars * 4 bytes
+    [DllImport(LibName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern uint pck_listByNodeToArray(
+        IntPtr entry,
+        uint offset,
+        uint maxRecords,
+        [Out] PckListRecord[]? records,
+        [Out] byte[]? names,
+        uint namesChars,
+        out uint total);
+
+    [DllImport(LibName, CallingConvention = CallingConvention.Cdecl, EntryPoint = "pck_searchByNameToArray")]
+    private static extern uint pck_searchByNameToArray_native(
+        IntPtr searchString,
+        uint offset,
+        uint maxRecords,
+        [Out] PckListRecord[]? records,
+        [Out] byte[]? names,
+        uint namesChars,
+        out uint total);
+
+    public static uint pck_searchByNameToArray(string searchString, uint offset, uint maxRecords, PckListRecord[]? records, byte[]? names, uint namesChars, out uint total)
+    {
+        IntPtr ptr = StringToUtf32Ptr(searchString);
+        try
+        {
+            return pck_searchByNameToArray_native(ptr, offset, maxRecords, records, names, namesChars, out total);
+        }
+        finally
+        {
+            FreeUtf32Ptr(ptr);
+        }
+    }
+
     [DllImport(LibName, CallingConvention = CallingConvention.Cdecl, EntryPoint = "pck_searchByName")]
     private static extern uint pck_searchByName_native(
         IntPtr searchString,
@@ -301,6 +364,19 @@ public static class PckNative
     [DllImport(LibName, CallingConvention = CallingConvention.Cdecl)]
     public static extern uint pck_getUIProgressUpper();
 
+    public const uint PCK_WAIT_INFINITE = 0xffffffff;
+
+    // Callbacks are called from the library threads while a task runs, one at a time
+    [DllImport(LibName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern PCKRTN pck_regTaskCallbacks(IntPtr tag, TaskProgressCallback? progress, TaskStageCallback? stage, TaskCompleteCallback? complete, uint progressIntervalMs);
+
+    [DllImport(LibName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int pck_getTaskStage();
+
+    [DllImport(LibName, CallingConvention = CallingConvention.Cdecl)]
+    [return: MarshalAs(UnmanagedType.Bool)]
+    public static extern bool pck_waitForTask(uint milliseconds);
+
     #endregion
 
     #region Creation/Editing
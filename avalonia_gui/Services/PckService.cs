@@ -1,6 +1,7 @@
 using System;
 using System.Collections.Generic;
 using System.Runtime.InteropServices;
+using System.Text;
 using Serilog;
 using WinPCK.Avalonia.Models;
 using WinPCK.Avalonia.Native;
@@ -16,6 +17,7 @@ public class PckService : IDisposable
     private bool _isFileOpen;
     private string? _currentFilePath;
     private PckNative.LogCallback? _logCallback;
+    private PckNative.TaskProgressCallback? _progressCallback;
 
     public bool IsFileOpen => _isFileOpen;
     public string? CurrentFilePath => _currentFilePath;
@@ -31,6 +33,10 @@ public class PckService : IDisposable
         _logCallback = OnNativeLogMessage;
         PckNative.log_regShowFunc(_logCallback);
 
+        // Progress is pushed by the library while a task runs
+        _progressCallback = OnNativeProgress;
+        PckNative.pck_regTaskCallbacks(IntPtr.Zero, _progressCallback, null, null, 100);
+
         _logger.Information("PckService initialized");
     }
 
@@ -52,6 +58,11 @@ public class PckService : IDisposable
         LogMessageReceived?.Invoke(this, $"[{logLevel}] {message}");
     }
 
+    private void OnNativeProgress(IntPtr tag, uint progress, uint progressUpper)
+    {
+        ProgressChanged?.Invoke(this, new ProgressEventArgs(progress, progressUpper));
+    }
+
     public bool OpenFile(string filePath)
     {
         try
@@ -146,8 +157,57 @@ public class PckService : IDisposable
         }
     }
 
+    // Records fetched per native call when listing
+    private const uint ListPageSize = 4096;
+
+    private delegate uint ListPageFunc(uint offset, uint maxRecords, PckNative.PckListRecord[] records, byte[] names, uint namesChars, out uint total);
+
+    // Reads a listing page by page, each page is one native call instead of one callback per entry
+    private static List<PckFileEntry> ReadListPages(ListPageFunc listPage, uint offset, uint maxCount, out uint total)
+    {
+        var entries = new List<PckFileEntry>();
+        uint pageSize = Math.Min(maxCount, ListPageSize);
+        var records = new PckNative.PckListRecord[pageSize];
+        uint namesChars = pageSize * PckNative.MAX_PATH_PCK_260;
+        var names = new byte[namesChars * 4];
+
+        total = 0;
+        while ((uint)entries.Count < maxCount)
+        {
+            uint max = Math.Min(pageSize, maxCount - (uint)entries.Count);
+            uint count = listPage(offset, max, records, names, namesChars, out total);
+
+            for (int i = 0; i < count; i++)
+            {
+                ref var record = ref records[i];
+                entries.Add(new PckFileEntry
+                {
+                    Name = Encoding.UTF32.GetString(names, (int)record.NameOffset * 4, (int)record.NameLength * 4),
+                    EntryType = record.EntryType,
+                    Size = record.FileSize,
+                    CompressedSize = record.FileSizeCompressed,
+                    EntryPointer = record.FileEntry
+                });
+            }
+
+            offset += count;
+            if (count == 0 || offset >= total)
+                break;
+        }
+
+        return entries;
+    }
+
     public List<PckFileEntry> ListFiles(IntPtr? entry = null)
     {
+        return ListFiles(entry, 0, uint.MaxValue, out _);
+    }
+
+    // Lists entries offset .. offset + maxCount - 1 of a folder, total is the count of all its entries
+    public List<PckFileEntry> ListFiles(IntPtr? entry, uint offset, uint maxCount, out uint total)
+    {
+        total = 0;
+
         if (!_isFileOpen)
         {
             _logger.Warning("Attempted to list files without an open file");
@@ -160,21 +220,12 @@ public class PckService : IDisposable
         {
             var entryPtr = entry ?? PckNative.pck_getRootNode();
 
-            PckNative.ShowListCallback callback = (param, sn, fileNamePtr, entryType, fileSize, fileSizeCompressed, fileEntry) =>
-            {
-                var fileName = PckNative.Utf32PtrToString(fileNamePtr);
-                entries.Add(new PckFileEntry
-                {
-                    Name = fileName,
-                    EntryType = entryType,
-                    Size = fileSize,
-                    CompressedSize = fileSizeCompressed,
-                    EntryPointer = fileEntry
-                });
-            };
+            entries = ReadListPages(
+                (uint pageOffset, uint max, PckNative.PckListRecord[] records, byte[] names, uint namesChars, out uint pageTotal) =>
+                    PckNative.pck_listByNodeToArray(entryPtr, pageOffset, max, records, names, namesChars, out pageTotal),
+                offset, maxCount, out total);
 
-            var count = PckNative.pck_listByNode(entryPtr, IntPtr.Zero, callback);
-            _logger.Debug("Listed {Count} entries", count);
+            _logger.Debug("Listed {Count} of {Total} entries", entries.Count, total);
         }
         catch (Exception ex)
         {
@@ -184,6 +235,27 @@ public class PckService : IDisposable
         return entries;
     }
 
+    // Folders of a folder, the library lists them before the files so the files are not read
+    public List<PckFileEntry> ListFolders(IntPtr? entry = null)
+    {
+        var folders = new List<PckFileEntry>();
+
+        for (uint offset = 0; ; offset += PckEntryPages.PageSize)
+        {
+            var entries = ListFiles(entry, offset, PckEntryPages.PageSize, out uint total);
+
+            foreach (var e in entries)
+            {
+                if (!e.IsFolder)
+                    return folders;
+                folders.Add(e);
+            }
+
+            if (entries.Count == 0 || offset + (uint)entries.Count >= total)
+                return folders;
+        }
+    }
+
     public bool ExtractSelectedFiles(IntPtr[] fileEntries, int count, string destDir)
     {
         if (!_isFileOpen)
@@ -204,16 +276,8 @@ public class PckService : IDisposable
                 return false;
             }
 
-            // Monitor progress
-            while (PckNative.pck_isThreadWorking())
-            {
-                var progress = PckNative.pck_getUIProgress();
-                var total = PckNative.pck_getUIProgressUpper();
-
-                ProgressChanged?.Invoke(this, new ProgressEventArgs(progress, total));
-
-                System.Threading.Thread.Sleep(100);
-            }
+            // Wait for operation to complete
+            PckNative.pck_waitForTask(PckNative.PCK_WAIT_INFINITE);
 
             var success = PckNative.pck_isLastOptSuccess();
 
@@ -237,6 +301,14 @@ public class PckService : IDisposable
 
     public List<PckFileEntry> SearchFiles(string searchString)
     {
+        return SearchFiles(searchString, 0, uint.MaxValue, out _);
+    }
+
+    // Results offset .. offset + maxCount - 1 of a search, the library searches once for all pages of the same string
+    public List<PckFileEntry> SearchFiles(string searchString, uint offset, uint maxCount, out uint total)
+    {
+        total = 0;
+
         if (!_isFileOpen)
         {
             _logger.Warning("Attempted to search files without an open file");
@@ -247,23 +319,16 @@ public class PckService : IDisposable
 
         try
         {
-            _logger.Information("Searching for: {SearchString}", searchString);
+            if (offset == 0)
+                _logger.Information("Searching for: {SearchString}", searchString);
 
-            PckNative.ShowListCallback callback = (param, sn, fileNamePtr, entryType, fileSize, fileSizeCompressed, fileEntry) =>
-            {
-                var fileName = PckNative.Utf32PtrToString(fileNamePtr);
-                results.Add(new PckFileEntry
-                {
-                    Name = fileName,
-                    EntryType = entryType,
-                    Size = fileSize,
-                    CompressedSize = fileSizeCompressed,
-                    EntryPointer = fileEntry
-                });
-            };
+            results = ReadListPages(
+                (uint pageOffset, uint max, PckNative.PckListRecord[] records, byte[] names, uint namesChars, out uint pageTotal) =>
+                    PckNative.pck_searchByNameToArray(searchString, pageOffset, max, records, names, namesChars, out pageTotal),
+                offset, maxCount, out total);
 
-            var count = PckNative.pck_searchByName(searchString, IntPtr.Zero, callback);
-            _logger.Information("Search found {Count} results", count);
+            if (offset == 0)
+                _logger.Information("Search found {Count} results", total);
         }
         catch (Exception ex)
         {
@@ -293,16 +358,8 @@ public class PckService : IDisposable
                 return false;
             }
 
-            // Monitor progress
-            while (PckNative.pck_isThreadWorking())
-            {
-                var progress = PckNative.pck_getUIProgress();
-                var total = PckNative.pck_getUIProgressUpper();
-
-                ProgressChanged?.Invoke(this, new ProgressEventArgs(progress, total));
-
-                System.Threading.Thread.Sleep(100);
-            }
+            // Wait for operation to complete
+            PckNative.pck_waitForTask(PckNative.PCK_WAIT_INFINITE);
 
             var success = PckNative.pck_isLastOptSuccess();
 
@@ -339,13 +396,7 @@ public class PckService : IDisposable
             }
 
             // Wait for operation to complete
-            while (PckNative.pck_isThreadWorking())
-            {
-                var progress = PckNative.pck_getUIProgress();
-                var total = PckNative.pck_getUIProgressUpper();
-                ProgressChanged?.Invoke(this, new ProgressEventArgs(progress, total));
-                System.Threading.Thread.Sleep(100);
-            }
+            PckNative.pck_waitForTask(PckNative.PCK_WAIT_INFINITE);
 
             var success = PckNative.pck_isLastOptSuccess();
             _logger.Information("PCK creation {Status}", success ? "succeeded" : "failed");
@@ -373,13 +424,7 @@ public class PckService : IDisposable
             }
 
             // Wait for operation to complete
-            while (PckNative.pck_isThreadWorking())
-            {
-                var progress = PckNative.pck_getUIProgress();
-                var total = PckNative.pck_getUIProgressUpper();
-                ProgressChanged?.Invoke(this, new ProgressEventArgs(progress, total));
-                System.Threading.Thread.Sleep(100);
-            }
+            PckNative.pck_waitForTask(PckNative.PCK_WAIT_INFINITE);
 
             var success = PckNative.pck_isLastOptSuccess();
             _logger.Information("Add files {Status}", success ? "succeeded" : "failed");
@@ -419,10 +464,7 @@ public class PckService : IDisposable
             }
 
             // Wait for operation to complete
-            while (PckNative.pck_isThreadWorking())
-            {
-                System.Threading.Thread.Sleep(100);
-            }
+            PckNative.pck_waitForTask(PckNative.PCK_WAIT_INFINITE);
 
             var success = PckNative.pck_isLastOptSuccess();
             _logger.Information("Rename {Status}", success ? "succeeded" : "failed");
@@ -462,10 +504,7 @@ public class PckService : IDisposable
             }
 
             // Wait for operation to complete
-            while (PckNative.pck_isThreadWorking())
-            {
-                System.Threading.Thread.Sleep(100);
-            }
+            PckNative.pck_waitForTask(PckNative.PCK_WAIT_INFINITE);
 
             var success = PckNative.pck_isLastOptSuccess();
             _logger.Information("Delete {Status}", success ? "succeeded" : "failed");
@@ -499,13 +538,7 @@ public class PckService : IDisposable
             }
 
             // Wait for operation to complete
-            while (PckNative.pck_isThreadWorking())
-            {
-                var progress = PckNative.pck_getUIProgress();
-                var total = PckNative.pck_getUIProgressUpper();
-                ProgressChanged?.Invoke(this, new ProgressEventArgs(progress, total));
-                System.Threading.Thread.Sleep(100);
-            }
+            PckNative.pck_waitForTask(PckNative.PCK_WAIT_INFINITE);
 
             var success = PckNative.pck_isLastOptSuccess();
             _logger.Information("Rebuild {Status}", success ? "succeeded" : "failed");
@@ -533,13 +566,7 @@ public class PckService : IDisposable
             }
 
             // Wait for operation to complete
-            while (PckNative.pck_isThreadWorking())
-            {
-                var progress = PckNative.pck_getUIProgress();
-                var total = PckNative.pck_getUIProgressUpper();
-                ProgressChanged?.Invoke(this, new ProgressEventArgs(progress, total));
-                System.Threading.Thread.Sleep(100);
-            }
+            PckNative.pck_waitForTask(PckNative.PCK_WAIT_INFINITE);
 
             var success = PckNative.pck_isLastOptSuccess();
             _logger.Information("Batch extraction {Status}", success ? "succeeded" : "failed");
@@ -555,6 +582,7 @@ public class PckService : IDisposable
     public void Dispose()
     {
         CloseFile();
+        PckNative.pck_regTaskCallbacks(IntPtr.Zero, null, null, null, 0);
         _logger.Information("PckService disposed");
     }
 }
@@ -41,7 +41,7 @@ public partial class MainWindowViewModel : ViewModelBase
     private PckFileInfo? _currentFileInfo;
 
     [ObservableProperty]
-    private ObservableCollection<PckFileEntry> _fileEntries = new();
+    private PckEntryPages _fileEntries = PckEntryPages.Empty;
 
     [ObservableProperty]
     private ObservableCollection<string> _logMessages = new();
@@ -68,8 +68,9 @@ public partial class MainWindowViewModel : ViewModelBase
     [ObservableProperty]
     private PckTreeNode? _selectedTreeNode;
 
+    // Read from the library a page at a time as the list shows them
     [ObservableProperty]
-    private ObservableCollection<PckFileEntry> _currentFolderEntries = new();
+    private PckEntryPages _currentFolderEntries = PckEntryPages.Empty;
 
     public MainWindowViewModel()
     {
@@ -89,11 +90,16 @@ public partial class MainWindowViewModel : ViewModelBase
 
     private void OnLogMessageReceived(object? sender, string message)
     {
-        LogMessages.Insert(0, $"[{DateTime.Now:HH:mm:ss}] {message}");
-        if (LogMessages.Count > 1000)
+        // Raised on the log thread of the library while a task runs
+        var line = $"[{DateTime.Now:HH:mm:ss}] {message}";
+        Dispatcher.UIThread.Post(() =>
         {
-            LogMessages.RemoveAt(LogMessages.Count - 1);
-        }
+            LogMessages.Insert(0, line);
+            if (LogMessages.Count > 1000)
+            {
+                LogMessages.RemoveAt(LogMessages.Count - 1);
+            }
+        });
     }
 
     partial void OnSelectedTreeNodeChanged(PckTreeNode? value)
@@ -107,8 +113,12 @@ public partial class MainWindowViewModel : ViewModelBase
 
     private void OnProgressChanged(object? sender, ProgressEventArgs e)
     {
-        ProgressValue = e.Percentage;
-        StatusText = $"Progress: {e.Current}/{e.Total} ({e.Percentage:F1}%)";
+        // Raised on a library thread
+        Dispatcher.UIThread.Post(() =>
+        {
+            ProgressValue = e.Percentage;
+            StatusText = $"Progress: {e.Current}/{e.Total} ({e.Percentage:F1}%)";
+        });
     }
 
     [RelayCommand]
@@ -185,9 +195,9 @@ public partial class MainWindowViewModel : ViewModelBase
             _pckService.CloseFile();
             IsFileOpen = false;
             CurrentFileInfo = null;
-            FileEntries.Clear();
+            FileEntries = PckEntryPages.Empty;
             TreeRootNodes.Clear();
-            CurrentFolderEntries.Clear();
+            CurrentFolderEntries = PckEntryPages.Empty;
             Title = "WinPCK - Linux Edition";
             AddLogMessage("INFO", "File closed");
         }
@@ -269,14 +279,8 @@ public partial class MainWindowViewModel : ViewModelBase
         try
         {
             _logger.Information("Loading file list");
-            FileEntries.Clear();
-
-            var entries = await Task.Run(() => _pckService.ListFiles());
-
-            foreach (var entry in entries)
-            {
-                FileEntries.Add(entry);
-            }
+            FileEntries = await Task.Run(() => new PckEntryPages(
+                (uint offset, uint maxCount, out uint total) => _pckService.ListFiles(null, offset, maxCount, out total)));
 
             AddLogMessage("INFO", $"Loaded {FileEntries.Count} entries");
         }
@@ -484,13 +488,10 @@ public partial class MainWindowViewModel : ViewModelBase
 
             AddLogMessage("INFO", $"Searching for: {searchText}");
 
-            var results = await Task.Run(() => _pckService.SearchFiles(searchText));
+            var results = await Task.Run(() => new PckEntryPages(
+                (uint offset, uint maxCount, out uint total) => _pckService.SearchFiles(searchText, offset, maxCount, out total)));
 
-            CurrentFolderEntries.Clear();
-            foreach (var result in results)
-            {
-                CurrentFolderEntries.Add(result);
-            }
+            CurrentFolderEntries = results;
 
             AddLogMessage("SUCCESS", $"Found {results.Count} matching files");
         }
@@ -577,65 +578,45 @@ public partial class MainWindowViewModel : ViewModelBase
         if (entryPtr != IntPtr.Zero)
             visitedNodes.Add(entryPtr);
 
-        var entries = _pckService.ListFiles(entryPtr == IntPtr.Zero ? null : entryPtr);
+        // The files are read when the folder is shown
+        var folders = _pckService.ListFolders(entryPtr == IntPtr.Zero ? null : entryPtr);
 
-        foreach (var entry in entries)
+        foreach (var entry in folders)
         {
-            if (entry.IsFolder)
+            var childNode = new PckTreeNode
             {
-                var childNode = new PckTreeNode
-                {
-                    DisplayName = entry.Name,
-                    Icon = "📁",
-                    EntryPointer = entry.EntryPointer,
-                    IsFolder = true
-                };
+                DisplayName = entry.Name,
+                Icon = "📁",
+                EntryPointer = entry.EntryPointer,
+                IsFolder = true
+            };
 
-                // Recursively build child folders
-                BuildTreeNodeRecursive(childNode, entry.EntryPointer, visitedNodes);
+            // Recursively build child folders
+            BuildTreeNodeRecursive(childNode, entry.EntryPointer, visitedNodes);
 
-                parentNode.Children.Add(childNode);
-            }
-            else
-            {
-                parentNode.Files.Add(entry);
-            }
+            parentNode.Children.Add(childNode);
         }
     }
 
-    private void LoadFolderContents(PckTreeNode node)
+    private async void LoadFolderContents(PckTreeNode node)
     {
         try
         {
-            _logger.Information($"Loading contents for: {node.DisplayName} (Files: {node.Files.Count}, Children: {node.Children.Count})");
+            _logger.Information($"Loading contents for: {node.DisplayName} (Children: {node.Children.Count})");
 
-            // Ensure UI updates happen on the UI thread
-            Dispatcher.UIThread.Post(() =>
-            {
-                CurrentFolderEntries.Clear();
+            var entryPtr = node.EntryPointer;
+            var entries = await Task.Run(() => new PckEntryPages(
+                (uint offset, uint maxCount, out uint total) =>
+                    _pckService.ListFiles(entryPtr == IntPtr.Zero ? null : entryPtr, offset, maxCount, out total)));
 
-                // Add child folders first
-                foreach (var child in node.Children)
-                {
-                    CurrentFolderEntries.Add(new PckFileEntry
-                    {
-                        Name = child.DisplayName,
-                        EntryType = 0x01, // Folder type
-                        Size = 0,
-                        CompressedSize = 0,
-                        EntryPointer = child.EntryPointer
-                    });
-                }
+            // Another folder was selected while this one was read
+            if (SelectedTreeNode != node)
+                return;
 
-                // Add all files in this folder
-                foreach (var file in node.Files)
-                {
-                    CurrentFolderEntries.Add(file);
-                }
+            CurrentFolderEntries = entries;
 
-                _logger.Information($"Loaded {CurrentFolderEntries.Count} entries to CurrentFolderEntries");
-                AddLogMessage("INFO", $"Loaded folder: {node.DisplayName} ({CurrentFolderEntries.Count} items)");
-            });
+            _logger.Information($"Loaded {CurrentFolderEntries.Count} entries to CurrentFolderEntries");
+            AddLogMessage("INFO", $"Loaded folder: {node.DisplayName} ({CurrentFolderEntries.Count} items)");
         }
         catch (Exception ex)
         {
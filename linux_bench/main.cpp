@@ -0,0 +1,584 @@
+/*
+ * Benchmark for WinPCK on Linux
+ * Generates synthetic archives and times the operations of the public API,
+ * the results are written as JSON to compare builds and releases
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+#include <wchar.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+
+// Include PCK library header
+#include "pck_handle.h"
+
+namespace fs = std::filesystem;
+
+enum SizeDistribution {
+    DIST_FIXED,
+    DIST_UNIFORM,
+    DIST_LOG
+};
+
+struct BenchConfig {
+    std::string work_dir = "pck_bench_work";
+    std::string output;                 // stdout if empty
+    std::string trace;                  // Chrome trace of the library, none if empty
+    uint32_t files = 2000;
+    uint32_t folders = 20;
+    uint32_t add_files = 200;
+    uint64_t min_size = 0;
+    uint64_t max_size = 256 * 1024;
+    SizeDistribution dist = DIST_LOG;
+    uint32_t compressibility = 50;      // percent of the data that is text
+    uint32_t iterations = 3;
+    uint32_t level = 0;                 // 0 - the default of the library
+    uint32_t threads = 0;               // 0 - the default of the library
+    uint64_t seed = 1;
+    bool keep = false;
+    bool verbose = false;
+};
+
+// Time the library spent in one of its stages, summed over threads
+struct ProfileStage {
+    uint64_t nanoseconds = 0;
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
+
+struct StageResult {
+    std::string name;
+    std::vector<double> seconds;
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+    bool ok = true;
+    std::vector<ProfileStage> profile;  // all iterations
+};
+
+struct DataSet {
+    uint32_t files = 0;
+    uint64_t bytes = 0;
+};
+
+static bool g_verbose = false;
+
+void print_usage(const char* program) {
+    printf("WinPCK benchmark\n\n");
+    printf("Usage: %s [options]\n\n", program);
+    printf("Options:\n");
+    printf("  --dir <path>             Work directory, removed when done (default pck_bench_work)\n");
+    printf("  --output <file>          Write the JSON results to a file instead of stdout\n");
+    printf("  --trace <file>           Write a Chrome trace of the stages of the library\n");
+    printf("  --files <n>              Files in the generated archive (default 2000)\n");
+    printf("  --folders <n>            Folders the files are spread over (default 20)\n");
+    printf("  --add-files <n>          Files added to the archive by the add stage (default 200)\n");
+    printf("  --min-size <bytes>       Smallest file (default 0)\n");
+    printf("  --max-size <bytes>       Largest file (default 262144)\n");
+    printf("  --dist <fixed|uniform|log>\n");
+    printf("                           Distribution of the file sizes (default log)\n");
+    printf("  --compressibility <0-100>\n");
+    printf("                           Percent of the data that is text, the rest is random (default 50)\n");
+    printf("  --iterations <n>         Runs of each stage (default 3)\n");
+    printf("  --level <n>              Compression level (default of the library)\n");
+    printf("  --threads <n>            Worker threads (default of the library)\n");
+    printf("  --seed <n>               Seed of the generator (default 1)\n");
+    printf("  --keep                   Keep the work directory\n");
+    printf("  --verbose                Show the log of the library\n");
+    printf("\n");
+}
+
+// Only errors are shown unless --verbose is given
+void log_callback(char level, const wchar_t* msg) {
+    if (g_verbose || level == 'E') {
+        fprintf(stderr, "[%c] %ls\n", level, msg);
+    }
+}
+
+std::wstring to_wstring(const std::string& str) {
+    std::wstring result(str.size() + 1, L'\0');
+    size_t len = mbstowcs(&result[0], str.c_str(), result.size());
+    if (len == (size_t)-1) return L"";
+    result.resize(len);
+    return result;
+}
+
+#pragma region Data generator
+
+// xorshift64*, the same data for the same seed on every platform
+struct Random {
+    uint64_t state;
+
+    explicit Random(uint64_t seed) : state(seed ? seed : 0x9e3779b97f4a7c15ULL) {}
+
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545f4914f6cdd1dULL;
+    }
+
+    // [0, n)
+    uint64_t below(uint64_t n) {
+        return n ? (next() % n) : 0;
+    }
+
+    double unit() {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+static const char* const g_words[] = {
+    "model", "texture", "skill", "effect", "config", "npc", "monster", "item",
+    "weapon", "armor", "sound", "map", "region", "quest", "dialog", "level",
+    "0", "1", "2", "16", "255", "=", ";", "{", "}", "\r\n", "\t", " ",
+};
+
+uint64_t pick_size(Random& rnd, const BenchConfig& cfg) {
+    switch (cfg.dist) {
+    case DIST_FIXED:
+        return cfg.max_size;
+    case DIST_UNIFORM:
+        return cfg.min_size + rnd.below(cfg.max_size - cfg.min_size + 1);
+    default: {
+        double lo = log((double)cfg.min_size + 1);
+        double hi = log((double)cfg.max_size + 1);
+        uint64_t size = (uint64_t)exp(lo + (hi - lo) * rnd.unit()) - 1;
+        return std::min(std::max(size, cfg.min_size), cfg.max_size);
+    }
+    }
+}
+
+// Runs of 256 bytes are either words or random bytes
+void fill_data(Random& rnd, std::vector<char>& data, uint32_t compressibility) {
+    const size_t word_count = sizeof(g_words) / sizeof(g_words[0]);
+    size_t pos = 0;
+
+    while (pos < data.size()) {
+        size_t end = std::min(pos + 256, data.size());
+
+        if (rnd.below(100) < compressibility) {
+            while (pos < end) {
+                const char* word = g_words[rnd.below(word_count)];
+                size_t len = std::min(strlen(word), end - pos);
+                memcpy(&data[pos], word, len);
+                pos += len;
+            }
+        }
+        else {
+            for (; pos < end; ++pos)
+                data[pos] = (char)rnd.next();
+        }
+    }
+}
+
+bool generate_tree(const fs::path& dir, const char* prefix, uint32_t files, const BenchConfig& cfg, uint64_t seed, DataSet& set) {
+    Random rnd(seed);
+    std::vector<char> data;
+    uint32_t folders = std::max<uint32_t>(cfg.folders, 1);
+
+    for (uint32_t i = 0; i < files; ++i) {
+        char name[64];
+        fs::path folder = dir / (std::string(prefix) + std::to_string(i % folders));
+        snprintf(name, sizeof(name), "%s%u.dat", prefix, i);
+
+        std::error_code ec;
+        fs::create_directories(folder, ec);
+
+        data.resize(pick_size(rnd, cfg));
+        fill_data(rnd, data, cfg.compressibility);
+
+        FILE* fp = fopen((folder / name).c_str(), "wb");
+        if (!fp) {
+            fprintf(stderr, "Error: Failed to create %s\n", (folder / name).c_str());
+            return false;
+        }
+        if (!data.empty() && fwrite(data.data(), 1, data.size(), fp) != data.size()) {
+            fclose(fp);
+            fprintf(stderr, "Error: Failed to write %s\n", (folder / name).c_str());
+            return false;
+        }
+        fclose(fp);
+
+        set.files++;
+        set.bytes += data.size();
+    }
+    return true;
+}
+
+#pragma endregion
+
+#pragma region Stages
+
+std::vector<ProfileStage> read_profile() {
+    std::vector<ProfileStage> profile(pck_getProfileStageCount());
+    for (uint32_t i = 0; i < profile.size(); ++i)
+        pck_getProfileStage(i, &profile[i].nanoseconds, &profile[i].count, &profile[i].bytes);
+    return profile;
+}
+
+template<typename Func>
+StageResult run_stage(const char* name, uint32_t iterations, uint64_t files, uint64_t bytes, Func func) {
+    StageResult result;
+    result.name = name;
+    result.files = files;
+    result.bytes = bytes;
+
+    fprintf(stderr, "%-12s", name);
+
+    // The counters run for the whole benchmark, a stage gets the difference
+    std::vector<ProfileStage> before = read_profile();
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        bool ok = func();
+        auto end = std::chrono::steady_clock::now();
+
+        if (!ok) {
+            result.ok = false;
+            break;
+        }
+
+        result.seconds.push_back(std::chrono::duration<double>(end - start).count());
+        fprintf(stderr, " %.3fs", result.seconds.back());
+    }
+
+    fprintf(stderr, result.ok ? "\n" : " failed\n");
+
+    result.profile = read_profile();
+    for (size_t i = 0; i < result.profile.size(); ++i) {
+        result.profile[i].nanoseconds -= before[i].nanoseconds;
+        result.profile[i].count -= before[i].count;
+        result.profile[i].bytes -= before[i].bytes;
+    }
+    return result;
+}
+
+struct ListCount {
+    uint64_t files = 0;
+    std::vector<LPCENTRY> folders;
+};
+
+void list_callback(void* param, int32_t sn, const wchar_t* szName, int32_t entryType,
+                  uint64_t dwFileClearTextSize, uint64_t dwFileCipherTextSize, void* fileEntry) {
+    ListCount* count = (ListCount*)param;
+
+    if (entryType & PCK_ENTRY_TYPE_DOTDOT)
+        return;
+
+    if (entryType & PCK_ENTRY_TYPE_FOLDER)
+        count->folders.push_back((LPCENTRY)fileEntry);
+    else
+        count->files++;
+}
+
+void search_callback(void* param, int32_t sn, const wchar_t* szName, int32_t entryType,
+                  uint64_t dwFileClearTextSize, uint64_t dwFileCipherTextSize, void* fileEntry) {
+    ++*(uint64_t*)param;
+}
+
+// Walks the whole tree, as a file manager showing every folder would
+bool list_all() {
+    ListCount count;
+    count.folders.push_back(pck_getRootNode());
+
+    while (!count.folders.empty()) {
+        LPCENTRY folder = count.folders.back();
+        count.folders.pop_back();
+        pck_listByNode(folder, &count, list_callback);
+    }
+    return count.files == pck_filecount();
+}
+
+bool search_all() {
+    static const wchar_t* const patterns[] = { L"f1", L"7.dat", L"f", L"no such file" };
+
+    for (const wchar_t* pattern : patterns) {
+        uint64_t found = 0;
+        pck_searchByName(pattern, &found, search_callback);
+    }
+    return true;
+}
+
+#pragma endregion
+
+#pragma region JSON
+
+std::string json_string(const std::string& str) {
+    std::string out = "\"";
+    for (unsigned char c : str) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            }
+            else {
+                out += (char)c;
+            }
+        }
+    }
+    return out + "\"";
+}
+
+const char* dist_name(SizeDistribution dist) {
+    switch (dist) {
+    case DIST_FIXED: return "fixed";
+    case DIST_UNIFORM: return "uniform";
+    default: return "log";
+    }
+}
+
+void write_json(FILE* fp, const BenchConfig& cfg, const DataSet& set, uint64_t pck_size, const std::vector<StageResult>& results) {
+    char timestamp[32];
+    time_t now = time(NULL);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"version\": %s,\n", json_string(pck_version()).c_str());
+    fprintf(fp, "  \"timestamp\": \"%s\",\n", timestamp);
+    fprintf(fp, "  \"config\": {\n");
+    fprintf(fp, "    \"files\": %u,\n", cfg.files);
+    fprintf(fp, "    \"folders\": %u,\n", cfg.folders);
+    fprintf(fp, "    \"add_files\": %u,\n", cfg.add_files);
+    fprintf(fp, "    \"min_size\": %llu,\n", (unsigned long long)cfg.min_size);
+    fprintf(fp, "    \"max_size\": %llu,\n", (unsigned long long)cfg.max_size);
+    fprintf(fp, "    \"distribution\": \"%s\",\n", dist_name(cfg.dist));
+    fprintf(fp, "    \"compressibility\": %u,\n", cfg.compressibility);
+    fprintf(fp, "    \"iterations\": %u,\n", cfg.iterations);
+    fprintf(fp, "    \"level\": %u,\n", pck_getCompressLevel());
+    fprintf(fp, "    \"threads\": %u,\n", pck_getMaxThread());
+    fprintf(fp, "    \"seed\": %llu\n", (unsigned long long)cfg.seed);
+    fprintf(fp, "  },\n");
+    fprintf(fp, "  \"archive\": {\n");
+    fprintf(fp, "    \"files\": %u,\n", set.files);
+    fprintf(fp, "    \"bytes\": %llu,\n", (unsigned long long)set.bytes);
+    fprintf(fp, "    \"pck_size\": %llu\n", (unsigned long long)pck_size);
+    fprintf(fp, "  },\n");
+    fprintf(fp, "  \"stages\": [\n");
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const StageResult& r = results[i];
+
+        double best = 0, mean = 0;
+        if (!r.seconds.empty()) {
+            best = *std::min_element(r.seconds.begin(), r.seconds.end());
+            for (double s : r.seconds) mean += s;
+            mean /= r.seconds.size();
+        }
+
+        fprintf(fp, "    {\n");
+        fprintf(fp, "      \"name\": %s,\n", json_string(r.name).c_str());
+        fprintf(fp, "      \"ok\": %s,\n", r.ok ? "true" : "false");
+        fprintf(fp, "      \"files\": %llu,\n", (unsigned long long)r.files);
+        fprintf(fp, "      \"bytes\": %llu,\n", (unsigned long long)r.bytes);
+        fprintf(fp, "      \"seconds\": [");
+        for (size_t j = 0; j < r.seconds.size(); ++j)
+            fprintf(fp, "%s%.6f", j ? ", " : "", r.seconds[j]);
+        fprintf(fp, "],\n");
+        fprintf(fp, "      \"best\": %.6f,\n", best);
+        fprintf(fp, "      \"mean\": %.6f,\n", mean);
+        fprintf(fp, "      \"files_per_second\": %.1f,\n", best > 0 ? r.files / best : 0.0);
+        fprintf(fp, "      \"mb_per_second\": %.3f,\n", best > 0 ? r.bytes / best / 1048576.0 : 0.0);
+        fprintf(fp, "      \"profile\": {");
+        bool first = true;
+        for (size_t j = 0; j < r.profile.size(); ++j) {
+            const ProfileStage& p = r.profile[j];
+            if (p.count == 0) continue;
+            fprintf(fp, "%s\n        \"%s\": { \"seconds\": %.6f, \"count\": %llu, \"bytes\": %llu }",
+                first ? "" : ",", pck_getProfileStageName(j), p.nanoseconds / 1e9,
+                (unsigned long long)p.count, (unsigned long long)p.bytes);
+            first = false;
+        }
+        fprintf(fp, first ? "}\n" : "\n      }\n");
+        fprintf(fp, "    }%s\n", (i + 1 < results.size()) ? "," : "");
+    }
+
+    fprintf(fp, "  ]\n");
+    fprintf(fp, "}\n");
+}
+
+#pragma endregion
+
+bool parse_args(int argc, char* argv[], BenchConfig& cfg) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (strcmp(arg, "--keep") == 0) { cfg.keep = true; continue; }
+        if (strcmp(arg, "--verbose") == 0) { cfg.verbose = true; continue; }
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) return false;
+
+        if (!value) {
+            fprintf(stderr, "Error: Missing value of %s\n", arg);
+            return false;
+        }
+        ++i;
+
+        if (strcmp(arg, "--dir") == 0) cfg.work_dir = value;
+        else if (strcmp(arg, "--output") == 0) cfg.output = value;
+        else if (strcmp(arg, "--trace") == 0) cfg.trace = value;
+        else if (strcmp(arg, "--files") == 0) cfg.files = strtoul(value, NULL, 10);
+        else if (strcmp(arg, "--folders") == 0) cfg.folders = strtoul(value, NULL, 10);
+        else if (strcmp(arg, "--add-files") == 0) cfg.add_files = strtoul(value, NULL, 10);
+        else if (strcmp(arg, "--min-size") == 0) cfg.min_size = strtoull(value, NULL, 10);
+        else if (strcmp(arg, "--max-size") == 0) cfg.max_size = strtoull(value, NULL, 10);
+        else if (strcmp(arg, "--compressibility") == 0) cfg.compressibility = std::min<uint32_t>(strtoul(value, NULL, 10), 100);
+        else if (strcmp(arg, "--iterations") == 0) cfg.iterations = std::max<uint32_t>(strtoul(value, NULL, 10), 1);
+        else if (strcmp(arg, "--level") == 0) cfg.level = strtoul(value, NULL, 10);
+        else if (strcmp(arg, "--threads") == 0) cfg.threads = strtoul(value, NULL, 10);
+        else if (strcmp(arg, "--seed") == 0) cfg.seed = strtoull(value, NULL, 10);
+        else if (strcmp(arg, "--dist") == 0) {
+            if (strcmp(value, "fixed") == 0) cfg.dist = DIST_FIXED;
+            else if (strcmp(value, "uniform") == 0) cfg.dist = DIST_UNIFORM;
+            else if (strcmp(value, "log") == 0) cfg.dist = DIST_LOG;
+            else {
+                fprintf(stderr, "Error: Unknown distribution: %s\n", value);
+                return false;
+            }
+        }
+        else {
+            fprintf(stderr, "Error: Unknown option: %s\n", arg);
+            return false;
+        }
+    }
+
+    if (cfg.min_size > cfg.max_size) {
+        fprintf(stderr, "Error: --min-size is larger than --max-size\n");
+        return false;
+    }
+    // Files of 4GB or more can not be stored in a pck
+    if (cfg.max_size >= 0xffffffffULL) {
+        fprintf(stderr, "Error: --max-size must be below 4GB\n");
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    // Set locale for wide character support
+    setlocale(LC_ALL, "");
+
+    BenchConfig cfg;
+    if (!parse_args(argc, argv, cfg)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    g_verbose = cfg.verbose;
+    log_regShowFunc(log_callback);
+
+    if (cfg.level) pck_setCompressLevel(cfg.level);
+    if (cfg.threads) pck_setMaxThread(cfg.threads);
+    int level = pck_getCompressLevel();
+
+    // Extracting changes the current directory
+    if (!cfg.output.empty()) cfg.output = fs::absolute(cfg.output).string();
+    if (!cfg.trace.empty()) cfg.trace = fs::absolute(cfg.trace).string();
+
+    std::error_code ec;
+    fs::path work = fs::absolute(cfg.work_dir);
+    fs::remove_all(work, ec);
+
+    fs::path src_dir = work / "src";
+    fs::path add_dir = work / "add";
+    fs::path extract_dir = work / "extract";
+    std::wstring wsrc = to_wstring(src_dir.string());
+    std::wstring wadd = to_wstring(add_dir.string());
+    std::wstring wextract = to_wstring(extract_dir.string());
+    std::wstring wpck = to_wstring((work / "bench.pck").string());
+    std::wstring wadd_pck = to_wstring((work / "bench_add.pck").string());
+    std::wstring wrebuild = to_wstring((work / "bench_rebuild.pck").string());
+
+    fprintf(stderr, "Generating %u files in %s\n", cfg.files, work.c_str());
+
+    DataSet set, add_set;
+    if (!generate_tree(src_dir, "f", cfg.files, cfg, cfg.seed, set) ||
+        !generate_tree(add_dir, "a", cfg.add_files, cfg, cfg.seed + 1, add_set)) {
+        return 1;
+    }
+
+    std::vector<StageResult> results;
+
+    std::wstring wtrace = to_wstring(cfg.trace);
+    pck_startProfile(cfg.trace.empty() ? NULL : wtrace.c_str());
+
+    results.push_back(run_stage("create", cfg.iterations, set.files, set.bytes, [&]() {
+        return do_CreatePckFile(wsrc.c_str(), wpck.c_str(), 0, level) == WINPCK_OK;
+    }));
+
+    if (!results.back().ok) {
+        fprintf(stderr, "Error: Failed to create the archive\n");
+        return 1;
+    }
+
+    uint64_t pck_size = fs::file_size(work / "bench.pck", ec);
+
+    results.push_back(run_stage("open", cfg.iterations, set.files, 0, [&]() {
+        bool ok = (pck_open(wpck.c_str()) == WINPCK_OK) && pck_IsValidPck();
+        pck_close();
+        return ok;
+    }));
+
+    if (pck_open(wpck.c_str()) == WINPCK_OK) {
+
+        results.push_back(run_stage("list", cfg.iterations, set.files, 0, list_all));
+        results.push_back(run_stage("search", cfg.iterations, set.files, 0, search_all));
+
+        results.push_back(run_stage("extract", cfg.iterations, set.files, set.bytes, [&]() {
+            fs::remove_all(extract_dir, ec);
+            return pck_ExtractAllFiles(wextract.c_str()) == WINPCK_OK;
+        }));
+
+        pck_close();
+    }
+
+    results.push_back(run_stage("add", cfg.iterations, add_set.files, add_set.bytes, [&]() {
+        fs::copy_file(work / "bench.pck", work / "bench_add.pck", fs::copy_options::overwrite_existing, ec);
+        return !ec && do_AddFileToPckFile(wadd.c_str(), wadd_pck.c_str(), L"", level) == WINPCK_OK;
+    }));
+
+    results.push_back(run_stage("rebuild", cfg.iterations, set.files, set.bytes, [&]() {
+        return do_RebuildPckFileWithScript(wpck.c_str(), NULL, wrebuild.c_str(), FALSE, level) == WINPCK_OK;
+    }));
+
+    results.push_back(run_stage("recompress", cfg.iterations, set.files, set.bytes, [&]() {
+        return do_RebuildPckFileWithScript(wpck.c_str(), NULL, wrebuild.c_str(), TRUE, level) == WINPCK_OK;
+    }));
+
+    if (!pck_stopProfile() && !cfg.trace.empty())
+        fprintf(stderr, "Error: Failed to write %s\n", cfg.trace.c_str());
+
+    FILE* fp = stdout;
+    if (!cfg.output.empty() && !(fp = fopen(cfg.output.c_str(), "w"))) {
+        fprintf(stderr, "Error: Failed to write %s\n", cfg.output.c_str());
+        return 1;
+    }
+
+    write_json(fp, cfg, set, pck_size, results);
+
+    if (fp != stdout)
+        fclose(fp);
+
+    if (!cfg.keep)
+        fs::remove_all(work, ec);
+
+    for (const StageResult& r : results) {
+        if (!r.ok) return 1;
+    }
+    return 0;
+}
@@ -9,6 +9,8 @@
 #include <locale.h>
 #include <wchar.h>
 #include <string>
+#include <vector>
+#include <fstream>
 #include <iostream>
 
 // Include PCK library header
@@ -24,10 +26,42 @@ void print_usage(const char* program) {
     printf("  info <pck_file>                - Show PCK file information\n");
     printf("  create <src_dir> <pck_file>    - Create new PCK file\n");
     printf("  add <pck_file> <file> [path]   - Add file to PCK\n");
+    printf("  rebuild <pck_file> <new_pck> [layout [list_file]]\n");
+    printf("                                 - Rebuild PCK, copy data without recompressing\n");
+    printf("  recompress <pck_file> <new_pck> [layout [list_file]]\n");
+    printf("                                 - Rebuild PCK and recompress all data\n");
+    printf("  apply-zup <zup_file> <pck_file> [zup_folder [path]]\n");
+    printf("                                 - Add the files of a ZUP folder to PCK\n");
+    printf("  strip <pck_file> <new_pck> [parts]\n");
+    printf("                                 - Recompress PCK without client-only content\n");
+    printf("  batch <operation> [options] <pck_file>...\n");
+    printf("                                 - Run one operation on many PCK files at the same time\n");
+    printf("  overlay <operation> [options] <pck_file>...\n");
+    printf("                                 - Mount PCK files over each other, later ones override earlier ones\n");
+    printf("  cat <pck_file> <path> [offset [length]]\n");
+    printf("                                 - Write a file of PCK to stdout without extracting it\n");
+    printf("\nLayouts (order of file data in the rebuilt PCK):\n");
+    printf("  original (default), dir, ext, list <list_file>\n");
+    printf("\nStrip parts (comma separated, default dds,att,gfx):\n");
+    printf("  dds - model textures, att - paths in .att files, gfx - elements of .gfx files\n");
+    printf("\nBatch operations: verify, extract, rebuild, recompress, strip\n");
+    printf("  --dest <dir>      - Output directory (not used by verify), a.pck goes to <dir>/a.pck or <dir>/a\n");
+    printf("  --path <path>     - extract: only this file or folder of each PCK\n");
+    printf("  --script <file>   - rebuild/recompress: filter script\n");
+    printf("  --parts <parts>   - strip: parts to strip, as for strip\n");
+    printf("  --threads <n>     - Threads shared by all PCK files (default: one per CPU)\n");
+    printf("  --list <file>     - Read more PCK files from a file, one per line\n");
+    printf("\nOverlay operations: list, which, extract\n");
+    printf("  --path <path>     - list/extract: this folder or file, which: the path to look up\n");
+    printf("  --dest <dir>      - extract: output directory\n");
     printf("\nExamples:\n");
     printf("  %s list game.pck\n", program);
     printf("  %s extract game.pck ./output\n", program);
     printf("  %s info game.pck\n", program);
+    printf("  %s batch verify *.pck\n", program);
+    printf("  %s batch recompress --dest ./out --threads 8 *.pck\n", program);
+    printf("  %s overlay which --path gfx\\ui.dds base.pck patch1.pck patch2.pck\n", program);
+    printf("  %s cat game.pck gfx\\ui.dds 1048576 4096 | xxd\n", program);
     printf("\n");
 }
 
@@ -54,6 +88,11 @@ void log_callback(char level, const wchar_t* msg) {
     wprintf(L"[%c] %ls\n", level, msg);
 }
 
+// Callback for logging while stdout holds file data
+void log_stderr_callback(char level, const wchar_t* msg) {
+    fprintf(stderr, "[%c] %ls\n", level, msg);
+}
+
 // Callback for listing files
 void list_callback(void* param, int32_t sn, const wchar_t* szName, int32_t entryType,
                   uint64_t dwFileClearTextSize, uint64_t dwFileCipherTextSize, void* fileEntry) {
@@ -241,6 +280,357 @@ int cmd_create(const char* src_dir, const char* pck_file) {
     return 0;
 }
 
+int cmd_rebuild(const char* pck_file, const char* new_pck_file, BOOL recompress, const char* layout, const char* list_file) {
+    std::wstring wpck = char_to_wstring(pck_file);
+    std::wstring wnew = char_to_wstring(new_pck_file);
+    std::wstring wlist = char_to_wstring(list_file);
+
+    int iLayout = PCK_LAYOUT_ORIGINAL;
+    if (layout) {
+        if (strcmp(layout, "original") == 0) iLayout = PCK_LAYOUT_ORIGINAL;
+        else if (strcmp(layout, "dir") == 0) iLayout = PCK_LAYOUT_BY_DIRECTORY;
+        else if (strcmp(layout, "ext") == 0) iLayout = PCK_LAYOUT_BY_EXTENSION;
+        else if (strcmp(layout, "list") == 0) iLayout = PCK_LAYOUT_ACCESS_LIST;
+        else {
+            fprintf(stderr, "Error: Unknown layout: %s\n", layout);
+            return 1;
+        }
+    }
+
+    if (pck_setRebuildLayout(iLayout, wlist.c_str()) != WINPCK_OK) {
+        fprintf(stderr, "Error: Invalid layout parameters\n");
+        return 1;
+    }
+
+    printf("%s PCK file: %s -> %s\n", recompress ? "Recompressing" : "Rebuilding", pck_file, new_pck_file);
+
+    PCKRTN ret = do_RebuildPckFileWithScript(wpck.c_str(), NULL, wnew.c_str(), recompress, pck_getDefaultCompressLevel());
+    if (ret != WINPCK_OK) {
+        fprintf(stderr, "Error: Rebuild failed\n");
+        return 1;
+    }
+
+    printf("PCK file rebuilt successfully\n");
+    return 0;
+}
+
+int cmd_apply_zup(const char* zup_file, const char* pck_file, const char* zup_folder, const char* path) {
+    std::wstring wzup = char_to_wstring(zup_file);
+    std::wstring wpck = char_to_wstring(pck_file);
+    std::wstring wfolder = char_to_wstring(zup_folder ? zup_folder : "element");
+    std::wstring wpath = char_to_wstring(path);
+
+    printf("Applying ZUP file: %s -> %s\n", zup_file, pck_file);
+
+    PCKRTN ret = do_ApplyZupToPck(wzup.c_str(), wfolder.c_str(), wpck.c_str(), wpath.c_str(), pck_getDefaultCompressLevel());
+    if (ret == WINPCK_NOTFOUND) {
+        fprintf(stderr, "Error: Path not found in PCK: %s\n", path);
+        return 1;
+    }
+    if (ret != WINPCK_OK) {
+        fprintf(stderr, "Error: Apply failed\n");
+        return 1;
+    }
+
+    printf("ZUP file applied successfully\n");
+    return 0;
+}
+
+// Parse comma separated strip parts, NULL is the default set
+bool parse_strip_parts(const char* parts, int& flag) {
+    flag = PCK_STRIP_DDS | PCK_STRIP_ATT | PCK_STRIP_GFX;
+    if (!parts) return true;
+
+    flag = PCK_STRIP_NONE;
+
+    std::string list(parts);
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+        std::string part = list.substr(start, end - start);
+
+        if (part == "dds") flag |= PCK_STRIP_DDS;
+        else if (part == "att") flag |= PCK_STRIP_ATT;
+        else if (part == "gfx") flag |= PCK_STRIP_GFX;
+        else {
+            fprintf(stderr, "Error: Unknown strip part: %s\n", part.c_str());
+            return false;
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+int cmd_strip(const char* pck_file, const char* new_pck_file, const char* parts) {
+    std::wstring wpck = char_to_wstring(pck_file);
+    std::wstring wnew = char_to_wstring(new_pck_file);
+
+    int flag;
+    if (!parse_strip_parts(parts, flag)) {
+        return 1;
+    }
+
+    printf("Stripping PCK file: %s -> %s\n", pck_file, new_pck_file);
+
+    PCKRTN ret = do_StripPck(wpck.c_str(), wnew.c_str(), flag, pck_getDefaultCompressLevel());
+    if (ret != WINPCK_OK) {
+        fprintf(stderr, "Error: Strip failed\n");
+        return 1;
+    }
+
+    printf("PCK file stripped successfully\n");
+    return 0;
+}
+
+// Callback for each finished archive of a batch
+void batch_callback(void* param, int32_t index, int32_t result) {
+    const std::vector<std::string>* files = (const std::vector<std::string>*)param;
+    const char* status = "failed";
+
+    if (result == WINPCK_OK) status = "ok";
+    else if (result == WINPCK_INVALIDPCK) status = "invalid";
+    else if (result == WINPCK_NOTFOUND) status = "not found";
+
+    printf("[%s] %s\n", status, (*files)[index].c_str());
+    fflush(stdout);
+}
+
+int cmd_batch(int argc, char* argv[]) {
+    const char* operation = argv[0];
+    const char* dest_dir = nullptr;
+    const char* path = nullptr;
+    const char* script = nullptr;
+    const char* parts = nullptr;
+    uint32_t threads = 0;
+    std::vector<std::string> files;
+
+    PCK_BATCH_PARAMS params = {};
+
+    if (strcmp(operation, "verify") == 0) params.iOperation = PCK_BATCH_VERIFY;
+    else if (strcmp(operation, "extract") == 0) params.iOperation = PCK_BATCH_EXTRACT;
+    else if (strcmp(operation, "rebuild") == 0) params.iOperation = PCK_BATCH_REBUILD;
+    else if (strcmp(operation, "recompress") == 0) params.iOperation = PCK_BATCH_RECOMPRESS;
+    else if (strcmp(operation, "strip") == 0) params.iOperation = PCK_BATCH_STRIP;
+    else {
+        fprintf(stderr, "Error: Unknown batch operation: %s\n", operation);
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+
+        if (strcmp(argv[i], "--dest") == 0 && has_value) dest_dir = argv[++i];
+        else if (strcmp(argv[i], "--path") == 0 && has_value) path = argv[++i];
+        else if (strcmp(argv[i], "--script") == 0 && has_value) script = argv[++i];
+        else if (strcmp(argv[i], "--parts") == 0 && has_value) parts = argv[++i];
+        else if (strcmp(argv[i], "--threads") == 0 && has_value) threads = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--list") == 0 && has_value) {
+            std::ifstream list(argv[++i]);
+            if (!list) {
+                fprintf(stderr, "Error: Can not read list: %s\n", argv[i]);
+                return 1;
+            }
+            std::string line;
+            while (std::getline(list, line)) {
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (!line.empty()) files.push_back(line);
+            }
+        }
+        else if (strncmp(argv[i], "--", 2) == 0) {
+            fprintf(stderr, "Error: Unknown or incomplete option: %s\n", argv[i]);
+            return 1;
+        }
+        else files.push_back(argv[i]);
+    }
+
+    if (files.empty()) {
+        fprintf(stderr, "Error: No PCK files given\n");
+        return 1;
+    }
+
+    if (params.iOperation != PCK_BATCH_VERIFY && !dest_dir) {
+        fprintf(stderr, "Error: --dest is required for %s\n", operation);
+        return 1;
+    }
+
+    if (!parse_strip_parts(parts, params.iStripFlag)) {
+        return 1;
+    }
+
+    std::wstring wdest = char_to_wstring(dest_dir);
+    std::wstring wpath = char_to_wstring(path);
+    std::wstring wscript = char_to_wstring(script);
+
+    params.lpszDestDirectory = dest_dir ? wdest.c_str() : nullptr;
+    params.lpszPathInPck = path ? wpath.c_str() : nullptr;
+    params.lpszScriptFile = script ? wscript.c_str() : nullptr;
+    params.dwThreads = threads;
+    params.dwCompressLevel = pck_getDefaultCompressLevel();
+
+    std::vector<std::wstring> wfiles;
+    std::vector<LPCWSTR> lpfiles;
+    for (const std::string& file : files) wfiles.push_back(char_to_wstring(file.c_str()));
+    for (const std::wstring& wfile : wfiles) lpfiles.push_back(wfile.c_str());
+
+    printf("Batch %s of %zu PCK files\n", operation, files.size());
+    fflush(stdout);
+
+    std::vector<PCKRTN> status(files.size(), WINPCK_ERROR);
+    pck_runBatch(&params, lpfiles.data(), (int)lpfiles.size(), &files, batch_callback, status.data());
+
+    size_t succeeded = 0;
+    for (PCKRTN rtn : status) {
+        if (rtn == WINPCK_OK) succeeded++;
+    }
+
+    printf("%zu of %zu PCK files succeeded\n", succeeded, files.size());
+    return (succeeded == files.size()) ? 0 : 1;
+}
+
+// Callback for listing an overlay, files show the PCK they are read from
+void overlay_list_callback(void* param, int32_t sn, const wchar_t* szName, int32_t entryType,
+                  uint64_t dwFileClearTextSize, uint64_t dwFileCipherTextSize, void* fileEntry) {
+    PCKOVERLAY overlay = (PCKOVERLAY)param;
+
+    if (!szName) return;
+
+    if (entryType & PCK_ENTRY_TYPE_INDEX) {
+        LPCWSTR layer = pcko_getLayerFile(overlay, pcko_getEntryLayer(overlay, (LPCENTRY)fileEntry));
+        printf("[FILE] %ls (%llu bytes) <- %ls\n", szName, dwFileClearTextSize, layer ? layer : L"?");
+    } else if (entryType & PCK_ENTRY_TYPE_FOLDER) {
+        printf("[DIR]  %ls\n", szName);
+    }
+}
+
+int cmd_overlay(int argc, char* argv[]) {
+    // The results are printed narrow, a wide log line would leave them out of stdout
+    log_regShowFunc(log_stderr_callback);
+
+    const char* operation = argv[0];
+    const char* dest_dir = nullptr;
+    const char* path = nullptr;
+    std::vector<std::string> files;
+
+    if (strcmp(operation, "list") != 0 && strcmp(operation, "which") != 0 && strcmp(operation, "extract") != 0) {
+        fprintf(stderr, "Error: Unknown overlay operation: %s\n", operation);
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+
+        if (strcmp(argv[i], "--dest") == 0 && has_value) dest_dir = argv[++i];
+        else if (strcmp(argv[i], "--path") == 0 && has_value) path = argv[++i];
+        else if (strncmp(argv[i], "--", 2) == 0) {
+            fprintf(stderr, "Error: Unknown or incomplete option: %s\n", argv[i]);
+            return 1;
+        }
+        else files.push_back(argv[i]);
+    }
+
+    if (files.empty()) {
+        fprintf(stderr, "Error: No PCK files given\n");
+        return 1;
+    }
+
+    if ((strcmp(operation, "which") == 0 && !path) || (strcmp(operation, "extract") == 0 && !dest_dir)) {
+        fprintf(stderr, "Error: %s is required for %s\n", path ? "--dest" : "--path", operation);
+        return 1;
+    }
+
+    std::vector<std::wstring> wfiles;
+    std::vector<LPCWSTR> lpfiles;
+    for (const std::string& file : files) wfiles.push_back(char_to_wstring(file.c_str()));
+    for (const std::wstring& wfile : wfiles) lpfiles.push_back(wfile.c_str());
+
+    PCKOVERLAY overlay = pcko_open(lpfiles.data(), (int)lpfiles.size());
+    if (!overlay) {
+        fprintf(stderr, "Error: Failed to open the PCK files\n");
+        return 1;
+    }
+
+    printf("%u PCK files mounted, %u files\n", pcko_getLayerCount(overlay), pcko_filecount(overlay));
+    fflush(stdout);
+
+    std::wstring wpath = char_to_wstring(path);
+    LPCENTRY entry = path ? pcko_getFileEntryByPath(overlay, wpath.c_str()) : pcko_getRootNode(overlay);
+    int result = 0;
+
+    if (!entry) {
+        fprintf(stderr, "Error: Path not found in the overlay\n");
+        result = 1;
+    }
+    else if (strcmp(operation, "which") == 0) {
+        printf("%s <- %ls\n", path, pcko_getLayerFile(overlay, pcko_getEntryLayer(overlay, entry)));
+    }
+    else if (strcmp(operation, "list") == 0) {
+        if (entry->entryType & PCK_ENTRY_TYPE_FOLDER) {
+            uint32_t count = pck_listByNode(entry, overlay, overlay_list_callback);
+            printf("\nTotal entries: %u\n", count);
+        } else {
+            printf("[FILE] %ls (%llu bytes) <- %ls\n", entry->szName, (unsigned long long)pck_getFileSizeInEntry(entry),
+                   pcko_getLayerFile(overlay, pcko_getEntryLayer(overlay, entry)));
+        }
+    }
+    else {
+        std::wstring wdest = char_to_wstring(dest_dir);
+        if (pcko_ExtractFilesByEntrys(overlay, &entry, 1, wdest.c_str()) != WINPCK_OK) {
+            fprintf(stderr, "Error: Failed to extract files\n");
+            result = 1;
+        } else {
+            printf("Files extracted successfully\n");
+        }
+    }
+
+    pcko_close(overlay);
+    return result;
+}
+
+int cmd_cat(const char* pck_file, const char* path, uint64_t offset, uint64_t length) {
+    std::wstring wpck = char_to_wstring(pck_file);
+    std::wstring wpath = char_to_wstring(path);
+
+    // Only the data of the file goes to stdout
+    log_regShowFunc(log_stderr_callback);
+
+    if (pck_open(wpck.c_str()) != WINPCK_OK || !pck_IsValidPck()) {
+        fprintf(stderr, "Error: Failed to open PCK file\n");
+        return 1;
+    }
+
+    PCKVFILE file = pck_vfsOpen(wpath.c_str());
+    if (!file) {
+        fprintf(stderr, "Error: File not found in PCK\n");
+        pck_close();
+        return 1;
+    }
+
+    int result = 0;
+    std::vector<char> buffer(1024 * 1024);
+
+    if (pck_vfsSeek(file, (int64_t)offset, PCK_SEEK_SET) < 0) {
+        fprintf(stderr, "Error: Invalid offset\n");
+        result = 1;
+    }
+
+    while (result == 0 && length > 0) {
+        int64_t read = pck_vfsRead(file, buffer.data(), (size_t)std::min<uint64_t>(length, buffer.size()));
+        if (read < 0) {
+            fprintf(stderr, "Error: Failed to read the file\n");
+            result = 1;
+        }
+        if (read <= 0) break;
+
+        fwrite(buffer.data(), 1, (size_t)read, stdout);
+        length -= (uint64_t)read;
+    }
+
+    pck_vfsClose(file);
+    pck_close();
+    return result;
+}
+
 int main(int argc, char* argv[]) {
     // Set locale for wide character support
     setlocale(LC_ALL, "");
@@ -288,6 +678,61 @@ int main(int argc, char* argv[]) {
         }
         return cmd_create(argv[2], argv[3]);
     }
+    else if (strcmp(command, "rebuild") == 0 || strcmp(command, "recompress") == 0) {
+        if (argc < 4) {
+            fprintf(stderr, "Error: Missing arguments\n");
+            print_usage(argv[0]);
+            return 1;
+        }
+        const char* layout = (argc >= 5) ? argv[4] : nullptr;
+        const char* list_file = (argc >= 6) ? argv[5] : nullptr;
+        return cmd_rebuild(argv[2], argv[3], strcmp(command, "recompress") == 0, layout, list_file);
+    }
+    else if (strcmp(command, "apply-zup") == 0) {
+        if (argc < 4) {
+            fprintf(stderr, "Error: Missing arguments\n");
+            print_usage(argv[0]);
+            return 1;
+        }
+        const char* zup_folder = (argc >= 5) ? argv[4] : nullptr;
+        const char* path = (argc >= 6) ? argv[5] : nullptr;
+        return cmd_apply_zup(argv[2], argv[3], zup_folder, path);
+    }
+    else if (strcmp(command, "strip") == 0) {
+        if (argc < 4) {
+            fprintf(stderr, "Error: Missing arguments\n");
+            print_usage(argv[0]);
+            return 1;
+        }
+        const char* parts = (argc >= 5) ? argv[4] : nullptr;
+        return cmd_strip(argv[2], argv[3], parts);
+    }
+    else if (strcmp(command, "batch") == 0) {
+        if (argc < 4) {
+            fprintf(stderr, "Error: Missing arguments\n");
+            print_usage(argv[0]);
+            return 1;
+        }
+        return cmd_batch(argc - 2, argv + 2);
+    }
+    else if (strcmp(command, "overlay") == 0) {
+        if (argc < 4) {
+            fprintf(stderr, "Error: Missing arguments\n");
+            print_usage(argv[0]);
+            return 1;
+        }
+        return cmd_overlay(argc - 2, argv + 2);
+    }
+    else if (strcmp(command, "cat") == 0) {
+        if (argc < 4) {
+            fprintf(stderr, "Error: Missing arguments\n");
+            print_usage(argv[0]);
+            return 1;
+        }
+        uint64_t offset = (argc >= 5) ? strtoull(argv[4], NULL, 10) : 0;
+        uint64_t length = (argc >= 6) ? strtoull(argv[5], NULL, 10) : UINT64_MAX;
+        return cmd_cat(argv[2], argv[3], offset, length);
+    }
     else {
         fprintf(stderr, "Error: Unknown command: %s\n", command);
         print_usage(argv[0]);
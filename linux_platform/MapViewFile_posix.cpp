@@ -213,6 +213,14 @@ QWORD CMapViewFile::GetFileSize() {
     return 0;
 }
 
+QWORD CMapViewFile::GetFileWriteTime() {
+    struct stat st;
+    if (fstat((int)(intptr_t)hFile, &st) == 0) {
+        return (QWORD)st.st_mtim.tv_sec * 1000000000ULL + (QWORD)st.st_mtim.tv_nsec;
+    }
+    return 0;
+}
+
 LPBYTE CMapViewFile::View(QWORD dwAddress, DWORD dwSize) {
     return ViewReal(dwAddress, dwSize, accessMode);
 }
@@ -242,16 +250,16 @@ uint8_t* CMapViewFile::ViewReal(QWORD qwAddress, DWORD dwSize, DWORD dwDesiredAc
         return nullptr;
     }
 
-    vMapAddress.push_back(addr);
     // Return pointer adjusted for the offset difference
-    return static_cast<uint8_t*>(addr) + offset_diff;
+    uint8_t* lpView = static_cast<uint8_t*>(addr) + offset_diff;
+    vMapAddress.push_back({ lpView, addr, map_size });
+    return lpView;
 }
 
 void CMapViewFile::UnmapView(LPVOID lpTargetAddress) {
     for (auto it = vMapAddress.begin(); it != vMapAddress.end(); ++it) {
-        if (*it == lpTargetAddress) {
-            // We don't know the size here, but we tracked it during mapping
-            // For now, just remove from vector - proper cleanup in UnmapViewAll
+        if ((it->lpView == lpTargetAddress) || (it->lpMapAddress == lpTargetAddress)) {
+            munmap(it->lpMapAddress, it->size);
             vMapAddress.erase(it);
             return;
         }
@@ -259,10 +267,8 @@ void CMapViewFile::UnmapView(LPVOID lpTargetAddress) {
 }
 
 void CMapViewFile::UnmapViewAll() {
-    // Note: This is a simplified version. In production, you'd need to track sizes
-    for (auto addr : vMapAddress) {
-        // We can't unmap without knowing the size
-        // This is a limitation - proper implementation would track size with address
+    for (auto &view : vMapAddress) {
+        munmap(view.lpMapAddress, view.size);
     }
     vMapAddress.clear();
 }
@@ -117,6 +117,8 @@ public:
     QWORD GetFilePointer();
     DWORD Read(LPVOID buffer, DWORD dwBytesToRead);
     QWORD GetFileSize();
+    // Last write time of the open file in nanoseconds, 0 when it can not be read
+    QWORD GetFileWriteTime();
 
     virtual LPBYTE View(QWORD dwAddress, DWORD dwSize);
     void UnmapView(LPVOID lpTargetAddress);
@@ -140,7 +142,13 @@ protected:
 protected:
     HANDLE hFile;
     HANDLE hFileMapping;  // Not used in POSIX, kept for compatibility
-    std::vector<void*> vMapAddress;
+    // A view as returned to the caller and the page aligned mapping behind it
+    struct MAP_VIEW {
+        void* lpView;
+        void* lpMapAddress;
+        size_t size;
+    };
+    std::vector<MAP_VIEW> vMapAddress;
     char m_szDisk[8];
     char szFileMappingName[32];
     QWORD fileSize;
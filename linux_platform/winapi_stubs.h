@@ -79,7 +79,16 @@ inline int SetCurrentDirectoryW(const wchar_t* lpPathName) {
 
 inline int SetCurrentDirectoryA(const char* lpPathName) {
     if (!lpPathName) return 0;
-    return (chdir(lpPathName) == 0) ? 1 : 0;
+
+    // Callers pass Windows paths such as "..\\"
+    char mb_path[4096];
+    strncpy(mb_path, lpPathName, sizeof(mb_path) - 1);
+    mb_path[sizeof(mb_path) - 1] = '\0';
+    for (char* p = mb_path; *p; ++p) {
+        if (*p == '\\') *p = '/';
+    }
+
+    return (chdir(mb_path) == 0) ? 1 : 0;
 }
 
 // TEXT macro for string literals